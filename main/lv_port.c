@@ -14,6 +14,9 @@
 #include "sdkconfig.h"
 
 #include "indicator_display.h"
+#include "indicator_store.h"
+#include "indicator_view.h"
+#include "rect_set.h"
 
 #define LV_PORT_BUFFER_HEIGHT           (brd->LCD_HEIGHT)
 #define LV_PORT_BUFFER_MALLOC           (MALLOC_CAP_SPIRAM)
@@ -21,6 +24,10 @@
 // #define LV_PORT_BUFFER_MALLOC           (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
 
 #define LV_PORT_TASK_DELAY_MS           (5)
+#define LV_PORT_MONITOR_PERIOD_MS       (60 * 1000)
+/* Rows narrower than the stride by less than a cache line share lines with the next row,
+ * they are written back as one span */
+#define LV_PORT_CACHE_LINE_SIZE         (CONFIG_ESP32S3_DATA_CACHE_LINE_SIZE)
 
 
 static char *TAG = "lvgl_port";
@@ -30,6 +37,13 @@ static lv_indev_t *indev_button = NULL;
 static SemaphoreHandle_t lvgl_mutex = NULL;
 static TaskHandle_t lvgl_task_handle;
 
+#if CONFIG_LCD_LVGL_DIRECT_MODE
+static rect_set_t direct_mode_dirty;        /* drawn into the front buffer only */
+static uint32_t direct_mode_copy_bytes;     /* since the last monitor log */
+static uint32_t direct_mode_skip_bytes;
+static uint32_t direct_mode_sync_us;
+#endif
+
 #ifndef CONFIG_LCD_TASK_PRIORITY
 #define CONFIG_LCD_TASK_PRIORITY    5
 #endif
@@ -43,6 +57,8 @@ static void disp_flush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_
 static esp_err_t lv_port_tick_init(void);
 static void lvgl_task(void *args);
 static void lv_port_direct_mode_copy(void);
+static void lv_port_direct_mode_sync(lv_disp_drv_t *disp_drv);
+static void lv_port_monitor_cb(lv_disp_drv_t *disp_drv, uint32_t time, uint32_t px);
 
 void lv_port_init(void)
 {
@@ -198,10 +214,12 @@ static void lv_port_disp_init(void)
     disp_drv.ver_res = brd->LCD_HEIGHT;
     disp_drv.flush_cb = disp_flush;
     disp_drv.draw_buf = &disp_buf;
+    disp_drv.monitor_cb = lv_port_monitor_cb;
 #if CONFIG_LCD_LVGL_FULL_REFRESH
     disp_drv.full_refresh = 1;
 #elif CONFIG_LCD_LVGL_DIRECT_MODE
     disp_drv.direct_mode = 1;
+    disp_drv.render_start_cb = lv_port_direct_mode_sync;
 #endif
 
     /* Use lcd_trans_done_cb to inform the graphics library that flush already done */
@@ -261,6 +279,41 @@ static void lv_port_indev_init(void)
 #endif
 }
 
+/**
+ * @brief Count what the refreshes redraw, logged once a minute.
+ * @note  px is the area LVGL rendered, so the sum is the invalidated pixels.
+ *
+ */
+static void lv_port_monitor_cb(lv_disp_drv_t *disp_drv, uint32_t time, uint32_t px)
+{
+    static uint32_t period_start;
+    static uint32_t px_sum;
+    static uint32_t refr_cnt;
+    static uint32_t refr_ms;
+
+    px_sum += px;
+    refr_cnt++;
+    refr_ms += time;
+
+    uint32_t elapsed = lv_tick_elaps(period_start);
+    if (elapsed >= LV_PORT_MONITOR_PERIOD_MS) {
+        ESP_LOGI(TAG, "Refreshed %lu px in %lu refreshes (%lu ms) over %lu s",
+                 px_sum, refr_cnt, refr_ms, elapsed / 1000);
+#if CONFIG_LCD_LVGL_DIRECT_MODE
+        ESP_LOGI(TAG, "Buffer sync: %lu bytes/frame copied, %lu bytes/frame skipped, %lu us/frame",
+                 direct_mode_copy_bytes / refr_cnt, direct_mode_skip_bytes / refr_cnt,
+                 direct_mode_sync_us / refr_cnt);
+        direct_mode_copy_bytes = 0;
+        direct_mode_skip_bytes = 0;
+        direct_mode_sync_us = 0;
+#endif
+        period_start = lv_tick_get();
+        px_sum = 0;
+        refr_cnt = 0;
+        refr_ms = 0;
+    }
+}
+
 /**
  * @brief Task to generate ticks for LVGL.
  *
@@ -300,53 +353,80 @@ static esp_err_t lv_port_tick_init(void)
 
 #if CONFIG_LCD_LVGL_DIRECT_MODE
 /**
- * @brief Copy dirty area from last frame to current frame.
- * @note  It's useful only when enable lvgl direct-mode, and should be called behind the end of flushing in lvgl.
+ * @brief Record the areas of the frame just flushed.
+ * @note  Called by bsp_lcd once the panel shows the frame. The copy to the other buffer waits for
+ *        lv_port_direct_mode_sync(), when the areas of the next frame are known.
  *
  */
 static void lv_port_direct_mode_copy(void)
 {
     lv_disp_t *disp_refr = _lv_refr_get_disp_refreshing();
+    rect_t screen = { 0, 0, disp_refr->driver->hor_res - 1, disp_refr->driver->ver_res - 1 };
 
-    uint8_t *buf_act = disp_refr->driver->draw_buf->buf_act;
-    uint8_t *buf1 = disp_refr->driver->draw_buf->buf1;
-    uint8_t *buf2 = disp_refr->driver->draw_buf->buf2;
-    int h_res = disp_refr->driver->hor_res;
-    int v_res = disp_refr->driver->ver_res;
-
-    uint8_t *fb_from = buf_act;
-    uint8_t *fb_to = (fb_from == buf1) ? buf2 : buf1;
-
-    int32_t i;
-    lv_coord_t x_start, x_end, y_start, y_end;
-    uint32_t copy_bytes_per_line;
-    uint32_t bytes_to_flush;
-    uint32_t bytes_per_line = h_res * 2;
-    uint8_t *from, *to;
-    uint8_t *flush_ptr;
-    // ESP_LOGI(TAG, "----- Area list ----");
-    for(i = 0; i < disp_refr->inv_p; i++) {
-        /*Refresh the unjoined areas*/
-        if(disp_refr->inv_area_joined[i] == 0) {
-            x_start = disp_refr->inv_areas[i].x1;
-            x_end = disp_refr->inv_areas[i].x2 + 1;
-            y_start = disp_refr->inv_areas[i].y1;
-            y_end = disp_refr->inv_areas[i].y2 + 1;
-
-            copy_bytes_per_line= (x_end - x_start) * 2;
-            from = fb_from + (y_start * h_res + x_start) * 2;
-            to = fb_to + (y_start * h_res + x_start) * 2;
-            for (int y = y_start; y < y_end; y++) {
-                memcpy(to, from, copy_bytes_per_line);
-                from += bytes_per_line;
-                to += bytes_per_line;
-            }
-            bytes_to_flush = (y_end - y_start) * bytes_per_line;
-            flush_ptr = fb_to + y_start * bytes_per_line;
+    for (int32_t i = 0; i < disp_refr->inv_p; i++) {
+        if (disp_refr->inv_area_joined[i] == 0) {
+            const lv_area_t *a = &disp_refr->inv_areas[i];
+            rect_t r = { a->x1, a->y1, a->x2, a->y2 };
+            rect_set_add(&direct_mode_dirty, &r, &screen);
+        }
+    }
+}
 
-            Cache_WriteBack_Addr((uint32_t)(flush_ptr), bytes_to_flush);
+/**
+ * @brief Bring the buffer about to be drawn up to date with the one on the panel.
+ * @note  Runs as render_start_cb, after LVGL joined the areas of the new frame. Copies the areas of the
+ *        last frame once each, minus what the new frame redraws anyway, and writes back only the cache
+ *        lines of the copied rows.
+ *
+ */
+static void lv_port_direct_mode_sync(lv_disp_drv_t *disp_drv)
+{
+    lv_disp_t *disp_refr = _lv_refr_get_disp_refreshing();
+    lv_disp_draw_buf_t *draw_buf = disp_drv->draw_buf;
+
+    if (direct_mode_dirty.cnt == 0) {
+        return;
+    }
+    int64_t start = esp_timer_get_time();
+    uint8_t *fb_to = draw_buf->buf_act;
+    uint8_t *fb_from = (fb_to == draw_buf->buf1) ? draw_buf->buf2 : draw_buf->buf1;
+    uint32_t bytes_per_line = disp_drv->hor_res * sizeof(lv_color_t);
+    uint32_t dirty_bytes = rect_set_area(&direct_mode_dirty) * sizeof(lv_color_t);
+    uint32_t copy_bytes = 0;
+
+    for (int32_t i = 0; i < disp_refr->inv_p && direct_mode_dirty.cnt; i++) {
+        if (disp_refr->inv_area_joined[i] == 0) {
+            const lv_area_t *a = &disp_refr->inv_areas[i];
+            rect_t r = { a->x1, a->y1, a->x2, a->y2 };
+            rect_set_subtract(&direct_mode_dirty, &r);
+        }
+    }
+
+    for (int i = 0; i < direct_mode_dirty.cnt; i++) {
+        const rect_t *r = &direct_mode_dirty.r[i];
+        uint32_t offset = r->y1 * bytes_per_line + r->x1 * sizeof(lv_color_t);
+        uint32_t copy_bytes_per_line = (r->x2 - r->x1 + 1) * sizeof(lv_color_t);
+        int rows = r->y2 - r->y1 + 1;
+
+        for (int y = 0; y < rows; y++) {
+            memcpy(fb_to + offset + y * bytes_per_line, fb_from + offset + y * bytes_per_line,
+                   copy_bytes_per_line);
+        }
+        if (bytes_per_line - copy_bytes_per_line < LV_PORT_CACHE_LINE_SIZE) {
+            Cache_WriteBack_Addr((uint32_t)(fb_to + offset),
+                                 (rows - 1) * bytes_per_line + copy_bytes_per_line);
+        } else {
+            for (int y = 0; y < rows; y++) {
+                Cache_WriteBack_Addr((uint32_t)(fb_to + offset + y * bytes_per_line), copy_bytes_per_line);
+            }
         }
+        copy_bytes += rows * copy_bytes_per_line;
     }
+    rect_set_clear(&direct_mode_dirty);
+
+    direct_mode_copy_bytes += copy_bytes;
+    direct_mode_skip_bytes += dirty_bytes - copy_bytes;
+    direct_mode_sync_us += (uint32_t)(esp_timer_get_time() - start);
 }
 #endif
 
@@ -357,8 +437,16 @@ static void lv_port_direct_mode_copy(void)
  */
 static void lvgl_task(void *args)
 {
+    uint32_t last_dispatch = 0;
+
     for (;;) {
         xSemaphoreTake(lvgl_mutex, portMAX_DELAY);
+        /* Model changes since the last frame, in one batch before it renders */
+        if (lv_tick_elaps(last_dispatch) >= LV_DISP_DEF_REFR_PERIOD) {
+            last_dispatch = lv_tick_get();
+            indicator_view_event_drain();
+            indicator_store_dispatch();
+        }
         lv_task_handler();
         xSemaphoreGive(lvgl_mutex);
         vTaskDelay(pdMS_TO_TICKS(LV_PORT_TASK_DELAY_MS));
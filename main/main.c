@@ -7,6 +7,7 @@
 #include "esp_event_base.h"
 
 #include "indicator_model.h"
+#include "indicator_store.h"
 #include "indicator_view.h"
 //#include "indicator_controller.h"
 
@@ -46,6 +47,7 @@ void app_main(void)
     };
 
     ESP_ERROR_CHECK(esp_event_loop_create(&view_event_task_args, &view_event_handle));
+    indicator_store_init();     /* before the view subscribes and the models publish */
 
 
     lv_port_sem_take();
@@ -1,10 +1,11 @@
 #include "indicator_city.h"
 #include "freertos/semphr.h"
-#include "esp_tls.h"
-#include "esp_http_client.h"
-#include "cJSON.h"
+#include "esp_timer.h"
 #include "indicator_time.h"
+#include "indicator_storage.h"
+#include "indicator_net_health.h"
 #include <strings.h>
+#include <time.h>
 #include <stdlib.h>
 
 #include "lwip/err.h"
@@ -13,19 +14,17 @@
 #include "lwip/netdb.h"
 #include "lwip/dns.h"
 
-#include "mbedtls/platform.h"
-#include "mbedtls/net_sockets.h"
-#include "mbedtls/esp_debug.h"
-#include "mbedtls/ssl.h"
-#include "mbedtls/entropy.h"
-#include "mbedtls/ctr_drbg.h"
-#include "mbedtls/error.h"
-#include "esp_crt_bundle.h"
-
-#define MAX_HTTP_OUTPUT_BUFFER 4096
+#include "https_client.h"
+#include "json_stream.h"
+#include "tz_db.h"
 
 #define DISPLAY_CFG_STORAGE  "city"
+#define CITY_CACHE_STORAGE   "city-cache"
 
+/* UTC offsets follow DST, so a cached offset is looked up again after this
+ * even when the public IP has not changed */
+#define CITY_CACHE_TTL_SEC   (12 * 3600)
+#define CITY_TIME_VALID      1577836800  /* 2020-01-01, earlier means SNTP has not synced yet */
 
 struct indicator_city
 {
@@ -38,159 +37,56 @@ struct indicator_city
 
 };
 
+/* Last looked-up location, applied at boot before the network is up */
+struct city_cache
+{
+    char    ip[32];
+    char    city[32];
+    char    timezone[64];
+    int32_t local_utc_offset;
+    int64_t checked;            /* time of the lookup, 0 if the clock was not set then */
+};
+
 static const char *TAG = "city";
 
 static struct indicator_city __g_city_model;
 
+static struct city_cache __g_cache;
+static bool __g_cache_valid = false;
+
 static SemaphoreHandle_t   __g_http_com_sem;
 
 static bool net_flag = false;
 
-static char local_response_buffer[MAX_HTTP_OUTPUT_BUFFER] = {0};
+/* Responses are parsed while they are read, only the wanted values are kept */
+struct json_body {
+    json_stream_t js;
+    int           len;
+    int64_t       parse_us;
+};
 
-static int __city_data_prase(const char *p_str)
+static int __json_body_cb(void *ctx, const char *data, int len)
 {
-    //prase
-    int ret = 0;
-
-    cJSON *root = NULL;
-    cJSON* cjson_item = NULL;
-
-    root = cJSON_Parse(p_str);
-    if( root == NULL ) {
-        return -1;
-    }
-   
-    cjson_item = cJSON_GetObjectItem(root, "status");
-    if( cjson_item != NULL  && cjson_item->valuestring != NULL) {
-        if( strcmp(cjson_item->valuestring, "success") != 0 ) {
-            ret = -2;
-            goto prase_end;
-        }
-    }
-    cjson_item = cJSON_GetObjectItem(root, "city");
-    if( cjson_item != NULL  && cjson_item->valuestring != NULL) {
-        strncpy(__g_city_model.city, cjson_item->valuestring, sizeof(__g_city_model.city)-1);
-    }
-
-    cjson_item = cJSON_GetObjectItem(root, "query");
-    if( cjson_item != NULL  && cjson_item->valuestring != NULL) {
-        strncpy(__g_city_model.ip, cjson_item->valuestring, sizeof(__g_city_model.ip)-1);
-    }
+    struct json_body *body = ctx;
+    int64_t start_us = esp_timer_get_time();
+    int ret = json_stream_feed(&body->js, data, len);
 
-    cjson_item = cJSON_GetObjectItem(root, "timezone");
-    if( cjson_item != NULL  && cjson_item->valuestring != NULL) {
-        strncpy(__g_city_model.timezone,  cjson_item->valuestring, sizeof(__g_city_model.timezone)-1);
-    }
-prase_end:
-
-    cJSON_Delete(root);
-    
-    return ret;
+    body->parse_us += esp_timer_get_time() - start_us;
+    body->len += len;
+    return ret;     /* not JSON, stop reading */
 }
 
-#if 0
-esp_err_t _http_event_handler(esp_http_client_event_t *evt)
+static bool __json_body_done(struct json_body *body, const char *what)
 {
-    static char *output_buffer;  // Buffer to store response of http request from event handler
-    static int output_len;       // Stores number of bytes read
-    switch(evt->event_id) {
-        case HTTP_EVENT_ERROR:
-            ESP_LOGD(TAG, "HTTP_EVENT_ERROR");
-            break;
-        case HTTP_EVENT_ON_CONNECTED:
-            ESP_LOGD(TAG, "HTTP_EVENT_ON_CONNECTED");
-            break;
-        case HTTP_EVENT_HEADER_SENT:
-            ESP_LOGD(TAG, "HTTP_EVENT_HEADER_SENT");
-            break;
-        case HTTP_EVENT_ON_HEADER:
-            ESP_LOGD(TAG, "HTTP_EVENT_ON_HEADER, key=%s, value=%s", evt->header_key, evt->header_value);
-            break;
-        case HTTP_EVENT_ON_DATA:
-            ESP_LOGD(TAG, "HTTP_EVENT_ON_DATA, len=%d", evt->data_len);
-            /*
-             *  Check for chunked encoding is added as the URL for chunked encoding used in this example returns binary data.
-             *  However, event handler can also be used in case chunked encoding is used.
-             */
-            if (!esp_http_client_is_chunked_response(evt->client)) {
-                // If user_data buffer is configured, copy the response into the buffer
-                if (evt->user_data) {
-                    memcpy(evt->user_data + output_len, evt->data, evt->data_len);
-                } else {
-                    if (output_buffer == NULL) {
-                        output_buffer = (char *) malloc(esp_http_client_get_content_length(evt->client));
-                        output_len = 0;
-                        if (output_buffer == NULL) {
-                            ESP_LOGE(TAG, "Failed to allocate memory for output buffer");
-                            return ESP_FAIL;
-                        }
-                    }
-                    memcpy(output_buffer + output_len, evt->data, evt->data_len);
-                }
-                output_len += evt->data_len;
-            }
-
-            break;
-        case HTTP_EVENT_ON_FINISH:
-            ESP_LOGD(TAG, "HTTP_EVENT_ON_FINISH");
-            if (output_buffer != NULL) {
-                // Response is accumulated in output_buffer. Uncomment the below line to print the accumulated response
-                // ESP_LOG_BUFFER_HEX(TAG, output_buffer, output_len);
-                free(output_buffer);
-                output_buffer = NULL;
-            }
-            output_len = 0;
-            break;
-        case HTTP_EVENT_DISCONNECTED:
-            ESP_LOGI(TAG, "HTTP_EVENT_DISCONNECTED");
-            int mbedtls_err = 0;
-            esp_err_t err = esp_tls_get_and_clear_last_error((esp_tls_error_handle_t)evt->data, &mbedtls_err, NULL);
-            if (err != 0) {
-                ESP_LOGI(TAG, "Last esp error code: 0x%x", err);
-                ESP_LOGI(TAG, "Last mbedtls failure: 0x%x", mbedtls_err);
-            }
-            if (output_buffer != NULL) {
-                free(output_buffer);
-                output_buffer = NULL;
-            }
-            output_len = 0;
-            break;
+    ESP_LOGI(TAG, "%s: parsed %d bytes in %lld us, %u bytes of parser state",
+             what, body->len, body->parse_us, (unsigned)sizeof(body->js));
+    if (!json_stream_done(&body->js)) {
+        ESP_LOGE(TAG, "%s: incomplete or invalid JSON", what);
+        return false;
     }
-    return ESP_OK;
+    return true;
 }
 
-
-
-static int __city_get(void)
-{
-    memset(local_response_buffer, 0, sizeof(local_response_buffer));
-
-    esp_http_client_config_t config = {
-        .host = "ip-api.com",
-        .path = "/json",
-        // .query = "format=json",
-        .event_handler = _http_event_handler,
-        .user_data = local_response_buffer,        // Pass address of local buffer to get response
-        .disable_auto_redirect = true,
-    };
-    esp_http_client_handle_t client = esp_http_client_init(&config);
-
-    esp_err_t err = esp_http_client_perform(client);
-    if (err == ESP_OK) {
-        ESP_LOGI(TAG, "HTTP GET Status = %d, content_length = %lld",
-                esp_http_client_get_status_code(client),
-                esp_http_client_get_content_length(client));
-    } else {
-        ESP_LOGE(TAG, "HTTP GET request failed: %s", esp_err_to_name(err));
-        return -1;
-    }
-    ESP_LOGI(TAG, "CITY RESPONSE: %s", local_response_buffer);
-    esp_http_client_cleanup(client);
-    
-    return __city_data_prase(local_response_buffer);
-}
-#else
 #define WEB_SERVER "ip-api.com"
 #define WEB_PORT "80"
 #define WEB_PATH "/json"
@@ -269,527 +165,262 @@ static int __city_get(void)
         }
         ESP_LOGI(TAG, "... set socket receiving timeout success");
 
-        /* Read HTTP response */
+        /* Skip the headers, then hand the body to the parser as it arrives */
+        char status[16];
+        char city[sizeof(__g_city_model.city)];
+        char ip[sizeof(__g_city_model.ip)];
+        char tz_name[sizeof(__g_city_model.timezone)];
+        json_stream_field_t fields[] = {
+            { .path = "status",   .value = status,   .size = sizeof(status) },
+            { .path = "city",     .value = city,     .size = sizeof(city) },
+            { .path = "query",    .value = ip,       .size = sizeof(ip) },
+            { .path = "timezone", .value = tz_name,  .size = sizeof(tz_name) },
+        };
+        struct json_body body = { 0 };
+        char chunk[256];
+        int header_match = 0;   /* bytes of "\r\n\r\n" seen so far */
         int recv_len = 0;
-        bzero(local_response_buffer, sizeof(local_response_buffer));
 
-        do {
-            r = read(s, local_response_buffer + recv_len, sizeof(local_response_buffer)-1-recv_len);
+        json_stream_init(&body.js, fields, sizeof(fields) / sizeof(fields[0]));
+        while ((r = read(s, chunk, sizeof(chunk))) > 0) {
+            int i = 0;
             recv_len += r;
-            for(int i = 0; i < r; i++) {
-                putchar(local_response_buffer[i+recv_len]);
+            for (; header_match < 4 && i < r; i++) {
+                if (chunk[i] == "\r\n\r\n"[header_match]) {
+                    header_match++;
+                } else {
+                    header_match = chunk[i] == '\r' ? 1 : 0;
+                }
+            }
+            if (header_match == 4 && i < r && __json_body_cb(&body, &chunk[i], r - i) != 0) {
+                break;
             }
-        } while(r > 0);
+        }
 
         ESP_LOGI(TAG, "... done reading from socket. Last read return=%d errno=%d.", r, errno);
         close(s);
 
         if( recv_len > 0) {
-            char *p_json = strstr(local_response_buffer, "\r\n\r\n");
-            if( p_json ) {
-                p_json =  p_json + 4;
-                return __city_data_prase(p_json);
-            } else {
+            if( header_match < 4 || !__json_body_done(&body, "city")) {
                 return -1;
             }
+            if( fields[0].found && strcmp(status, "success") != 0 ) {
+                return -2;
+            }
+            if( fields[1].found ) {
+                strcpy(__g_city_model.city, city);
+            }
+            if( fields[2].found ) {
+                strcpy(__g_city_model.ip, ip);
+            }
+            if( fields[3].found ) {
+                strcpy(__g_city_model.timezone, tz_name);
+            }
+            return 0;
         }
 
     }
+    return -1;
 }
 
-#endif
-
 /* ---------------------------------------------------------- */
 //  time zone
 /* ---------------------------------------------------------- */
 
-/* Fallback timezone lookup for known cities when API fails */
-typedef struct {
-    const char *city;
-    int offset_seconds;  /* UTC offset in seconds (winter time) */
-} city_tz_entry_t;
-
-static const city_tz_entry_t known_city_timezones[] = {
-    /* Central European Time (CET) - UTC+1 */
-    {"Vienna", 3600}, {"Wien", 3600},
-    {"Berlin", 3600}, {"Munich", 3600}, {"Frankfurt", 3600}, {"Hamburg", 3600},
-    {"Zurich", 3600}, {"Bern", 3600}, {"Geneva", 3600},
-    {"Paris", 3600}, {"Lyon", 3600}, {"Marseille", 3600},
-    {"Amsterdam", 3600}, {"Rotterdam", 3600},
-    {"Brussels", 3600}, {"Antwerp", 3600},
-    {"Rome", 3600}, {"Milan", 3600}, {"Naples", 3600},
-    {"Madrid", 3600}, {"Barcelona", 3600},
-    {"Warsaw", 3600}, {"Krakow", 3600},
-    {"Prague", 3600}, {"Brno", 3600},
-    {"Budapest", 3600},
-    {"Stockholm", 3600}, {"Oslo", 3600}, {"Copenhagen", 3600},
-    /* Eastern European Time (EET) - UTC+2 */
-    {"Helsinki", 7200}, {"Tallinn", 7200}, {"Riga", 7200}, {"Vilnius", 7200},
-    {"Athens", 7200}, {"Bucharest", 7200}, {"Sofia", 7200},
-    {"Kyiv", 7200}, {"Kiev", 7200},
-    /* Western European Time (WET) - UTC+0 */
-    {"London", 0}, {"Dublin", 0}, {"Lisbon", 0}, {"Porto", 0},
-    {"Reykjavik", 0},
-    /* Moscow Time - UTC+3 */
-    {"Moscow", 10800}, {"Saint Petersburg", 10800},
-    /* US Eastern - UTC-5 */
-    {"New York", -18000}, {"Boston", -18000}, {"Philadelphia", -18000},
-    {"Washington", -18000}, {"Miami", -18000}, {"Atlanta", -18000},
-    /* US Central - UTC-6 */
-    {"Chicago", -21600}, {"Houston", -21600}, {"Dallas", -21600},
-    /* US Mountain - UTC-7 */
-    {"Denver", -25200}, {"Phoenix", -25200},
-    /* US Pacific - UTC-8 */
-    {"Los Angeles", -28800}, {"San Francisco", -28800}, {"Seattle", -28800},
-    {NULL, 0}  /* End marker */
-};
-
-static int __get_city_timezone_offset(const char *city)
-{
-    if (city == NULL || strlen(city) == 0) {
-        return -1;  /* Unknown */
-    }
+extern const char timeapi_root_cert_pem_start[] asm("_binary_timeapi_cert_pem_start");
+extern const char timeapi_root_cert_pem_end[]   asm("_binary_timeapi_cert_pem_end");
 
-    for (int i = 0; known_city_timezones[i].city != NULL; i++) {
-        if (strcasecmp(city, known_city_timezones[i].city) == 0) {
-            ESP_LOGI(TAG, "City '%s' matched, offset=%d seconds",
-                     city, known_city_timezones[i].offset_seconds);
-            return known_city_timezones[i].offset_seconds;
-        }
-    }
+/* TLS config, CA chain and per-host sessions survive between lookups */
+static https_client_t __g_https;
 
-    return -1;  /* Not found */
+static int __https_ready(void)
+{
+    return https_client_init(&__g_https, timeapi_root_cert_pem_start,
+                             timeapi_root_cert_pem_end - timeapi_root_cert_pem_start);
 }
 
-static int __time_zone_data_prase(const char *p_str)
+static void __https_log(const char *host, const char *path, int status, const https_timing_t *t)
 {
-    int ret = 0;
+    ESP_LOGI(TAG, "GET %s%s: %d, dns %lld us, connect %lld us, handshake %lld us (%s), first byte %lld us, total %lld us",
+             host, path, status, t->dns_us, t->connect_us, t->handshake_us,
+             t->reused ? "kept alive" : (t->resumed ? "resumed" : "full"), t->first_byte_us, t->total_us);
+
+    /* Any HTTP status means the host answered. The TCP connect is one round
+     * trip; on a kept-alive connection the first byte is the closest there is */
+    int64_t rtt_us = t->connect_us > 0 ? t->connect_us : t->first_byte_us;
+    indicator_net_health_report(host, status > 0, rtt_us / 1000);
+}
 
-    cJSON *root = NULL;
-    cJSON *cjson_item = NULL;
-    cJSON *cjson_item_child = NULL;
-    cJSON *cjson_tz = NULL;
+static int __ip_get(char *ip, int buf_len)
+{
+    https_timing_t t;
+    char body[32];
 
-    root = cJSON_Parse(p_str);
-    if( root == NULL ) {
-        ESP_LOGE(TAG, "cJSON_Parse failed for timezone data");
+    if (__https_ready() != 0) {
         return -1;
     }
-
-    /* Log the timezone name */
-    cjson_tz = cJSON_GetObjectItem(root, "timeZone");
-    if( cjson_tz != NULL && cjson_tz->valuestring != NULL) {
-        ESP_LOGI(TAG, "Timezone name: %s", cjson_tz->valuestring);
-    }
-
-    cjson_item = cJSON_GetObjectItem(root, "currentUtcOffset");
-    if( cjson_item != NULL ) {
-        cjson_item_child = cJSON_GetObjectItem(cjson_item, "seconds");
-        if( cjson_item_child != NULL) {
-            __g_city_model.local_utc_offset = cjson_item_child->valueint;
-            ESP_LOGI(TAG, "Parsed UTC offset: %d seconds (%d hours)",
-                     cjson_item_child->valueint, cjson_item_child->valueint / 3600);
-        } else {
-            ESP_LOGW(TAG, "No 'seconds' field in currentUtcOffset");
-        }
-    } else {
-        ESP_LOGW(TAG, "No 'currentUtcOffset' field in response");
+    int status = https_get(&__g_https, "api.ipify.org", 443, "/", body, sizeof(body), &t);
+    __https_log("api.ipify.org", "/", status, &t);
+    if (status != 200) {
+        return -1;
     }
-
-    cJSON_Delete(root);
-    return ret;
+    strncpy(ip, body, buf_len - 1);
+    ip[buf_len - 1] = '\0';
+    return 0;
 }
 
-#if 1
-extern const char timeapi_root_cert_pem_start[] asm("_binary_timeapi_cert_pem_start");
-extern const char timeapi_root_cert_pem_end[]   asm("_binary_timeapi_cert_pem_end");
-
-static int https_get_request(esp_tls_cfg_t cfg, const char *WEB_SERVER_URL, const char *REQUEST)
+static int __time_zone_get(char *ip)
 {
-    int ret, len;
-    int recv_len = 0;
-    esp_tls_t *tls = esp_tls_init();
-    if (!tls) {
-        ESP_LOGE(TAG, "Failed to allocate esp_tls handle!");
-        goto exit;
-    }
+    https_timing_t t;
+    char path[96];
+    char tz_name[sizeof(__g_city_model.timezone)];
+    char seconds[16];
+    json_stream_field_t fields[] = {
+        { .path = "timeZone",                 .value = tz_name,  .size = sizeof(tz_name) },
+        { .path = "currentUtcOffset.seconds", .value = seconds,  .size = sizeof(seconds) },
+    };
+    struct json_body body = { 0 };
 
-    if (esp_tls_conn_http_new_sync(WEB_SERVER_URL, &cfg, tls) == 1) {
-        ESP_LOGI(TAG, "Connection established...");
-    } else {
-        ESP_LOGE(TAG, "Connection failed...");
-        goto cleanup;
+    if (__https_ready() != 0) {
+        return -1;
     }
-
-    size_t written_bytes = 0;
-    do {
-        ret = esp_tls_conn_write(tls,
-                                 REQUEST + written_bytes,
-                                 strlen(REQUEST) - written_bytes);
-        if (ret >= 0) {
-            ESP_LOGI(TAG, "%d bytes written", ret);
-            written_bytes += ret;
-        } else if (ret != ESP_TLS_ERR_SSL_WANT_READ  && ret != ESP_TLS_ERR_SSL_WANT_WRITE) {
-            ESP_LOGE(TAG, "esp_tls_conn_write  returned: [0x%02X](%s)", ret, esp_err_to_name(ret));
-            goto cleanup;
-        }
-    } while (written_bytes < strlen(REQUEST));
-
-    ESP_LOGI(TAG, "Reading HTTP response...");
-    memset(local_response_buffer, 0x00, sizeof(local_response_buffer));
-    recv_len = 0;
-    do {
-        len = sizeof(local_response_buffer) - recv_len - 1;
-       
-        ret = esp_tls_conn_read(tls, (char *)local_response_buffer + recv_len, len);
-
-        if (ret == ESP_TLS_ERR_SSL_WANT_WRITE  || ret == ESP_TLS_ERR_SSL_WANT_READ) {
-            continue;
-        } else if (ret < 0) {
-            recv_len = 0;
-            ESP_LOGE(TAG, "esp_tls_conn_read  returned [-0x%02X](%s)", -ret, esp_err_to_name(ret));
-            break;
-        } else if (ret == 0) {
-            ESP_LOGI(TAG, "connection closed");
-            break;
-        }
-        recv_len += ret;
-        
-        break; //todo Let's say I can receive it all at once
-    } while (1);
-
-    if( recv_len > 0 ) {
-        printf( "%s", local_response_buffer);
+    snprintf(path, sizeof(path), "/api/TimeZone/ip?ipAddress=%s", ip);
+    json_stream_init(&body.js, fields, sizeof(fields) / sizeof(fields[0]));
+    int status = https_get_stream(&__g_https, "www.timeapi.io", 443, path, __json_body_cb, &body, &t);
+    __https_log("www.timeapi.io", path, status, &t);
+    if (status != 200 || !__json_body_done(&body, "time zone")) {
+        return -1;
     }
-    
-cleanup:
-    esp_tls_conn_destroy(tls);
-exit:
-    return recv_len;
-}
 
-static int __ip_get(char *ip, int buf_len)
-{
-    esp_tls_cfg_t cfg = {
-        .cacert_buf = (const unsigned char *) timeapi_root_cert_pem_start,
-        .cacert_bytes = timeapi_root_cert_pem_end - timeapi_root_cert_pem_start,
-    };
-    char ip_url[128] = {0};
-    char ip_request[200] = {0};
-    int len;
-    snprintf(ip_url, sizeof(ip_url),"https://api.ipify.org");
-    snprintf(ip_request, sizeof(ip_request),"GET %s HTTP/1.1\r\nHost: api.ipify.org\r\nUser-Agent: sensecap\r\n\r\n", ip_url);
-
-    len = https_get_request(cfg, ip_url, ip_request);
-    if(len > 0) {
-        char *p_ip = strstr(local_response_buffer, "\r\n\r\n");
-        if( p_ip ) {
-            strncpy(ip, p_ip+4, buf_len);
-            return 0;
-        } else {
-            return -1;
-        }
+    if (fields[0].found) {
+        ESP_LOGI(TAG, "Timezone name: %s", tz_name);
+        strcpy(__g_city_model.timezone, tz_name);
     }
-    return -1;
-}
-
-static int __time_zone_get(char *ip)
-{
-    esp_tls_cfg_t cfg = {
-        .cacert_buf = (const unsigned char *) timeapi_root_cert_pem_start,
-        .cacert_bytes = timeapi_root_cert_pem_end - timeapi_root_cert_pem_start,
-    };
-
-    char time_zone_url[128] = {0};
-    char time_zone_request[200] = {0};
-    int len  = 0;
-    snprintf(time_zone_url, sizeof(time_zone_url),"https://www.timeapi.io/api/TimeZone/ip?ipAddress=%s",ip);
-    snprintf(time_zone_request, sizeof(time_zone_request),"GET %s HTTP/1.1\r\nHost: www.timeapi.io\r\nUser-Agent: sensecap\r\n\r\n", time_zone_url);
-
-    len = https_get_request(cfg, time_zone_url, time_zone_request);
-    if( len > 0) {
-        // Find the JSON start - skip headers and chunk size
-        char *p_body = strstr(local_response_buffer, "\r\n\r\n");
-        if( p_body ) {
-            p_body += 4;  // Skip \r\n\r\n
-            // Find the actual JSON start ('{' character) - handles any chunk size length
-            char *p_json = strchr(p_body, '{');
-            if( p_json ) {
-                ESP_LOGI(TAG, "Timezone JSON: %.100s...", p_json);
-                return __time_zone_data_prase(p_json);
-            } else {
-                ESP_LOGE(TAG, "No JSON found in timezone response");
-                return -1;
-            }
-        } else {
-            ESP_LOGE(TAG, "No body separator found in timezone response");
-            return -1;
-        }
+    if (fields[1].found) {
+        __g_city_model.local_utc_offset = atoi(seconds);
+        ESP_LOGI(TAG, "Parsed UTC offset: %d seconds (%d hours)",
+                 __g_city_model.local_utc_offset, __g_city_model.local_utc_offset / 3600);
+    } else {
+        ESP_LOGW(TAG, "No 'currentUtcOffset.seconds' field in response");
     }
-    return -1;
+    return 0;
 }
 
-#else
+/* ---------------------------------------------------------- */
+//  cache
+/* ---------------------------------------------------------- */
 
-int https_mbedtls_request(const char *p_url, const char * port, const char *p_request, uint32_t request_len)
+static void __cache_restore(void)
 {
-    int ret, flags, len;
-
-    mbedtls_entropy_context entropy;
-    mbedtls_ctr_drbg_context ctr_drbg;
-    mbedtls_ssl_context ssl;
-    mbedtls_x509_crt cacert;
-    mbedtls_ssl_config conf;
-    mbedtls_net_context server_fd;
+    size_t len = sizeof(__g_cache);
 
-    mbedtls_ssl_init(&ssl);
-    mbedtls_x509_crt_init(&cacert);
-    mbedtls_ctr_drbg_init(&ctr_drbg);
-    ESP_LOGI(TAG, "Seeding the random number generator");
-
-    mbedtls_ssl_config_init(&conf);
-
-    mbedtls_entropy_init(&entropy);
-    if((ret = mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy,
-                                    NULL, 0)) != 0)
-    {
-        ESP_LOGE(TAG, "mbedtls_ctr_drbg_seed returned %d", ret);
-        abort();
-    }
-    ESP_LOGI(TAG, "Attaching the certificate bundle...");
-    ret = esp_crt_bundle_attach(&conf);
-
-    if(ret < 0)
-    {
-        ESP_LOGE(TAG, "esp_crt_bundle_attach returned -0x%x\n\n", -ret);
-        abort();
+    if( indicator_storage_read(CITY_CACHE_STORAGE, &__g_cache, &len) != ESP_OK || len != sizeof(__g_cache) ) {
+        ESP_LOGI(TAG, "No cached location");
+        return;
     }
+    __g_cache_valid = true;
+    ESP_LOGI(TAG, "Cached location: ip %s, city %s, offset %ld", __g_cache.ip, __g_cache.city,
+             (long)__g_cache.local_utc_offset);
+}
 
-    ESP_LOGI(TAG, "Setting hostname for TLS session...");
+/* The cached time zone still holds for ip: same public IP and not expired.
+ * Before SNTP has synced its age is unknown and it is trusted; the task
+ * checks again after CITY_CACHE_TTL_SEC anyway */
+static bool __cache_fresh(const char *ip)
+{
+    time_t now = time(NULL);
 
-     /* Hostname set here should match CN in server certificate */
-    if((ret = mbedtls_ssl_set_hostname(&ssl, p_url)) != 0)
-    {
-        ESP_LOGE(TAG, "mbedtls_ssl_set_hostname returned -0x%x", -ret);
-        abort();
+    if( !__g_cache_valid || strcmp(__g_cache.ip, ip) != 0 ) {
+        return false;
     }
-
-    ESP_LOGI(TAG, "Setting up the SSL/TLS structure...");
-
-    if((ret = mbedtls_ssl_config_defaults(&conf,
-                                          MBEDTLS_SSL_IS_CLIENT,
-                                          MBEDTLS_SSL_TRANSPORT_STREAM,
-                                          MBEDTLS_SSL_PRESET_DEFAULT)) != 0)
-    {
-        ESP_LOGE(TAG, "mbedtls_ssl_config_defaults returned %d", ret);
-        goto exit;
+    if( now < CITY_TIME_VALID ) {
+        return true;
     }
+    return __g_cache.checked != 0 && now - __g_cache.checked < CITY_CACHE_TTL_SEC;
+}
 
-    /* MBEDTLS_SSL_VERIFY_OPTIONAL is bad for security, in this example it will print
-       a warning if CA verification fails but it will continue to connect.
-
-       You should consider using MBEDTLS_SSL_VERIFY_REQUIRED in your own code.
-    */
-    mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_OPTIONAL);
-    mbedtls_ssl_conf_ca_chain(&conf, &cacert, NULL);
-    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &ctr_drbg);
-    //mbedtls_esp_enable_debug_log(&conf, 1);
-
-#ifdef CONFIG_MBEDTLS_SSL_PROTO_TLS1_3
-    mbedtls_ssl_conf_min_version(&conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_4);
-    mbedtls_ssl_conf_max_version(&conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_4);
-#endif
+static void __cache_save(void)
+{
+    time_t now = time(NULL);
 
-    if ((ret = mbedtls_ssl_setup(&ssl, &conf)) != 0)
-    {
-        ESP_LOGE(TAG, "mbedtls_ssl_setup returned -0x%x\n\n", -ret);
-        goto exit;
+    /* Nothing changed and not expired, spare the flash */
+    if( __cache_fresh(__g_city_model.ip) && strcmp(__g_cache.city, __g_city_model.city) == 0 &&
+        strcmp(__g_cache.timezone, __g_city_model.timezone) == 0 &&
+        __g_cache.local_utc_offset == __g_city_model.local_utc_offset ) {
+        return;
     }
-
-    while(1) {
-        mbedtls_net_init(&server_fd);
-
-        ESP_LOGI(TAG, "Connecting to %s:%s...", p_url, port);
-
-        if ((ret = mbedtls_net_connect(&server_fd, p_url,
-                                      port, MBEDTLS_NET_PROTO_TCP)) != 0)
-        {
-            ESP_LOGE(TAG, "mbedtls_net_connect returned -%x", -ret);
-            goto exit;
-        }
-
-        ESP_LOGI(TAG, "Connected.");
-
-        mbedtls_ssl_set_bio(&ssl, &server_fd, mbedtls_net_send, mbedtls_net_recv, NULL);
-
-        ESP_LOGI(TAG, "Performing the SSL/TLS handshake...");
-
-
-        while ((ret = mbedtls_ssl_handshake(&ssl)) != 0)
-        {
-            if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
-            {
-                ESP_LOGE(TAG, "mbedtls_ssl_handshake returned -0x%x", -ret);
-                goto exit;
-            }
-        }
-
-        ESP_LOGI(TAG, "Verifying peer X.509 certificate...");
-
-        if ((flags = mbedtls_ssl_get_verify_result(&ssl)) != 0)
-        {
-            /* In real life, we probably want to close connection if ret != 0 */
-            ESP_LOGW(TAG, "Failed to verify peer certificate!");
-            bzero(local_response_buffer, sizeof(local_response_buffer));
-            mbedtls_x509_crt_verify_info(local_response_buffer, sizeof(local_response_buffer), "  ! ", flags);
-            ESP_LOGW(TAG, "verification info: %s", local_response_buffer);
-        }
-        else {
-            ESP_LOGI(TAG, "Certificate verified.");
-        }
-
-        ESP_LOGI(TAG, "Cipher suite is %s", mbedtls_ssl_get_ciphersuite(&ssl));
-
-        ESP_LOGI(TAG, "Writing HTTP request...");
-        size_t written_bytes = 0;
-        do {
-            ret = mbedtls_ssl_write(&ssl,
-                                    (const unsigned char *)p_request + written_bytes,
-                                    request_len- written_bytes);
-            if (ret >= 0) {
-                ESP_LOGI(TAG, "%d bytes written", ret);
-                written_bytes += ret;
-            } else if (ret != MBEDTLS_ERR_SSL_WANT_WRITE && ret != MBEDTLS_ERR_SSL_WANT_READ) {
-                ESP_LOGE(TAG, "mbedtls_ssl_write returned -0x%x", -ret);
-                goto exit;
-            }
-        } while(written_bytes < request_len);
-
-        ESP_LOGI(TAG, "Reading HTTP response...");
-        int recv_len = 0;
-        len = sizeof(local_response_buffer) - 1;
-        bzero(local_response_buffer, sizeof(local_response_buffer));
-        do
-        {
-            len -= recv_len;
-            ret = mbedtls_ssl_read(&ssl, (unsigned char *)local_response_buffer+recv_len, len);
-
-            if(ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE)
-                continue;
-
-            if(ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
-                ret = 0;
-                break;
-            }
-
-            if(ret < 0)
-            {
-                ESP_LOGE(TAG, "mbedtls_ssl_read returned -0x%x", -ret);
-                break;
-            }
-
-            if(ret == 0)
-            {
-                ESP_LOGI(TAG, "connection closed");
-                break;
-            }
-
-            ESP_LOGD(TAG, "%d bytes read", ret);
-            /* Print response directly to stdout as it is read */
-            for(int i = 0; i < ret; i++) {
-                putchar(local_response_buffer[i+recv_len]);
-            }
-            recv_len += ret;
-
-        } while(1);
-
-        mbedtls_ssl_close_notify(&ssl);
-
-    exit:
-        mbedtls_ssl_session_reset(&ssl);
-        mbedtls_net_free(&server_fd);
-
-        if(ret != 0)
-        {
-            mbedtls_strerror(ret, local_response_buffer, 100);
-            ESP_LOGE(TAG, "Last error was: -0x%x - %s", -ret, local_response_buffer);
-            return -1;
-        }
-
-        putchar('\n'); // JSON output doesn't have a newline at end
-
-        return recv_len;
+    strcpy(__g_cache.ip, __g_city_model.ip);
+    strcpy(__g_cache.city, __g_city_model.city);
+    strcpy(__g_cache.timezone, __g_city_model.timezone);
+    __g_cache.local_utc_offset = __g_city_model.local_utc_offset;
+    __g_cache.checked = now >= CITY_TIME_VALID ? now : 0;
+    __g_cache_valid = true;
+    if( indicator_storage_write(CITY_CACHE_STORAGE, &__g_cache, sizeof(__g_cache)) != ESP_OK ) {
+        ESP_LOGE(TAG, "Failed to save location cache");
     }
 }
 
-static int __ip_get(char *ip, int buf_len)
+static void __utc_offset_apply(int offset, const char *source)
 {
-    char ip_url[128] = {0};
-    char ip_request[200] = {0};
-    int len;
-    snprintf(ip_url, sizeof(ip_url),"https://api.ipify.org");
-    len = snprintf(ip_request, sizeof(ip_request),"GET %s HTTP/1.0\r\nHost: api.ipify.org\r\nUser-Agent: esp-idf/1.0 esp32\r\n\r\n", ip_url);
-
-    len = https_mbedtls_request("api.ipify.org", "443", ip_request, len);
-    if(len > 0) {
-        char *p_ip = strstr(local_response_buffer, "\r\n\r\n");
-        if( p_ip ) {
-            strncpy(ip, p_ip+4, buf_len);
-            return 0;
+    char zone_str[64];
+    int offset_hours = offset / 3600;
+    int offset_mins = abs((offset % 3600) / 60);
+
+    ESP_LOGI(TAG, "UTC offset: %d seconds = %d hours %d mins", offset, offset_hours, offset_mins);
+
+    /* POSIX TZ format: sign is inverted (UTC-1 means UTC+1 in common notation)
+     * For Vienna (CET/CEST): offset_hours=1 in winter, 2 in summer
+     * We create "UTC-1" for UTC+1, "UTC+5" for UTC-5 */
+    if (offset_mins == 0) {
+        if (offset_hours >= 0) {
+            snprintf(zone_str, sizeof(zone_str) - 1, "UTC-%d", offset_hours);
         } else {
-            return -1;
+            snprintf(zone_str, sizeof(zone_str) - 1, "UTC+%d", -offset_hours);
+        }
+    } else {
+        if (offset_hours >= 0) {
+            snprintf(zone_str, sizeof(zone_str) - 1, "UTC-%d:%02d", offset_hours, offset_mins);
+        } else {
+            snprintf(zone_str, sizeof(zone_str) - 1, "UTC+%d:%02d", -offset_hours, offset_mins);
         }
     }
-    return -1;
+    /* Boot to local time: compare this line with a warm and a cold cache */
+    ESP_LOGI(TAG, "Setting TZ to: %s (%s, %lld ms after boot)", zone_str, source, esp_timer_get_time() / 1000);
+    indicator_time_net_zone_set( zone_str );
 }
 
-static int __time_zone_get(char *ip)
+/* Full rule with DST from the compiled-in database, by zone name first and
+ * then by city. False when neither is known */
+static bool __zone_rule_apply(const char *source)
 {
+    const char *rule = tz_db_lookup(__g_city_model.timezone);
 
-    char time_zone_url[128] = {0};
-    char time_zone_request[200] = {0};
-    int len  = 0;
-    snprintf(time_zone_url, sizeof(time_zone_url),"https://www.timeapi.io/api/TimeZone/ip?ipAddress=%s",ip);
-    len = snprintf(time_zone_request, sizeof(time_zone_request),"GET %s HTTP/1.1\r\nHost: www.timeapi.io\r\nUser-Agent: sensecap\r\n\r\n", time_zone_url);
-
-    len = https_mbedtls_request("www.timeapi.io", "443", time_zone_request, len);
-
-    if( len > 0) {
-        // Find the JSON start - skip headers and chunk size
-        char *p_body = strstr(local_response_buffer, "\r\n\r\n");
-        if( p_body ) {
-            p_body += 4;  // Skip \r\n\r\n
-            // Find the actual JSON start ('{' character) - handles any chunk size length
-            char *p_json = strchr(p_body, '{');
-            if( p_json ) {
-                ESP_LOGI(TAG, "Timezone JSON: %.100s...", p_json);
-                return __time_zone_data_prase(p_json);
-            } else {
-                ESP_LOGE(TAG, "No JSON found in timezone response");
-                return -1;
-            }
-        } else {
-            ESP_LOGE(TAG, "No body separator found in timezone response");
-            return -1;
-        }
+    if( !rule ) {
+        rule = tz_db_lookup(__g_city_model.city);
     }
-    return -1;
+    if( !rule ) {
+        return false;
+    }
+    ESP_LOGI(TAG, "Setting TZ to: %s for %s/%s (%s, %lld ms after boot)", rule, __g_city_model.timezone,
+             __g_city_model.city, source, esp_timer_get_time() / 1000);
+    indicator_time_net_zone_set( (char *)rule );
+    return true;
 }
-#endif
 
-static void __indicator_http_task(void *p_arg)
+/* Look up (or confirm) the location and time zone. Returns true when done,
+ * false when the network went away first */
+static bool __city_refresh(void)
 {
     int err = -1;
 
     bool city_flag = false;
     bool ip_flag = false;
     bool time_zone_flag = false;
-
-    xSemaphoreTake(__g_http_com_sem, portMAX_DELAY);
+    bool looked_up = false;
 
     ESP_LOGI(TAG, "start Get city and time zone");
 
-    while(1) {
+    while( net_flag ) {
 
         if( net_flag  && !city_flag) {
             
@@ -802,6 +433,12 @@ static void __indicator_http_task(void *p_arg)
                 city_flag = true;
                 ip_flag= true;
                 esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_CITY, &__g_city_model.city, sizeof(__g_city_model.city), portMAX_DELAY);
+
+                /* ip-api names the zone, no timezone lookup needed when it is known */
+                if( __zone_rule_apply("lookup") ) {
+                    time_zone_flag = true;
+                    looked_up = true;
+                }
             }
         }
 
@@ -813,80 +450,66 @@ static void __indicator_http_task(void *p_arg)
                 ip_flag= true;
             }
         }
+        if( ip_flag && !time_zone_flag && __cache_fresh(__g_city_model.ip) ) {
+            /* Applied from the cache at boot already, only the IP needed checking */
+            ESP_LOGI(TAG, "Public IP unchanged, keeping the cached time zone");
+            if( !city_flag ) {
+                strcpy(__g_city_model.city, __g_cache.city);
+                strcpy(__g_city_model.timezone, __g_cache.timezone);
+                city_flag = true;
+            }
+            __g_city_model.local_utc_offset = __g_cache.local_utc_offset;
+            time_zone_flag = true;
+        }
         if(  net_flag && ip_flag && !time_zone_flag) {
             ESP_LOGI(TAG, "Get time zone...");
             err =  __time_zone_get(__g_city_model.ip);
 
-            /* ALWAYS prefer city-based lookup if city is known - API can return wrong offset due to IP geolocation errors */
-            {
-                int city_offset = __get_city_timezone_offset(__g_city_model.city);
-                if (city_offset != -1) {
-                    if (err == 0 && __g_city_model.local_utc_offset != city_offset) {
-                        ESP_LOGW(TAG, "API offset (%d) differs from city offset (%d) for '%s' - using city offset",
-                                 __g_city_model.local_utc_offset, city_offset, __g_city_model.city);
-                    }
-                    __g_city_model.local_utc_offset = city_offset;
-                    err = 0;  /* Mark as success */
-                } else if (err != 0) {
-                    ESP_LOGW(TAG, "Timezone API failed and no city fallback for '%s'",
-                             __g_city_model.city);
-                }
-            }
-
-            if( err == 0 && __g_city_model.local_utc_offset != 0) {
-                char zone_str[64];
-                int offset_hours = __g_city_model.local_utc_offset / 3600;
-                int offset_mins = abs((__g_city_model.local_utc_offset % 3600) / 60);
-
-                ESP_LOGI(TAG, "UTC offset: %d seconds = %d hours %d mins",
-                         __g_city_model.local_utc_offset, offset_hours, offset_mins);
-
-                /* POSIX TZ format: sign is inverted (UTC-1 means UTC+1 in common notation)
-                 * For Vienna (CET/CEST): offset_hours=1 in winter, 2 in summer
-                 * We create "UTC-1" for UTC+1, "UTC+5" for UTC-5 */
-                if (offset_mins == 0) {
-                    if (offset_hours >= 0) {
-                        snprintf(zone_str, sizeof(zone_str) - 1, "UTC-%d", offset_hours);
-                    } else {
-                        snprintf(zone_str, sizeof(zone_str) - 1, "UTC+%d", -offset_hours);
-                    }
-                } else {
-                    if (offset_hours >= 0) {
-                        snprintf(zone_str, sizeof(zone_str) - 1, "UTC-%d:%02d", offset_hours, offset_mins);
-                    } else {
-                        snprintf(zone_str, sizeof(zone_str) - 1, "UTC+%d:%02d", -offset_hours, offset_mins);
-                    }
-                }
-                ESP_LOGI(TAG, "Setting TZ to: %s", zone_str);
-                indicator_time_net_zone_set( zone_str );
-
+            /* A rule for the reported zone or the city beats a bare offset, which has no DST */
+            if( __zone_rule_apply("lookup") ) {
                 time_zone_flag = true;
-            } else if (city_flag) {
-                /* City detected but no timezone - try city fallback one more time */
-                int city_offset = __get_city_timezone_offset(__g_city_model.city);
-                if (city_offset != -1) {
-                    char zone_str[64];
-                    int offset_hours = city_offset / 3600;
-                    if (offset_hours >= 0) {
-                        snprintf(zone_str, sizeof(zone_str) - 1, "UTC-%d", offset_hours);
-                    } else {
-                        snprintf(zone_str, sizeof(zone_str) - 1, "UTC+%d", -offset_hours);
-                    }
-                    ESP_LOGI(TAG, "City fallback TZ: %s", zone_str);
-                    indicator_time_net_zone_set(zone_str);
-                    time_zone_flag = true;
-                }
+                looked_up = true;
+            } else if( err == 0 && __g_city_model.local_utc_offset != 0) {
+                __utc_offset_apply(__g_city_model.local_utc_offset, "lookup");
+                time_zone_flag = true;
+                looked_up = true;
+            } else if (err != 0) {
+                ESP_LOGW(TAG, "Timezone API failed and no rule for '%s'", __g_city_model.city);
             }
         }
 
         if( city_flag  && time_zone_flag) {
-            break;
+            if( looked_up ) {
+                __cache_save();
+            }
+            https_client_close(&__g_https);
+            return true;
         }
 
         vTaskDelay(pdMS_TO_TICKS(1000));
         
     }
-    vTaskDelete(NULL);
+    https_client_close(&__g_https);
+    return false;
+}
+
+static void __indicator_http_task(void *p_arg)
+{
+    TickType_t wait = portMAX_DELAY;
+
+    while(1) {
+        /* Network came up, or the cached offset is due for a recheck */
+        xSemaphoreTake(__g_http_com_sem, wait);
+        if( !net_flag ) {
+            wait = portMAX_DELAY;
+            continue;
+        }
+        if( __city_refresh() ) {
+            wait = (TickType_t)CITY_CACHE_TTL_SEC * configTICK_RATE_HZ;
+        } else {
+            wait = portMAX_DELAY;
+        }
+    }
 }
 
 static void __view_event_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data)
@@ -897,8 +520,11 @@ static void __view_event_handler(void* handler_args, esp_event_base_t base, int3
             ESP_LOGI(TAG, "event: VIEW_EVENT_WIFI_ST");
             struct view_data_wifi_st *p_st = ( struct view_data_wifi_st *)event_data;
             if( p_st->is_network) {
-                net_flag = true;
-                xSemaphoreGive(__g_http_com_sem); //right away  get city and time zone
+                /* Every ping result is posted, only a network-up edge rechecks */
+                if( !net_flag ) {
+                    net_flag = true;
+                    xSemaphoreGive(__g_http_com_sem); //right away  get city and time zone
+                }
             } else {
                 net_flag = false;
             }
@@ -912,6 +538,19 @@ static void __view_event_handler(void* handler_args, esp_event_base_t base, int3
 int indicator_city_init(void)
 {
     __g_http_com_sem = xSemaphoreCreateBinary();
+
+    /* Local time right away, the task revalidates once the network is up */
+    __cache_restore();
+    if( __g_cache_valid ) {
+        strcpy(__g_city_model.ip, __g_cache.ip);
+        strcpy(__g_city_model.city, __g_cache.city);
+        strcpy(__g_city_model.timezone, __g_cache.timezone);
+        __g_city_model.local_utc_offset = __g_cache.local_utc_offset;
+        esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_CITY, &__g_city_model.city, sizeof(__g_city_model.city), portMAX_DELAY);
+        if( !__zone_rule_apply("cached") ) {
+            __utc_offset_apply(__g_city_model.local_utc_offset, "cached");
+        }
+    }
     
     xTaskCreate(&__indicator_http_task, "__indicator_http_task", 1024 * 5, NULL, 10, NULL);
 
@@ -0,0 +1,351 @@
+#include "indicator_export.h"
+#include "indicator_sensor.h"
+#include "indicator_time.h"
+#include "indicator_net_health.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_mac.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define EXPORT_TASK_STACK        (10 * 1024) /* sinks run their network I/O (and TLS) on it */
+#define EXPORT_TASK_PRIORITY     3           /* below the LVGL task, a backlog flush must not stall the UI */
+
+/* Backlog flush rate: a few batches per sink and wake-up, with a pause in between */
+#define EXPORT_DRAIN_MAX_BATCHES 4
+#define EXPORT_DRAIN_PAUSE_MS    200
+
+/* Samples are taken on wall-clock multiples of the interval (12:00, 12:05 ...)
+ * plus a fixed per-device offset of up to a tenth of the interval, so devices
+ * sharing a server don't all send in the same second */
+#define EXPORT_JITTER_MAX_SEC    60
+
+static const char *TAG = "export";
+
+const char *const export_field_names[EXPORT_FIELD_MAX] = {
+    "temp_internal", "humidity_internal", "co2", "tvoc",
+    "temp_external", "humidity_external", "pm1_0", "pm2_5", "pm10",
+    "no2_ppm", "c2h5oh_ppm", "voc_ppm", "co_ppm",
+};
+
+const uint8_t export_field_precision[EXPORT_FIELD_MAX] = {
+    2, 2, 1, 1, 2, 2, 1, 1, 1, 2, 2, 2, 2
+};
+
+static struct export_sink *__g_sinks[EXPORT_SINK_MAX];
+static int __g_sink_cnt;
+static int __g_boundary_id = -1;       /* wall-clock subscription, see indicator_time.h */
+static TaskHandle_t __g_task_handle;
+static struct export_row *__g_batch_rows;   /* EXPORT_BATCH_MAX_ROWS, PSRAM */
+static bool __g_backlog = false;
+static bool __g_initialized = false;
+
+static char __g_device_id[13];          /* station MAC as hex */
+static uint32_t __g_device_hash;
+static uint32_t __g_interval_sec;
+
+static bool __any_enabled(void)
+{
+    for (int i = 0; i < __g_sink_cnt; i++) {
+        if (__g_sinks[i]->enabled()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Snapshot the sensors into the export queue */
+static int __queue_sample(time_t timestamp)
+{
+    struct view_data_sensor sensor_data;
+    struct export_row row;
+
+    if (indicator_sensor_get_data(&sensor_data) != 0) {
+        ESP_LOGE(TAG, "Failed to get sensor data");
+        return -2;
+    }
+    indicator_export_row_from_sensor(&row, &sensor_data, timestamp);
+    return indicator_export_queue_push(&row) == 0 ? 0 : -2;
+}
+
+/* One round of a sink: send what it has not seen yet, a few batches at most.
+ * Returns true when rows are left for the next round */
+static bool __run_sink(struct export_sink *sink, uint32_t head, int queued)
+{
+    int offset = (int)(sink->next_row - head);
+    int status = 0;
+    uint32_t bytes;
+
+    /* Behind the head: those rows were dropped while the queue was full */
+    if (offset < 0 || offset > queued) {
+        offset = offset < 0 ? 0 : queued;
+        sink->next_row = head + offset;
+    }
+
+    if (offset == queued) {
+        if (sink->idle) sink->idle();
+        return false;
+    }
+
+    if (sink->begin) {
+        status = sink->begin(queued - offset);
+    }
+
+    for (int batch = 0; status == 0 && batch < EXPORT_DRAIN_MAX_BATCHES && offset < queued; batch++) {
+        if (batch > 0) {
+            vTaskDelay(pdMS_TO_TICKS(EXPORT_DRAIN_PAUSE_MS));
+        }
+
+        int cnt = indicator_export_queue_peek_at(offset, __g_batch_rows, EXPORT_BATCH_MAX_ROWS);
+        if (cnt == 0) {
+            break;
+        }
+
+        int64_t start_us = esp_timer_get_time();
+        bytes = 0;
+        int rows = sink->send(__g_batch_rows, cnt, &bytes);
+        int64_t elapsed_us = esp_timer_get_time() - start_us;
+        sink->stats.busy_us += elapsed_us;
+        /* No round trip of its own: the time of the whole send */
+        indicator_net_health_report(sink->name, rows >= 0, elapsed_us / 1000);
+        if (rows < 0) {
+            status = rows;
+            break;
+        }
+
+        offset += rows;
+        sink->next_row += rows;
+        sink->stats.rows += rows;
+        sink->stats.batches++;
+        sink->stats.bytes += bytes;
+    }
+
+    if (status < 0) {
+        sink->stats.errors++;
+    }
+    sink->stats.last_status = status;
+    if (sink->done) {
+        sink->done(status, queued - offset);
+    }
+
+    ESP_LOGI(TAG, "%s: %lu rows, %lu batches, %lu bytes, %lu errors, %lu rows/s",
+             sink->name, (unsigned long)sink->stats.rows, (unsigned long)sink->stats.batches,
+             (unsigned long)sink->stats.bytes, (unsigned long)sink->stats.errors,
+             sink->stats.busy_us ? (unsigned long)((int64_t)sink->stats.rows * 1000000 / sink->stats.busy_us) : 0);
+
+    return status == 0 && offset < queued;
+}
+
+/* What the other traffic saw, next to the sink counters */
+static void __log_net_health(void)
+{
+    struct view_data_net_health h;
+
+    for (int i = 0; indicator_net_health_get(i, &h) == 0; i++) {
+        int rtt = indicator_net_health_rtt_median_ms(&h);
+        char median[24] = "-";
+
+        if (rtt < 0) {
+            strcpy(median, ">= 1000 ms");
+        } else if (rtt > 0) {
+            snprintf(median, sizeof(median), "< %d ms", rtt);
+        }
+        ESP_LOGI(TAG, "net %s: %lu answered, %lu failed, median rtt %s, %u%% lost in the last window",
+                 h.dest, (unsigned long)h.ok, (unsigned long)h.fail, median, h.last_loss);
+    }
+}
+
+/* Run every sink once, then pop what all enabled sinks have sent */
+static void __run_sinks(void)
+{
+    uint32_t head = indicator_export_queue_head();
+    int queued = indicator_export_queue_count();
+    uint32_t done = head + queued;
+    bool backlog = false;
+
+    for (int i = 0; i < __g_sink_cnt; i++) {
+        struct export_sink *sink = __g_sinks[i];
+        if (!sink->enabled()) {
+            if (sink->idle) sink->idle();
+            continue;
+        }
+        if (__run_sink(sink, head, queued)) {
+            backlog = true;
+        }
+        if ((int32_t)(sink->next_row - done) < 0) {
+            done = sink->next_row;
+        }
+    }
+
+    if ((int32_t)(done - head) > 0) {
+        indicator_export_queue_pop(done - head);
+    }
+    __g_backlog = backlog;
+}
+
+/* Seconds after each boundary this device samples at */
+static uint32_t __device_offset(void)
+{
+    uint32_t span = __g_interval_sec / 10;
+    if (span > EXPORT_JITTER_MAX_SEC) {
+        span = EXPORT_JITTER_MAX_SEC;
+    }
+    return span ? __g_device_hash % span : 0;
+}
+
+static void __export_boundary_callback(time_t boundary, void *arg)
+{
+    /* Stamped with the boundary, so rows of different devices line up */
+    time_t timestamp = boundary ? boundary : time(NULL);
+
+    ESP_LOGI(TAG, "Export timer triggered");
+    if (!__any_enabled()) {
+        return;
+    }
+    /* The sample is taken now, sending may happen much later */
+    __queue_sample(timestamp);
+    xTaskNotifyGive(__g_task_handle);
+}
+
+static void __export_task(void *arg)
+{
+    ESP_LOGI(TAG, "Export task started (stack: %d bytes free)",
+             uxTaskGetStackHighWaterMark(NULL) * 4);
+
+    while (1) {
+        /* Come back sooner while a backlog is flushed */
+        uint32_t notify = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(__g_backlog ? EXPORT_DRAIN_PAUSE_MS : 5000));
+
+        /* Keep PSRAM headroom during a long outage */
+        while (indicator_export_queue_need_spill()) {
+            if (indicator_export_queue_spill() <= 0) {
+                break;
+            }
+        }
+
+        if (notify > 0 || __g_backlog) {
+            __run_sinks();
+            if (!__g_backlog) {
+                __log_net_health();     /* once per round, not per drained batch */
+            }
+            ESP_LOGI(TAG, "Stack high water mark: %d bytes",
+                     uxTaskGetStackHighWaterMark(NULL) * 4);
+        }
+    }
+}
+
+int indicator_export_init(void)
+{
+    if (__g_initialized) {
+        return 0;
+    }
+
+    uint8_t mac[6];
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    snprintf(__g_device_id, sizeof(__g_device_id), "%02x%02x%02x%02x%02x%02x",
+             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    /* FNV-1a, spreads neighbouring MACs over the whole offset range */
+    __g_device_hash = 2166136261u;
+    for (int i = 0; i < 6; i++) {
+        __g_device_hash = (__g_device_hash ^ mac[i]) * 16777619u;
+    }
+
+    __g_batch_rows = heap_caps_malloc(EXPORT_BATCH_MAX_ROWS * sizeof(struct export_row), MALLOC_CAP_SPIRAM);
+    if (!__g_batch_rows) {
+        ESP_LOGE(TAG, "Failed to allocate batch buffer");
+        return -1;
+    }
+
+    if (indicator_export_queue_init() != 0) {
+        ESP_LOGE(TAG, "Failed to init export queue");
+        return -1;
+    }
+
+    BaseType_t ret = xTaskCreate(__export_task, "export_task", EXPORT_TASK_STACK,
+                                 NULL, EXPORT_TASK_PRIORITY, &__g_task_handle);
+    if (ret != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create export task");
+        return -1;
+    }
+
+    /* Registered disabled, indicator_export_set_interval() starts it */
+    __g_boundary_id = indicator_time_boundary_register(0, 0, false, __export_boundary_callback, NULL);
+    if (__g_boundary_id < 0) {
+        ESP_LOGE(TAG, "Failed to subscribe to the wall clock");
+        return -1;
+    }
+
+    __g_initialized = true;
+    ESP_LOGI(TAG, "Export framework initialized");
+    return 0;
+}
+
+int indicator_export_register(struct export_sink *sink)
+{
+    if (!sink || !sink->enabled || !sink->send || __g_sink_cnt >= EXPORT_SINK_MAX) {
+        return -1;
+    }
+    /* A new sink starts at the current head */
+    sink->next_row = indicator_export_queue_head();
+    __g_sinks[__g_sink_cnt++] = sink;
+    ESP_LOGI(TAG, "Sink registered: %s", sink->name);
+    return 0;
+}
+
+void indicator_export_set_interval(uint16_t minutes)
+{
+    if (__g_boundary_id < 0) {
+        return;
+    }
+
+    __g_interval_sec = (uint32_t)minutes * 60;
+    indicator_time_boundary_set(__g_boundary_id, __g_interval_sec, __device_offset());
+    if (minutes > 0) {
+        ESP_LOGI(TAG, "Export timer started: every %d minutes, device offset %lu s",
+                 minutes, (unsigned long)__device_offset());
+    } else {
+        ESP_LOGI(TAG, "Export timer stopped");
+    }
+}
+
+int indicator_export_now(void)
+{
+    if (!__g_task_handle) {
+        ESP_LOGE(TAG, "Export task not running");
+        return -1;
+    }
+
+    int ret = __queue_sample(time(NULL));
+    xTaskNotifyGive(__g_task_handle);
+    return ret;
+}
+
+void indicator_export_kick(void)
+{
+    if (__g_task_handle) {
+        xTaskNotifyGive(__g_task_handle);
+    }
+}
+
+const char *indicator_export_device_id(void)
+{
+    return __g_device_id;
+}
+
+int indicator_export_get_sink_stats(int index, const char **name, struct export_sink_stats *stats)
+{
+    if (index < 0 || index >= __g_sink_cnt) {
+        return -1;
+    }
+    if (name) {
+        *name = __g_sinks[index]->name;
+    }
+    if (stats) {
+        memcpy(stats, &__g_sinks[index]->stats, sizeof(*stats));
+    }
+    return 0;
+}
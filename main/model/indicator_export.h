@@ -0,0 +1,79 @@
+#ifndef INDICATOR_EXPORT_H
+#define INDICATOR_EXPORT_H
+
+#include "config.h"
+#include "indicator_export_queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EXPORT_BATCH_MAX_ROWS   128     /* rows handed to a sink per send call */
+#define EXPORT_SINK_MAX         4
+
+struct export_sink_stats {
+    uint32_t rows;          /* Rows delivered */
+    uint32_t batches;       /* Successful send calls */
+    uint32_t bytes;         /* Payload bytes handed to the transport */
+    uint32_t errors;        /* Failed rounds */
+    int      last_status;   /* 0 or the error code of the last round */
+    int64_t  busy_us;       /* Time spent sending, rows / busy_us is the throughput */
+};
+
+/*
+ * An export destination. All sinks read the same queue of samples, each at
+ * its own position, and are run one after the other by the export task:
+ * begin, then send until the sink has caught up (a few batches per wake-up),
+ * then done. Rows leave the queue once every enabled sink has sent them.
+ */
+struct export_sink {
+    const char *name;
+    /* Configured and switched on. Disabled sinks don't hold rows back */
+    bool (*enabled)(void);
+    /* Optional: prepare a round with `pending` rows waiting, <0 skips it */
+    int  (*begin)(int pending);
+    /* Deliver the first rows of the batch. Returns the number of rows
+     * acknowledged (at least one) or <0. *bytes: payload size sent */
+    int  (*send)(const struct export_row *rows, int cnt, uint32_t *bytes);
+    /* Optional: end of a round, status 0 or the error, rows still pending */
+    void (*done)(int status, int pending);
+    /* Optional: a round without work for this sink (disabled or caught up) */
+    void (*idle)(void);
+
+    /* Owned by the export task */
+    uint32_t next_row;      /* absolute queue index of the next row to send */
+    struct export_sink_stats stats;
+};
+
+int indicator_export_init(void);
+
+/* Add a sink, call once from the sink's init */
+int indicator_export_register(struct export_sink *sink);
+
+/* Sampling interval shared by all sinks, 0 stops sampling. Samples are taken
+ * on wall-clock multiples of the interval plus a per-device offset and are
+ * stamped with the boundary; one timer drives every sink */
+void indicator_export_set_interval(uint16_t minutes);
+
+/* Take a sample now and run the sinks */
+int indicator_export_now(void);
+
+/* Run the sinks without a new sample, e.g. after a config change */
+void indicator_export_kick(void);
+
+/* Station MAC as 12 hex digits, identifies the device in shared tables */
+const char *indicator_export_device_id(void);
+
+/* Counters of sink `index`, -1 past the last one */
+int indicator_export_get_sink_stats(int index, const char **name, struct export_sink_stats *stats);
+
+/* Field names used by the text formats, same order as enum export_field */
+extern const char *const export_field_names[EXPORT_FIELD_MAX];
+/* Decimals sent per field */
+extern const uint8_t export_field_precision[EXPORT_FIELD_MAX];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,442 @@
+#include "indicator_export_queue.h"
+#include "esp_event.h"
+#include "esp_partition.h"
+#include "esp_heap_caps.h"
+#include "freertos/semphr.h"
+
+/*
+ * Store-and-forward queue for exported samples.
+ *
+ * New rows go into a ring in PSRAM. When the ring fills up the oldest rows are
+ * moved, one flash sector at a time, to the raw "exportq" partition, so an
+ * outage of several days survives without touching NVS. Rows always leave the
+ * queue oldest first: flash sectors, then the PSRAM ring.
+ *
+ * A sector is written once (rows first, header last) and erased once all of
+ * its rows are acknowledged. The read position inside the oldest sector is
+ * kept in RAM only, so after a reboot that sector is sent again: delivery is
+ * at-least-once.
+ *
+ * Several consumers can read the same rows: each keeps the absolute index of
+ * its next row and peeks at that offset from the head. Rows are popped once
+ * every consumer is past them.
+ */
+
+#define EXPORT_QUEUE_PARTITION    "exportq"
+#define EXPORT_QUEUE_RAM_ROWS     1024                          /* ~64KB of PSRAM */
+#define EXPORT_QUEUE_SPILL_ROWS   (EXPORT_QUEUE_RAM_ROWS * 3 / 4)
+#define EXPORT_QUEUE_SECTOR_SIZE  4096
+#define EXPORT_QUEUE_MAGIC        0x51505845                    /* "EXPQ" */
+
+struct export_sector_header {
+    uint32_t magic;
+    uint32_t seq;           /* Write order, the oldest sector has the lowest seq */
+    uint16_t count;         /* Rows in this sector */
+    uint16_t row_size;      /* sizeof(struct export_row) when written */
+    uint32_t reserved;
+};
+
+#define EXPORT_QUEUE_SECTOR_ROWS  ((EXPORT_QUEUE_SECTOR_SIZE - sizeof(struct export_sector_header)) / sizeof(struct export_row))
+
+static const char *TAG = "export-queue";
+
+/* PSRAM ring, shared by producers and the consumer */
+static SemaphoreHandle_t __g_ram_mutex;
+static struct export_row *__g_ram_rows;
+static uint32_t __g_ram_head;
+static uint32_t __g_ram_count;
+static uint32_t __g_dropped;
+static uint32_t __g_head_index;         /* Absolute index of the oldest row */
+
+/* Flash spill area, only touched with __g_consumer_mutex held */
+static SemaphoreHandle_t __g_consumer_mutex;
+static const esp_partition_t *__g_part;
+static uint8_t *__g_sector_buf;
+static uint32_t __g_sector_cnt;
+static uint32_t __g_flash_tail_seq;     /* Oldest sector that still holds rows */
+static uint32_t __g_flash_head_seq;     /* Next sector to write */
+static uint32_t __g_flash_tail_pos;     /* Rows of the oldest sector already popped */
+/* Changed with __g_ram_mutex held too, in the same section as the ring, so
+ * the ring and flash counts always add up for readers of the total */
+static uint32_t __g_flash_rows;
+
+static bool __g_initialized = false;
+
+static size_t __sector_offset(uint32_t seq)
+{
+    return (size_t)(seq % __g_sector_cnt) * EXPORT_QUEUE_SECTOR_SIZE;
+}
+
+/* Rows stored in a sector, 0 if it is erased or not ours */
+static int __sector_count(uint32_t seq)
+{
+    struct export_sector_header hdr;
+
+    if (esp_partition_read(__g_part, __sector_offset(seq), &hdr, sizeof(hdr)) != ESP_OK) {
+        return 0;
+    }
+    if (hdr.magic != EXPORT_QUEUE_MAGIC || hdr.seq != seq ||
+        hdr.row_size != sizeof(struct export_row) ||
+        hdr.count == 0 || hdr.count > EXPORT_QUEUE_SECTOR_ROWS) {
+        return 0;
+    }
+    return hdr.count;
+}
+
+static void __sector_release(uint32_t seq)
+{
+    esp_err_t err = esp_partition_erase_range(__g_part, __sector_offset(seq), EXPORT_QUEUE_SECTOR_SIZE);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Sector erase failed: %s", esp_err_to_name(err));
+    }
+}
+
+static void __flash_restore(void)
+{
+    struct export_sector_header hdr;
+    bool found = false;
+    uint32_t min_seq = 0;
+    uint32_t max_seq = 0;
+
+    for (uint32_t i = 0; i < __g_sector_cnt; i++) {
+        if (esp_partition_read(__g_part, (size_t)i * EXPORT_QUEUE_SECTOR_SIZE, &hdr, sizeof(hdr)) != ESP_OK) {
+            continue;
+        }
+        if (hdr.magic != EXPORT_QUEUE_MAGIC) {
+            continue;
+        }
+        if (hdr.row_size != sizeof(struct export_row) || (hdr.seq % __g_sector_cnt) != i) {
+            /* Written by another firmware layout, cannot be decoded */
+            esp_partition_erase_range(__g_part, (size_t)i * EXPORT_QUEUE_SECTOR_SIZE, EXPORT_QUEUE_SECTOR_SIZE);
+            continue;
+        }
+        if (!found || hdr.seq < min_seq) min_seq = hdr.seq;
+        if (!found || hdr.seq > max_seq) max_seq = hdr.seq;
+        found = true;
+    }
+
+    __g_flash_rows = 0;
+    __g_flash_tail_pos = 0;
+    if (!found) {
+        __g_flash_tail_seq = 0;
+        __g_flash_head_seq = 0;
+        return;
+    }
+
+    __g_flash_tail_seq = min_seq;
+    __g_flash_head_seq = max_seq + 1;
+    for (uint32_t seq = min_seq; seq != __g_flash_head_seq; seq++) {
+        __g_flash_rows += __sector_count(seq);
+    }
+    ESP_LOGI(TAG, "Restored %lu rows in %lu sectors from flash",
+             (unsigned long)__g_flash_rows, (unsigned long)(__g_flash_head_seq - __g_flash_tail_seq));
+}
+
+/* Drop fully consumed (or unreadable) sectors from the tail */
+static void __flash_trim(void)
+{
+    while (__g_flash_tail_seq != __g_flash_head_seq) {
+        int cnt = __sector_count(__g_flash_tail_seq);
+        if (cnt > 0 && __g_flash_tail_pos < (uint32_t)cnt) {
+            break;
+        }
+        __sector_release(__g_flash_tail_seq);
+        __g_flash_tail_seq++;
+        __g_flash_tail_pos = 0;
+    }
+}
+
+/* Write up to one sector worth of the oldest PSRAM rows to flash */
+static int __spill_one_sector(void)
+{
+    struct export_sector_header *hdr = (struct export_sector_header *)__g_sector_buf;
+    struct export_row *rows = (struct export_row *)(__g_sector_buf + sizeof(struct export_sector_header));
+    uint32_t cnt;
+
+    if (!__g_part) {
+        return -1;
+    }
+
+    xSemaphoreTake(__g_ram_mutex, portMAX_DELAY);
+    cnt = __g_ram_count < EXPORT_QUEUE_SECTOR_ROWS ? __g_ram_count : EXPORT_QUEUE_SECTOR_ROWS;
+    for (uint32_t i = 0; i < cnt; i++) {
+        rows[i] = __g_ram_rows[(__g_ram_head + i) % EXPORT_QUEUE_RAM_ROWS];
+    }
+    xSemaphoreGive(__g_ram_mutex);
+
+    if (cnt == 0) {
+        return 0;
+    }
+
+    /* Flash full: the oldest sector makes room */
+    if (__g_flash_head_seq - __g_flash_tail_seq >= __g_sector_cnt) {
+        int lost = __sector_count(__g_flash_tail_seq) - (int)__g_flash_tail_pos;
+        if (lost > 0) {
+            xSemaphoreTake(__g_ram_mutex, portMAX_DELAY);
+            __g_flash_rows -= lost;
+            __g_dropped += lost;
+            __g_head_index += lost;
+            xSemaphoreGive(__g_ram_mutex);
+        }
+        ESP_LOGW(TAG, "Flash queue full, dropping %d oldest rows", lost);
+        __sector_release(__g_flash_tail_seq);
+        __g_flash_tail_seq++;
+        __g_flash_tail_pos = 0;
+    }
+
+    size_t offset = __sector_offset(__g_flash_head_seq);
+    esp_err_t err = esp_partition_erase_range(__g_part, offset, EXPORT_QUEUE_SECTOR_SIZE);
+    if (err == ESP_OK) {
+        /* Rows first, header last: a torn write leaves the sector without magic */
+        err = esp_partition_write(__g_part, offset + sizeof(struct export_sector_header),
+                                  rows, cnt * sizeof(struct export_row));
+    }
+    if (err == ESP_OK) {
+        memset(hdr, 0, sizeof(*hdr));
+        hdr->magic = EXPORT_QUEUE_MAGIC;
+        hdr->seq = __g_flash_head_seq;
+        hdr->count = cnt;
+        hdr->row_size = sizeof(struct export_row);
+        err = esp_partition_write(__g_part, offset, hdr, sizeof(*hdr));
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Spill to flash failed: %s", esp_err_to_name(err));
+        return -1;
+    }
+
+    __g_flash_head_seq++;
+
+    /* The rows move from the ring to flash in one step */
+    xSemaphoreTake(__g_ram_mutex, portMAX_DELAY);
+    __g_flash_rows += cnt;
+    __g_ram_head = (__g_ram_head + cnt) % EXPORT_QUEUE_RAM_ROWS;
+    __g_ram_count -= cnt;
+    xSemaphoreGive(__g_ram_mutex);
+
+    ESP_LOGI(TAG, "Spilled %lu rows to flash (%lu rows on flash)",
+             (unsigned long)cnt, (unsigned long)__g_flash_rows);
+    return cnt;
+}
+
+static void __view_event_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data)
+{
+    switch (id)
+    {
+        case VIEW_EVENT_SHUTDOWN: {
+            ESP_LOGI(TAG, "event: VIEW_EVENT_SHUTDOWN");
+            /* Keep unsent rows across the power cycle */
+            xSemaphoreTake(__g_consumer_mutex, portMAX_DELAY);
+            while (__g_ram_count > 0 && __spill_one_sector() > 0) {
+            }
+            xSemaphoreGive(__g_consumer_mutex);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+int indicator_export_queue_init(void)
+{
+    if (__g_initialized) {
+        return 0;
+    }
+
+    __g_ram_mutex = xSemaphoreCreateMutex();
+    __g_consumer_mutex = xSemaphoreCreateMutex();
+    __g_ram_rows = heap_caps_calloc(EXPORT_QUEUE_RAM_ROWS, sizeof(struct export_row), MALLOC_CAP_SPIRAM);
+    __g_sector_buf = heap_caps_malloc(EXPORT_QUEUE_SECTOR_SIZE, MALLOC_CAP_SPIRAM);
+    if (!__g_ram_mutex || !__g_consumer_mutex || !__g_ram_rows || !__g_sector_buf) {
+        ESP_LOGE(TAG, "Out of memory");
+        return -1;
+    }
+
+    __g_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, EXPORT_QUEUE_PARTITION);
+    if (__g_part) {
+        __g_sector_cnt = __g_part->size / EXPORT_QUEUE_SECTOR_SIZE;
+        __flash_restore();
+    } else {
+        ESP_LOGW(TAG, "No '%s' partition, queue is RAM only", EXPORT_QUEUE_PARTITION);
+    }
+
+    ESP_ERROR_CHECK(esp_event_handler_instance_register_with(view_event_handle,
+                                                            VIEW_EVENT_BASE, VIEW_EVENT_SHUTDOWN,
+                                                            __view_event_handler, NULL, NULL));
+
+    __g_initialized = true;
+    ESP_LOGI(TAG, "Export queue: %d rows in PSRAM, %lu rows per flash sector",
+             EXPORT_QUEUE_RAM_ROWS, (unsigned long)EXPORT_QUEUE_SECTOR_ROWS);
+    return 0;
+}
+
+void indicator_export_row_from_sensor(struct export_row *row, const struct view_data_sensor *data, time_t timestamp)
+{
+    row->timestamp = timestamp;
+    row->values[EXPORT_FIELD_TEMP_INTERNAL]     = data->temp_internal;
+    row->values[EXPORT_FIELD_HUMIDITY_INTERNAL] = data->humidity_internal;
+    row->values[EXPORT_FIELD_CO2]               = data->co2;
+    row->values[EXPORT_FIELD_TVOC]              = data->tvoc;
+    row->values[EXPORT_FIELD_TEMP_EXTERNAL]     = data->temp_external;
+    row->values[EXPORT_FIELD_HUMIDITY_EXTERNAL] = data->humidity_external;
+    row->values[EXPORT_FIELD_PM1_0]             = data->pm1_0;
+    row->values[EXPORT_FIELD_PM2_5]             = data->pm2_5;
+    row->values[EXPORT_FIELD_PM10]              = data->pm10;
+    row->values[EXPORT_FIELD_NO2]               = data->multigas_gm102b[0];
+    row->values[EXPORT_FIELD_C2H5OH]            = data->multigas_gm302b[0];
+    row->values[EXPORT_FIELD_VOC]               = data->multigas_gm502b[0];
+    row->values[EXPORT_FIELD_CO]                = data->multigas_gm702b[0];
+}
+
+int indicator_export_queue_push(const struct export_row *row)
+{
+    int ret = 0;
+
+    if (!__g_initialized || !row) {
+        return -1;
+    }
+
+    xSemaphoreTake(__g_ram_mutex, portMAX_DELAY);
+    if (__g_ram_count < EXPORT_QUEUE_RAM_ROWS) {
+        __g_ram_rows[(__g_ram_head + __g_ram_count) % EXPORT_QUEUE_RAM_ROWS] = *row;
+        __g_ram_count++;
+    } else {
+        /* Only happens when flash spilling fails too */
+        __g_dropped++;
+        ret = -1;
+    }
+    xSemaphoreGive(__g_ram_mutex);
+
+    if (ret < 0) {
+        ESP_LOGW(TAG, "Queue full, sample dropped");
+    }
+    return ret;
+}
+
+int indicator_export_queue_peek(struct export_row *rows, int max)
+{
+    return indicator_export_queue_peek_at(0, rows, max);
+}
+
+int indicator_export_queue_peek_at(int offset, struct export_row *rows, int max)
+{
+    int n = 0;
+    uint32_t skip = offset > 0 ? offset : 0;
+
+    if (!__g_initialized || !rows || max <= 0) {
+        return 0;
+    }
+
+    xSemaphoreTake(__g_consumer_mutex, portMAX_DELAY);
+
+    /* Oldest rows live on flash */
+    uint32_t pos = __g_flash_tail_pos;
+    for (uint32_t seq = __g_flash_tail_seq; seq != __g_flash_head_seq && n < max; seq++) {
+        int cnt = __sector_count(seq);
+        if ((int)pos < cnt && skip >= (uint32_t)(cnt - (int)pos)) {
+            /* Whole rest of the sector is before the offset */
+            skip -= cnt - (int)pos;
+        } else if ((int)pos < cnt) {
+            pos += skip;
+            skip = 0;
+            int take = cnt - (int)pos;
+            if (take > max - n) take = max - n;
+            size_t addr = __sector_offset(seq) + sizeof(struct export_sector_header) +
+                          pos * sizeof(struct export_row);
+            if (esp_partition_read(__g_part, addr, &rows[n], take * sizeof(struct export_row)) != ESP_OK) {
+                break;
+            }
+            n += take;
+        }
+        pos = 0;
+    }
+
+    xSemaphoreTake(__g_ram_mutex, portMAX_DELAY);
+    for (uint32_t i = skip; i < __g_ram_count && n < max; i++) {
+        rows[n++] = __g_ram_rows[(__g_ram_head + i) % EXPORT_QUEUE_RAM_ROWS];
+    }
+    xSemaphoreGive(__g_ram_mutex);
+
+    xSemaphoreGive(__g_consumer_mutex);
+    return n;
+}
+
+int indicator_export_queue_pop(int cnt)
+{
+    int popped = 0;
+
+    if (!__g_initialized || cnt <= 0) {
+        return 0;
+    }
+
+    xSemaphoreTake(__g_consumer_mutex, portMAX_DELAY);
+
+    while (cnt > 0 && __g_flash_tail_seq != __g_flash_head_seq) {
+        int in_sector = __sector_count(__g_flash_tail_seq) - (int)__g_flash_tail_pos;
+        int take = in_sector < cnt ? in_sector : cnt;
+        if (take > 0) {
+            __g_flash_tail_pos += take;
+            cnt -= take;
+            popped += take;
+        }
+        __flash_trim();
+    }
+
+    xSemaphoreTake(__g_ram_mutex, portMAX_DELAY);
+    __g_flash_rows -= popped;
+    if ((uint32_t)cnt > __g_ram_count) {
+        cnt = __g_ram_count;
+    }
+    __g_ram_head = (__g_ram_head + cnt) % EXPORT_QUEUE_RAM_ROWS;
+    __g_ram_count -= cnt;
+    __g_head_index += popped + cnt;
+    xSemaphoreGive(__g_ram_mutex);
+
+    xSemaphoreGive(__g_consumer_mutex);
+    return 0;
+}
+
+int indicator_export_queue_count(void)
+{
+    int cnt;
+    xSemaphoreTake(__g_ram_mutex, portMAX_DELAY);
+    cnt = __g_ram_count + __g_flash_rows;
+    xSemaphoreGive(__g_ram_mutex);
+    return cnt;
+}
+
+uint32_t indicator_export_queue_head(void)
+{
+    uint32_t head;
+    xSemaphoreTake(__g_ram_mutex, portMAX_DELAY);
+    head = __g_head_index;
+    xSemaphoreGive(__g_ram_mutex);
+    return head;
+}
+
+bool indicator_export_queue_need_spill(void)
+{
+    return __g_part && __g_ram_count >= EXPORT_QUEUE_SPILL_ROWS;
+}
+
+int indicator_export_queue_spill(void)
+{
+    int ret;
+
+    if (!__g_initialized) {
+        return -1;
+    }
+
+    xSemaphoreTake(__g_consumer_mutex, portMAX_DELAY);
+    ret = __spill_one_sector();
+    xSemaphoreGive(__g_consumer_mutex);
+    return ret;
+}
+
+void indicator_export_queue_get_stats(struct export_queue_stats *stats)
+{
+    xSemaphoreTake(__g_ram_mutex, portMAX_DELAY);
+    stats->ram_rows = __g_ram_count;
+    stats->flash_rows = __g_flash_rows;
+    stats->dropped = __g_dropped;
+    xSemaphoreGive(__g_ram_mutex);
+}
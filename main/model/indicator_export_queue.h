@@ -0,0 +1,68 @@
+#ifndef INDICATOR_EXPORT_QUEUE_H
+#define INDICATOR_EXPORT_QUEUE_H
+
+#include "config.h"
+#include "view_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Column order of an exported sample, matches the database schema */
+enum export_field {
+    EXPORT_FIELD_TEMP_INTERNAL,
+    EXPORT_FIELD_HUMIDITY_INTERNAL,
+    EXPORT_FIELD_CO2,
+    EXPORT_FIELD_TVOC,
+    EXPORT_FIELD_TEMP_EXTERNAL,
+    EXPORT_FIELD_HUMIDITY_EXTERNAL,
+    EXPORT_FIELD_PM1_0,
+    EXPORT_FIELD_PM2_5,
+    EXPORT_FIELD_PM10,
+    EXPORT_FIELD_NO2,
+    EXPORT_FIELD_C2H5OH,
+    EXPORT_FIELD_VOC,
+    EXPORT_FIELD_CO,
+    EXPORT_FIELD_MAX,
+};
+
+/* One sensor sample, stamped when it was taken (not when it was sent) */
+struct export_row {
+    int64_t timestamp;
+    float   values[EXPORT_FIELD_MAX];
+};
+
+struct export_queue_stats {
+    uint32_t ram_rows;      /* Rows waiting in PSRAM */
+    uint32_t flash_rows;    /* Rows spilled to the exportq partition */
+    uint32_t dropped;       /* Rows lost because both stores were full */
+};
+
+int indicator_export_queue_init(void);
+
+/* Fill a row from a sensor snapshot */
+void indicator_export_row_from_sensor(struct export_row *row, const struct view_data_sensor *data, time_t timestamp);
+
+/* Producer side - safe from any task */
+int indicator_export_queue_push(const struct export_row *row);
+
+/* Consumer side - a single task peeks the oldest rows, sends them and pops them once acknowledged */
+int indicator_export_queue_peek(struct export_row *rows, int max);
+/* Peek starting offset rows after the oldest one */
+int indicator_export_queue_peek_at(int offset, struct export_row *rows, int max);
+int indicator_export_queue_pop(int cnt);
+int indicator_export_queue_count(void);
+/* Absolute index of the oldest row, advanced by pops and by rows dropped when full */
+uint32_t indicator_export_queue_head(void);
+
+/* Move the oldest PSRAM rows to flash when PSRAM runs full. Call from the consumer task */
+bool indicator_export_queue_need_spill(void);
+int indicator_export_queue_spill(void);
+
+void indicator_export_queue_get_stats(struct export_queue_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,347 @@
+#include "indicator_influx.h"
+#include "indicator_export.h"
+#include "indicator_storage.h"
+#include "line_protocol.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <string.h>
+
+#define INFLUX_CFG_STORAGE      "influx-cfg"
+#define INFLUX_UDP_CFG_STORAGE  "influx-udp-cfg"
+
+/* Points of one HTTP write are built in a PSRAM buffer, one point is
+ * about 250 bytes so a full batch fits */
+#define INFLUX_BUF_SIZE         (32 * 1024)
+#define INFLUX_PATH_MAX         256
+
+static const char *TAG = "influx";
+
+static struct influx_config __g_config;
+static struct influx_udp_config __g_udp_config;
+static SemaphoreHandle_t __g_mutex;
+static bool __g_initialized = false;
+static volatile bool __g_reset = false;
+static volatile bool __g_udp_reset = false;
+
+static char *__g_buf;                   /* INFLUX_BUF_SIZE, PSRAM */
+static char __g_tags[32];               /* device=<mac>, identifies the sensor in shared buckets */
+static line_http_t __g_http = { .sock = -1 };
+static line_udp_t __g_udp = { .sock = -1 };
+
+/* Per round copies, the config may change while the export task sends */
+static struct influx_config __g_round;
+static struct influx_udp_config __g_udp_round;
+static char __g_path[INFLUX_PATH_MAX];
+static char __g_auth[sizeof(__g_config.token) + 8];
+
+/* ========== Configuration ========== */
+
+static void __config_copy(void *dst, const void *src, size_t size)
+{
+    xSemaphoreTake(__g_mutex, portMAX_DELAY);
+    memcpy(dst, src, size);
+    xSemaphoreGive(__g_mutex);
+}
+
+static void __config_restore(void)
+{
+    struct influx_config config;
+    struct influx_udp_config udp;
+    size_t len = sizeof(config);
+
+    if (indicator_storage_read(INFLUX_CFG_STORAGE, &config, &len) != ESP_OK || len != sizeof(config)) {
+        memset(&config, 0, sizeof(config));
+        config.port = 8086;
+        strncpy(config.bucket, "sensors", sizeof(config.bucket) - 1);
+        strncpy(config.measurement, "indicator", sizeof(config.measurement) - 1);
+    }
+
+    len = sizeof(udp);
+    if (indicator_storage_read(INFLUX_UDP_CFG_STORAGE, &udp, &len) != ESP_OK || len != sizeof(udp)) {
+        memset(&udp, 0, sizeof(udp));
+        udp.port = 8089;
+        strncpy(udp.measurement, "indicator", sizeof(udp.measurement) - 1);
+    }
+
+    ESP_LOGI(TAG, "Config restored: http enabled=%d host=%s:%d, udp enabled=%d host=%s:%d",
+             config.enabled, config.host, config.port, udp.enabled, udp.host, udp.port);
+    __config_copy(&__g_config, &config, sizeof(config));
+    __config_copy(&__g_udp_config, &udp, sizeof(udp));
+}
+
+/* Query string value, org names may contain spaces */
+static int __url_encode(char *dst, int size, const char *src)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    int len = 0;
+
+    for (; *src; src++) {
+        unsigned char c = *src;
+        bool plain = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                     c == '-' || c == '_' || c == '.' || c == '~';
+        if (len + (plain ? 1 : 3) >= size) {
+            return -1;
+        }
+        if (plain) {
+            dst[len++] = c;
+        } else {
+            dst[len++] = '%';
+            dst[len++] = hex[c >> 4];
+            dst[len++] = hex[c & 0x0f];
+        }
+    }
+    dst[len] = '\0';
+    return len;
+}
+
+/* Build points from rows until the buffer is full. Returns the bytes built,
+ * *used the rows consumed (rows without a reading are skipped) */
+static int __build_points(const char *measurement, const struct export_row *rows, int cnt,
+                          int max_len, bool nanoseconds, int *used)
+{
+    int len = 0;
+    int i;
+
+    for (i = 0; i < cnt; i++) {
+        int n = line_protocol_append(&__g_buf[len], max_len - len, measurement, __g_tags,
+                                     export_field_names, rows[i].values, export_field_precision,
+                                     EXPORT_FIELD_MAX, rows[i].timestamp, nanoseconds);
+        if (n < 0) {
+            break;
+        }
+        len += n;
+    }
+    *used = i;
+    return len;
+}
+
+/* ========== HTTP Sink ========== */
+
+static bool __http_enabled(void)
+{
+    return __g_config.enabled;
+}
+
+static int __http_begin(int pending)
+{
+    char bucket[3 * sizeof(__g_config.bucket)];
+    char org[3 * sizeof(__g_config.org)];
+    int len;
+
+    __config_copy(&__g_round, &__g_config, sizeof(__g_round));
+    if (__g_reset) {
+        __g_reset = false;
+        line_http_close(&__g_http);
+    }
+    if (strlen(__g_round.host) == 0 || strlen(__g_round.bucket) == 0) {
+        ESP_LOGE(TAG, "Export failed: no host or bucket configured");
+        return -1;
+    }
+
+    __url_encode(bucket, sizeof(bucket), __g_round.bucket);
+    if (__g_round.token[0]) {
+        __url_encode(org, sizeof(org), __g_round.org);
+        len = snprintf(__g_path, sizeof(__g_path), "/api/v2/write?org=%s&bucket=%s&precision=s", org, bucket);
+        snprintf(__g_auth, sizeof(__g_auth), "Token %s", __g_round.token);
+    } else {
+        len = snprintf(__g_path, sizeof(__g_path), "/write?db=%s&precision=s", bucket);
+        __g_auth[0] = '\0';
+    }
+    if (len >= (int)sizeof(__g_path)) {
+        ESP_LOGE(TAG, "Export failed: bucket or org name too long");
+        return -1;
+    }
+    return 0;
+}
+
+/* A 400 for points the server cannot take: a line-protocol parse error
+ * ("unable to parse ...", v1 and v2) or a v1 partial write (field type
+ * conflict), which has stored the rest of the batch already. Other 400s (a bad
+ * query parameter, an unknown org) are configuration errors, the rows stay */
+static bool __points_rejected(const char *reply)
+{
+    return strstr(reply, "unable to parse") != NULL || strstr(reply, "partial write") != NULL;
+}
+
+static int __http_send(const struct export_row *rows, int cnt, uint32_t *bytes)
+{
+    int used;
+    int len = __build_points(__g_round.measurement, rows, cnt, INFLUX_BUF_SIZE, false, &used);
+
+    if (used == 0) {
+        ESP_LOGE(TAG, "Point does not fit the buffer");
+        return -1;
+    }
+    if (len == 0) {
+        /* Only rows without readings, nothing to write */
+        return used;
+    }
+
+    int status = line_http_post(&__g_http, __g_round.host, __g_round.port, __g_path, __g_auth, __g_buf, len);
+    if (status >= 200 && status < 300) {
+        *bytes = len;
+        return used;
+    }
+    if (status == 400 && __points_rejected(__g_http.reply)) {
+        /* Rejected points would be rejected again, drop them instead of blocking the queue */
+        ESP_LOGW(TAG, "Server rejected %d points, dropped: %s", used, __g_http.reply);
+        *bytes = len;
+        return used;
+    }
+
+    ESP_LOGE(TAG, "Write failed: %s %d %s", status < 0 ? "connection error" : "HTTP", status, __g_http.reply);
+    line_http_close(&__g_http);
+    return status < 0 ? -2 : -4;
+}
+
+static void __http_idle(void)
+{
+    if (!__g_config.enabled || __g_reset) {
+        __g_reset = false;
+        line_http_close(&__g_http);
+    }
+}
+
+static struct export_sink __g_http_sink = {
+    .name = "influx",
+    .enabled = __http_enabled,
+    .begin = __http_begin,
+    .send = __http_send,
+    .idle = __http_idle,
+};
+
+/* ========== UDP Sink ========== */
+
+static bool __udp_enabled(void)
+{
+    return __g_udp_config.enabled;
+}
+
+static int __udp_begin(int pending)
+{
+    __config_copy(&__g_udp_round, &__g_udp_config, sizeof(__g_udp_round));
+    if (__g_udp_reset) {
+        __g_udp_reset = false;
+        line_udp_close(&__g_udp);
+    }
+    if (strlen(__g_udp_round.host) == 0) {
+        ESP_LOGE(TAG, "UDP export failed: no host configured");
+        return -1;
+    }
+    /* Resolved once, again after a config change or a send error */
+    if (__g_udp.sock < 0 && line_udp_open(&__g_udp, __g_udp_round.host, __g_udp_round.port) < 0) {
+        return -2;
+    }
+    return 0;
+}
+
+/* One datagram per call, as many points as fit. There is no acknowledgement,
+ * rows count as delivered once the stack took them */
+static int __udp_send(const struct export_row *rows, int cnt, uint32_t *bytes)
+{
+    int used;
+    int len = __build_points(__g_udp_round.measurement, rows, cnt, LINE_UDP_PAYLOAD_MAX, true, &used);
+
+    if (used == 0) {
+        ESP_LOGE(TAG, "Point does not fit a datagram");
+        return -1;
+    }
+    if (len > 0 && line_udp_send(&__g_udp, __g_buf, len) < 0) {
+        line_udp_close(&__g_udp);
+        return -2;
+    }
+    *bytes = len;
+    return used;
+}
+
+static void __udp_idle(void)
+{
+    if (!__g_udp_config.enabled || __g_udp_reset) {
+        __g_udp_reset = false;
+        line_udp_close(&__g_udp);
+    }
+}
+
+static struct export_sink __g_udp_sink = {
+    .name = "influx-udp",
+    .enabled = __udp_enabled,
+    .begin = __udp_begin,
+    .send = __udp_send,
+    .idle = __udp_idle,
+};
+
+/* ========== Public API ========== */
+
+int indicator_influx_init(void)
+{
+    if (__g_initialized) {
+        return 0;
+    }
+
+    __g_mutex = xSemaphoreCreateMutex();
+    __g_buf = heap_caps_malloc(INFLUX_BUF_SIZE, MALLOC_CAP_SPIRAM);
+    if (!__g_mutex || !__g_buf) {
+        ESP_LOGE(TAG, "Failed to allocate");
+        return -1;
+    }
+
+    strcpy(__g_tags, "device=");
+    line_protocol_escape(&__g_tags[7], sizeof(__g_tags) - 7, indicator_export_device_id(), true);
+
+    __config_restore();
+
+    if (indicator_export_register(&__g_http_sink) != 0 ||
+        indicator_export_register(&__g_udp_sink) != 0) {
+        ESP_LOGE(TAG, "Failed to register export sinks");
+        return -1;
+    }
+
+    __g_initialized = true;
+    ESP_LOGI(TAG, "InfluxDB module initialized");
+    return 0;
+}
+
+int indicator_influx_get_config(struct influx_config *config)
+{
+    if (!config) return -1;
+    __config_copy(config, &__g_config, sizeof(*config));
+    return 0;
+}
+
+int indicator_influx_set_config(const struct influx_config *config)
+{
+    if (!config) return -1;
+
+    __config_copy(&__g_config, config, sizeof(*config));
+    if (indicator_storage_write(INFLUX_CFG_STORAGE, (void *)config, sizeof(*config)) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save config");
+        return -1;
+    }
+    __g_reset = true;
+    indicator_export_kick();
+    return 0;
+}
+
+int indicator_influx_udp_get_config(struct influx_udp_config *config)
+{
+    if (!config) return -1;
+    __config_copy(config, &__g_udp_config, sizeof(*config));
+    return 0;
+}
+
+int indicator_influx_udp_set_config(const struct influx_udp_config *config)
+{
+    if (!config) return -1;
+
+    __config_copy(&__g_udp_config, config, sizeof(*config));
+    if (indicator_storage_write(INFLUX_UDP_CFG_STORAGE, (void *)config, sizeof(*config)) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to save config");
+        return -1;
+    }
+    __g_udp_reset = true;
+    indicator_export_kick();
+    return 0;
+}
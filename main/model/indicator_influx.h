@@ -0,0 +1,44 @@
+#ifndef INDICATOR_INFLUX_H
+#define INDICATOR_INFLUX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* InfluxDB HTTP write configuration. With a token the v2 API is used
+ * (org + bucket), without one the v1 /write endpoint (database) */
+struct influx_config {
+    bool enabled;
+    char host[64];
+    uint16_t port;
+    char bucket[32];            /* v2 bucket, or the v1 database */
+    char org[32];               /* v2 only */
+    char token[96];             /* v2 API token, empty for v1 */
+    char measurement[32];
+};
+
+/* UDP line protocol configuration (InfluxDB/Telegraf UDP listener) */
+struct influx_udp_config {
+    bool enabled;
+    char host[64];
+    uint16_t port;
+    char measurement[32];
+};
+
+/* Initialize both sinks, after indicator_export_init() */
+int indicator_influx_init(void);
+
+int indicator_influx_get_config(struct influx_config *config);
+int indicator_influx_set_config(const struct influx_config *config);
+
+int indicator_influx_udp_get_config(struct influx_udp_config *config);
+int indicator_influx_udp_set_config(const struct influx_udp_config *config);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
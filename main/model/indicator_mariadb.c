@@ -1,48 +1,147 @@
 #include "indicator_mariadb.h"
+#include "indicator_export.h"
 #include "indicator_sensor.h"
 #include "indicator_storage.h"
 #include "indicator_wifi.h"
+#include "indicator_store.h"
+#include "mysql_client.h"
 #include "esp_log.h"
+#include "esp_event.h"
 #include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
 #include "freertos/semphr.h"
-#include "lwip/sockets.h"
-#include "lwip/netdb.h"
-#include "mbedtls/sha1.h"
+#include <math.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
 #define MARIADB_CFG_STORAGE  "mariadb-cfg"
-#define MYSQL_TIMEOUT_SEC    10
-#define MARIADB_TASK_STACK   (8 * 1024)  /* 8KB stack for DB operations */
+#define MARIADB_AGG_STORAGE  "mariadb-agg"   /* start of the last bucket the server acknowledged */
+#define MARIADB_QUERY_BUF_SIZE   1024
+
+/* Queued rows are sent as multi-row INSERTs built in a PSRAM buffer. The
+ * statement is also capped by the server's max_allowed_packet */
+#define MARIADB_TX_BUF_SIZE      (16 * 1024)
+#define MARIADB_ROW_TEXT_MAX     256
+
+/* Rows are sent with COM_STMT_EXECUTE and binary parameters, prepared once
+ * per session. Set to 0 to compare against the text INSERT path */
+#define MARIADB_USE_PREPARED      1
+#define MARIADB_STMT_BATCH_ROWS   16     /* rows bound by the multi-row statement */
+#define MARIADB_STMT_PARAMS       (EXPORT_FIELD_MAX + 1)   /* timestamp + values */
+
+/* Compressed protocol for large statements, see MYSQL_COMPRESS_MIN. The
+ * deflate state and frame buffers are allocated in PSRAM once. Set to 0 to
+ * compare bytes on the wire and upload time without it */
+#define MARIADB_USE_COMPRESS      1
+#define MARIADB_ZFRAME_SIZE       (MARIADB_TX_BUF_SIZE + 64)
+
+/* History aggregates are upserted into <table>_agg keyed by (device, bucket),
+ * this many buckets per statement */
+#define MARIADB_AGG_BATCH        16
+#define MARIADB_AGG_ROW_TEXT_MAX 1024
+
+/* Session keep-alive: an idle session is checked with COM_PING before reuse,
+ * TCP keep-alive (see mysql_client.c) catches peers that vanish between exports */
+#define MARIADB_PING_IDLE_SEC    30
+
+/* Reconnect backoff after a failed connect: 5s, 10s, 20s ... capped at 5min */
+#define MARIADB_BACKOFF_MIN_MS   5000
+#define MARIADB_BACKOFF_MAX_MS   (5 * 60 * 1000)
 
 static const char *TAG = "mariadb";
 
 static struct mariadb_config __g_config;
 static SemaphoreHandle_t __g_mutex;
-static esp_timer_handle_t __g_export_timer;
 static int __g_last_status = 0;
 static time_t __g_last_export_time = 0;
 static bool __g_initialized = false;
 static volatile bool __g_test_pending = false;
-static volatile bool __g_export_pending = false;
-static TaskHandle_t __g_db_task_handle = NULL;
-
-/* Forward declarations */
-static void __export_timer_callback(void *arg);
-static int __do_export(void);
-
-/* MySQL Protocol Constants */
-#define MYSQL_PACKET_HEADER_SIZE 4
-#define MYSQL_MAX_PACKET_SIZE    1024
+static volatile uint32_t __g_test_gen;      /* operation number of the pending test */
+static uint32_t __g_gen_last;               /* last operation number handed out */
+static volatile bool __g_session_reset = false;
+static volatile bool __g_agg_resend = false;
+static struct mariadb_stats __g_stats;
+
+/* Config layout before the tls flag, still found in NVS after an update */
+struct mariadb_config_v1 {
+    bool enabled;
+    char host[64];
+    uint16_t port;
+    char user[32];
+    char password[64];
+    char database[32];
+    char table[32];
+    uint16_t interval_minutes;
+};
+
+/* Config layout before the certificate pin */
+struct mariadb_config_v2 {
+    struct mariadb_config_v1 v1;
+    bool tls;
+};
+
+/* Server-side prepared INSERT */
+struct mariadb_stmt
+{
+    uint32_t id;
+    uint16_t rows;               /* rows bound per execute, 0 = not prepared */
+    bool     types_sent;         /* parameter types are only sent with the first execute */
+};
 
-/* Simple MySQL packet structure */
-typedef struct {
-    uint8_t data[MYSQL_MAX_PACKET_SIZE];
-    int length;
-    uint8_t sequence;
-} mysql_packet_t;
+/* Long-lived server session, only touched from the export task */
+struct mariadb_session
+{
+    mysql_conn_t conn;
+    bool     schema_ready;       /* CREATE TABLE already sent on this session */
+    int64_t  last_used_us;
+    uint32_t backoff_ms;
+    int64_t  next_retry_us;      /* no reconnect attempt before this time */
+    uint32_t max_packet;         /* server max_allowed_packet */
+    struct mariadb_stmt stmt_single;
+    struct mariadb_stmt stmt_batch;
+    /* Config the session was opened with, a change forces a reconnect */
+    char     host[64];
+    uint16_t port;
+    char     user[32];
+    char     password[64];
+    char     database[32];
+    char     table[32];
+    bool     tls;
+    char     tls_pin[96];
+};
+
+static void __status_phase(int phase);
+
+/* TLS config and the cached session, kept across reconnects */
+static mysql_tls_t __g_tls;
+static mysql_zstream_t __g_zstream;
+
+/* Current export round */
+static bool     __g_round_test;
+static int64_t  __g_round_start_us;
+static size_t   __g_round_heap;
+
+/* Upload of the current backlog, reported once the queue is empty */
+static int64_t  __g_backlog_start_us;
+static uint32_t __g_backlog_rows;
+static uint32_t __g_backlog_packet_bytes;
+static uint32_t __g_backlog_wire_bytes;
+
+static struct mariadb_session __g_session = {
+    .conn.sock = -1,
+    .conn.on_phase = __status_phase,
+    .conn.tls = &__g_tls,
+};
+
+/* Query text is built in place, one buffer per task instead of a malloc per export */
+static char __g_query_buf[MARIADB_QUERY_BUF_SIZE];
+static uint8_t *__g_tx_buf;                 /* MARIADB_TX_BUF_SIZE, PSRAM */
+
+static struct sensor_bucket *__g_agg_buckets;  /* MARIADB_AGG_BATCH, PSRAM */
+static int64_t __g_agg_acked;               /* persisted in MARIADB_AGG_STORAGE */
+static const char *const __g_agg_suffix[] = { "avg", "min", "max", "cnt" };
 
 static void __config_get(struct mariadb_config *config)
 {
@@ -80,9 +179,19 @@ static int __config_restore(void)
     size_t len = sizeof(config);
 
     ret = indicator_storage_read(MARIADB_CFG_STORAGE, &config, &len);
+    if (ret == ESP_OK && len == sizeof(struct mariadb_config_v1)) {
+        /* Saved before TLS support: the same fields up front, plain connection */
+        config.tls = false;
+        len = sizeof(struct mariadb_config_v2);
+    }
+    if (ret == ESP_OK && len == sizeof(struct mariadb_config_v2)) {
+        /* Saved before the pin: verify against the CA bundle */
+        config.tls_pin[0] = '\0';
+        len = sizeof(config);
+    }
     if (ret == ESP_OK && len == sizeof(config)) {
-        ESP_LOGI(TAG, "Config restored: enabled=%d, host=%s, port=%d, interval=%d min",
-                 config.enabled, config.host, config.port, config.interval_minutes);
+        ESP_LOGI(TAG, "Config restored: enabled=%d, host=%s, port=%d, interval=%d min, tls=%d",
+                 config.enabled, config.host, config.port, config.interval_minutes, config.tls);
         __config_set(&config);
         return 0;
     }
@@ -102,374 +211,587 @@ static int __config_restore(void)
     return 0;
 }
 
-static void __update_timer(void)
+/* The sampling interval is this module's setting; other sinks share it */
+static void __update_interval(void)
 {
     struct mariadb_config config;
     __config_get(&config);
+    indicator_export_set_interval(config.interval_minutes);
+}
 
-    if (__g_export_timer) {
-        esp_timer_stop(__g_export_timer);
-    }
+/* ========== Status ========== */
 
-    if (config.enabled && config.interval_minutes > 0) {
-        uint64_t interval_us = (uint64_t)config.interval_minutes * 60 * 1000000;
-        esp_timer_start_periodic(__g_export_timer, interval_us);
-        ESP_LOGI(TAG, "Export timer started: every %d minutes", config.interval_minutes);
-    } else {
-        ESP_LOGI(TAG, "Export timer stopped (disabled)");
-    }
+/* The view reads it from the store, at most once per frame */
+static void __status_post(int status, int phase)
+{
+    struct view_data_db_status st;
+
+    memset(&st, 0, sizeof(st));     /* padding too, the store compares words */
+    st.status = status;
+    st.phase = phase;
+    st.is_test = __g_test_pending;
+    st.last_export = __g_last_export_time;
+    indicator_store_publish(STORE_TOPIC_DB_STATUS, &st, sizeof(st));
 }
 
-/* ========== MySQL Protocol Implementation ========== */
+static void __status_phase(int phase)
+{
+    int db_phase = DB_PHASE_IDLE;
+    switch (phase) {
+        case MYSQL_PHASE_RESOLVE:   db_phase = DB_PHASE_RESOLVE; break;
+        case MYSQL_PHASE_CONNECT:   db_phase = DB_PHASE_CONNECT; break;
+        case MYSQL_PHASE_HANDSHAKE: db_phase = DB_PHASE_HANDSHAKE; break;
+        case MYSQL_PHASE_QUERY:     db_phase = DB_PHASE_QUERY; break;
+    }
+    __status_post(-99, db_phase);
+}
 
-static int mysql_read_packet(int sock, mysql_packet_t *pkt)
+/* Error code for a failed connection operation */
+static int __conn_status(int fallback)
 {
-    uint8_t header[4];
-    int n = recv(sock, header, 4, 0);
-    if (n != 4) {
-        ESP_LOGE(TAG, "Failed to read packet header");
-        return -1;
+    switch (__g_session.conn.error) {
+        case MYSQL_CONN_ERR_TIMEOUT:   return -5;
+        case MYSQL_CONN_ERR_CANCELLED: return -6;
+        case MYSQL_CONN_ERR_CERT:      return -7;
+        default:                       return fallback;
     }
+}
 
-    pkt->length = header[0] | (header[1] << 8) | (header[2] << 16);
-    pkt->sequence = header[3];
+static int __create_agg_table(const char *table);
 
-    if (pkt->length > MYSQL_MAX_PACKET_SIZE - 4) {
-        ESP_LOGE(TAG, "Packet too large: %d", pkt->length);
-        return -1;
-    }
+/* Number for the next export round or test, the target of a cancel */
+static uint32_t __gen_alloc(void)
+{
+    uint32_t gen;
 
-    n = recv(sock, pkt->data, pkt->length, 0);
-    if (n != pkt->length) {
-        ESP_LOGE(TAG, "Failed to read packet data");
-        return -1;
+    xSemaphoreTake(__g_mutex, portMAX_DELAY);
+    if (++__g_gen_last == 0) {
+        __g_gen_last = 1;                   /* 0 is never cancelled */
     }
-
-    return 0;
+    gen = __g_gen_last;
+    xSemaphoreGive(__g_mutex);
+    return gen;
 }
 
-static int mysql_send_packet(int sock, const uint8_t *data, int len, uint8_t seq)
-{
-    uint8_t header[4];
-    header[0] = len & 0xFF;
-    header[1] = (len >> 8) & 0xFF;
-    header[2] = (len >> 16) & 0xFF;
-    header[3] = seq;
+/* ========== Session Management ========== */
 
-    if (send(sock, header, 4, 0) != 4) return -1;
-    if (send(sock, data, len, 0) != len) return -1;
-    return 0;
+static bool __session_matches(const struct mariadb_config *config)
+{
+    return strcmp(__g_session.host, config->host) == 0 &&
+           __g_session.port == config->port &&
+           strcmp(__g_session.user, config->user) == 0 &&
+           strcmp(__g_session.password, config->password) == 0 &&
+           strcmp(__g_session.database, config->database) == 0 &&
+           strcmp(__g_session.table, config->table) == 0 &&
+           __g_session.tls == config->tls &&
+           strcmp(__g_session.tls_pin, config->tls_pin) == 0;
 }
 
-/* Native password auth (mysql_native_password) - SHA1 based
- * Algorithm: SHA1(password) XOR SHA1(scramble + SHA1(SHA1(password)))
- */
-static void mysql_native_auth(const char *password, const uint8_t *scramble, uint8_t *out)
+static void __session_close(const char *reason)
 {
-    uint8_t stage1[20];  /* SHA1(password) */
-    uint8_t stage2[20];  /* SHA1(stage1) */
-    uint8_t combined[40]; /* scramble (20) + stage2 (20) */
-    uint8_t stage3[20];  /* SHA1(combined) */
-
-    /* Stage 1: SHA1(password) */
-    mbedtls_sha1((const unsigned char *)password, strlen(password), stage1);
+    if (__g_session.conn.sock >= 0) {
+        ESP_LOGI(TAG, "Closing session: %s", reason);
+        mysql_quit(&__g_session.conn);
+        mysql_conn_close(&__g_session.conn);
+    }
+    __g_session.schema_ready = false;
+    memset(&__g_session.stmt_single, 0, sizeof(__g_session.stmt_single));
+    memset(&__g_session.stmt_batch, 0, sizeof(__g_session.stmt_batch));
+}
 
-    /* Stage 2: SHA1(SHA1(password)) */
-    mbedtls_sha1(stage1, 20, stage2);
+static void __session_backoff(void)
+{
+    if (__g_session.backoff_ms == 0) {
+        __g_session.backoff_ms = MARIADB_BACKOFF_MIN_MS;
+    } else if (__g_session.backoff_ms < MARIADB_BACKOFF_MAX_MS) {
+        __g_session.backoff_ms *= 2;
+        if (__g_session.backoff_ms > MARIADB_BACKOFF_MAX_MS) {
+            __g_session.backoff_ms = MARIADB_BACKOFF_MAX_MS;
+        }
+    }
+    __g_session.next_retry_us = esp_timer_get_time() + (int64_t)__g_session.backoff_ms * 1000;
+    ESP_LOGW(TAG, "Next reconnect attempt in %lu ms", (unsigned long)__g_session.backoff_ms);
+}
 
-    /* Combine: scramble + stage2 */
-    memcpy(combined, scramble, 20);
-    memcpy(combined + 20, stage2, 20);
+/* Prepare an INSERT binding `rows` rows */
+static void __session_prepare_stmt(const char *table, struct mariadb_stmt *stmt, int rows)
+{
+    uint32_t stmt_id;
+    int len;
 
-    /* Stage 3: SHA1(scramble + stage2) */
-    mbedtls_sha1(combined, 40, stage3);
+    len = snprintf(__g_query_buf, sizeof(__g_query_buf),
+        "INSERT INTO %s (timestamp,temp_internal,humidity_internal,co2,tvoc,"
+        "temp_external,humidity_external,pm1_0,pm2_5,pm10,"
+        "no2_ppm,c2h5oh_ppm,voc_ppm,co_ppm) VALUES ", table);
+    for (int r = 0; r < rows && len < (int)sizeof(__g_query_buf); r++) {
+        len += snprintf(&__g_query_buf[len], sizeof(__g_query_buf) - len,
+                        "%s(?,?,?,?,?,?,?,?,?,?,?,?,?,?)", r ? "," : "");
+    }
+    if (len >= (int)sizeof(__g_query_buf)) {
+        return;
+    }
 
-    /* Result: stage1 XOR stage3 */
-    for (int i = 0; i < 20; i++) {
-        out[i] = stage1[i] ^ stage3[i];
+    if (mysql_stmt_prepare(&__g_session.conn, __g_query_buf, &stmt_id) != rows * MARIADB_STMT_PARAMS) {
+        ESP_LOGW(TAG, "Prepare of %d-row INSERT failed, using text queries", rows);
+        return;
     }
+    stmt->id = stmt_id;
+    stmt->rows = rows;
+    stmt->types_sent = false;
 }
 
-static int mysql_connect(const char *host, uint16_t port, const char *user,
-                         const char *password, const char *database)
+/* Make sure a live, authenticated session with the table in place exists.
+ * Reuses the open session when possible, otherwise reconnects.
+ * force: ignore the reconnect backoff (user-triggered test) */
+static int __session_ensure(const struct mariadb_config *config, bool force)
 {
-    struct sockaddr_in server_addr;
-    struct hostent *server;
-    int sock;
-    mysql_packet_t pkt;
+    int64_t now_us = esp_timer_get_time();
 
-    /* Resolve hostname */
-    server = gethostbyname(host);
-    if (!server) {
-        ESP_LOGE(TAG, "DNS lookup failed for %s", host);
-        return -1;
+    if (__g_session_reset) {
+        __g_session_reset = false;
+        __g_session.backoff_ms = 0;
+        __g_session.next_retry_us = 0;
+        __session_close("config changed");
     }
 
-    /* Create socket */
-    sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        ESP_LOGE(TAG, "Socket creation failed");
-        return -1;
+    if (__g_session.conn.sock >= 0 && !__session_matches(config)) {
+        __session_close("config changed");
     }
 
-    /* Set timeout */
-    struct timeval tv;
-    tv.tv_sec = MYSQL_TIMEOUT_SEC;
-    tv.tv_usec = 0;
-    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
-    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
-
-    /* Connect */
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    memcpy(&server_addr.sin_addr.s_addr, server->h_addr, server->h_length);
-
-    if (connect(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-        ESP_LOGE(TAG, "Connection failed to %s:%d", host, port);
-        close(sock);
-        return -1;
+    if (__g_session.conn.sock >= 0 &&
+        (now_us - __g_session.last_used_us) > (int64_t)MARIADB_PING_IDLE_SEC * 1000000) {
+        __g_stats.pings++;
+        if (mysql_ping(&__g_session.conn) != 0) {
+            ESP_LOGW(TAG, "Session ping failed");
+            __session_close("ping failed");
+        }
     }
 
-    ESP_LOGI(TAG, "Connected to MySQL server %s:%d", host, port);
+    if (__g_session.conn.sock < 0) {
+        if (!force && now_us < __g_session.next_retry_us) {
+            ESP_LOGW(TAG, "Reconnect backoff active, skipping");
+            return -3;
+        }
 
-    /* Read initial handshake packet */
-    if (mysql_read_packet(sock, &pkt) < 0) {
-        close(sock);
-        return -1;
-    }
+        ESP_LOGI(TAG, "Connecting to %s:%d as %s%s...", config->host, config->port, config->user,
+                 config->tls ? " (TLS)" : "");
+        if (strcmp(__g_session.host, config->host) != 0 || __g_session.port != config->port) {
+            /* A cached TLS session is only worth offering to the server that issued it */
+            mysql_tls_forget(&__g_tls);
+        }
+        mysql_tls_pin(&__g_tls, config->tls_pin);   /* checked by set_config */
+        __g_session.conn.use_tls = config->tls;
+        __g_stats.handshakes++;
+        if (mysql_connect(&__g_session.conn, config->host, config->port, config->user,
+                          config->password, config->database) < 0) {
+            ESP_LOGE(TAG, "MySQL connection failed to %s:%d", config->host, config->port);
+            __session_backoff();
+            return __conn_status(-3);
+        }
 
-    /* Check for error */
-    if (pkt.data[0] == 0xFF) {
-        ESP_LOGE(TAG, "Server error during handshake");
-        close(sock);
-        return -1;
+        __g_session.conn.error = MYSQL_CONN_OK;
+        __g_session.schema_ready = false;
+        __g_session.backoff_ms = 0;
+        __g_session.next_retry_us = 0;
+        strlcpy(__g_session.host, config->host, sizeof(__g_session.host));
+        __g_session.port = config->port;
+        strlcpy(__g_session.user, config->user, sizeof(__g_session.user));
+        strlcpy(__g_session.password, config->password, sizeof(__g_session.password));
+        strlcpy(__g_session.database, config->database, sizeof(__g_session.database));
+        strlcpy(__g_session.table, config->table, sizeof(__g_session.table));
+        __g_session.tls = config->tls;
+        strlcpy(__g_session.tls_pin, config->tls_pin, sizeof(__g_session.tls_pin));
+        if (__g_session.conn.tls_active) {
+            if (__g_tls.resumed) {
+                __g_stats.tls_resumed++;
+                __g_stats.tls_resumed_us += __g_tls.handshake_us;
+            } else {
+                __g_stats.tls_full++;
+                __g_stats.tls_full_us += __g_tls.handshake_us;
+            }
+        }
+        ESP_LOGI(TAG, "Connected successfully! (handshake #%lu)", (unsigned long)__g_stats.handshakes);
     }
 
-    /* Parse handshake - extract scramble (auth data) */
-    uint8_t protocol_version = pkt.data[0];
-    ESP_LOGI(TAG, "MySQL protocol version: %d", protocol_version);
-
-    /* Find end of server version string */
-    int i = 1;
-    while (i < pkt.length && pkt.data[i] != 0) i++;
-    i++; /* Skip null terminator */
-
-    /* Skip connection id (4 bytes) */
-    i += 4;
-
-    /* Auth plugin data part 1 (8 bytes) */
-    uint8_t scramble[20];
-    memset(scramble, 0, sizeof(scramble));
-    memcpy(scramble, &pkt.data[i], 8);
-    i += 8;
-
-    /* Skip filler (1 byte) */
-    i++;
-
-    /* Capability flags lower 2 bytes */
-    uint32_t server_caps = pkt.data[i] | (pkt.data[i+1] << 8);
-    i += 2;
-
-    /* If there's more data, parse extended handshake */
-    if (i < pkt.length) {
-        /* Character set (1 byte) */
-        i++;
-        /* Status flags (2 bytes) */
-        i += 2;
-        /* Capability flags upper 2 bytes */
-        server_caps |= (pkt.data[i] | (pkt.data[i+1] << 8)) << 16;
-        i += 2;
-        /* Auth plugin data length or 0 (1 byte) */
-        int auth_plugin_data_len = pkt.data[i];
-        i++;
-        /* Reserved (10 bytes) */
-        i += 10;
-        /* Auth plugin data part 2 (rest of scramble, 12 bytes typically) */
-        if (auth_plugin_data_len > 8 && i + 12 <= pkt.length) {
-            memcpy(scramble + 8, &pkt.data[i], 12);
+    /* Schema setup runs once per session */
+    if (!__g_session.schema_ready) {
+        snprintf(__g_query_buf, sizeof(__g_query_buf),
+            "CREATE TABLE IF NOT EXISTS %s ("
+            "id INT AUTO_INCREMENT PRIMARY KEY,"
+            "timestamp BIGINT NOT NULL,"
+            "received_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
+            "temp_internal FLOAT,humidity_internal FLOAT,"
+            "co2 FLOAT,tvoc FLOAT,"
+            "temp_external FLOAT,humidity_external FLOAT,"
+            "pm1_0 FLOAT,pm2_5 FLOAT,pm10 FLOAT,"
+            "no2_ppm FLOAT,c2h5oh_ppm FLOAT,voc_ppm FLOAT,co_ppm FLOAT"
+            ")", config->table);
+
+        if (mysql_query(&__g_session.conn, __g_query_buf) < 0) {
+            ESP_LOGW(TAG, "Create table query failed (may already exist)");
+        }
+        if (__create_agg_table(config->table) < 0) {
+            ESP_LOGW(TAG, "Create aggregate table query failed (may already exist)");
+        }
+
+        /* Batches must fit the server's packet limit */
+        char value[24];
+        __g_session.max_packet = MARIADB_QUERY_BUF_SIZE;
+        if (mysql_query_scalar(&__g_session.conn, "SELECT @@max_allowed_packet", value, sizeof(value)) == 0) {
+            uint32_t max_packet = strtoul(value, NULL, 10);
+            if (max_packet > __g_session.max_packet) {
+                __g_session.max_packet = max_packet;
+            }
+        }
+        ESP_LOGI(TAG, "Server max_allowed_packet: %lu", (unsigned long)__g_session.max_packet);
+
+        /* Statements live as long as the session */
+        if (MARIADB_USE_PREPARED) {
+            __session_prepare_stmt(config->table, &__g_session.stmt_single, 1);
+            __session_prepare_stmt(config->table, &__g_session.stmt_batch, MARIADB_STMT_BATCH_ROWS);
+        }
+        /* A timeout or cancel leaves a response half read */
+        if (__g_session.conn.error != MYSQL_CONN_OK) {
+            int status = __conn_status(-3);
+            __session_close("setup interrupted");
+            return status;
         }
+        __g_session.schema_ready = true;
     }
 
-    ESP_LOGI(TAG, "Server capabilities: 0x%08lx", (unsigned long)server_caps);
+    __g_session.last_used_us = esp_timer_get_time();
+    return 0;
+}
 
-    /* Build handshake response */
-    uint8_t response[512];
-    int resp_len = 0;
+static int __append_value(char *buf, int size, float value, int precision)
+{
+    /* NaN/Inf would make the whole batch fail to parse */
+    if (!isfinite(value)) {
+        return snprintf(buf, size, ",NULL");
+    }
+    return snprintf(buf, size, ",%.*f", precision, value);
+}
 
-    /* Client capabilities (4 bytes) */
-    uint32_t client_caps = 0x000FA685; /* CLIENT_PROTOCOL_41 + CLIENT_SECURE_CONNECTION + others */
-    if (database && strlen(database) > 0) {
-        client_caps |= 0x00000008; /* CLIENT_CONNECT_WITH_DB */
+/* Build one multi-row INSERT into __g_tx_buf, as many rows as fit the packet limit.
+ * Returns the number of rows taken, *query_len the statement length */
+static int __build_batch(const char *table, const struct export_row *rows, int cnt, int *query_len)
+{
+    char *query = (char *)&__g_tx_buf[1];
+    int limit = MARIADB_TX_BUF_SIZE - 1;
+    char row_text[MARIADB_ROW_TEXT_MAX];
+    int len;
+    int taken = 0;
+
+    if (__g_session.max_packet - 1 < (uint32_t)limit) {
+        limit = __g_session.max_packet - 1;
     }
-    client_caps |= 0x00080000; /* CLIENT_PLUGIN_AUTH */
-    response[resp_len++] = client_caps & 0xFF;
-    response[resp_len++] = (client_caps >> 8) & 0xFF;
-    response[resp_len++] = (client_caps >> 16) & 0xFF;
-    response[resp_len++] = (client_caps >> 24) & 0xFF;
 
-    /* Max packet size (4 bytes) */
-    response[resp_len++] = 0x00;
-    response[resp_len++] = 0x00;
-    response[resp_len++] = 0x00;
-    response[resp_len++] = 0x01; /* 16MB */
+    len = snprintf(query, limit,
+        "INSERT INTO %s (timestamp,temp_internal,humidity_internal,co2,tvoc,"
+        "temp_external,humidity_external,pm1_0,pm2_5,pm10,"
+        "no2_ppm,c2h5oh_ppm,voc_ppm,co_ppm) VALUES ", table);
+    if (len <= 0 || len >= limit) {
+        return 0;
+    }
 
-    /* Character set (1 byte) - utf8mb4 */
-    response[resp_len++] = 45; /* utf8mb4_general_ci */
+    for (taken = 0; taken < cnt; taken++) {
+        int n = snprintf(row_text, sizeof(row_text), "%s(%lld", taken ? "," : "",
+                         (long long)rows[taken].timestamp);
+        for (int i = 0; i < EXPORT_FIELD_MAX; i++) {
+            n += __append_value(&row_text[n], sizeof(row_text) - n, rows[taken].values[i], export_field_precision[i]);
+        }
+        n += snprintf(&row_text[n], sizeof(row_text) - n, ")");
+        if (len + n >= limit) {
+            break;
+        }
+        memcpy(&query[len], row_text, n);
+        len += n;
+    }
 
-    /* Reserved (23 bytes) */
-    memset(&response[resp_len], 0, 23);
-    resp_len += 23;
+    *query_len = len;
+    return taken;
+}
 
-    /* Username (null terminated) */
-    strcpy((char *)&response[resp_len], user);
-    resp_len += strlen(user) + 1;
+static uint8_t *__put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+    return p + 4;
+}
 
-    /* Password - use mysql_native_password auth */
-    if (password && strlen(password) > 0) {
-        uint8_t auth_response[20];
-        mysql_native_auth(password, scramble, auth_response);
-        response[resp_len++] = 20;  /* Length of auth response */
-        memcpy(&response[resp_len], auth_response, 20);
-        resp_len += 20;
-    } else {
-        response[resp_len++] = 0;
+/* Build COM_STMT_EXECUTE for stmt->rows rows into __g_tx_buf, returns its length */
+static int __build_stmt_execute(const struct mariadb_stmt *stmt, const struct export_row *rows)
+{
+    int params = stmt->rows * MARIADB_STMT_PARAMS;
+    int bitmap_len = (params + 7) / 8;
+    uint8_t *p = __g_tx_buf;
+    uint8_t *null_bitmap;
+
+    *p++ = 0x17;                    /* COM_STMT_EXECUTE */
+    p = __put_le32(p, stmt->id);
+    *p++ = 0x00;                    /* CURSOR_TYPE_NO_CURSOR */
+    p = __put_le32(p, 1);           /* iteration count */
+
+    null_bitmap = p;
+    memset(null_bitmap, 0, bitmap_len);
+    p += bitmap_len;
+
+    /* new-params-bound flag, then (type, unsigned) per parameter */
+    *p++ = stmt->types_sent ? 0 : 1;
+    if (!stmt->types_sent) {
+        for (int r = 0; r < stmt->rows; r++) {
+            *p++ = 0x08;            /* MYSQL_TYPE_LONGLONG */
+            *p++ = 0x00;
+            for (int i = 0; i < EXPORT_FIELD_MAX; i++) {
+                *p++ = 0x04;        /* MYSQL_TYPE_FLOAT */
+                *p++ = 0x00;
+            }
+        }
     }
 
-    /* Database (if specified) */
-    if (database && strlen(database) > 0) {
-        strcpy((char *)&response[resp_len], database);
-        resp_len += strlen(database) + 1;
+    /* Values, little endian like the ESP32 itself. NULL parameters send no value */
+    for (int r = 0; r < stmt->rows; r++) {
+        int param = r * MARIADB_STMT_PARAMS;
+        memcpy(p, &rows[r].timestamp, 8);
+        p += 8;
+        for (int i = 0; i < EXPORT_FIELD_MAX; i++) {
+            param++;
+            if (!isfinite(rows[r].values[i])) {
+                null_bitmap[param / 8] |= 1 << (param % 8);
+                continue;
+            }
+            memcpy(p, &rows[r].values[i], 4);
+            p += 4;
+        }
     }
 
-    /* Auth plugin name */
-    strcpy((char *)&response[resp_len], "mysql_native_password");
-    resp_len += strlen("mysql_native_password") + 1;
+    return p - __g_tx_buf;
+}
 
-    /* Send handshake response */
-    if (mysql_send_packet(sock, response, resp_len, 1) < 0) {
-        ESP_LOGE(TAG, "Failed to send auth response");
-        close(sock);
-        return -1;
+/* Send the first rows of the batch, prepared when possible.
+ * Returns the number of rows the server acknowledged, <0 on error */
+static int __send_rows(const struct export_row *rows, int cnt, uint32_t *bytes)
+{
+    struct mariadb_stmt *stmt = NULL;
+    int64_t build_us = esp_timer_get_time();
+    int len = 0;
+    int sent;
+
+    if (__g_session.stmt_batch.rows && cnt >= __g_session.stmt_batch.rows) {
+        stmt = &__g_session.stmt_batch;
+    } else if (__g_session.stmt_single.rows) {
+        stmt = &__g_session.stmt_single;
     }
 
-    /* Read auth result */
-    if (mysql_read_packet(sock, &pkt) < 0) {
-        close(sock);
-        return -1;
+    if (stmt) {
+        len = __build_stmt_execute(stmt, rows);
+        sent = stmt->rows;
+        build_us = esp_timer_get_time() - build_us;
+        if (len + 1 > (int)__g_session.max_packet) {
+            stmt = NULL;
+            build_us = esp_timer_get_time();
+        }
     }
 
-    if (pkt.data[0] == 0x00) {
-        ESP_LOGI(TAG, "MySQL authentication successful");
-        return sock;
-    } else if (pkt.data[0] == 0xFF) {
-        uint16_t err_code = pkt.data[1] | (pkt.data[2] << 8);
-        ESP_LOGE(TAG, "MySQL auth error %d: %.*s", err_code, pkt.length - 9, &pkt.data[9]);
-        close(sock);
-        return -1;
-    } else if (pkt.data[0] == 0xFE) {
-        /* Auth switch request - server wants different auth method */
-        ESP_LOGI(TAG, "Server requests auth switch");
-        /* Read auth method name */
-        char auth_method[64] = {0};
-        int j = 1;
-        while (j < pkt.length && pkt.data[j] != 0 && j < 64) {
-            auth_method[j-1] = pkt.data[j];
-            j++;
+    if (stmt) {
+        if (mysql_command_tx(&__g_session.conn, len) != 0) {
+            return -1;
         }
-        ESP_LOGI(TAG, "Requested auth method: %s", auth_method);
-
-        /* Get new scramble if provided */
-        if (j + 1 < pkt.length) {
-            memcpy(scramble, &pkt.data[j + 1], 20);
+        stmt->types_sent = true;
+        __g_stats.bin_rows += sent;
+        __g_stats.bin_bytes += len;
+        __g_stats.bin_build_us += build_us;
+    } else {
+        sent = __build_batch(__g_session.table, rows, cnt, &len);
+        build_us = esp_timer_get_time() - build_us;
+        if (sent == 0) {
+            ESP_LOGE(TAG, "Row does not fit max_allowed_packet");
+            return -1;
+        }
+        if (mysql_query_tx(&__g_session.conn, len) != 0) {
+            return -1;
         }
+        len += 1;
+        __g_stats.text_rows += sent;
+        __g_stats.text_bytes += len;
+        __g_stats.text_build_us += build_us;
+    }
+
+    ESP_LOGI(TAG, "Sent %d rows as %s: %d bytes (%d per row), built in %lld us",
+             sent, stmt ? "binary execute" : "text query", len, len / sent, build_us);
+    *bytes = len;
+    return sent;
+}
 
-        /* Send auth response for mysql_native_password */
-        if (password && strlen(password) > 0) {
-            uint8_t auth_response[20];
-            mysql_native_auth(password, scramble, auth_response);
-            if (mysql_send_packet(sock, auth_response, 20, 3) < 0) {
-                ESP_LOGE(TAG, "Failed to send auth switch response");
-                close(sock);
+/* ========== History Aggregates ========== */
+
+/* Aggregate column list, or "col=VALUES(col)" pairs for the upsert.
+ * With buf NULL only the length is computed */
+static int __agg_columns(char *buf, int size, bool update)
+{
+    int len = 0;
+
+    for (int i = 0; i < EXPORT_FIELD_MAX; i++) {
+        for (int s = 0; s < 4; s++) {
+            const char *name = export_field_names[i];
+            const char *suffix = __g_agg_suffix[s];
+            const char *sep = (i || s) ? "," : "";
+            if (update) {
+                len += snprintf(buf ? &buf[len] : NULL, buf ? size - len : 0, "%s%s_%s=VALUES(%s_%s)",
+                                sep, name, suffix, name, suffix);
+            } else {
+                len += snprintf(buf ? &buf[len] : NULL, buf ? size - len : 0, "%s%s_%s", sep, name, suffix);
+            }
+            if (buf && len >= size) {
                 return -1;
             }
-        } else {
-            uint8_t empty = 0;
-            mysql_send_packet(sock, &empty, 0, 3);
         }
+    }
+    return len;
+}
 
-        /* Read final auth result */
-        if (mysql_read_packet(sock, &pkt) < 0) {
-            close(sock);
-            return -1;
-        }
+/* Too long for __g_query_buf, built in the tx buffer */
+static int __create_agg_table(const char *table)
+{
+    char *query = (char *)&__g_tx_buf[1];
+    int size = MARIADB_TX_BUF_SIZE - 1;
+    int len;
+
+    len = snprintf(query, size, "CREATE TABLE IF NOT EXISTS %s_agg ("
+                   "device CHAR(12) NOT NULL,bucket BIGINT NOT NULL,", table);
+    for (int i = 0; i < EXPORT_FIELD_MAX; i++) {
+        const char *name = export_field_names[i];
+        len += snprintf(&query[len], size - len, "%s_avg FLOAT,%s_min FLOAT,%s_max FLOAT,%s_cnt SMALLINT UNSIGNED,",
+                        name, name, name, name);
+    }
+    len += snprintf(&query[len], size - len, "PRIMARY KEY (device,bucket))");
+    return mysql_query_tx(&__g_session.conn, len);
+}
 
-        if (pkt.data[0] == 0x00) {
-            ESP_LOGI(TAG, "MySQL authentication successful (after switch)");
-            return sock;
-        } else if (pkt.data[0] == 0xFF) {
-            uint16_t err_code = pkt.data[1] | (pkt.data[2] << 8);
-            ESP_LOGE(TAG, "MySQL auth error after switch %d: %.*s", err_code, pkt.length - 9, &pkt.data[9]);
-            close(sock);
-            return -1;
+/* One INSERT ... ON DUPLICATE KEY UPDATE for as many buckets as fit the packet
+ * limit. Returns the number of buckets taken, *query_len the statement length */
+static int __build_agg_upsert(const struct sensor_bucket *buckets, int cnt, int *query_len)
+{
+    char *query = (char *)&__g_tx_buf[1];
+    int limit = MARIADB_TX_BUF_SIZE - 1;
+    char row_text[MARIADB_AGG_ROW_TEXT_MAX];
+    int tail_len = __agg_columns(NULL, 0, true) + sizeof(" ON DUPLICATE KEY UPDATE ");
+    int len;
+    int taken;
+
+    if (__g_session.max_packet - 1 < (uint32_t)limit) {
+        limit = __g_session.max_packet - 1;
+    }
+
+    len = snprintf(query, limit, "INSERT INTO %s_agg (device,bucket,", __g_session.table);
+    len += __agg_columns(&query[len], limit - len, false);
+    len += snprintf(&query[len], limit - len, ") VALUES ");
+    if (len + tail_len >= limit) {
+        return 0;
+    }
+
+    for (taken = 0; taken < cnt; taken++) {
+        const struct sensor_bucket *bucket = &buckets[taken];
+        int n = snprintf(row_text, sizeof(row_text), "%s('%s',%lld", taken ? "," : "",
+                         indicator_export_device_id(), (long long)bucket->start);
+        for (int i = 0; i < EXPORT_FIELD_MAX; i++) {
+            const struct sensor_bucket_field *field = &bucket->fields[i];
+            n += __append_value(&row_text[n], sizeof(row_text) - n, field->avg, export_field_precision[i]);
+            n += __append_value(&row_text[n], sizeof(row_text) - n, field->min, export_field_precision[i]);
+            n += __append_value(&row_text[n], sizeof(row_text) - n, field->max, export_field_precision[i]);
+            n += snprintf(&row_text[n], sizeof(row_text) - n, ",%u", field->count);
+        }
+        n += snprintf(&row_text[n], sizeof(row_text) - n, ")");
+        if (len + n + tail_len >= limit) {
+            break;
         }
+        memcpy(&query[len], row_text, n);
+        len += n;
     }
 
-    close(sock);
-    return -1;
+    len += snprintf(&query[len], limit - len, " ON DUPLICATE KEY UPDATE ");
+    len += __agg_columns(&query[len], limit - len, true);
+    *query_len = len;
+    return taken;
 }
 
-static int mysql_query(int sock, const char *query)
+/* Upsert the closed history buckets the server has not acknowledged yet, in
+ * batches. Buckets missed during an outage are backfilled from the sensor
+ * history on the next successful export; one sent twice is overwritten */
+static int __send_buckets(void)
 {
-    mysql_packet_t pkt;
-    int query_len = strlen(query);
-    uint8_t *cmd = malloc(query_len + 1);
-    if (!cmd) return -1;
+    int total = 0;
 
-    cmd[0] = 0x03; /* COM_QUERY */
-    memcpy(&cmd[1], query, query_len);
-
-    if (mysql_send_packet(sock, cmd, query_len + 1, 0) < 0) {
-        free(cmd);
-        return -1;
+    if (__g_agg_resend) {
+        /* New server or table: it gets every bucket still in RAM */
+        __g_agg_resend = false;
+        __g_agg_acked = 0;
     }
-    free(cmd);
 
-    /* Read response */
-    if (mysql_read_packet(sock, &pkt) < 0) {
-        return -1;
-    }
+    while (1) {
+        int len = 0;
+        int cnt = indicator_sensor_get_buckets(__g_agg_acked, __g_agg_buckets, MARIADB_AGG_BATCH);
+        if (cnt == 0) {
+            break;
+        }
 
-    if (pkt.data[0] == 0x00) {
-        ESP_LOGI(TAG, "Query OK");
-        return 0;
-    } else if (pkt.data[0] == 0xFF) {
-        uint16_t err_code = pkt.data[1] | (pkt.data[2] << 8);
-        ESP_LOGE(TAG, "Query error %d: %.*s", err_code, pkt.length - 9, &pkt.data[9]);
-        return -1;
+        int taken = __build_agg_upsert(__g_agg_buckets, cnt, &len);
+        if (taken == 0) {
+            ESP_LOGE(TAG, "Aggregate row does not fit max_allowed_packet");
+            return -1;
+        }
+        if (mysql_query_tx(&__g_session.conn, len) != 0) {
+            int status = __conn_status(-4);
+            ESP_LOGE(TAG, "Aggregate upsert failed");
+            __session_close("query failed");
+            return status;
+        }
+
+        __g_agg_acked = __g_agg_buckets[taken - 1].start;
+        __g_stats.agg_buckets += taken;
+        __g_stats.agg_acked = __g_agg_acked;
+        total += taken;
     }
 
+    if (total > 0) {
+        __g_session.last_used_us = esp_timer_get_time();
+        indicator_storage_write(MARIADB_AGG_STORAGE, &__g_agg_acked, sizeof(__g_agg_acked));
+        ESP_LOGI(TAG, "Upserted %d history buckets, acknowledged up to %lld", total, (long long)__g_agg_acked);
+    }
     return 0;
 }
 
-static int __do_export(void)
+/* ========== Export Sink ========== */
+
+static bool __sink_enabled(void)
 {
     struct mariadb_config config;
-    struct view_data_sensor sensor_data;
-    int ret = -1;
-    int sock = -1;
-    char *query = NULL;
-    bool is_test = __g_test_pending;
-
     __config_get(&config);
+    /* A connection test runs even while the export is switched off */
+    return config.enabled || __g_test_pending;
+}
 
-    /* For regular export, check if enabled */
-    if (!is_test && !config.enabled) {
-        ESP_LOGW(TAG, "Export skipped: disabled");
-        return -1;
+/* Check the config and make sure the session is up */
+static int __sink_begin(int pending)
+{
+    struct mariadb_config config;
+    mysql_conn_t *conn = &__g_session.conn;
+
+    __g_round_test = __g_test_pending;
+    __g_round_start_us = esp_timer_get_time();
+    __g_round_heap = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    /* A test keeps the number it got when requested, so a cancel tapped
+     * before the round started still reaches it */
+    conn->gen = __g_round_test ? __g_test_gen : __gen_alloc();
+    conn->error = MYSQL_CONN_OK;
+    if (conn->cancel_gen == conn->gen) {
+        ESP_LOGW(TAG, "Cancelled before it started");
+        return -6;
     }
+    __config_get(&config);
 
-    /* Check configuration */
     if (strlen(config.host) == 0) {
         ESP_LOGE(TAG, "Export failed: no host configured");
         return -1;
@@ -483,121 +805,132 @@ static int __do_export(void)
         return -1;
     }
 
-    ESP_LOGI(TAG, "Connecting to %s:%d as %s...", config.host, config.port, config.user);
-
-    /* Allocate query buffer on heap to save stack */
-    query = malloc(1024);
-    if (!query) {
-        ESP_LOGE(TAG, "Failed to allocate query buffer");
-        return -2;
-    }
-
-    /* Get current sensor data */
-    if (indicator_sensor_get_data(&sensor_data) != 0) {
-        ESP_LOGE(TAG, "Failed to get sensor data");
-        free(query);
-        return -2;
-    }
-
-    /* Connect to MySQL/MariaDB */
-    sock = mysql_connect(config.host, config.port, config.user,
-                         config.password, config.database);
-    if (sock < 0) {
-        ESP_LOGE(TAG, "MySQL connection failed to %s:%d", config.host, config.port);
-        free(query);
-        return -3;
+    /* Reuse the open session, or connect */
+    int ret = __session_ensure(&config, __g_round_test);
+    if (ret < 0) {
+        return ret;
     }
 
-    ESP_LOGI(TAG, "Connected successfully!");
-
-    /* Create table if not exists */
-    snprintf(query, 1024,
-        "CREATE TABLE IF NOT EXISTS %s ("
-        "id INT AUTO_INCREMENT PRIMARY KEY,"
-        "timestamp BIGINT NOT NULL,"
-        "received_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
-        "temp_internal FLOAT,humidity_internal FLOAT,"
-        "co2 FLOAT,tvoc FLOAT,"
-        "temp_external FLOAT,humidity_external FLOAT,"
-        "pm1_0 FLOAT,pm2_5 FLOAT,pm10 FLOAT,"
-        "no2_ppm FLOAT,c2h5oh_ppm FLOAT,voc_ppm FLOAT,co_ppm FLOAT"
-        ")", config.table);
-
-    if (mysql_query(sock, query) < 0) {
-        ESP_LOGW(TAG, "Create table query failed (may already exist)");
+    /* More than one batch queued: time the upload until the sink caught up */
+    if (__g_backlog_start_us == 0 && pending > EXPORT_BATCH_MAX_ROWS) {
+        __g_backlog_start_us = esp_timer_get_time();
+        __g_backlog_rows = 0;
+        __g_backlog_packet_bytes = conn->tx_packet_bytes;
+        __g_backlog_wire_bytes = conn->tx_wire_bytes;
     }
+    return 0;
+}
 
-    /* Insert data */
-    time_t now = time(NULL);
-    snprintf(query, 1024,
-        "INSERT INTO %s (timestamp,temp_internal,humidity_internal,co2,tvoc,"
-        "temp_external,humidity_external,pm1_0,pm2_5,pm10,"
-        "no2_ppm,c2h5oh_ppm,voc_ppm,co_ppm) VALUES "
-        "(%ld,%.2f,%.2f,%.1f,%.1f,%.2f,%.2f,%.1f,%.1f,%.1f,%.2f,%.2f,%.2f,%.2f)",
-        config.table,
-        (long)now,
-        sensor_data.temp_internal, sensor_data.humidity_internal,
-        sensor_data.co2, sensor_data.tvoc,
-        sensor_data.temp_external, sensor_data.humidity_external,
-        sensor_data.pm1_0, sensor_data.pm2_5, sensor_data.pm10,
-        sensor_data.multigas_gm102b[0], sensor_data.multigas_gm302b[0],
-        sensor_data.multigas_gm502b[0], sensor_data.multigas_gm702b[0]);
-
-    if (mysql_query(sock, query) == 0) {
-        ret = 0;
-        __g_last_export_time = now;
-        ESP_LOGI(TAG, "Data exported to MariaDB successfully");
-    } else {
-        ret = -4;
+static int __sink_send(const struct export_row *rows, int cnt, uint32_t *bytes)
+{
+    int sent = __send_rows(rows, cnt, bytes);
+    if (sent < 0) {
+        int status = __conn_status(-4);
         ESP_LOGE(TAG, "Failed to insert data");
+        /* Session state is unknown after a failed query, start over next time */
+        __session_close("query failed");
+        return status;
     }
 
-    close(sock);
-    free(query);
-    __g_last_status = ret;
-    return ret;
+    __g_last_export_time = time(NULL);
+    __g_session.last_used_us = esp_timer_get_time();
+    __g_stats.batches++;
+    __g_stats.rows += sent;
+    __g_backlog_rows += sent;
+    return sent;
 }
 
-static void __export_timer_callback(void *arg)
+static void __sink_done(int status, int pending)
 {
-    ESP_LOGI(TAG, "Export timer triggered");
-    __g_export_pending = true;
-    if (__g_db_task_handle) {
-        xTaskNotifyGive(__g_db_task_handle);
+    struct mariadb_config config;
+    mysql_conn_t *conn = &__g_session.conn;
+
+    __config_get(&config);
+    if (status == 0 && config.enabled) {
+        status = __send_buckets();
     }
-}
 
-/* Database task - runs DB operations with larger stack */
-static void __db_task(void *arg)
-{
-    ESP_LOGI(TAG, "MariaDB task started (stack: %d bytes free)",
-             uxTaskGetStackHighWaterMark(NULL) * 4);
+    if (status == 0) {
+        ESP_LOGI(TAG, "Data exported to MariaDB successfully, %d rows pending", pending);
+    }
 
-    while (1) {
-        /* Wait for notification with timeout */
-        uint32_t notify = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5000));
+    if (status == 0 && pending == 0 && __g_backlog_start_us) {
+        /* Byte counters include any reconnect handshakes during the upload */
+        __g_stats.backlog_rows = __g_backlog_rows;
+        __g_stats.backlog_us = esp_timer_get_time() - __g_backlog_start_us;
+        __g_stats.backlog_packet_bytes = conn->tx_packet_bytes - __g_backlog_packet_bytes;
+        __g_stats.backlog_wire_bytes = conn->tx_wire_bytes - __g_backlog_wire_bytes;
+        __g_backlog_start_us = 0;
+        ESP_LOGI(TAG, "Backlog of %lu rows sent in %lld ms: %lu bytes on the wire, %lu uncompressed (%s)",
+                 (unsigned long)__g_stats.backlog_rows, __g_stats.backlog_us / 1000,
+                 (unsigned long)__g_stats.backlog_wire_bytes, (unsigned long)__g_stats.backlog_packet_bytes,
+                 conn->compressed ? "compressed" : "plain");
+    }
 
-        if (notify > 0 || __g_test_pending || __g_export_pending) {
-            ESP_LOGI(TAG, "DB operation triggered: test=%d, export=%d, notify=%lu",
-                     __g_test_pending, __g_export_pending, (unsigned long)notify);
+    if (__g_round_test && !config.enabled) {
+        /* Nothing will reuse the session until the export is enabled */
+        __session_close("test done, export disabled");
+    }
 
-            bool was_test = __g_test_pending;
+    int64_t elapsed_us = esp_timer_get_time() - __g_round_start_us;
+    __g_stats.exports++;
+    __g_stats.last_export_us = elapsed_us;
+    __g_stats.total_export_us += elapsed_us;
+    __g_stats.last_heap_delta = (int32_t)__g_round_heap - (int32_t)heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    ESP_LOGI(TAG, "Export stats: handshakes=%lu exports=%lu batches=%lu rows=%lu pings=%lu latency=%lld us (avg %lld us) heap_delta=%ld",
+             (unsigned long)__g_stats.handshakes, (unsigned long)__g_stats.exports,
+             (unsigned long)__g_stats.batches, (unsigned long)__g_stats.rows,
+             (unsigned long)__g_stats.pings, elapsed_us,
+             __g_stats.total_export_us / __g_stats.exports, (long)__g_stats.last_heap_delta);
+    if (__g_stats.bin_rows) {
+        ESP_LOGI(TAG, "Binary rows: %lu, %lu bytes/row, %lld us/row encode",
+                 (unsigned long)__g_stats.bin_rows, (unsigned long)(__g_stats.bin_bytes / __g_stats.bin_rows),
+                 __g_stats.bin_build_us / __g_stats.bin_rows);
+    }
+    if (__g_stats.text_rows) {
+        ESP_LOGI(TAG, "Text rows: %lu, %lu bytes/row, %lld us/row encode",
+                 (unsigned long)__g_stats.text_rows, (unsigned long)(__g_stats.text_bytes / __g_stats.text_rows),
+                 __g_stats.text_build_us / __g_stats.text_rows);
+    }
+    if (__g_stats.tls_full || __g_stats.tls_resumed) {
+        ESP_LOGI(TAG, "TLS handshakes: full %lu (avg %lld us), resumed %lu (avg %lld us)",
+                 (unsigned long)__g_stats.tls_full,
+                 __g_stats.tls_full ? __g_stats.tls_full_us / __g_stats.tls_full : 0,
+                 (unsigned long)__g_stats.tls_resumed,
+                 __g_stats.tls_resumed ? __g_stats.tls_resumed_us / __g_stats.tls_resumed : 0);
+    }
 
-            int result = __do_export();
-            __g_last_status = result;
+    __g_last_status = status;
+    __status_post(status, DB_PHASE_IDLE);
+    __g_test_pending = false;
+}
 
-            ESP_LOGI(TAG, "DB operation complete: result=%d, was_test=%d", result, was_test);
+static void __sink_idle(void)
+{
+    struct mariadb_config config;
 
-            __g_test_pending = false;
-            __g_export_pending = false;
+    if (__g_test_pending) {
+        /* Nothing to send, the test sample could not be queued */
+        __g_last_status = -2;
+        __status_post(-2, DB_PHASE_IDLE);
+        __g_test_pending = false;
+    }
 
-            /* Log stack usage after operation */
-            ESP_LOGI(TAG, "Stack high water mark: %d bytes",
-                     uxTaskGetStackHighWaterMark(NULL) * 4);
-        }
+    __config_get(&config);
+    if (!config.enabled) {
+        __session_close("export disabled");
     }
 }
 
+static struct export_sink __g_sink = {
+    .name = "mariadb",
+    .enabled = __sink_enabled,
+    .begin = __sink_begin,
+    .send = __sink_send,
+    .done = __sink_done,
+    .idle = __sink_idle,
+};
+
 int indicator_mariadb_init(void)
 {
     if (__g_initialized) {
@@ -613,24 +946,41 @@ int indicator_mariadb_init(void)
     /* Restore configuration */
     __config_restore();
 
-    /* Create database task with larger stack */
-    BaseType_t ret = xTaskCreate(__db_task, "mariadb_task", MARIADB_TASK_STACK,
-                                  NULL, 5, &__g_db_task_handle);
-    if (ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create DB task");
+    __g_tx_buf = heap_caps_malloc(MARIADB_TX_BUF_SIZE, MALLOC_CAP_SPIRAM);
+    if (!__g_tx_buf) {
+        ESP_LOGE(TAG, "Failed to allocate export buffer");
         return -1;
     }
+    __g_session.conn.tx_buf = __g_tx_buf;
+    __g_session.conn.tx_size = MARIADB_TX_BUF_SIZE;
 
-    /* Create export timer */
-    const esp_timer_create_args_t timer_args = {
-        .callback = __export_timer_callback,
-        .arg = NULL,
-        .name = "mariadb_export"
-    };
-    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &__g_export_timer));
+    __g_agg_buckets = heap_caps_malloc(MARIADB_AGG_BATCH * sizeof(struct sensor_bucket), MALLOC_CAP_SPIRAM);
+    if (!__g_agg_buckets) {
+        ESP_LOGE(TAG, "Failed to allocate aggregate buffer");
+        return -1;
+    }
+    size_t len = sizeof(__g_agg_acked);
+    if (indicator_storage_read(MARIADB_AGG_STORAGE, &__g_agg_acked, &len) != ESP_OK || len != sizeof(__g_agg_acked)) {
+        __g_agg_acked = 0;
+    }
+    __g_stats.agg_acked = __g_agg_acked;
+
+    if (MARIADB_USE_COMPRESS) {
+        if (mysql_zstream_alloc(&__g_zstream, MARIADB_ZFRAME_SIZE) == 0) {
+            __g_session.conn.z = &__g_zstream;
+            __g_session.conn.use_compress = true;
+        } else {
+            ESP_LOGW(TAG, "Compression unavailable, exporting uncompressed");
+        }
+    }
+
+    if (indicator_export_register(&__g_sink) != 0) {
+        ESP_LOGE(TAG, "Failed to register export sink");
+        return -1;
+    }
 
-    /* Start timer if enabled */
-    __update_timer();
+    /* Start sampling if enabled */
+    __update_interval();
 
     __g_initialized = true;
     ESP_LOGI(TAG, "MariaDB module initialized");
@@ -648,54 +998,64 @@ int indicator_mariadb_set_config(const struct mariadb_config *config)
 {
     if (!config) return -1;
 
+    uint8_t pin[32];
+    if (mysql_parse_sha256(config->tls_pin, pin) < 0) {
+        ESP_LOGE(TAG, "Certificate pin is not a SHA-256 fingerprint");
+        return -2;
+    }
+
     ESP_LOGI(TAG, "Setting config: enabled=%d, host=%s, port=%d, interval=%d min",
              config->enabled, config->host, config->port, config->interval_minutes);
 
     __config_set(config);
     __config_save();
-    __update_timer();
+    __g_session_reset = true;  /* the export task reconnects with the new settings */
+    __g_agg_resend = true;     /* possibly another server, which has none of the buckets */
+    /* Don't let an operation on the old settings run to its timeout. A round
+     * that starts from now on reads the new settings */
+    __g_session.conn.cancel_gen = __g_session.conn.gen;
+    __update_interval();
+    indicator_export_kick();
     return 0;
 }
 
 int indicator_mariadb_test_connection(void)
 {
-    if (!__g_db_task_handle) {
-        ESP_LOGE(TAG, "DB task not running");
+    if (!__g_initialized) {
+        ESP_LOGE(TAG, "MariaDB module not initialized");
         __g_last_status = -1;
         return -1;
     }
 
-    /* Wait if a test is already in progress */
-    if (__g_test_pending || __g_export_pending) {
-        ESP_LOGW(TAG, "Operation already in progress, waiting...");
-        for (int i = 0; i < 50 && (__g_test_pending || __g_export_pending); i++) {
-            vTaskDelay(pdMS_TO_TICKS(100));
-        }
-    }
-
-    /* Reset status and trigger test (async) */
-    __g_last_status = -99;  /* Pending - caller should poll get_last_status() */
+    /* Runs after any operation in progress, the result arrives as STORE_TOPIC_DB_STATUS */
+    __g_last_status = -99;
+    __g_test_gen = __gen_alloc();
     __g_test_pending = true;
-    __g_export_pending = false;
+    __status_post(-99, DB_PHASE_IDLE);     /* a repeated result still reads as a change */
 
-    ESP_LOGI(TAG, "Test connection triggered (async), notifying task...");
-    xTaskNotifyGive(__g_db_task_handle);
+    ESP_LOGI(TAG, "Test connection triggered (async)");
+    indicator_export_now();
 
-    return 0;  /* Triggered successfully, result will be in get_last_status() */
+    return 0;
 }
 
 int indicator_mariadb_export_now(void)
 {
-    if (!__g_db_task_handle) {
-        ESP_LOGE(TAG, "DB task not running");
+    if (!__g_initialized) {
+        ESP_LOGE(TAG, "MariaDB module not initialized");
         return -1;
     }
 
-    __g_export_pending = true;
-    xTaskNotifyGive(__g_db_task_handle);
+    indicator_export_now();
     return 0;  /* Triggered, actual result available via get_last_status */
 }
 
+void indicator_mariadb_cancel(void)
+{
+    /* The test, whether it runs or still waits for its turn */
+    __g_session.conn.cancel_gen = __g_test_pending ? __g_test_gen : __g_session.conn.gen;
+}
+
 int indicator_mariadb_get_last_status(void)
 {
     return __g_last_status;
@@ -705,3 +1065,10 @@ time_t indicator_mariadb_get_last_export_time(void)
 {
     return __g_last_export_time;
 }
+
+int indicator_mariadb_get_stats(struct mariadb_stats *stats)
+{
+    if (!stats) return -1;
+    memcpy(stats, &__g_stats, sizeof(struct mariadb_stats));
+    return 0;
+}
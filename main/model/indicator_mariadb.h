@@ -19,6 +19,40 @@ struct mariadb_config {
     char database[32];
     char table[32];
     uint16_t interval_minutes;  /* Export interval in minutes */
+    bool tls;                   /* Require TLS, resumed from the last session where possible */
+    char tls_pin[96];           /* SHA-256 of a self-signed server certificate in hex, "" for the CA bundle */
+};
+
+/* Exporter counters, for comparing connection strategies on a device */
+struct mariadb_stats {
+    uint32_t handshakes;        /* Full connect + auth handshakes performed */
+    uint32_t exports;           /* Export attempts that reached the server */
+    uint32_t pings;             /* COM_PING liveness checks */
+    /* TLS handshakes, a full one vs. one resuming the cached session */
+    uint32_t tls_full;
+    int64_t  tls_full_us;
+    uint32_t tls_resumed;
+    int64_t  tls_resumed_us;
+    uint32_t batches;           /* INSERT statements acknowledged by the server */
+    uint32_t rows;              /* Queued rows delivered */
+    /* Encoding cost, prepared binary execute vs. text INSERT */
+    uint32_t bin_rows;
+    uint32_t bin_bytes;         /* Bytes on the wire, excluding the packet header */
+    int64_t  bin_build_us;      /* Time spent encoding */
+    uint32_t text_rows;
+    uint32_t text_bytes;
+    int64_t  text_build_us;
+    /* Last backlog upload, from the first batch until the queue was empty */
+    uint32_t backlog_rows;
+    int64_t  backlog_us;
+    uint32_t backlog_packet_bytes;  /* Protocol bytes before compression */
+    uint32_t backlog_wire_bytes;    /* Bytes actually sent */
+    /* History aggregates upserted into <table>_agg */
+    uint32_t agg_buckets;
+    int64_t  agg_acked;         /* Start of the newest bucket the server acknowledged */
+    int64_t  last_export_us;    /* Wall time of the last export */
+    int64_t  total_export_us;   /* Sum over all exports, for the average */
+    int32_t  last_heap_delta;   /* Free heap consumed by the last export (bytes) */
 };
 
 /* Initialize the MariaDB module */
@@ -27,12 +61,16 @@ int indicator_mariadb_init(void);
 /* Get current MariaDB configuration */
 int indicator_mariadb_get_config(struct mariadb_config *config);
 
-/* Set and save MariaDB configuration */
+/* Set and save MariaDB configuration, -2 if tls_pin is not a SHA-256 fingerprint */
 int indicator_mariadb_set_config(const struct mariadb_config *config);
 
-/* Test the database connection */
+/* Test the database connection. Progress and result are published as STORE_TOPIC_DB_STATUS */
 int indicator_mariadb_test_connection(void);
 
+/* Abort the pending connection test, or else the operation in progress. It
+ * completes with status -6, also when it had not started yet */
+void indicator_mariadb_cancel(void);
+
 /* Manually trigger a data export */
 int indicator_mariadb_export_now(void);
 
@@ -42,6 +80,9 @@ int indicator_mariadb_get_last_status(void);
 /* Get timestamp of last successful export */
 time_t indicator_mariadb_get_last_export_time(void);
 
+/* Get exporter counters */
+int indicator_mariadb_get_stats(struct mariadb_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
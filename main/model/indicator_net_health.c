@@ -0,0 +1,212 @@
+#include "indicator_net_health.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "net-health";
+
+static const uint16_t __g_rtt_bounds_ms[NET_HEALTH_RTT_BUCKETS - 1] = {
+    10, 25, 50, 100, 250, 500, 1000
+};
+
+struct net_health_dest {
+    struct view_data_net_health stats;
+    bool     answered;          /* since the link came up */
+    int64_t  window_start_us;
+    uint32_t window_ok;
+    uint32_t window_fail;
+};
+
+static struct net_health_dest __g_dests[NET_HEALTH_DEST_MAX];
+static int __g_dest_cnt;
+static SemaphoreHandle_t __g_mutex;
+static net_health_cb_t __g_cb;
+
+static bool __g_link;
+static bool __g_reachable;
+static int  __g_fail_cnt;               /* counted failures in a row */
+static int64_t __g_last_ok_us;
+static int64_t __g_last_report_us;      /* 0: nothing since the link came up */
+
+static struct net_health_dest *__dest_get(const char *dest)
+{
+    for (int i = 0; i < __g_dest_cnt; i++) {
+        if (strncmp(__g_dests[i].stats.dest, dest, sizeof(__g_dests[i].stats.dest) - 1) == 0) {
+            return &__g_dests[i];
+        }
+    }
+    if (__g_dest_cnt == NET_HEALTH_DEST_MAX) {
+        return NULL;
+    }
+    struct net_health_dest *d = &__g_dests[__g_dest_cnt++];
+    memset(d, 0, sizeof(*d));
+    strncpy(d->stats.dest, dest, sizeof(d->stats.dest) - 1);
+    return d;
+}
+
+static int __rtt_bucket(int rtt_ms)
+{
+    int i = 0;
+    while (i < NET_HEALTH_RTT_BUCKETS - 1 && rtt_ms >= __g_rtt_bounds_ms[i]) {
+        i++;
+    }
+    return i;
+}
+
+static int __loss_bucket(uint32_t loss)
+{
+    if (loss == 0) return 0;
+    if (loss <= 10) return 1;
+    if (loss <= 50) return 2;
+    if (loss < 100) return 3;
+    return 4;
+}
+
+/* Bin the window that ended before now_us */
+static void __window_close(struct net_health_dest *d, int64_t now_us)
+{
+    if (d->window_start_us == 0) {
+        d->window_start_us = now_us;
+        return;
+    }
+    if (now_us - d->window_start_us < (int64_t)NET_HEALTH_WINDOW_SEC * 1000000) {
+        return;
+    }
+
+    uint32_t total = d->window_ok + d->window_fail;
+    if (total > 0) {
+        d->stats.last_loss = (uint8_t)(d->window_fail * 100 / total);
+        d->stats.loss_hist[__loss_bucket(d->stats.last_loss)]++;
+        ESP_LOGD(TAG, "%s: %lu answered, %lu lost in the last window", d->stats.dest,
+                 d->window_ok, d->window_fail);
+    }
+    d->window_start_us = now_us;
+    d->window_ok = 0;
+    d->window_fail = 0;
+}
+
+int indicator_net_health_init(void)
+{
+    __g_mutex = xSemaphoreCreateMutex();
+    return 0;
+}
+
+void indicator_net_health_report(const char *dest, bool ok, int rtt_ms)
+{
+    bool changed = false;
+    net_health_cb_t cb;
+    int64_t now_us = esp_timer_get_time();
+
+    xSemaphoreTake(__g_mutex, portMAX_DELAY);
+    struct net_health_dest *d = __dest_get(dest);
+    if (d) {
+        __window_close(d, now_us);
+        if (ok) {
+            d->stats.ok++;
+            d->window_ok++;
+            d->stats.rtt_hist[__rtt_bucket(rtt_ms < 0 ? 0 : rtt_ms)]++;
+        } else {
+            d->stats.fail++;
+            d->window_fail++;
+        }
+    }
+    __g_last_report_us = now_us;
+
+    if (ok) {
+        if (d) {
+            d->answered = true;
+        }
+        __g_fail_cnt = 0;
+        __g_last_ok_us = now_us;
+        changed = __g_link && !__g_reachable;
+        __g_reachable = __g_link;
+    } else if (d == NULL || d->answered) {
+        __g_fail_cnt++;
+        if (__g_reachable && __g_fail_cnt >= NET_HEALTH_FAIL_MAX &&
+            now_us - __g_last_ok_us >= (int64_t)NET_HEALTH_FRESH_SEC * 1000000) {
+            __g_reachable = false;
+            changed = true;
+        }
+    }
+    bool reachable = __g_reachable;
+    cb = __g_cb;
+    xSemaphoreGive(__g_mutex);
+
+    if (changed) {
+        ESP_LOGI(TAG, "Network %s (%s %s)", reachable ? "reachable" : "unreachable",
+                 dest, ok ? "answered" : "failed");
+        if (cb) {
+            cb(reachable);
+        }
+    }
+}
+
+void indicator_net_health_link(bool up)
+{
+    xSemaphoreTake(__g_mutex, portMAX_DELAY);
+    __g_link = up;
+    __g_reachable = false;
+    __g_fail_cnt = 0;
+    __g_last_report_us = 0;
+    for (int i = 0; i < __g_dest_cnt; i++) {
+        __g_dests[i].answered = false;
+    }
+    xSemaphoreGive(__g_mutex);
+}
+
+bool indicator_net_health_reachable(void)
+{
+    xSemaphoreTake(__g_mutex, portMAX_DELAY);
+    bool reachable = __g_reachable;
+    xSemaphoreGive(__g_mutex);
+    return reachable;
+}
+
+bool indicator_net_health_probe_due(void)
+{
+    bool due;
+
+    xSemaphoreTake(__g_mutex, portMAX_DELAY);
+    int64_t idle_us = (int64_t)(__g_reachable ? NET_HEALTH_IDLE_SEC : NET_HEALTH_RETRY_SEC) * 1000000;
+    due = __g_link && (__g_last_report_us == 0 || esp_timer_get_time() - __g_last_report_us >= idle_us);
+    xSemaphoreGive(__g_mutex);
+    return due;
+}
+
+void indicator_net_health_set_cb(net_health_cb_t cb)
+{
+    __g_cb = cb;
+}
+
+int indicator_net_health_rtt_median_ms(const struct view_data_net_health *stats)
+{
+    uint32_t seen = 0;
+
+    if (stats->ok == 0) {
+        return 0;
+    }
+    for (int i = 0; i < NET_HEALTH_RTT_BUCKETS - 1; i++) {
+        seen += stats->rtt_hist[i];
+        if (seen * 2 >= stats->ok) {
+            return __g_rtt_bounds_ms[i];
+        }
+    }
+    return -1;
+}
+
+int indicator_net_health_get(int index, struct view_data_net_health *stats)
+{
+    int ret = -1;
+
+    xSemaphoreTake(__g_mutex, portMAX_DELAY);
+    if (index >= 0 && index < __g_dest_cnt) {
+        if (stats) {
+            memcpy(stats, &__g_dests[index].stats, sizeof(*stats));
+        }
+        ret = 0;
+    }
+    xSemaphoreGive(__g_mutex);
+    return ret;
+}
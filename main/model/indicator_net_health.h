@@ -0,0 +1,60 @@
+#ifndef INDICATOR_NET_HEALTH_H
+#define INDICATOR_NET_HEALTH_H
+
+#include "config.h"
+#include "view_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Reachability inferred from the traffic the device sends anyway: NTP
+ * queries, HTTPS requests and export rounds report their outcome and round
+ * trip here. Any answer makes the network reachable; it is given up after
+ * NET_HEALTH_FAIL_MAX failures in a row with no answer for
+ * NET_HEALTH_FRESH_SEC. Failures of a destination that has not answered
+ * since the link came up are kept in its counters but don't decide
+ * reachability, they usually mean a wrong host or password.
+ *
+ * An active probe is only due when nothing has been reported for a while.
+ */
+#define NET_HEALTH_DEST_MAX      12
+#define NET_HEALTH_FAIL_MAX      3
+#define NET_HEALTH_FRESH_SEC     60
+#define NET_HEALTH_WINDOW_SEC    300    /* loss is binned per window */
+#define NET_HEALTH_IDLE_SEC      300    /* probe after this long without traffic */
+#define NET_HEALTH_RETRY_SEC     15     /* same, while unreachable */
+
+typedef void (*net_health_cb_t)(bool reachable);
+
+int indicator_net_health_init(void);
+
+/* Outcome of one exchange with dest, rtt_ms is ignored on failure */
+void indicator_net_health_report(const char *dest, bool ok, int rtt_ms);
+
+/* Link up: reachability unknown until the first answer, probe due at once.
+ * Link down: unreachable, no callback */
+void indicator_net_health_link(bool up);
+
+bool indicator_net_health_reachable(void);
+
+/* True when an active probe should run now */
+bool indicator_net_health_probe_due(void);
+
+/* Called on every change of reachability, from the reporting task */
+void indicator_net_health_set_cb(net_health_cb_t cb);
+
+/* Counters of destination `index`, -1 past the last one. The export task
+ * logs them after every round */
+int indicator_net_health_get(int index, struct view_data_net_health *stats);
+
+/* Upper bound of the RTT bucket holding the median answer in ms, 0 without
+ * answers, -1 when it is the open >= 1000 ms bucket */
+int indicator_net_health_rtt_median_ms(const struct view_data_net_health *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
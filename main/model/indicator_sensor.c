@@ -1,7 +1,9 @@
 #include "indicator_sensor.h"
+#include "indicator_time.h"
+#include "indicator_store.h"
 #include "driver/uart.h"
 #include "cobs.h"
-#include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include "nvs.h"
 #include <stdlib.h>
 #include <math.h>
@@ -65,6 +67,8 @@ struct sensor_present_data
     float sum;
     int per_hour_cnt;
     //time_t hour_timestamp;
+    float bucket_min;
+    float bucket_max;
 
     float  day_min;
     float  day_max;
@@ -129,12 +133,15 @@ static SemaphoreHandle_t       __g_data_mutex;
 static struct indicator_sensor_history_data  __g_sensor_history_data;
 static struct indicator_sensor_present_data  __g_sensor_present_data;
 
-static esp_timer_handle_t   sensor_history_data_timer_handle;
-
 static QueueHandle_t updata_queue_handle = NULL;
 
 static struct view_data_sensor __g_current_sensor_data = {0};
 
+/* Closed buckets, oldest first, for the exporters. Not persisted: the NVS
+ * partition has no room for a second day of history */
+static struct sensor_bucket *__g_buckets;  /* SENSOR_BUCKET_MAX, PSRAM */
+static int __g_bucket_cnt;
+
 /*
  * Grove Multichannel Gas Sensor V2 - ppm(eq) ranges
  * These are QUALITATIVE/UNCALIBRATED equivalent ppm estimates.
@@ -340,7 +347,8 @@ static void __sensor_history_data_week_check(struct sensor_data_minmax p_data_we
 
 
 
-static void __sensor_history_data_day_insert(struct sensor_data_average p_data_day[],  struct sensor_present_data  *p_cur,  time_t now)
+/* Returns true when a new bucket was stored */
+static bool __sensor_history_data_day_insert(struct sensor_data_average p_data_day[],  struct sensor_present_data  *p_cur,  time_t now)
 {
     int history_interval = 0;
     int cur_interval = 0;
@@ -353,7 +361,7 @@ static void __sensor_history_data_day_insert(struct sensor_data_average p_data_d
     history_interval = (timeinfo.tm_hour * 60 + timeinfo.tm_min) / 30;
 
     if( cur_interval == history_interval) {
-        return;
+        return false;
     }
 
     for( int i =0;  i < 47; i++) {
@@ -384,7 +392,7 @@ static void __sensor_history_data_day_insert(struct sensor_data_average p_data_d
         }
     }
 #endif
-
+    return true;
 }
 
 static void __sensor_history_data_week_insert(struct sensor_data_minmax p_data_week[],  struct sensor_present_data  *p_cur, time_t now)
@@ -490,11 +498,56 @@ static void __sensor_history_data_check(time_t now)
     xSemaphoreGive(__g_data_mutex);
 }
 
+static void __sensor_bucket_field_fill(struct sensor_bucket_field *p_field, const struct sensor_present_data *p_cur)
+{
+    if( p_cur->per_hour_cnt >= 1) {
+        p_field->avg = p_cur->average;
+        p_field->min = p_cur->bucket_min;
+        p_field->max = p_cur->bucket_max;
+        p_field->count = p_cur->per_hour_cnt > UINT16_MAX ? UINT16_MAX : p_cur->per_hour_cnt;
+    } else {
+        p_field->avg = NAN;
+        p_field->min = NAN;
+        p_field->max = NAN;
+        p_field->count = 0;
+    }
+}
+
+static void __sensor_bucket_push(const struct sensor_bucket *p_bucket)
+{
+    if( !__g_buckets) {
+        return;
+    }
+    if( __g_bucket_cnt == SENSOR_BUCKET_MAX) {
+        memmove(&__g_buckets[0], &__g_buckets[1], sizeof(struct sensor_bucket) * (SENSOR_BUCKET_MAX - 1));
+        __g_bucket_cnt--;
+    }
+    memcpy(&__g_buckets[__g_bucket_cnt++], p_bucket, sizeof(struct sensor_bucket));
+}
+
 static void __sensor_history_data_day_update(time_t now)
 {
+    /* Same order as enum export_field */
+    const struct sensor_present_data *present[EXPORT_FIELD_MAX] = {
+        &__g_sensor_present_data.temp, &__g_sensor_present_data.humidity,
+        &__g_sensor_present_data.co2, &__g_sensor_present_data.tvoc,
+        &__g_sensor_present_data.temp_ext, &__g_sensor_present_data.humidity_ext,
+        &__g_sensor_present_data.pm1_0, &__g_sensor_present_data.pm2_5, &__g_sensor_present_data.pm10,
+        &__g_sensor_present_data.no2, &__g_sensor_present_data.c2h5oh,
+        &__g_sensor_present_data.voc, &__g_sensor_present_data.co,
+    };
+    struct sensor_bucket bucket = {
+        .start = (now / SENSOR_BUCKET_SECONDS) * SENSOR_BUCKET_SECONDS,
+    };
+
     xSemaphoreTake(__g_data_mutex, portMAX_DELAY);
 
-    __sensor_history_data_day_insert( __g_sensor_history_data.temp.data_day, &__g_sensor_present_data.temp, now);
+    /* Before the insert resets the running sums */
+    for( int i = 0; i < EXPORT_FIELD_MAX; i++) {
+        __sensor_bucket_field_fill(&bucket.fields[i], present[i]);
+    }
+
+    bool closed = __sensor_history_data_day_insert( __g_sensor_history_data.temp.data_day, &__g_sensor_present_data.temp, now);
     __sensor_history_data_day_insert( __g_sensor_history_data.humidity.data_day, &__g_sensor_present_data.humidity, now);
     __sensor_history_data_day_insert( __g_sensor_history_data.co2.data_day, &__g_sensor_present_data.co2, now);
     __sensor_history_data_day_insert( __g_sensor_history_data.tvoc.data_day, &__g_sensor_present_data.tvoc, now);
@@ -509,6 +562,10 @@ static void __sensor_history_data_day_update(time_t now)
     __sensor_history_data_day_insert( __g_sensor_history_data.voc.data_day, &__g_sensor_present_data.voc, now);
     __sensor_history_data_day_insert( __g_sensor_history_data.co.data_day, &__g_sensor_present_data.co, now);
 
+    if( closed) {
+        __sensor_bucket_push(&bucket);
+    }
+
     xSemaphoreGive(__g_data_mutex);
 
     __sensor_history_data_save();
@@ -539,13 +596,15 @@ static void __sensor_history_data_week_update(time_t now)
 }
 
 
-static void __sensor_history_data_timer_callback(void* arg)
+/* On each local half hour, which includes midnight for the week data, and
+ * after each step of the clock or time zone change */
+static void __sensor_history_data_boundary_callback(time_t boundary, void *arg)
 {
     struct updata_queue_msg msg = {
         .flag = 3,
         .time = 0,
     };
-    xQueueSendFromISR(updata_queue_handle, &msg, NULL);
+    xQueueSend(updata_queue_handle, &msg, 0);
 }
 
 static void __sensor_history_data_update_check(void)
@@ -589,7 +648,7 @@ static void __sensor_history_data_update_check(void)
         last_timestamp1 = (now / HISTORY_INTERVAL_SECONDS) * HISTORY_INTERVAL_SECONDS;
     }
 
-    if( cur_day != last_day  &&  ((now - last_timestamp2) > (3600*24))) {
+    if( cur_day != last_day  &&  ((now - last_timestamp2) >= (3600*24))) {
         last_day = cur_day;
         if( last_timestamp2 == 0) {
             last_timestamp2 = ((now - 3600 * 24) / (3600 * 24)) * (3600 * 24);
@@ -603,13 +662,13 @@ static void __sensor_history_data_update_check(void)
 
 static void __sensor_history_data_update_init(void)
 {
-    const esp_timer_create_args_t timer_args = {
-            .callback = &__sensor_history_data_timer_callback,
-            .arg = NULL,
-            .name = "sensor data update"
-    };
-    ESP_ERROR_CHECK( esp_timer_create(&timer_args, &sensor_history_data_timer_handle));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(sensor_history_data_timer_handle, 1000000 * 10));
+    int id = indicator_time_boundary_register(HISTORY_INTERVAL_SECONDS, 0, true,
+                                              __sensor_history_data_boundary_callback, NULL);
+
+    /* A clock set at boot must not wait for the next half hour to reset
+     * stale history. Once now, in case it is set already */
+    indicator_time_boundary_on_step(id, true);
+    __sensor_history_data_boundary_callback(0, NULL);
 }
 
 static void sensor_history_data_updata_task(void *arg)
@@ -657,6 +716,17 @@ static void __sensor_present_data_update(struct sensor_present_data *p_data, flo
     p_data->per_hour_cnt++;
     p_data->sum += vaule;
     p_data->average = p_data->sum / p_data->per_hour_cnt;
+    if( p_data->per_hour_cnt != 1) {
+        if( p_data->bucket_min > vaule) {
+            p_data->bucket_min = vaule;
+        }
+        if( p_data->bucket_max < vaule) {
+            p_data->bucket_max = vaule;
+        }
+    } else {
+        p_data->bucket_min = vaule;
+        p_data->bucket_max = vaule;
+    }
 
 
     p_data->per_day_cnt++;
@@ -750,8 +820,6 @@ static int __data_parse_handle(uint8_t *p_data, ssize_t len)
             __sensor_present_data_update(&__g_sensor_present_data.co2, data.vaule);
             __g_current_sensor_data.co2 = data.vaule;
 
-            esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_SENSOR_DATA, \
-                           &data, sizeof(struct view_data_sensor_data ), portMAX_DELAY);
             break;
         } 
         
@@ -766,8 +834,6 @@ static int __data_parse_handle(uint8_t *p_data, ssize_t len)
             __sensor_present_data_update(&__g_sensor_present_data.temp, data.vaule);
             __g_current_sensor_data.temp_internal = data.vaule;
 
-            esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_SENSOR_DATA, \
-                           &data, sizeof(struct view_data_sensor_data ), portMAX_DELAY);
             break;
         } 
 
@@ -782,8 +848,6 @@ static int __data_parse_handle(uint8_t *p_data, ssize_t len)
             __sensor_present_data_update(&__g_sensor_present_data.humidity, data.vaule);
             __g_current_sensor_data.humidity_internal = data.vaule;
 
-            esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_SENSOR_DATA, \
-                           &data, sizeof(struct view_data_sensor_data ), portMAX_DELAY);
             break;
         } 
 
@@ -798,8 +862,6 @@ static int __data_parse_handle(uint8_t *p_data, ssize_t len)
             __sensor_present_data_update(&__g_sensor_present_data.tvoc, data.vaule);
             __g_current_sensor_data.tvoc = data.vaule;
 
-            esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_SENSOR_DATA, \
-                           &data, sizeof(struct view_data_sensor_data ), portMAX_DELAY);
             break;
         }
 
@@ -956,9 +1018,14 @@ static int __data_parse_handle(uint8_t *p_data, ssize_t len)
         }
 
         default:
-            break;
+            return 0;
     }
 
+    /* The store passes on what changed, a repeated reading costs the view nothing */
+    struct view_data_sensor current;
+    indicator_sensor_get_data(&current);
+    indicator_store_publish(STORE_TOPIC_SENSOR, &current, sizeof(current));
+    return 0;
 }
 
 static int __cmd_send(uint8_t cmd, void *p_data, uint8_t len)
@@ -1408,7 +1475,12 @@ int indicator_sensor_init(void)
     updata_queue_handle = xQueueCreate(4, sizeof( struct updata_queue_msg));
 
     __sensor_history_data_restore();
-    
+
+    __g_buckets = heap_caps_calloc(SENSOR_BUCKET_MAX, sizeof(struct sensor_bucket), MALLOC_CAP_SPIRAM);
+    if( !__g_buckets) {
+        ESP_LOGE(TAG, "No memory for history buckets");
+    }
+
     __sensor_history_data_update_init();
 
     xTaskCreate(esp32_rp2040_comm_task, "esp32_rp2040_comm_task", ESP32_RP2040_COMM_TASK_STACK_SIZE, NULL, 2, NULL);
@@ -1469,3 +1541,17 @@ int indicator_sensor_get_data(struct view_data_sensor *out_data)
     return 0;
 }
 
+int indicator_sensor_get_buckets(int64_t after, struct sensor_bucket *out, int max)
+{
+    int cnt = 0;
+
+    if (!out || max <= 0) return 0;
+    xSemaphoreTake(__g_data_mutex, portMAX_DELAY);
+    for (int i = 0; i < __g_bucket_cnt && cnt < max; i++) {
+        if (__g_buckets[i].start > after) {
+            memcpy(&out[cnt++], &__g_buckets[i], sizeof(struct sensor_bucket));
+        }
+    }
+    xSemaphoreGive(__g_data_mutex);
+    return cnt;
+}
@@ -3,6 +3,7 @@
 
 #include "config.h"
 #include "view_data.h"
+#include "indicator_export_queue.h"
 #include "driver/uart.h"
 
 
@@ -10,9 +11,28 @@
 extern "C" {
 #endif
 
+#define SENSOR_BUCKET_SECONDS  1800    /* history resolution, one aggregate per bucket */
+#define SENSOR_BUCKET_MAX      48      /* closed buckets kept in RAM, one day */
+
+struct sensor_bucket_field {
+    float    avg;
+    float    min;
+    float    max;
+    uint16_t count;     /* readings in the bucket, 0: avg/min/max are NaN */
+};
+
+/* Aggregates of one closed history bucket, fields in enum export_field order */
+struct sensor_bucket {
+    int64_t start;      /* bucket start, aligned to SENSOR_BUCKET_SECONDS */
+    struct sensor_bucket_field fields[EXPORT_FIELD_MAX];
+};
+
 int indicator_sensor_init(void);
 int indicator_sensor_get_data(struct view_data_sensor *out_data);
 
+/* Closed buckets starting after `after`, oldest first. Returns the number copied */
+int indicator_sensor_get_buckets(int64_t after, struct sensor_bucket *out, int max);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,137 @@
+#include "indicator_store.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+#define STORE_WORDS     (STORE_STATE_SIZE / 4)
+
+static const char *TAG = "store";
+
+struct store_state {
+    uint32_t words[STORE_WORDS];
+    size_t   size;
+    uint32_t version;
+    uint32_t changed;           /* since the last dispatch */
+};
+
+struct store_sub {
+    enum store_topic topic;
+    uint32_t   mask;
+    store_cb_t cb;
+    void      *arg;
+    bool       initial;         /* owes the subscriber the current state */
+};
+
+static struct store_state __g_topics[STORE_TOPIC_MAX];
+static SemaphoreHandle_t __g_mutex;
+static volatile bool __g_dirty;
+
+/* Only touched on the LVGL task */
+static struct store_sub __g_subs[STORE_SUB_MAX];
+static int __g_sub_cnt;
+static bool __g_initial;
+static uint32_t __g_deliver[STORE_WORDS];
+
+int indicator_store_init(void)
+{
+    __g_mutex = xSemaphoreCreateMutex();
+    return 0;
+}
+
+void indicator_store_publish(enum store_topic topic, const void *state, size_t size)
+{
+    uint32_t words[STORE_WORDS] = { 0 };
+    uint32_t changed = 0;
+
+    if (topic >= STORE_TOPIC_MAX || size > STORE_STATE_SIZE) {
+        ESP_LOGE(TAG, "Bad publish: topic %d, %u bytes", topic, (unsigned)size);
+        return;
+    }
+    memcpy(words, state, size);
+
+    xSemaphoreTake(__g_mutex, portMAX_DELAY);
+    struct store_state *t = &__g_topics[topic];
+    if (t->version == 0 || t->size != size) {
+        changed = STORE_ALL;
+    } else {
+        for (int i = 0; i < (size + 3) / 4; i++) {
+            if (words[i] != t->words[i]) {
+                changed |= 1u << (i < 31 ? i : 31);
+            }
+        }
+    }
+    if (changed) {
+        memcpy(t->words, words, sizeof(words));
+        t->size = size;
+        t->version++;
+        t->changed |= changed;
+        __g_dirty = true;
+    }
+    xSemaphoreGive(__g_mutex);
+}
+
+uint32_t indicator_store_get(enum store_topic topic, void *state, size_t size)
+{
+    uint32_t version;
+
+    if (topic >= STORE_TOPIC_MAX) {
+        return 0;
+    }
+    xSemaphoreTake(__g_mutex, portMAX_DELAY);
+    struct store_state *t = &__g_topics[topic];
+    memcpy(state, t->words, size < sizeof(t->words) ? size : sizeof(t->words));
+    version = t->version;
+    xSemaphoreGive(__g_mutex);
+    return version;
+}
+
+int indicator_store_subscribe(enum store_topic topic, uint32_t mask, store_cb_t cb, void *arg)
+{
+    if (topic >= STORE_TOPIC_MAX || __g_sub_cnt == STORE_SUB_MAX) {
+        ESP_LOGE(TAG, "No room for a subscriber of topic %d", topic);
+        return -1;
+    }
+    __g_subs[__g_sub_cnt++] = (struct store_sub) {
+        .topic = topic, .mask = mask, .cb = cb, .arg = arg, .initial = true,
+    };
+    __g_initial = true;
+    return 0;
+}
+
+void indicator_store_dispatch(void)
+{
+    if (!__g_dirty && !__g_initial) {
+        return;
+    }
+    __g_dirty = false;
+    __g_initial = false;
+
+    for (int topic = 0; topic < STORE_TOPIC_MAX; topic++) {
+        xSemaphoreTake(__g_mutex, portMAX_DELAY);
+        struct store_state *t = &__g_topics[topic];
+        uint32_t changed = t->changed;
+        uint32_t version = t->version;
+        t->changed = 0;
+        if (version) {
+            memcpy(__g_deliver, t->words, sizeof(__g_deliver));
+        }
+        xSemaphoreGive(__g_mutex);
+
+        if (version == 0) {
+            continue;       /* nothing to show yet, initial deliveries wait */
+        }
+        for (int i = 0; i < __g_sub_cnt; i++) {
+            struct store_sub *s = &__g_subs[i];
+            if (s->topic != topic) {
+                continue;
+            }
+            if (s->initial) {
+                s->initial = false;
+                s->cb(topic, STORE_ALL, __g_deliver, s->arg);
+            } else if (changed & s->mask) {
+                s->cb(topic, changed, __g_deliver, s->arg);
+            }
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef INDICATOR_STORE_H
+#define INDICATOR_STORE_H
+
+#include "config.h"
+#include "view_data.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * State the models share with the view. A model publishes the whole state
+ * of a topic whenever it may have changed; the store compares it word by
+ * word and keeps a mask of the 32-bit words that differ, bit n for word n
+ * (words past 31 share bit 31). Subscribers name the words they show and
+ * are called on the LVGL task, once per frame, with everything that changed
+ * since the last frame. Nothing is delivered for a publish that changed
+ * nothing.
+ */
+enum store_topic {
+    STORE_TOPIC_SENSOR,         /* struct view_data_sensor */
+    STORE_TOPIC_DB_STATUS,      /* struct view_data_db_status */
+    STORE_TOPIC_CLOCK,          /* time_t, on every wall-clock minute */
+    STORE_TOPIC_MAX,
+};
+
+#define STORE_STATE_SIZE    128     /* largest state of a topic */
+#define STORE_SUB_MAX       16
+
+/* Change bit of a word-sized field */
+#define STORE_BIT(type, field)  (1u << (offsetof(type, field) / 4 < 31 ? offsetof(type, field) / 4 : 31))
+#define STORE_ALL               0xffffffffu
+
+typedef void (*store_cb_t)(enum store_topic topic, uint32_t changed, const void *state, void *arg);
+
+int indicator_store_init(void);
+
+/* Any task. size must not exceed STORE_STATE_SIZE */
+void indicator_store_publish(enum store_topic topic, const void *state, size_t size);
+
+/* Latest published state, returns its version, 0 if never published */
+uint32_t indicator_store_get(enum store_topic topic, void *state, size_t size);
+
+/* LVGL task. cb runs when a word in mask changes, and once with the current
+ * state at the next frame if the topic was published before */
+int indicator_store_subscribe(enum store_topic topic, uint32_t mask, store_cb_t cb, void *arg);
+
+/* Called by the LVGL task before each frame, with the LVGL lock held */
+void indicator_store_dispatch(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,11 +1,37 @@
 #include "indicator_time.h"
-#include "esp_sntp.h"
+#include "indicator_storage.h"
+#include "ntp_client.h"
+#include "indicator_store.h"
+#include "indicator_net_health.h"
 #include "freertos/semphr.h"
 #include<stdlib.h>
+#include <sys/time.h>
 #include "nvs.h"
 #include "esp_timer.h"
 
-#define TIME_CFG_STORAGE  "time-cfg"
+#define TIME_CFG_STORAGE    "time-cfg"
+#define TIME_DRIFT_STORAGE  "time-drift"
+
+#define TIME_VALID              1577836800  /* 2020-01-01, earlier means the clock was never set */
+#define TIME_NTP_TIMEOUT_MS     1500
+
+/* Offsets up to this are slewed with adjtime() so history buckets and
+ * export timestamps never jump; larger ones, and the first sync after a
+ * cold boot, step the clock */
+#define TIME_STEP_THRESHOLD_US  (5 * 1000000LL)
+
+/* Sync interval: doubles while the clock holds within TIME_POLL_TIGHT_US */
+#define TIME_POLL_MIN_SEC       64
+#define TIME_POLL_MAX_SEC       3600
+#define TIME_POLL_TIGHT_US      50000
+#define TIME_RETRY_SEC          30
+
+/* Drift: the rate error is compensated every TIME_DRIFT_PERIOD_SEC and
+ * re-estimated from syncs at least TIME_DRIFT_MIN_SPAN_SEC apart */
+#define TIME_DRIFT_PERIOD_SEC   60
+#define TIME_DRIFT_MIN_SPAN_SEC 900
+#define TIME_DRIFT_MAX_PPB      500000
+#define TIME_DRIFT_SAVE_PPB     100         /* smaller changes are not worth a flash write */
 
 struct indicator_time
 {
@@ -18,7 +44,36 @@ static const char *TAG = "time";
 static struct indicator_time __g_time_model;
 static SemaphoreHandle_t       __g_data_mutex;
 
-static esp_timer_handle_t   view_update_timer_handle;
+struct time_boundary
+{
+    uint32_t period_sec;        /* 0: disabled */
+    uint32_t offset_sec;
+    bool     local;
+    bool     on_step;           /* cb also runs after a step or TZ change */
+    time_boundary_cb_t cb;
+    void    *arg;
+    time_t   next;              /* boundary it is armed for, 0: clock not set */
+    time_t   last;              /* last boundary it ran for */
+    int64_t  due_us;            /* esp_timer time, 0: not armed */
+};
+
+static struct time_boundary __g_boundaries[TIME_BOUNDARY_MAX];
+static int                  __g_boundary_cnt;
+static esp_timer_handle_t   __g_boundary_timer;
+static SemaphoreHandle_t    __g_boundary_mutex;
+static uint32_t             __g_boundary_wakeups;
+
+static const char *__g_ntp_servers[] = {
+    "0.pool.ntp.org", "1.pool.ntp.org", "2.pool.ntp.org", "cn.ntp.org.cn",
+};
+
+static SemaphoreHandle_t __g_sync_sem;
+static volatile bool __g_sync_enabled = false;
+static int32_t  __g_drift_ppb;             /* clock rate error, positive: it runs slow */
+static int32_t  __g_drift_saved_ppb;
+static int64_t  __g_drift_rem;             /* us * ppb not yet applied */
+static int64_t  __g_drift_last_us;
+static int64_t  __g_last_sync_us;          /* esp_timer time of the last slewed sync, 0: none */
 
 static void __time_cfg_set(struct view_data_time_cfg *p_cfg )
 {
@@ -71,12 +126,372 @@ static void __time_set(time_t time)
 
 static void __time_sync_enable(void)
 {
-    sntp_init();
+    __g_sync_enabled = true;
+    xSemaphoreGive(__g_sync_sem);
 }
 
 static void __time_sync_stop(void)
 {
-    sntp_stop();
+    __g_sync_enabled = false;
+}
+
+/* ========== Wall-clock boundaries ========== */
+
+/* Local time minus UTC at t, from localtime_r() and the days of the civil
+ * date (H. Hinnant's days_from_civil), newlib has no tm_gmtoff */
+static int32_t __utc_offset(time_t t)
+{
+    struct tm tm;
+    localtime_r(&t, &tm);
+
+    int y = tm.tm_year + 1900 - (tm.tm_mon < 2);
+    int m = tm.tm_mon + 1;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + tm.tm_mday - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = (int64_t)era * 146097 + doe - 719468;
+
+    return (int32_t)(days * 86400 + tm.tm_hour * 3600 + tm.tm_min * 60 + tm.tm_sec - t);
+}
+
+/* The current boundary if its offset is still ahead, else the next one;
+ * never the one it already ran for */
+static time_t __boundary_next(const struct time_boundary *b, time_t now)
+{
+    int32_t local = b->local ? __utc_offset(now) : 0;
+    time_t boundary = ((now + local) / b->period_sec) * b->period_sec - local;
+
+    while( boundary + (time_t)b->offset_sec <= now || boundary == b->last ) {
+        boundary += b->period_sec;
+    }
+    return boundary;
+}
+
+/* Work out every subscription's due time and arm the timer for the earliest.
+ * Called with __g_boundary_mutex held */
+static void __boundary_arm(void)
+{
+    struct timeval tv;
+    int64_t now_us = esp_timer_get_time();
+    int64_t earliest = INT64_MAX;
+
+    gettimeofday(&tv, NULL);
+    int64_t wall_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+
+    for( int i = 0; i < __g_boundary_cnt; i++ ) {
+        struct time_boundary *b = &__g_boundaries[i];
+        if( b->period_sec == 0 ) {
+            b->due_us = 0;
+            continue;
+        }
+        if( tv.tv_sec >= TIME_VALID ) {
+            b->next = __boundary_next(b, tv.tv_sec);
+            b->due_us = now_us + ((int64_t)(b->next + b->offset_sec) * 1000000 - wall_us);
+        } else if( b->next != 0 || b->due_us == 0 ) {
+            /* No wall clock: plain periods, kept when another one re-arms */
+            b->next = 0;
+            b->due_us = now_us + (int64_t)b->period_sec * 1000000;
+        }
+        if( b->due_us < earliest ) {
+            earliest = b->due_us;
+        }
+    }
+
+    esp_timer_stop(__g_boundary_timer);
+    if( earliest != INT64_MAX ) {
+        esp_timer_start_once(__g_boundary_timer, earliest > now_us ? earliest - now_us : 1);
+    }
+}
+
+static void __boundary_timer_callback(void *arg)
+{
+    struct time_boundary due[TIME_BOUNDARY_MAX];
+    int due_cnt = 0;
+    struct timeval tv;
+
+    xSemaphoreTake(__g_boundary_mutex, portMAX_DELAY);
+    __g_boundary_wakeups++;
+    int64_t now_us = esp_timer_get_time();
+    gettimeofday(&tv, NULL);
+    int64_t wall_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+
+    for( int i = 0; i < __g_boundary_cnt; i++ ) {
+        struct time_boundary *b = &__g_boundaries[i];
+        if( b->period_sec == 0 || b->due_us == 0 || b->due_us > now_us ) {
+            continue;
+        }
+        if( b->next != 0 ) {
+            /* A slew may have held the wall clock back: not there yet, re-armed below */
+            if( wall_us < (int64_t)(b->next + b->offset_sec) * 1000000 ) {
+                continue;
+            }
+            b->last = b->next;
+        } else {
+            b->due_us = 0;
+        }
+        due[due_cnt++] = *b;
+    }
+    __boundary_arm();
+    xSemaphoreGive(__g_boundary_mutex);
+
+    /* Outside the lock, a callback may change its own subscription */
+    for( int i = 0; i < due_cnt; i++ ) {
+        due[i].cb(due[i].next, due[i].arg);
+    }
+}
+
+static void __boundary_init(void)
+{
+    if( __g_boundary_mutex ) {
+        return;
+    }
+    const esp_timer_create_args_t timer_args = {
+        .callback = &__boundary_timer_callback,
+        .arg = NULL,
+        .name = "wall clock"
+    };
+    __g_boundary_mutex = xSemaphoreCreateMutex();
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &__g_boundary_timer));
+}
+
+/* After settimeofday() or a new TZ: the armed delay is off by the step */
+static void __boundary_rearm(void)
+{
+    struct time_boundary step[TIME_BOUNDARY_MAX];
+    int step_cnt = 0;
+
+    if( !__g_boundary_mutex ) {
+        return;
+    }
+    xSemaphoreTake(__g_boundary_mutex, portMAX_DELAY);
+    for( int i = 0; i < __g_boundary_cnt; i++ ) {
+        if( __g_boundaries[i].on_step && __g_boundaries[i].period_sec != 0 ) {
+            step[step_cnt++] = __g_boundaries[i];
+        }
+    }
+    __boundary_arm();
+    xSemaphoreGive(__g_boundary_mutex);
+
+    for( int i = 0; i < step_cnt; i++ ) {
+        step[i].cb(0, step[i].arg);
+    }
+}
+
+int indicator_time_boundary_register(uint32_t period_sec, uint32_t offset_sec, bool local,
+                                     time_boundary_cb_t cb, void *arg)
+{
+    int id;
+
+    /* Models start before indicator_time_init() */
+    __boundary_init();
+
+    xSemaphoreTake(__g_boundary_mutex, portMAX_DELAY);
+    if( __g_boundary_cnt >= TIME_BOUNDARY_MAX || !cb ) {
+        xSemaphoreGive(__g_boundary_mutex);
+        return -1;
+    }
+    id = __g_boundary_cnt++;
+    __g_boundaries[id] = (struct time_boundary) {
+        .period_sec = period_sec,
+        .offset_sec = offset_sec,
+        .local = local,
+        .cb = cb,
+        .arg = arg,
+    };
+    __boundary_arm();
+    xSemaphoreGive(__g_boundary_mutex);
+    return id;
+}
+
+void indicator_time_boundary_set(int id, uint32_t period_sec, uint32_t offset_sec)
+{
+    if( id < 0 || id >= __g_boundary_cnt ) {
+        return;
+    }
+    xSemaphoreTake(__g_boundary_mutex, portMAX_DELAY);
+    struct time_boundary *b = &__g_boundaries[id];
+    b->period_sec = period_sec;
+    b->offset_sec = offset_sec;
+    b->last = 0;
+    b->next = 0;
+    b->due_us = 0;
+    __boundary_arm();
+    xSemaphoreGive(__g_boundary_mutex);
+}
+
+void indicator_time_boundary_on_step(int id, bool on)
+{
+    if( id < 0 || id >= __g_boundary_cnt ) {
+        return;
+    }
+    xSemaphoreTake(__g_boundary_mutex, portMAX_DELAY);
+    __g_boundaries[id].on_step = on;
+    xSemaphoreGive(__g_boundary_mutex);
+}
+
+/* ========== Clock discipline ========== */
+
+static int64_t __adjtime_pending(void)
+{
+    struct timeval old = { 0 };
+    adjtime(NULL, &old);
+    return (int64_t)old.tv_sec * 1000000 + old.tv_usec;
+}
+
+static struct timeval __us_to_timeval(int64_t us)
+{
+    struct timeval tv = { .tv_sec = us / 1000000, .tv_usec = us % 1000000 };
+
+    if( tv.tv_usec < 0 ) {
+        tv.tv_sec--;
+        tv.tv_usec += 1000000;
+    }
+    return tv;
+}
+
+/* Add delta_us to what adjtime() still has to slew */
+static void __adjtime_add(int64_t delta_us)
+{
+    struct timeval tv = __us_to_timeval(__adjtime_pending() + delta_us);
+    adjtime(&tv, NULL);
+}
+
+static void __drift_restore(void)
+{
+    int32_t drift = 0;
+    size_t len = sizeof(drift);
+
+    if( indicator_storage_read(TIME_DRIFT_STORAGE, &drift, &len) == ESP_OK && len == sizeof(drift) &&
+        drift >= -TIME_DRIFT_MAX_PPB && drift <= TIME_DRIFT_MAX_PPB ) {
+        __g_drift_ppb = drift;
+        __g_drift_saved_ppb = drift;
+        ESP_LOGI(TAG, "Clock drift restored: %.3f ppm", drift / 1000.0);
+    }
+}
+
+/* Compensate the estimated rate error since the last call, also without
+ * network and across reboots once the estimate is stored */
+static void __drift_apply(void)
+{
+    int64_t now_us = esp_timer_get_time();
+    int64_t elapsed_us = now_us - __g_drift_last_us;
+    struct timeval tv;
+
+    __g_drift_last_us = now_us;
+    gettimeofday(&tv, NULL);
+    if( __g_drift_ppb == 0 || tv.tv_sec < TIME_VALID ) {
+        return;
+    }
+    __g_drift_rem += elapsed_us * __g_drift_ppb;
+    int64_t delta_us = __g_drift_rem / 1000000000;
+    __g_drift_rem -= delta_us * 1000000000;
+    if( delta_us != 0 ) {
+        __adjtime_add(delta_us);
+    }
+}
+
+/* A slewed sync: what is left of offset_us once the queued slew is done,
+ * accumulated since the last one, is the rate error not yet compensated */
+static void __drift_update(int64_t residual_us)
+{
+    int64_t now_us = esp_timer_get_time();
+    int64_t span_us = now_us - __g_last_sync_us;
+
+    if( __g_last_sync_us == 0 ) {
+        __g_last_sync_us = now_us;
+        return;
+    }
+    if( span_us < TIME_DRIFT_MIN_SPAN_SEC * 1000000LL ) {
+        return;
+    }
+    __g_last_sync_us = now_us;
+
+    /* Half the measured error per update keeps jitter out of the estimate */
+    int64_t drift = __g_drift_ppb + residual_us * 1000000000 / span_us / 2;
+    if( drift > TIME_DRIFT_MAX_PPB ) drift = TIME_DRIFT_MAX_PPB;
+    if( drift < -TIME_DRIFT_MAX_PPB ) drift = -TIME_DRIFT_MAX_PPB;
+    __g_drift_ppb = drift;
+    ESP_LOGI(TAG, "Clock drift: %.3f ppm (residual %lld us over %lld s)", drift / 1000.0,
+             residual_us, span_us / 1000000);
+
+    if( llabs(__g_drift_ppb - __g_drift_saved_ppb) >= TIME_DRIFT_SAVE_PPB ) {
+        if( indicator_storage_write(TIME_DRIFT_STORAGE, &__g_drift_ppb, sizeof(__g_drift_ppb)) == ESP_OK ) {
+            __g_drift_saved_ppb = __g_drift_ppb;
+        }
+    }
+}
+
+/* Query every server, combine, then slew or step. Returns the applied
+ * offset's magnitude in us, or -1 */
+static int64_t __time_sync(void)
+{
+    int cnt = sizeof(__g_ntp_servers) / sizeof(__g_ntp_servers[0]);
+    ntp_sample_t samples[sizeof(__g_ntp_servers) / sizeof(__g_ntp_servers[0])];
+    int64_t offset_us;
+    int used;
+    struct timeval tv;
+
+    for( int i = 0; i < cnt; i++ ) {
+        ntp_query(__g_ntp_servers[i], NTP_PORT, TIME_NTP_TIMEOUT_MS, &samples[i]);
+        indicator_net_health_report(__g_ntp_servers[i], samples[i].valid, samples[i].delay_us / 1000);
+    }
+    if( ntp_combine(samples, cnt, &offset_us, &used) != 0 ) {
+        ESP_LOGW(TAG, "NTP: no majority of servers agrees, clock left alone");
+        return -1;
+    }
+
+    gettimeofday(&tv, NULL);
+    if( tv.tv_sec < TIME_VALID || llabs(offset_us) > TIME_STEP_THRESHOLD_US ) {
+        int64_t now_us = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec + offset_us;
+        struct timeval zero = { 0 };
+
+        adjtime(&zero, NULL);           /* a queued slew would be wrong after the step */
+        tv = __us_to_timeval(now_us);
+        settimeofday(&tv, NULL);
+        __boundary_rearm();
+        __g_last_sync_us = 0;           /* the drift span starts over */
+        ESP_LOGI(TAG, "NTP: clock stepped by %lld ms (%d servers)", offset_us / 1000, used);
+    } else {
+        int64_t residual_us = offset_us - __adjtime_pending();
+        struct timeval delta = __us_to_timeval(offset_us);
+
+        adjtime(&delta, NULL);
+        __drift_update(residual_us);
+        ESP_LOGI(TAG, "NTP: slewing %lld us (%d servers)", offset_us, used);
+    }
+    __time_sync_notification_cb(&tv);
+    return llabs(offset_us);
+}
+
+static void __time_sync_task(void *p_arg)
+{
+    int poll_sec = TIME_POLL_MIN_SEC;
+    int64_t next_sync_us = 0;
+
+    __g_drift_last_us = esp_timer_get_time();
+    while(1) {
+        /* Given on enable or network up: sync right away */
+        bool kicked = xSemaphoreTake(__g_sync_sem, pdMS_TO_TICKS(TIME_DRIFT_PERIOD_SEC * 1000)) == pdTRUE;
+
+        __drift_apply();
+        if( !__g_sync_enabled || (!kicked && esp_timer_get_time() < next_sync_us) ) {
+            continue;
+        }
+
+        int64_t offset_us = __time_sync();
+        if( offset_us < 0 ) {
+            poll_sec = TIME_POLL_MIN_SEC;
+            next_sync_us = esp_timer_get_time() + TIME_RETRY_SEC * 1000000LL;
+            continue;
+        }
+        if( offset_us < TIME_POLL_TIGHT_US ) {
+            poll_sec = poll_sec * 2 > TIME_POLL_MAX_SEC ? TIME_POLL_MAX_SEC : poll_sec * 2;
+        } else {
+            poll_sec = TIME_POLL_MIN_SEC;
+        }
+        next_sync_us = esp_timer_get_time() + poll_sec * 1000000LL;
+    }
 }
 
 static void __time_zone_set(struct view_data_time_cfg *p_cfg)
@@ -117,6 +532,7 @@ static void __time_zone_set(struct view_data_time_cfg *p_cfg)
     ESP_LOGI(TAG, "Applying TZ environment variable: %s", zone_str);
     setenv("TZ", zone_str, 1);
     tzset();
+    __boundary_rearm();                 /* local boundaries moved */
 }
 
 static void __time_cfg(struct view_data_time_cfg *p_cfg, bool set_time)
@@ -129,41 +545,34 @@ static void __time_cfg(struct view_data_time_cfg *p_cfg, bool set_time)
         struct timeval timestamp = { p_cfg->time, 0 };
         if( set_time ) {
             settimeofday(&timestamp, NULL);
+            __boundary_rearm();
         }
     }
 }
 
-static void __time_view_update_callback(void* arg)
+/* On each minute, the view only shows hours and minutes */
+static void __time_view_update_callback(time_t boundary, void *arg)
 {
-    static int last_min = 60;
-    time_t now = 0;
-    struct tm timeinfo = { 0 };
-    time(&now);
-    localtime_r(&now, &timeinfo);
-    if( timeinfo.tm_min != last_min) {
-        last_min = timeinfo.tm_min;
-        
-        struct view_data_time_cfg cfg;
-        __time_cfg_get(&cfg);
-        bool time_format_24 = cfg.time_format_24;
-        esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_TIME, &time_format_24, sizeof(time_format_24), portMAX_DELAY);
-        ESP_LOGI(TAG, "need update time view");
-        char strftime_buf[64];
-        strftime(strftime_buf, sizeof(strftime_buf), "%c", &timeinfo);
-        ESP_LOGI(TAG, "%s", strftime_buf);
+    struct view_data_time_cfg cfg;
+    __time_cfg_get(&cfg);
+    bool time_format_24 = cfg.time_format_24;
+    esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_TIME, &time_format_24, sizeof(time_format_24), portMAX_DELAY);
+
+    time_t now = time(NULL);
+    indicator_store_publish(STORE_TOPIC_CLOCK, &now, sizeof(now));
+
+    if( boundary != 0 && boundary % 3600 == 0 ) {
+        xSemaphoreTake(__g_boundary_mutex, portMAX_DELAY);
+        uint32_t wakeups = __g_boundary_wakeups;
+        __g_boundary_wakeups = 0;
+        xSemaphoreGive(__g_boundary_mutex);
+        ESP_LOGI(TAG, "Wall-clock timer: %lu wakeups in the last hour", (unsigned long)wakeups);
     }
 }
 
-static __time_view_update_init(void)
+static void __time_view_update_init(void)
 {
-    const esp_timer_create_args_t timer_args = {
-            .callback = &__time_view_update_callback,
-            /* argument specified here will be passed to timer callback function */
-            .arg = (void*) view_update_timer_handle,
-            .name = "time update"
-    };
-    ESP_ERROR_CHECK( esp_timer_create(&timer_args, &view_update_timer_handle));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(view_update_timer_handle, 1000000)); //1s
+    indicator_time_boundary_register(60, 0, false, __time_view_update_callback, NULL);
 }
 
 
@@ -245,10 +654,9 @@ int indicator_time_init(void)
 
     __time_cfg_restore();
 
-    sntp_setoperatingmode(SNTP_OPMODE_POLL);
-    sntp_setservername(0, "pool.ntp.org");
-    sntp_setservername(1, "cn.ntp.org.cn");
-    sntp_set_time_sync_notification_cb(__time_sync_notification_cb);
+    __drift_restore();
+    __g_sync_sem = xSemaphoreCreateBinary();
+    xTaskCreate(&__time_sync_task, "__time_sync_task", 1024 * 4, NULL, 5, NULL);
     
     struct view_data_time_cfg cfg;
     __time_cfg_get(&cfg);
@@ -16,6 +16,29 @@ int indicator_time_init(void);
 // set TZ
 int indicator_time_net_zone_set( char *p);
 
+/*
+ * Wall-clock boundaries: one one-shot timer, armed for the earliest boundary
+ * any subscriber waits for, instead of every model polling the clock.
+ * cb runs on the esp_timer task at each multiple of period_sec (of UTC, or of
+ * local time when local is set) plus offset_sec, never before it, and gets
+ * the boundary. Until the clock is set it runs every period_sec with
+ * boundary 0. Steps of the clock and time zone changes re-arm the timer.
+ */
+typedef void (*time_boundary_cb_t)(time_t boundary, void *arg);
+
+#define TIME_BOUNDARY_MAX   4
+
+// returns a subscription id or -1; period_sec 0 registers it disabled
+int indicator_time_boundary_register(uint32_t period_sec, uint32_t offset_sec, bool local,
+                                     time_boundary_cb_t cb, void *arg);
+
+// new period and offset, period_sec 0 disables
+void indicator_time_boundary_set(int id, uint32_t period_sec, uint32_t offset_sec);
+
+// also run cb, with boundary 0, right after each step of the clock or time
+// zone change, for subscribers that have to catch up at once
+void indicator_time_boundary_on_step(int id, bool on);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,9 +1,13 @@
 #include "indicator_wifi.h"
+#include "indicator_storage.h"
+#include "indicator_util.h"
+#include "indicator_net_health.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "esp_system.h"
 #include "esp_wifi.h"
+#include <stdlib.h>
 
 #include "lwip/err.h"
 #include "lwip/sys.h"
@@ -12,22 +16,59 @@
 #include "lwip/sockets.h"
 #include "esp_event.h"
 #include "ping/ping_sock.h"
+#include "esp_timer.h"
+#include "esp_random.h"
 
 
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT      BIT1
 
+#define WIFI_FAST_STORAGE  "wifi-fast"
+
+/* Background scan: one channel at a time, results merged into a cache the
+ * Wi-Fi screen is answered from right away */
+#define WIFI_SCAN_CACHE_SIZE     32
+#define WIFI_SCAN_DWELL_MIN_MS   40     /* active dwell per channel: an empty one is left after min */
+#define WIFI_SCAN_DWELL_MAX_MS   80
+#define WIFI_SCAN_MAX_AGE_SEC    120    /* networks not seen for this long are dropped */
+#define WIFI_SCAN_REFRESH_SEC    10     /* requests within this of the last sweep get the cache only */
+#define WIFI_SCAN_RSSI_HYST_DB   5      /* smaller changes don't reorder the list */
+
+#define WIFI_PROFILE_STORAGE     "wifi-profiles"
+#define WIFI_PROFILE_MAX         4
+#define WIFI_PROFILE_ATTEMPTS    2      /* failures before the next saved network is tried */
+
+/* Reconnect delay: doubles per failed attempt up to the max, then a random
+ * point in its upper half, so devices that lost the same AP spread out */
+#define WIFI_BACKOFF_BASE_MS     1000
+#define WIFI_BACKOFF_MAX_MS      (5 * 60 * 1000)
+
+/* Roaming: after WIFI_ROAM_CHECKS weak readings, 5 s apart, move to a saved
+ * network the scan cache has at least WIFI_ROAM_HYST_DB stronger */
+#define WIFI_ROAM_RSSI           -75
+#define WIFI_ROAM_CHECKS         6
+#define WIFI_ROAM_HYST_DB        10
+
+/* Probe when indicator_net_health has nothing recent to go by */
+#define WIFI_PROBE_ADDR          "1.1.1.1"
+#define WIFI_PROBE_DEST          "ping " WIFI_PROBE_ADDR
+#define WIFI_PROBE_COUNT         3
+
 struct indicator_wifi
 {
     struct view_data_wifi_st  st;
     bool is_cfg;
-    int wifi_reconnect_cnt;  
 };
 
 static struct indicator_wifi _g_wifi_model;
 static SemaphoreHandle_t   __g_wifi_mutex;
 static SemaphoreHandle_t   __g_data_mutex;
 static SemaphoreHandle_t   __g_net_check_sem;
+/* Saved networks and the retry state (s_retry_num, wifi_retry_max and the
+ * __g_profile..., __g_roam_to, __g_weak_cnt, __g_user_connect globals). The
+ * default event loop, the view event loop, the reconnect timer and the net
+ * check task all change them. Taken before __g_wifi_mutex, never while posting */
+static SemaphoreHandle_t   __g_profile_mutex;
 
 
 static int s_retry_num = 0;
@@ -37,6 +78,77 @@ static bool __g_ping_done = true;
 
 static EventGroupHandle_t __wifi_event_group;
 
+/* The AP the station last associated with. A boot connect goes straight to
+ * it on its channel instead of scanning all channels for the SSID. The PMK
+ * is not kept here: the driver stores it with the station config in its
+ * own NVS namespace and skips PBKDF2 while SSID and password are unchanged */
+struct wifi_fast_cache
+{
+    uint8_t ssid[33];
+    uint8_t bssid[6];
+    uint8_t channel;
+};
+
+static struct wifi_fast_cache __g_fast_cache;
+static bool        __g_fast_connect = false;   /* driver config pinned to the cached AP */
+static const char *__g_connect_path = "scan";
+static int64_t     __g_connect_start_us;
+static int64_t     __g_assoc_us;               /* 0: not associated since the last start */
+
+struct wifi_scan_entry
+{
+    char    ssid[33];
+    bool    auth_mode;
+    int8_t  rssi;           /* strongest BSSID of the SSID */
+    int64_t seen_us;
+};
+
+static struct wifi_scan_entry __g_scan_cache[WIFI_SCAN_CACHE_SIZE];   /* strongest first */
+static int      __g_scan_cnt;
+static uint8_t  __g_scan_channel;           /* channel being scanned, 0: idle */
+static uint8_t  __g_scan_last_channel;
+static int64_t  __g_scan_sweep_us;          /* start of the current or last sweep */
+static int64_t  __g_scan_done_us;           /* end of the last sweep */
+static wifi_ap_record_t __g_scan_records[WIFI_SCAN_LIST_SIZE];
+static bool     __g_scan_for_view;          /* post the list, the Wi-Fi screen asked */
+
+/* Saved networks, index 0 first. One joined from the Wi-Fi screen moves to
+ * the front, one reached automatically keeps its place. Joining them needs
+ * their passwords, which are kept in NVS like the driver keeps its own; the
+ * network in the driver's station config is stored without it (see
+ * __g_driver_net) */
+struct wifi_profile
+{
+    char ssid[33];
+    char password[65];
+    bool have_password;
+};
+
+struct wifi_profiles
+{
+    uint8_t cnt;
+    struct wifi_profile p[WIFI_PROFILE_MAX];
+};
+
+static struct wifi_profiles __g_profiles;
+/* The network in the driver's station config (nvs.net80211). Its password is
+ * not written to our storage a second time but taken from the driver on boot */
+static struct wifi_profile __g_driver_net;
+static int      __g_profile_idx = -1;       /* profile the station is set to, -1: a new network */
+static int      __g_roam_to = -1;           /* profile to join after our own disconnect */
+static int      __g_weak_cnt;
+static bool     __g_user_connect = false;   /* the attempt was started from the Wi-Fi screen */
+static esp_timer_handle_t __g_reconnect_timer;
+
+/* Offline time per outage, from losing the link to having an IP again */
+static const uint32_t __g_offline_bounds_sec[] = { 2, 5, 15, 60, 300 };
+static uint32_t __g_offline_hist[6];
+static int64_t  __g_offline_total_us;
+static int64_t  __g_offline_since_us;       /* 0: online, or never was */
+static bool     __g_online = false;
+
+static void __scan_channel_done(void);
+
 static const char *TAG = "wifi-model";
 
 static int min(int a, int b) { return (a < b) ? a : b; }
@@ -55,6 +167,348 @@ static void __wifi_st_get(struct view_data_wifi_st *p_st )
     xSemaphoreGive(__g_data_mutex);
 }
 
+/* Post the state only when it changed as listeners see it: a steady
+ * connection is not announced again on every network check */
+static void __wifi_st_publish(struct view_data_wifi_st *p_st )
+{
+    static struct view_data_wifi_st last;
+    static bool posted = false;
+    bool same;
+
+    xSemaphoreTake(__g_data_mutex, portMAX_DELAY);
+    same = posted && last.is_connected == p_st->is_connected && last.is_connecting == p_st->is_connecting &&
+           last.is_network == p_st->is_network && strncmp(last.ssid, p_st->ssid, sizeof(last.ssid)) == 0 &&
+           wifi_rssi_level_get(last.rssi) == wifi_rssi_level_get(p_st->rssi);
+    memcpy(&last, p_st, sizeof(last));
+    posted = true;
+    xSemaphoreGive(__g_data_mutex);
+
+    if( !same ) {
+        esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_WIFI_ST, p_st, sizeof(struct view_data_wifi_st ), portMAX_DELAY);
+    }
+}
+
+static bool __fast_cache_restore(const wifi_config_t *p_cfg)
+{
+    size_t len = sizeof(__g_fast_cache);
+    esp_err_t ret = indicator_storage_read(WIFI_FAST_STORAGE, (void *)&__g_fast_cache, &len);
+
+    if( ret != ESP_OK || len != sizeof(__g_fast_cache) ) {
+        memset(&__g_fast_cache, 0, sizeof(__g_fast_cache));
+        return false;
+    }
+    /* Only while the same network is configured */
+    return __g_fast_cache.channel != 0 &&
+           strncmp((char *)__g_fast_cache.ssid, (char *)p_cfg->sta.ssid, sizeof(p_cfg->sta.ssid)) == 0;
+}
+
+static void __fast_cache_save(const wifi_event_sta_connected_t *event)
+{
+    struct wifi_fast_cache cache = {0};
+
+    memcpy(cache.ssid, event->ssid, min(event->ssid_len, sizeof(cache.ssid) - 1));
+    memcpy(cache.bssid, event->bssid, sizeof(cache.bssid));
+    cache.channel = event->channel;
+    if( memcmp(&cache, &__g_fast_cache, sizeof(cache)) == 0 ) {
+        return;     /* no flash write for every reconnect to the same AP */
+    }
+    if( indicator_storage_write(WIFI_FAST_STORAGE, (void *)&cache, sizeof(cache)) == ESP_OK ) {
+        __g_fast_cache = cache;
+        ESP_LOGI(TAG, "Cached AP " MACSTR " on channel %d", MAC2STR(cache.bssid), cache.channel);
+    }
+}
+
+static void __fast_cache_clear(void)
+{
+    memset(&__g_fast_cache, 0, sizeof(__g_fast_cache));
+    indicator_storage_write(WIFI_FAST_STORAGE, (void *)&__g_fast_cache, sizeof(__g_fast_cache));
+}
+
+/* Pin the station to the cached AP and channel, or back to the SSID alone.
+ * Set in RAM only, the config in flash keeps the plain SSID */
+static void __fast_connect_set(bool pinned)
+{
+    wifi_config_t cfg;
+
+    esp_wifi_get_config(WIFI_IF_STA, &cfg);
+    cfg.sta.bssid_set = pinned;
+    if( pinned ) {
+        memcpy(cfg.sta.bssid, __g_fast_cache.bssid, sizeof(cfg.sta.bssid));
+        cfg.sta.channel = __g_fast_cache.channel;
+    } else {
+        cfg.sta.channel = 0;
+    }
+    esp_wifi_set_storage(WIFI_STORAGE_RAM);
+    esp_wifi_set_config(WIFI_IF_STA, &cfg);
+    esp_wifi_set_storage(WIFI_STORAGE_FLASH);
+    __g_fast_connect = pinned;
+}
+
+static int __profile_find(const char *p_ssid)
+{
+    for( int i = 0; i < __g_profiles.cnt; i++ ) {
+        if( strcmp(__g_profiles.p[i].ssid, p_ssid) == 0 ) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void __profile_from_cfg(struct wifi_profile *p, const wifi_config_t *cfg)
+{
+    memset(p, 0, sizeof(*p));
+    memcpy(p->ssid, cfg->sta.ssid, sizeof(cfg->sta.ssid));
+    memcpy(p->password, cfg->sta.password, sizeof(cfg->sta.password));
+    p->have_password = p->password[0] != '\0';
+}
+
+static void __profiles_restore(void)
+{
+    size_t len = sizeof(__g_profiles);
+    esp_err_t ret = indicator_storage_read(WIFI_PROFILE_STORAGE, (void *)&__g_profiles, &len);
+
+    if( ret != ESP_OK || len != sizeof(__g_profiles) || __g_profiles.cnt > WIFI_PROFILE_MAX ) {
+        memset(&__g_profiles, 0, sizeof(__g_profiles));
+    }
+    ESP_LOGI(TAG, "%d saved networks", __g_profiles.cnt);
+}
+
+static void __profiles_save(void)
+{
+    struct wifi_profiles out = __g_profiles;
+
+    for( int i = 0; i < out.cnt; i++ ) {
+        if( __g_driver_net.have_password && strcmp(out.p[i].ssid, __g_driver_net.ssid) == 0 &&
+            strcmp(out.p[i].password, __g_driver_net.password) == 0 ) {
+            memset(out.p[i].password, 0, sizeof(out.p[i].password));
+        }
+    }
+    if( indicator_storage_write(WIFI_PROFILE_STORAGE, (void *)&out, sizeof(out)) != ESP_OK ) {
+        ESP_LOGW(TAG, "saving networks failed");
+    }
+    memset(&out, 0, sizeof(out));
+}
+
+/* Passwords left out by __profiles_save, from the driver's config */
+static void __profiles_fill(void)
+{
+    for( int i = 0; i < __g_profiles.cnt; i++ ) {
+        struct wifi_profile *p = &__g_profiles.p[i];
+        if( !p->have_password || p->password[0] != '\0' ) {
+            continue;
+        }
+        if( strcmp(p->ssid, __g_driver_net.ssid) == 0 ) {
+            memcpy(p->password, __g_driver_net.password, sizeof(p->password));
+        } else {
+            ESP_LOGW(TAG, "saved network %s has no password", p->ssid);
+        }
+    }
+}
+
+/* The driver's station config was written or erased. A saved network that
+ * was held there is now written with its password */
+static void __driver_net_set(const wifi_config_t *cfg)
+{
+    struct wifi_profile prev = __g_driver_net;
+
+    if( cfg ) {
+        __profile_from_cfg(&__g_driver_net, cfg);
+    } else {
+        memset(&__g_driver_net, 0, sizeof(__g_driver_net));
+    }
+    if( prev.have_password && __profile_find(prev.ssid) >= 0 &&
+        memcmp(&prev, &__g_driver_net, sizeof(prev)) != 0 ) {
+        __profiles_save();
+    }
+    memset(&prev, 0, sizeof(prev));
+}
+
+/* The network the station just got an IP on: added, or moved to the front
+ * when the user picked it. A full list loses its last one */
+static void __profile_joined(void)
+{
+    wifi_config_t cfg;
+    struct wifi_profile p;
+
+    esp_wifi_get_config(WIFI_IF_STA, &cfg);
+    __profile_from_cfg(&p, &cfg);
+
+    int idx = __profile_find(p.ssid);
+    int to = __g_user_connect ? 0 : idx;
+
+    if( idx < 0 ) {
+        idx = __g_profiles.cnt < WIFI_PROFILE_MAX ? __g_profiles.cnt++ : WIFI_PROFILE_MAX - 1;
+        to = __g_user_connect ? 0 : idx;
+    } else if( to == idx && memcmp(&__g_profiles.p[idx], &p, sizeof(p)) == 0 ) {
+        __g_profile_idx = idx;
+        return;     /* known and in place, no flash write */
+    }
+    for( int i = idx; i > to; i-- ) {
+        __g_profiles.p[i] = __g_profiles.p[i - 1];
+    }
+    __g_profiles.p[to] = p;
+    __g_profile_idx = to;
+    __g_user_connect = false;
+    __profiles_save();
+    ESP_LOGI(TAG, "saved network %s at priority %d of %d", p.ssid, to, __g_profiles.cnt);
+}
+
+static void __profile_forget(const char *p_ssid)
+{
+    int idx = __profile_find(p_ssid);
+
+    if( idx < 0 ) {
+        return;
+    }
+    for( int i = idx; i < __g_profiles.cnt - 1; i++ ) {
+        __g_profiles.p[i] = __g_profiles.p[i + 1];
+    }
+    __g_profiles.cnt--;
+    memset(&__g_profiles.p[__g_profiles.cnt], 0, sizeof(struct wifi_profile));
+    __g_profile_idx = -1;
+    __profiles_save();
+}
+
+/* Point the station at a saved network. In RAM like the fast connect: the
+ * config in flash stays the one last picked on the Wi-Fi screen */
+static void __profile_apply(int idx)
+{
+    const struct wifi_profile *p = &__g_profiles.p[idx];
+    wifi_config_t cfg = {0};
+
+    strncpy((char *)cfg.sta.ssid, p->ssid, sizeof(cfg.sta.ssid));
+    if( p->have_password ) {
+        strncpy((char *)cfg.sta.password, p->password, sizeof(cfg.sta.password));
+        cfg.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
+    } else {
+        cfg.sta.threshold.authmode = WIFI_AUTH_OPEN;
+    }
+    cfg.sta.sae_pwe_h2e = WPA3_SAE_PWE_BOTH;
+
+    esp_wifi_set_storage(WIFI_STORAGE_RAM);
+    esp_wifi_set_config(WIFI_IF_STA, &cfg);
+    esp_wifi_set_storage(WIFI_STORAGE_FLASH);
+    __g_fast_connect = false;
+    __g_profile_idx = idx;
+}
+
+/* RSSI of an SSID in the scan cache, INT8_MIN when the last sweeps missed it */
+static int __scan_rssi(const char *p_ssid)
+{
+    int rssi = INT8_MIN;
+
+    xSemaphoreTake(__g_wifi_mutex, portMAX_DELAY);
+    for( int i = 0; i < __g_scan_cnt; i++ ) {
+        if( strcmp(__g_scan_cache[i].ssid, p_ssid) == 0 ) {
+            rssi = __g_scan_cache[i].rssi;
+            break;
+        }
+    }
+    xSemaphoreGive(__g_wifi_mutex);
+    return rssi;
+}
+
+/* The saved network after the current one by priority. Ones the scan cache
+ * does not have are skipped, unless it has none of them */
+static int __profile_next(void)
+{
+    int start = __g_profile_idx < 0 ? __g_profiles.cnt - 1 : __g_profile_idx;
+    bool any_seen = false;
+
+    for( int i = 0; i < __g_profiles.cnt; i++ ) {
+        if( __scan_rssi(__g_profiles.p[i].ssid) != INT8_MIN ) {
+            any_seen = true;
+            break;
+        }
+    }
+    for( int n = 1; n <= __g_profiles.cnt; n++ ) {
+        int i = (start + n) % __g_profiles.cnt;
+        if( !any_seen || __scan_rssi(__g_profiles.p[i].ssid) != INT8_MIN ) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* A saved network clearly stronger than the weak current one, by priority */
+static int __profile_roam_target(const char *p_ssid, int rssi)
+{
+    for( int i = 0; i < __g_profiles.cnt; i++ ) {
+        int cand = __scan_rssi(__g_profiles.p[i].ssid);
+        if( strcmp(__g_profiles.p[i].ssid, p_ssid) != 0 && cand != INT8_MIN &&
+            cand >= rssi + WIFI_ROAM_HYST_DB && cand >= WIFI_ROAM_RSSI ) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void __reconnect_schedule(void)
+{
+    int shift = min(s_retry_num > 0 ? s_retry_num - 1 : 0, 16);
+    int64_t delay_ms = (int64_t)WIFI_BACKOFF_BASE_MS << shift;
+
+    if( delay_ms > WIFI_BACKOFF_MAX_MS ) {
+        delay_ms = WIFI_BACKOFF_MAX_MS;
+    }
+    delay_ms = delay_ms / 2 + esp_random() % (delay_ms / 2 + 1);
+
+    esp_timer_stop(__g_reconnect_timer);
+    esp_timer_start_once(__g_reconnect_timer, delay_ms * 1000);
+    ESP_LOGI(TAG, "reconnect attempt %d in %lld ms", s_retry_num + 1, delay_ms);
+}
+
+static void __reconnect_timer_callback(void *arg)
+{
+    struct view_data_wifi_st st;
+
+    __wifi_st_get(&st);
+    if( !_g_wifi_model.is_cfg || st.is_connected ) {
+        return;
+    }
+
+    xSemaphoreTake(__g_profile_mutex, portMAX_DELAY);
+
+    /* Every few failures the next saved network; a new one from the Wi-Fi
+     * screen first gets its wifi_retry_max attempts */
+    bool move_on = __g_user_connect ? s_retry_num >= wifi_retry_max : s_retry_num % WIFI_PROFILE_ATTEMPTS == 0;
+    if( move_on ) {
+        int next = __profile_next();
+        if( next >= 0 && next != __g_profile_idx ) {
+            ESP_LOGI(TAG, "trying saved network %s", __g_profiles.p[next].ssid);
+            __profile_apply(next);
+            __g_user_connect = false;
+        }
+    }
+
+    esp_err_t ret = esp_wifi_connect();
+    if( ret != ESP_OK ) {
+        ESP_LOGW(TAG, "connect not started: %s", esp_err_to_name(ret));
+        s_retry_num++;
+        __reconnect_schedule();
+    }
+    xSemaphoreGive(__g_profile_mutex);
+}
+
+static void __offline_account(int64_t now_us)
+{
+    if( __g_offline_since_us == 0 ) {
+        return;
+    }
+    int64_t offline_us = now_us - __g_offline_since_us;
+    int b = 0;
+
+    while( b < 5 && offline_us >= __g_offline_bounds_sec[b] * 1000000LL ) {
+        b++;
+    }
+    __g_offline_hist[b]++;
+    __g_offline_total_us += offline_us;
+    __g_offline_since_us = 0;
+    ESP_LOGI(TAG, "back online after %lld ms; outages <2s:%lu <5s:%lu <15s:%lu <1m:%lu <5m:%lu >=5m:%lu, %lld s offline in total",
+             offline_us / 1000, __g_offline_hist[0], __g_offline_hist[1], __g_offline_hist[2],
+             __g_offline_hist[3], __g_offline_hist[4], __g_offline_hist[5], __g_offline_total_us / 1000000);
+}
+
 static void __wifi_event_handler(void* arg, esp_event_base_t event_base,
                                 int32_t event_id, void* event_data)
 {
@@ -71,6 +525,8 @@ static void __wifi_event_handler(void* arg, esp_event_base_t event_base,
             st.rssi = 0;
             __wifi_st_set(&st);
 
+            __g_connect_start_us = esp_timer_get_time();
+            __g_assoc_us = 0;
             esp_wifi_connect();
             break;
         }
@@ -82,12 +538,22 @@ static void __wifi_event_handler(void* arg, esp_event_base_t event_base,
             __wifi_st_get(&st);
             memset(st.ssid, 0,  sizeof(st.ssid));
             memcpy(st.ssid, event->ssid, event->ssid_len);
-            st.rssi = -50; //todo
+            st.rssi = -50; // the network check reads the real one
             st.is_connected = true;
             st.is_connecting = false;
             __wifi_st_set(&st);
+
+            esp_timer_stop(__g_reconnect_timer);
+            xSemaphoreTake(__g_profile_mutex, portMAX_DELAY);
+            __g_weak_cnt = 0;
+            xSemaphoreGive(__g_profile_mutex);
+
+            __g_assoc_us = esp_timer_get_time();
+            ESP_LOGI(TAG, "Associated via %s: %lld ms after start, %lld ms after boot", __g_connect_path,
+                     (__g_assoc_us - __g_connect_start_us) / 1000, __g_assoc_us / 1000);
+            __fast_cache_save(event);
             
-            esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_WIFI_ST, &st, sizeof(struct view_data_wifi_st ), portMAX_DELAY);
+            __wifi_st_publish(&st);
             
             struct view_data_wifi_connet_ret_msg msg;
             msg.ret = 0;
@@ -97,26 +563,63 @@ static void __wifi_event_handler(void* arg, esp_event_base_t event_base,
         }
         case WIFI_EVENT_STA_DISCONNECTED: {
             ESP_LOGI(TAG, "wifi event: WIFI_EVENT_STA_DISCONNECTED");
+            wifi_event_sta_disconnected_t *event = (wifi_event_sta_disconnected_t*) event_data;
 
-            if ( (wifi_retry_max == -1) || s_retry_num < wifi_retry_max) {
+            if( __g_online ) {
+                __g_online = false;
+                __g_offline_since_us = esp_timer_get_time();
+            }
+            indicator_net_health_link(false);
+
+            xSemaphoreTake(__g_profile_mutex, portMAX_DELAY);
+            if( __g_roam_to >= 0 ) {
+                /* Our own disconnect: straight on to the stronger network */
+                ESP_LOGI(TAG, "roaming to %s", __g_profiles.p[__g_roam_to].ssid);
+                __profile_apply(__g_roam_to);
+                __g_roam_to = -1;
+                s_retry_num = 0;
+                xSemaphoreGive(__g_profile_mutex);
                 esp_wifi_connect();
-                s_retry_num++;
-                ESP_LOGI(TAG, "retry to connect to the AP");
+                break;
+            }
+            xSemaphoreGive(__g_profile_mutex);
+            if( __g_fast_connect ) {
+                /* Unpin on any disconnect. The AP may have moved, or be gone:
+                 * one full scan before the normal retries */
+                bool failed = __g_assoc_us == 0;
+                __fast_connect_set(false);
+                if( failed ) {
+                    ESP_LOGW(TAG, "Cached AP not reachable (reason %d), falling back to a full scan", event->reason);
+                    __fast_cache_clear();
+                    __g_connect_path = "scan after cached AP failed";
+                    esp_wifi_connect();
+                    break;
+                }
+            }
+            __g_connect_path = "scan";
+            __g_assoc_us = 0;
 
-            } else {
-                
-                // update list  todo
-                struct view_data_wifi_st st;
-        
-                __wifi_st_get(&st);
-                st.is_connected = false;
-                st.is_network   = false;
-                st.is_connecting = false;
-                __wifi_st_set(&st);
-
-                esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_WIFI_ST, &st, sizeof(struct view_data_wifi_st ), portMAX_DELAY);
-                
-                char *p_str = "";
+            if( !_g_wifi_model.is_cfg ) {
+                break;      /* shut down or forgotten */
+            }
+
+            xSemaphoreTake(__g_profile_mutex, portMAX_DELAY);
+            bool connecting = s_retry_num + 1 < wifi_retry_max;
+            s_retry_num++;
+            bool given_up = s_retry_num == wifi_retry_max;
+            /* Keeps trying, further and further apart */
+            __reconnect_schedule();
+            xSemaphoreGive(__g_profile_mutex);
+
+            struct view_data_wifi_st st;
+            __wifi_st_get(&st);
+            st.is_connected = false;
+            st.is_network   = false;
+            st.is_connecting = connecting;
+            __wifi_st_set(&st);
+            __wifi_st_publish(&st);
+
+            if( given_up ) {
                 struct view_data_wifi_connet_ret_msg msg;
                 msg.ret = 0;
                 strcpy(msg.msg, "Connection failure");
@@ -124,6 +627,12 @@ static void __wifi_event_handler(void* arg, esp_event_base_t event_base,
             }
             break;
         }
+        case WIFI_EVENT_SCAN_DONE: {
+            if( __g_scan_channel != 0 ) {
+                __scan_channel_done();
+            }
+            break;
+        }
     default:
         break;
     }
@@ -135,7 +644,17 @@ static void __ip_event_handler(void* arg, esp_event_base_t event_base,
     if ( event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "got ip:" IPSTR, IP2STR(&event->ip_info.ip));
+
+        int64_t now_us = esp_timer_get_time();
+        ESP_LOGI(TAG, "IP via %s: %lld ms after start, %lld ms after boot", __g_connect_path,
+                 (now_us - __g_connect_start_us) / 1000, now_us / 1000);
+        __offline_account(now_us);
+        __g_online = true;
+        xSemaphoreTake(__g_profile_mutex, portMAX_DELAY);
         s_retry_num = 0;
+        __profile_joined();
+        xSemaphoreGive(__g_profile_mutex);
+        indicator_net_health_link(true);
 
         //xEventGroupSetBits(__wifi_event_group, WIFI_CONNECTED_BIT);
         xSemaphoreGive(__g_net_check_sem);  //goto check network
@@ -148,33 +667,213 @@ static void __ip_event_handler(void* arg, esp_event_base_t event_base,
 //     return true; //todo
 // }
 
-static int __wifi_scan(wifi_ap_record_t *p_ap_info, uint16_t number)
+/* One channel's results into the cache, one entry per SSID. Returns true
+ * when what the list shows changed. Called with __g_wifi_mutex held */
+static bool __scan_cache_merge(const wifi_ap_record_t *p_ap, int cnt, int64_t now_us)
 {
-    uint16_t ap_count;
+    bool changed = false;
+
+    for( int i = 0; i < cnt; i++ ) {
+        const char *ssid = (const char *)p_ap[i].ssid;
+        struct wifi_scan_entry *e = NULL;
+
+        if( ssid[0] == '\0' ) {
+            continue;   /* hidden, nothing to tap on */
+        }
+        for( int j = 0; j < __g_scan_cnt; j++ ) {
+            if( strcmp(__g_scan_cache[j].ssid, ssid) == 0 ) {
+                e = &__g_scan_cache[j];
+                break;
+            }
+        }
+        if( e ) {
+            /* Seen earlier in this sweep: another BSSID, keep the stronger */
+            bool this_sweep = e->seen_us >= __g_scan_sweep_us;
+            if( abs(p_ap[i].rssi - e->rssi) >= WIFI_SCAN_RSSI_HYST_DB && (!this_sweep || p_ap[i].rssi > e->rssi) ) {
+                e->rssi = p_ap[i].rssi;
+                changed = true;
+            }
+            e->seen_us = now_us;
+            continue;
+        }
+        if( __g_scan_cnt < WIFI_SCAN_CACHE_SIZE ) {
+            e = &__g_scan_cache[__g_scan_cnt++];
+        } else {
+            /* Full: the weakest makes room for a stronger one */
+            e = &__g_scan_cache[0];
+            for( int j = 1; j < __g_scan_cnt; j++ ) {
+                if( __g_scan_cache[j].rssi < e->rssi ) {
+                    e = &__g_scan_cache[j];
+                }
+            }
+            if( p_ap[i].rssi <= e->rssi ) {
+                continue;
+            }
+        }
+        strlcpy(e->ssid, ssid, sizeof(e->ssid));
+        e->auth_mode = p_ap[i].authmode != WIFI_AUTH_OPEN;
+        e->rssi = p_ap[i].rssi;
+        e->seen_us = now_us;
+        changed = true;
+    }
+
+    /* Few entries, mostly in order already */
+    for( int i = 1; i < __g_scan_cnt; i++ ) {
+        struct wifi_scan_entry e = __g_scan_cache[i];
+        int j = i;
+        for( ; j > 0 && __g_scan_cache[j - 1].rssi < e.rssi; j-- ) {
+            __g_scan_cache[j] = __g_scan_cache[j - 1];
+        }
+        __g_scan_cache[j] = e;
+    }
+    return changed;
+}
+
+/* Drop what was not seen for WIFI_SCAN_MAX_AGE_SEC. Called with __g_wifi_mutex held */
+static bool __scan_cache_age(int64_t now_us)
+{
+    int cnt = 0;
+
+    for( int i = 0; i < __g_scan_cnt; i++ ) {
+        if( now_us - __g_scan_cache[i].seen_us <= WIFI_SCAN_MAX_AGE_SEC * 1000000LL ) {
+            __g_scan_cache[cnt++] = __g_scan_cache[i];
+        }
+    }
+    bool changed = cnt != __g_scan_cnt;
+    __g_scan_cnt = cnt;
+    return changed;
+}
+
+static void __scan_list_post(void)
+{
+    struct view_data_wifi_list list;
+    struct view_data_wifi_st st;
+
+    memset(&list, 0 , sizeof(struct view_data_wifi_list ));
+    __wifi_st_get(&st);
+
+    list.is_connect = st.is_connected;
+    if( st.is_connected ) {
+        strlcpy((char *)list.connect.ssid, (char *)st.ssid, sizeof(list.connect.ssid));
+        list.connect.auth_mode =false;
+        list.connect.rssi = st.rssi;
+    }
+
+    xSemaphoreTake(__g_wifi_mutex, portMAX_DELAY);
+    list.cnt = min(__g_scan_cnt, WIFI_SCAN_LIST_SIZE);
+    for( int i = 0; i < list.cnt; i++ ) {
+        strlcpy(list.aps[i].ssid, __g_scan_cache[i].ssid, sizeof(list.aps[i].ssid));
+        list.aps[i].auth_mode = __g_scan_cache[i].auth_mode;
+        list.aps[i].rssi = __g_scan_cache[i].rssi;
+    }
+    xSemaphoreGive(__g_wifi_mutex);
+
+    esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_WIFI_LIST, &list, sizeof(struct view_data_wifi_list ), portMAX_DELAY);
+}
+
+/* Non-blocking scan of one channel, WIFI_EVENT_SCAN_DONE moves on to the next */
+static void __scan_channel_start(uint8_t channel)
+{
+    wifi_scan_config_t cfg = {
+        .channel = channel,
+        .show_hidden = false,
+        .scan_type = WIFI_SCAN_TYPE_ACTIVE,
+        .scan_time.active = { .min = WIFI_SCAN_DWELL_MIN_MS, .max = WIFI_SCAN_DWELL_MAX_MS },
+    };
+    esp_err_t ret = esp_wifi_scan_start(&cfg, false);
+
+    if( ret != ESP_OK ) {
+        /* Busy connecting: the sweep ends here, the list still gets an answer */
+        ESP_LOGW(TAG, "scan of channel %d not started: %s", channel, esp_err_to_name(ret));
+        xSemaphoreTake(__g_wifi_mutex, portMAX_DELAY);
+        __g_scan_channel = 0;
+        __g_scan_done_us = esp_timer_get_time();
+        xSemaphoreGive(__g_wifi_mutex);
+        if( __g_scan_for_view ) {
+            __scan_list_post();
+        }
+    }
+}
+
+static void __scan_sweep_start(bool for_view)
+{
+    wifi_country_t country;
+    uint8_t first = 1;
+    int64_t now_us = esp_timer_get_time();
+
+    xSemaphoreTake(__g_wifi_mutex, portMAX_DELAY);
+    if( for_view ) {
+        __g_scan_for_view = true;   /* also when it joins a roaming sweep */
+    }
+    if( __g_scan_channel != 0 ||
+        (__g_scan_done_us != 0 && now_us - __g_scan_done_us < WIFI_SCAN_REFRESH_SEC * 1000000LL) ) {
+        xSemaphoreGive(__g_wifi_mutex);
+        return;     /* running, or the cache is fresh */
+    }
+    __g_scan_last_channel = 13;
+    if( esp_wifi_get_country(&country) == ESP_OK && country.nchan > 0 ) {
+        first = country.schan;
+        __g_scan_last_channel = country.schan + country.nchan - 1;
+    }
+    __g_scan_channel = first;
+    __g_scan_sweep_us = now_us;
+    __g_scan_for_view = for_view;
+    xSemaphoreGive(__g_wifi_mutex);
+
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA) );
     ESP_ERROR_CHECK(esp_wifi_start());
-    esp_wifi_scan_start(NULL, true);
-    ESP_ERROR_CHECK(esp_wifi_scan_get_ap_num(&ap_count));
-    ESP_ERROR_CHECK(esp_wifi_scan_get_ap_records(&number, p_ap_info));
-    ESP_LOGI(TAG, " scan ap cont: %d", ap_count);
-    
-    for (int i = 0; (i < number) && (i < ap_count); i++) {
-        ESP_LOGI(TAG, "SSID: %s, RSSI:%d, Channel: %d", p_ap_info[i].ssid, p_ap_info[i].rssi, p_ap_info[i].primary);
-    }
-    return ap_count;
+    __scan_channel_start(first);
 }
 
+static void __scan_channel_done(void)
+{
+    uint16_t number = WIFI_SCAN_LIST_SIZE;
+    int64_t now_us = esp_timer_get_time();
+    uint8_t next = 0;
+    bool changed;
+
+    /* Also frees the driver's copy of the results */
+    if( esp_wifi_scan_get_ap_records(&number, __g_scan_records) != ESP_OK ) {
+        number = 0;
+    }
+
+    xSemaphoreTake(__g_wifi_mutex, portMAX_DELAY);
+    changed = __scan_cache_merge(__g_scan_records, number, now_us);
+    if( __g_scan_channel < __g_scan_last_channel ) {
+        next = ++__g_scan_channel;
+    } else {
+        changed |= __scan_cache_age(now_us);
+        __g_scan_channel = 0;
+        __g_scan_done_us = now_us;
+        ESP_LOGI(TAG, "scan sweep: %d networks cached, %lld ms", __g_scan_cnt,
+                 (now_us - __g_scan_sweep_us) / 1000);
+    }
+    xSemaphoreGive(__g_wifi_mutex);
+
+    /* In place as results come in; the end of a sweep always answers, an
+     * empty cache still has a spinner to hide */
+    if( __g_scan_for_view && (changed || next == 0) ) {
+        __scan_list_post();
+    }
+    if( next ) {
+        __scan_channel_start(next);
+    }
+}
 
 static int __wifi_connect(const char *p_ssid, const char *p_password, int retry_num)
 {
+    esp_timer_stop(__g_reconnect_timer);
+    xSemaphoreTake(__g_profile_mutex, portMAX_DELAY);
     wifi_retry_max = retry_num; //todo
     s_retry_num =0;
+    __g_user_connect = true;
+    __g_profile_idx = __profile_find(p_ssid);
+    xSemaphoreGive(__g_profile_mutex);
 
     wifi_config_t wifi_config = {0};
     strlcpy((char *)wifi_config.sta.ssid, p_ssid, sizeof(wifi_config.sta.ssid));
     ESP_LOGI(TAG, "ssid: %s", p_ssid);
     if( p_password ) {
-        ESP_LOGI(TAG, "password: %s", p_password);
         strlcpy((char *)wifi_config.sta.password, p_password, sizeof(wifi_config.sta.password));
         wifi_config.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK; //todo
     } else {
@@ -185,6 +884,11 @@ static int __wifi_connect(const char *p_ssid, const char *p_password, int retry_
     esp_wifi_stop();
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA) );
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config) );
+    xSemaphoreTake(__g_profile_mutex, portMAX_DELAY);
+    __driver_net_set(&wifi_config);
+    xSemaphoreGive(__g_profile_mutex);
+    __g_fast_connect = false;
+    __g_connect_path = "scan";
 
     _g_wifi_model.is_cfg = true;
 
@@ -202,7 +906,17 @@ static int __wifi_connect(const char *p_ssid, const char *p_password, int retry_
 
 static void __wifi_cfg_restore(void) 
 {
+    wifi_config_t cfg;
+    char ssid[33] = {0};
+
+    esp_wifi_get_config(WIFI_IF_STA, &cfg);
+    memcpy(ssid, cfg.sta.ssid, sizeof(cfg.sta.ssid));
+
     _g_wifi_model.is_cfg = false;
+    esp_timer_stop(__g_reconnect_timer);
+    xSemaphoreTake(__g_profile_mutex, portMAX_DELAY);
+    __profile_forget(ssid);
+    xSemaphoreGive(__g_profile_mutex);
     
     struct view_data_wifi_st st = {0};
     st.is_connected = false;
@@ -210,15 +924,34 @@ static void __wifi_cfg_restore(void)
     st.is_network   = false;
     __wifi_st_set(&st);
 
-    esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_WIFI_ST, &st, sizeof(struct view_data_wifi_st ), portMAX_DELAY);
+    __wifi_st_publish(&st);
 
     // restore and stop
     esp_wifi_restore();
+    __g_fast_connect = false;
+    __fast_cache_clear();
+
+    /* Other saved networks: go on with the first of them */
+    xSemaphoreTake(__g_profile_mutex, portMAX_DELAY);
+    __driver_net_set(NULL);
+    bool other = __g_profiles.cnt > 0;
+    if( other ) {
+        ESP_LOGI(TAG, "joining saved network %s", __g_profiles.p[0].ssid);
+        _g_wifi_model.is_cfg = true;
+        s_retry_num = 0;
+        ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+        __profile_apply(0);
+    }
+    xSemaphoreGive(__g_profile_mutex);
+    if( other ) {
+        ESP_ERROR_CHECK(esp_wifi_start());
+    }
 }
 
 static void __wifi_shutdown(void) 
 {
     _g_wifi_model.is_cfg = false;  //disable reconnect
+    esp_timer_stop(__g_reconnect_timer);
     
     struct view_data_wifi_st st = {0};
     st.is_connected = false;
@@ -226,50 +959,42 @@ static void __wifi_shutdown(void)
     st.is_network   = false;
     __wifi_st_set(&st);
 
-    esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_WIFI_ST, &st, sizeof(struct view_data_wifi_st ), portMAX_DELAY);
+    __wifi_st_publish(&st);
 
     esp_wifi_stop();
 }
 
-static void __ping_end(esp_ping_handle_t hdl, void *args)
+/* Reachability comes from indicator_net_health, fed by real traffic */
+static void __net_health_cb(bool reachable)
 {
-    ip_addr_t target_addr;
-    uint32_t transmitted =0;
-    uint32_t received =0;
-    uint32_t total_time_ms =0 ;
-    uint32_t loss = 0;
-    esp_ping_get_profile(hdl, ESP_PING_PROF_REQUEST, &transmitted, sizeof(transmitted));
-    esp_ping_get_profile(hdl, ESP_PING_PROF_REPLY, &received, sizeof(received));
-    esp_ping_get_profile(hdl, ESP_PING_PROF_IPADDR, &target_addr, sizeof(target_addr));
-    esp_ping_get_profile(hdl, ESP_PING_PROF_DURATION, &total_time_ms, sizeof(total_time_ms));
-    
-    if( transmitted > 0 ) {
-        loss = (uint32_t)((1 - ((float)received) / transmitted) * 100);
-    } else {
-        loss = 100;
-    }
-     
-    if (IP_IS_V4(&target_addr)) {
-        printf("\n--- %s ping statistics ---\n", inet_ntoa(*ip_2_ip4(&target_addr)));
-    } else {
-        printf("\n--- %s ping statistics ---\n", inet6_ntoa(*ip_2_ip6(&target_addr)));
+    struct view_data_wifi_st st;
+
+    __wifi_st_get(&st);
+    if( !st.is_connected ) {
+        return;
     }
-    printf("%d packets transmitted, %d received, %d%% packet loss, time %dms\n",
-           transmitted, received, loss, total_time_ms);
+    st.is_network = reachable;
+    __wifi_st_set(&st);
+    __wifi_st_publish(&st);
+}
 
-    esp_ping_delete_session(hdl);
+/* The probe, only run when there was no traffic to judge by */
+static void __ping_success(esp_ping_handle_t hdl, void *args)
+{
+    uint32_t elapsed_ms = 0;
 
-    struct view_data_wifi_st st;
-    if( received > 0) {
-        __wifi_st_get(&st);
-        st.is_network = true;
-        __wifi_st_set(&st);
-    } else {
-        __wifi_st_get(&st);
-        st.is_network = false;
-        __wifi_st_set(&st);
-    }
-    esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_WIFI_ST, &st, sizeof(struct view_data_wifi_st ), portMAX_DELAY);
+    esp_ping_get_profile(hdl, ESP_PING_PROF_TIMEGAP, &elapsed_ms, sizeof(elapsed_ms));
+    indicator_net_health_report(WIFI_PROBE_DEST, true, elapsed_ms);
+}
+
+static void __ping_timeout(esp_ping_handle_t hdl, void *args)
+{
+    indicator_net_health_report(WIFI_PROBE_DEST, false, 0);
+}
+
+static void __ping_end(esp_ping_handle_t hdl, void *args)
+{
+    esp_ping_delete_session(hdl);
     __g_ping_done = true;
 }
 
@@ -278,14 +1003,15 @@ static void __ping_start(void)
     esp_ping_config_t config = ESP_PING_DEFAULT_CONFIG();
 
     ip_addr_t target_addr;
-    ipaddr_aton("1.1.1.1", &target_addr);
+    ipaddr_aton(WIFI_PROBE_ADDR, &target_addr);
 
     config.target_addr = target_addr;
+    config.count = WIFI_PROBE_COUNT;
 
     esp_ping_callbacks_t cbs = {
         .cb_args = NULL,
-        .on_ping_success = NULL,
-        .on_ping_timeout = NULL,
+        .on_ping_success = __ping_success,
+        .on_ping_timeout = __ping_timeout,
         .on_ping_end = __ping_end
     };
     esp_ping_handle_t ping;
@@ -294,10 +1020,51 @@ static void __ping_start(void)
     esp_ping_start(ping);
 }
 
+/* Signal of the current AP, and a move to a stronger saved network when it
+ * stays weak */
+static void __roam_check(void)
+{
+    wifi_ap_record_t ap;
+    struct view_data_wifi_st st;
+
+    if( esp_wifi_sta_get_ap_info(&ap) != ESP_OK ) {
+        return;
+    }
+    __wifi_st_get(&st);
+    st.rssi = ap.rssi;
+    __wifi_st_set(&st);
+    __wifi_st_publish(&st);
+
+    xSemaphoreTake(__g_profile_mutex, portMAX_DELAY);
+    if( ap.rssi >= WIFI_ROAM_RSSI || __g_profiles.cnt < 2 ) {
+        __g_weak_cnt = 0;
+        xSemaphoreGive(__g_profile_mutex);
+        return;
+    }
+    if( ++__g_weak_cnt < WIFI_ROAM_CHECKS ) {
+        xSemaphoreGive(__g_profile_mutex);
+        return;
+    }
+    __g_weak_cnt = 0;
+
+    int to = __profile_roam_target((char *)ap.ssid, ap.rssi);
+    if( to >= 0 ) {
+        ESP_LOGI(TAG, "%s weak (%d dBm), %s has %d dBm", (char *)ap.ssid, ap.rssi,
+                 __g_profiles.p[to].ssid, __scan_rssi(__g_profiles.p[to].ssid));
+        __g_roam_to = to;
+    }
+    xSemaphoreGive(__g_profile_mutex);
+
+    if( to < 0 ) {
+        __scan_sweep_start(false);      /* fresh candidates for the next round */
+        return;
+    }
+    esp_wifi_disconnect();
+}
+
 // net check
 static void __indicator_wifi_task(void *p_arg)
 {
-    int cnt = 0;
     struct view_data_wifi_st st;
 
     while(1) {
@@ -305,41 +1072,16 @@ static void __indicator_wifi_task(void *p_arg)
         xSemaphoreTake(__g_net_check_sem, pdMS_TO_TICKS(5000));
         __wifi_st_get(&st);
 
-        // Periodically check the network connection status
+        // Probe only when no traffic told us how the network is doing
         if( st.is_connected) {
 
-            if(__g_ping_done ) {
-                if( st.is_network ) {
-                    cnt++;
-                    //5min check network
-                    if( cnt > 60) {
-                        cnt = 0;
-                        ESP_LOGI(TAG, "Network normal last time, retry check network...");
-                        __ping_start();
-                    }
-                } else {
-                    ESP_LOGI(TAG, "Last network exception, check network...");
-                    __ping_start();
-                }
+            if( __g_ping_done && indicator_net_health_probe_due() ) {
+                ESP_LOGI(TAG, "No recent traffic, probing network...");
+                __ping_start();
             }
-
-        } else if(  _g_wifi_model.is_cfg && !st.is_connecting) {
-            // Periodically check the wifi connection status
-
-            // 5min retry connect 
-            if( _g_wifi_model.wifi_reconnect_cnt > 5 ) {
-                ESP_LOGI(TAG, " Wifi reconnect...");
-                _g_wifi_model.wifi_reconnect_cnt =0;
-                wifi_retry_max = 3;
-                s_retry_num =0;
-
-                esp_wifi_stop();
-                ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA) );
-                ESP_ERROR_CHECK(esp_wifi_start());
-            }
-            _g_wifi_model.wifi_reconnect_cnt++;
+            __roam_check();
         }
-
+        // reconnecting is up to the backoff timer
     }
 }
 
@@ -352,53 +1094,11 @@ static void __view_event_handler(void* handler_args, esp_event_base_t base, int3
         case VIEW_EVENT_WIFI_LIST_REQ: {
             ESP_LOGI(TAG, "event: VIEW_EVENT_WIFI_LIST_REQ");
 
-            uint16_t number = WIFI_SCAN_LIST_SIZE;
-            uint16_t ap_count = 0;
-            wifi_ap_record_t ap_info[WIFI_SCAN_LIST_SIZE];
-            ap_count = __wifi_scan(ap_info, number);
-
-            struct view_data_wifi_list list;
-            struct view_data_wifi_st st;
-
-            memset(&list, 0 , sizeof(struct view_data_wifi_list ));
-            
-            __wifi_st_get(&st);
-
-            list.is_connect = st.is_connected;
-            if( st.is_connected ) {
-                strlcpy((char *)list.connect.ssid, (char *)st.ssid, sizeof(list.connect.ssid));
-                list.connect.auth_mode =false;
-                list.connect.rssi = st.rssi;
-            }
-            
-            ap_count= min(number, ap_count);
-            
-            bool is_exist =  false;
-            int list_cnt = 0;
-            for(int i = 0; i <  ap_count; i++ ) {
-
-                is_exist = false;
-                for( int j = 0; j < list_cnt; j++ ) {
-                    if(strcmp(list.aps[j].ssid, ap_info[i].ssid) == 0) {
-                        ESP_LOGI(TAG, "list exit ap:%s", ap_info[i].ssid);
-                        is_exist = true;
-                        break;
-                    }
-                }
-                if(!is_exist) {
-                    strcpy(list.aps[list_cnt].ssid, ap_info[i].ssid);
-                    list.aps[list_cnt].rssi = ap_info[i].rssi;
-                    if( ap_info[i].authmode == WIFI_AUTH_OPEN) {
-                        list.aps[list_cnt].auth_mode = false;
-                    } else {
-                        list.aps[list_cnt].auth_mode = true;
-                    } 
-                    list_cnt++;
-                }
+            /* The cache answers at once, a sweep then refreshes it in place */
+            if( __g_scan_cnt > 0 ) {
+                __scan_list_post();
             }
-            list.cnt = list_cnt;
-            esp_event_post_to(view_event_handle, VIEW_EVENT_BASE, VIEW_EVENT_WIFI_LIST, &list, sizeof(struct view_data_wifi_list ), portMAX_DELAY);
-
+            __scan_sweep_start(true);
             break;
         }
         case VIEW_EVENT_WIFI_CONNECT: {
@@ -436,10 +1136,20 @@ int indicator_wifi_init(void)
 {
     __g_wifi_mutex  = xSemaphoreCreateMutex( );
     __g_data_mutex  =  xSemaphoreCreateMutex();
+    __g_profile_mutex = xSemaphoreCreateMutex();
     __g_net_check_sem = xSemaphoreCreateBinary();
     //__wifi_event_group = xEventGroupCreate();
 
     __wifi_model_init();
+    __profiles_restore();
+    indicator_net_health_set_cb(__net_health_cb);
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = &__reconnect_timer_callback,
+        .arg = NULL,
+        .name = "wifi reconnect"
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &__g_reconnect_timer));
     
     xTaskCreate(&__indicator_wifi_task, "__indicator_wifi_task", 1024 * 5, NULL, 10, NULL);
 
@@ -485,11 +1195,31 @@ int indicator_wifi_init(void)
 
     wifi_config_t wifi_cfg;
     esp_wifi_get_config(WIFI_IF_STA, &wifi_cfg);
+    xSemaphoreTake(__g_profile_mutex, portMAX_DELAY);
+    __profile_from_cfg(&__g_driver_net, &wifi_cfg);
+    __profiles_fill();
+    bool saved_only = strlen((const char *) wifi_cfg.sta.ssid) == 0 && __g_profiles.cnt > 0;
+    if (saved_only) {
+        /* Config forgotten, but other networks are saved */
+        ESP_LOGI(TAG, "saved network: %s", __g_profiles.p[0].ssid);
+        _g_wifi_model.is_cfg = true;
+        ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+        __profile_apply(0);
+    }
+    xSemaphoreGive(__g_profile_mutex);
    
-    if (strlen((const char *) wifi_cfg.sta.ssid)) {
+    if (saved_only) {
+        ESP_ERROR_CHECK(esp_wifi_start());
+    } else if (strlen((const char *) wifi_cfg.sta.ssid)) {
         _g_wifi_model.is_cfg = true;
         ESP_LOGI(TAG, "last config ssid: %s",  wifi_cfg.sta.ssid);
         ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
+        if( __fast_cache_restore(&wifi_cfg) ) {
+            ESP_LOGI(TAG, "Directed connect to " MACSTR " on channel %d",
+                     MAC2STR(__g_fast_cache.bssid), __g_fast_cache.channel);
+            __fast_connect_set(true);
+            __g_connect_path = "cached AP";
+        }
         ESP_ERROR_CHECK(esp_wifi_start());
     } else {
         ESP_LOGI(TAG, "Not config wifi, Entry wifi config screen");
@@ -0,0 +1,120 @@
+#include "dns_cache.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#else
+/* Host build: POSIX resolver, log to stderr */
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <time.h>
+
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) fprintf(stderr, "I (%s) " fmt "\n", tag, ##__VA_ARGS__)
+
+static int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+#endif
+
+struct dns_cache_entry {
+    char     host[64];
+    uint32_t addr;
+    int64_t  resolved_us;       /* 0: slot free */
+};
+
+static const char *TAG = "dns";
+
+static struct dns_cache_entry __g_entries[DNS_CACHE_SIZE];
+static uint32_t __g_hits;
+static uint32_t __g_misses;
+
+static struct dns_cache_entry *__find(const char *host)
+{
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        if (__g_entries[i].resolved_us && strcmp(__g_entries[i].host, host) == 0) {
+            return &__g_entries[i];
+        }
+    }
+    return NULL;
+}
+
+/* Free slot, or the one resolved longest ago */
+static struct dns_cache_entry *__victim(void)
+{
+    struct dns_cache_entry *oldest = &__g_entries[0];
+
+    for (int i = 0; i < DNS_CACHE_SIZE; i++) {
+        if (__g_entries[i].resolved_us == 0) {
+            return &__g_entries[i];
+        }
+        if (__g_entries[i].resolved_us < oldest->resolved_us) {
+            oldest = &__g_entries[i];
+        }
+    }
+    return oldest;
+}
+
+int dns_cache_resolve(const char *host, uint32_t *addr)
+{
+    struct in_addr numeric;
+    int64_t now_us = esp_timer_get_time();
+
+    if (inet_aton(host, &numeric)) {
+        *addr = numeric.s_addr;
+        return 0;
+    }
+
+    struct dns_cache_entry *entry = __find(host);
+    int64_t age_us = entry ? now_us - entry->resolved_us : 0;
+    if (entry && age_us < (int64_t)DNS_CACHE_TTL_SEC * 1000000) {
+        __g_hits++;
+        *addr = entry->addr;
+        return 0;
+    }
+
+    __g_misses++;
+    struct hostent *server = gethostbyname(host);
+    if (!server || server->h_length != 4) {
+        if (entry && age_us < (int64_t)DNS_CACHE_STALE_SEC * 1000000) {
+            ESP_LOGW(TAG, "DNS lookup failed for %s, using the address from %lld s ago",
+                     host, (long long)(age_us / 1000000));
+            *addr = entry->addr;
+            return 0;
+        }
+        return -1;
+    }
+
+    if (!entry) {
+        entry = __victim();
+        strncpy(entry->host, host, sizeof(entry->host) - 1);
+        entry->host[sizeof(entry->host) - 1] = '\0';
+    }
+    memcpy(&entry->addr, server->h_addr, 4);
+    entry->resolved_us = now_us;
+    *addr = entry->addr;
+    return 0;
+}
+
+void dns_cache_invalidate(const char *host)
+{
+    struct dns_cache_entry *entry = __find(host);
+    if (entry) {
+        entry->resolved_us = 0;
+    }
+}
+
+void dns_cache_get_stats(uint32_t *hits, uint32_t *misses)
+{
+    if (hits) *hits = __g_hits;
+    if (misses) *misses = __g_misses;
+}
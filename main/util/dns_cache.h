@@ -0,0 +1,38 @@
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+/*
+ * Small resolver cache for the exporters. lwIP does not report record TTLs
+ * through gethostbyname, so entries live for a fixed DNS_CACHE_TTL_SEC and
+ * are dropped early when a connect to the address fails. A stale entry is
+ * still used, up to DNS_CACHE_STALE_SEC, while the DNS server is unreachable.
+ *
+ * Not locked: every caller runs on the export task. Builds on a Linux host
+ * like mysql_client and line_protocol.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DNS_CACHE_SIZE       4
+#define DNS_CACHE_TTL_SEC    300
+#define DNS_CACHE_STALE_SEC  3600
+
+/* IPv4 address of host in network byte order. Numeric addresses bypass the
+ * cache. Returns 0, or -1 when the name cannot be resolved */
+int dns_cache_resolve(const char *host, uint32_t *addr);
+
+/* Forget host, e.g. after a failed connect */
+void dns_cache_invalidate(const char *host);
+
+/* Lookups answered from the cache vs. sent to the DNS server */
+void dns_cache_get_stats(uint32_t *hits, uint32_t *misses);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
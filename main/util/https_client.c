@@ -0,0 +1,543 @@
+#include "https_client.h"
+#include "mbedtls/net_sockets.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_crt_bundle.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#else
+/* Host build: POSIX sockets, log to stderr */
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) fprintf(stderr, "I (%s) " fmt "\n", tag, ##__VA_ARGS__)
+
+static int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+#endif
+
+#define HTTPS_LINE_MAX  256
+
+static const char *TAG = "https";
+
+int https_client_init(https_client_t *client, const char *ca_pem, size_t ca_len)
+{
+    int ret;
+
+    if (client->ready) {
+        return 0;
+    }
+
+    memset(client, 0, sizeof(*client));
+    client->sock = -1;
+    mbedtls_entropy_init(&client->entropy);
+    mbedtls_ctr_drbg_init(&client->ctr_drbg);
+    mbedtls_x509_crt_init(&client->ca);
+    mbedtls_ssl_config_init(&client->conf);
+    mbedtls_ssl_init(&client->ssl);
+    for (int i = 0; i < HTTPS_SESSION_CACHE_SIZE; i++) {
+        mbedtls_ssl_session_init(&client->sessions[i].session);
+    }
+
+    ret = mbedtls_ctr_drbg_seed(&client->ctr_drbg, mbedtls_entropy_func, &client->entropy,
+                                (const unsigned char *)TAG, strlen(TAG));
+    if (ret == 0) {
+        ret = mbedtls_ssl_config_defaults(&client->conf, MBEDTLS_SSL_IS_CLIENT,
+                                          MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    }
+    if (ret == 0 && ca_pem) {
+        /* Parsed once, every handshake verifies against it */
+        ret = mbedtls_x509_crt_parse(&client->ca, (const unsigned char *)ca_pem, ca_len);
+        if (ret == 0) {
+            mbedtls_ssl_conf_ca_chain(&client->conf, &client->ca, NULL);
+            mbedtls_ssl_conf_authmode(&client->conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+        }
+    } else if (ret == 0) {
+#ifdef ESP_PLATFORM
+        ret = esp_crt_bundle_attach(&client->conf);
+        mbedtls_ssl_conf_authmode(&client->conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+#else
+        ESP_LOGW(TAG, "No CA given, server certificates are not verified");
+        mbedtls_ssl_conf_authmode(&client->conf, MBEDTLS_SSL_VERIFY_NONE);
+#endif
+    }
+    if (ret == 0) {
+        mbedtls_ssl_conf_rng(&client->conf, mbedtls_ctr_drbg_random, &client->ctr_drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+        mbedtls_ssl_conf_session_tickets(&client->conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+        ret = mbedtls_ssl_setup(&client->ssl, &client->conf);
+    }
+
+    if (ret != 0) {
+        ESP_LOGE(TAG, "TLS setup failed: -0x%04x", -ret);
+        mbedtls_ssl_free(&client->ssl);
+        mbedtls_ssl_config_free(&client->conf);
+        mbedtls_x509_crt_free(&client->ca);
+        mbedtls_ctr_drbg_free(&client->ctr_drbg);
+        mbedtls_entropy_free(&client->entropy);
+        return -1;
+    }
+    client->ready = true;
+    return 0;
+}
+
+void https_client_close(https_client_t *client)
+{
+    if (client->sock >= 0) {
+        mbedtls_ssl_close_notify(&client->ssl);
+        close(client->sock);
+    }
+    client->sock = -1;
+    client->rx_pos = 0;
+    client->rx_len = 0;
+}
+
+/* ========== Transport ========== */
+
+static int https_bio_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    https_client_t *client = ctx;
+    int n = send(client->sock, buf, len, 0);
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_TIMEOUT : MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+    return n;
+}
+
+static int https_bio_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    https_client_t *client = ctx;
+    int n = recv(client->sock, buf, len, 0);
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_TIMEOUT : MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+    if (n == 0) {
+        return MBEDTLS_ERR_NET_CONN_RESET;
+    }
+    return n;
+}
+
+static int https_tcp_connect(https_client_t *client, const char *host, uint16_t port, https_timing_t *timing)
+{
+    const struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = SOCK_STREAM,
+    };
+    struct addrinfo *res = NULL;
+    struct timeval tv = { .tv_sec = HTTPS_CONNECT_TIMEOUT_SEC };
+    char port_str[8];
+    fd_set fds;
+    int err = 0;
+    socklen_t err_len = sizeof(err);
+    int64_t start_us = esp_timer_get_time();
+
+    snprintf(port_str, sizeof(port_str), "%u", port);
+    if (getaddrinfo(host, port_str, &hints, &res) != 0 || !res) {
+        ESP_LOGE(TAG, "DNS lookup failed for %s", host);
+        return -1;
+    }
+    timing->dns_us = esp_timer_get_time() - start_us;
+
+    start_us = esp_timer_get_time();
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Socket creation failed");
+        freeaddrinfo(res);
+        return -1;
+    }
+
+    int flags = fcntl(sock, F_GETFL, 0);
+    fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+    if (connect(sock, res->ai_addr, res->ai_addrlen) < 0) {
+        err = errno;
+        if (err == EINPROGRESS) {
+            FD_ZERO(&fds);
+            FD_SET(sock, &fds);
+            if (select(sock + 1, NULL, &fds, NULL, &tv) == 1) {
+                getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &err_len);
+            } else {
+                err = ETIMEDOUT;
+            }
+        }
+    }
+    freeaddrinfo(res);
+    if (err != 0) {
+        ESP_LOGE(TAG, "Connection failed to %s:%d (errno %d)", host, port, err);
+        close(sock);
+        return -1;
+    }
+    fcntl(sock, F_SETFL, flags);
+
+    tv.tv_sec = HTTPS_TIMEOUT_SEC;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    timing->connect_us = esp_timer_get_time() - start_us;
+    return sock;
+}
+
+/* ========== TLS Sessions ========== */
+
+static https_session_t *https_session_find(https_client_t *client, const char *host)
+{
+    for (int i = 0; i < HTTPS_SESSION_CACHE_SIZE; i++) {
+        if (client->sessions[i].valid && strcmp(client->sessions[i].host, host) == 0) {
+            return &client->sessions[i];
+        }
+    }
+    return NULL;
+}
+
+/* Slot for host: its own, a free one, or the least recently used */
+static https_session_t *https_session_slot(https_client_t *client, const char *host)
+{
+    https_session_t *slot = https_session_find(client, host);
+
+    if (slot) {
+        return slot;
+    }
+    slot = &client->sessions[0];
+    for (int i = 0; i < HTTPS_SESSION_CACHE_SIZE; i++) {
+        if (!client->sessions[i].valid) {
+            return &client->sessions[i];
+        }
+        if (client->sessions[i].used < slot->used) {
+            slot = &client->sessions[i];
+        }
+    }
+    return slot;
+}
+
+static int https_handshake(https_client_t *client, const char *host, https_timing_t *timing)
+{
+    https_session_t *cached = https_session_find(client, host);
+    mbedtls_ssl_session fresh;
+    int64_t start_us = esp_timer_get_time();
+    bool offered;
+    int ret;
+
+    mbedtls_ssl_session_reset(&client->ssl);
+    mbedtls_ssl_set_hostname(&client->ssl, host);
+    mbedtls_ssl_set_bio(&client->ssl, client, https_bio_send, https_bio_recv, NULL);
+    offered = cached && mbedtls_ssl_set_session(&client->ssl, &cached->session) == 0;
+
+    while ((ret = mbedtls_ssl_handshake(&client->ssl)) != 0) {
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            ESP_LOGE(TAG, "TLS handshake with %s failed: -0x%04x", host, -ret);
+            if (cached) {
+                /* Don't let a stale session fail every following attempt */
+                cached->valid = false;
+            }
+            return -1;
+        }
+    }
+    timing->handshake_us = esp_timer_get_time() - start_us;
+
+    /* A resumed handshake carries the master secret over, see mysql_client */
+    mbedtls_ssl_session_init(&fresh);
+    if (mbedtls_ssl_get_session(&client->ssl, &fresh) == 0) {
+        https_session_t *slot = cached ? cached : https_session_slot(client, host);
+        timing->resumed = offered &&
+                          memcmp(fresh.MBEDTLS_PRIVATE(master), slot->session.MBEDTLS_PRIVATE(master),
+                                 sizeof(fresh.MBEDTLS_PRIVATE(master))) == 0;
+        mbedtls_ssl_session_free(&slot->session);
+        slot->session = fresh;
+        strncpy(slot->host, host, sizeof(slot->host) - 1);
+        slot->host[sizeof(slot->host) - 1] = '\0';
+        slot->valid = true;
+        slot->used = ++client->use_clock;
+    } else {
+        mbedtls_ssl_session_free(&fresh);
+    }
+
+    if (timing->resumed) {
+        client->resumed_handshakes++;
+    } else {
+        client->full_handshakes++;
+    }
+    return 0;
+}
+
+/* ========== HTTP ========== */
+
+static int https_write_all(https_client_t *client, const char *data, int len)
+{
+    while (len > 0) {
+        int ret = mbedtls_ssl_write(&client->ssl, (const unsigned char *)data, len);
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            continue;
+        }
+        if (ret <= 0) {
+            return -1;
+        }
+        data += ret;
+        len -= ret;
+    }
+    return 0;
+}
+
+/* Make sure unread response bytes are buffered, -1 on error or close */
+static int https_fill(https_client_t *client)
+{
+    while (client->rx_pos == client->rx_len) {
+        int ret = mbedtls_ssl_read(&client->ssl, client->rx_buf, sizeof(client->rx_buf));
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            continue;
+        }
+        if (ret <= 0) {
+            return -1;
+        }
+        client->rx_pos = 0;
+        client->rx_len = ret;
+    }
+    return 0;
+}
+
+/* Next byte of the response, -1 on error or close */
+static int https_read_byte(https_client_t *client)
+{
+    if (https_fill(client) < 0) {
+        return -1;
+    }
+    return client->rx_buf[client->rx_pos++];
+}
+
+/* One line without its CRLF, truncated to size - 1. Returns its length or -1 */
+static int https_read_line(https_client_t *client, char *line, int size)
+{
+    int len = 0;
+    int c;
+
+    while ((c = https_read_byte(client)) >= 0) {
+        if (c == '\n') {
+            if (len > 0 && line[len - 1] == '\r') {
+                len--;
+            }
+            line[len] = '\0';
+            return len;
+        }
+        if (len < size - 1) {
+            line[len++] = c;
+        }
+    }
+    return -1;
+}
+
+/* Pass n body bytes (n < 0: until the server closes) to cb straight from the
+ * receive buffer. Returns 0, 1 when cb stopped reading, -1 on a read error */
+static int https_read_body(https_client_t *client, int n, https_body_cb_t cb, void *ctx)
+{
+    while (n != 0) {
+        if (https_fill(client) < 0) {
+            return n < 0 ? 0 : -1;
+        }
+        int avail = client->rx_len - client->rx_pos;
+        int len = (n < 0 || avail < n) ? avail : n;
+        const char *data = (const char *)&client->rx_buf[client->rx_pos];
+        client->rx_pos += len;
+        if (n > 0) {
+            n -= len;
+        }
+        if (cb(ctx, data, len) != 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Send the request and read the response. Returns the status, -1 on a
+ * transport error; *keep tells whether the connection can be reused and
+ * *answered whether any of the response arrived */
+static int https_exchange(https_client_t *client, const char *host, const char *path,
+                          https_body_cb_t cb, void *ctx, https_timing_t *timing,
+                          bool *keep, bool *answered)
+{
+    char line[HTTPS_LINE_MAX];
+    int status = 0;
+    int content_length = -1;
+    bool chunked = false;
+    int ret = 0;
+
+    int req_len = snprintf(line, sizeof(line),
+                           "GET %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: sensecap\r\n"
+                           "Connection: keep-alive\r\n\r\n", path, host);
+    if (req_len >= (int)sizeof(line)) {
+        ESP_LOGE(TAG, "Request too long");
+        return -1;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    if (https_write_all(client, line, req_len) < 0) {
+        return -1;
+    }
+
+    /* Status line, then headers */
+    if (https_fill(client) < 0) {
+        return -1;
+    }
+    timing->first_byte_us = esp_timer_get_time() - start_us;
+    *answered = true;
+
+    *keep = true;
+    if (https_read_line(client, line, sizeof(line)) < 0 ||
+        sscanf(line, "HTTP/1.%*d %d", &status) != 1) {
+        ESP_LOGE(TAG, "Malformed response from %s", host);
+        return -1;
+    }
+    if (strncmp(line, "HTTP/1.0", 8) == 0) {
+        *keep = false;
+    }
+    while (https_read_line(client, line, sizeof(line)) > 0) {
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            content_length = atoi(&line[15]);
+        } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0 && strstr(&line[18], "chunked")) {
+            chunked = true;
+        } else if (strncasecmp(line, "Connection:", 11) == 0 && strstr(&line[11], "close")) {
+            *keep = false;
+        }
+    }
+
+    if (chunked) {
+        int chunk;
+        do {
+            if (https_read_line(client, line, sizeof(line)) < 0) {
+                return -1;
+            }
+            chunk = strtol(line, NULL, 16);
+            if (chunk > 0 && (ret = https_read_body(client, chunk, cb, ctx)) != 0) {
+                break;
+            }
+            /* CRLF after the data; after the last chunk, the (empty) trailer */
+            if (https_read_line(client, line, sizeof(line)) < 0) {
+                return -1;
+            }
+        } while (chunk > 0);
+    } else if (content_length >= 0) {
+        ret = https_read_body(client, content_length, cb, ctx);
+    } else {
+        /* Body runs until the server closes */
+        *keep = false;
+        ret = https_read_body(client, -1, cb, ctx);
+    }
+    if (ret < 0) {
+        return -1;
+    }
+    if (ret > 0) {
+        /* The rest of the body is still on the connection */
+        *keep = false;
+    }
+    return status;
+}
+
+int https_get_stream(https_client_t *client, const char *host, uint16_t port, const char *path,
+                     https_body_cb_t cb, void *ctx, https_timing_t *timing)
+{
+    https_timing_t local;
+    int64_t start_us = esp_timer_get_time();
+
+    if (!timing) {
+        timing = &local;
+    }
+    memset(timing, 0, sizeof(*timing));
+    if (!client->ready) {
+        return -1;
+    }
+
+    if (client->sock >= 0 && (strcmp(client->host, host) != 0 || client->port != port)) {
+        https_client_close(client);
+    }
+
+    client->requests++;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = client->sock >= 0;
+        bool keep = false;
+        bool answered = false;
+
+        if (!reused) {
+            memset(timing, 0, sizeof(*timing));
+            client->sock = https_tcp_connect(client, host, port, timing);
+            if (client->sock < 0) {
+                return -1;
+            }
+            client->rx_pos = 0;
+            client->rx_len = 0;
+            strncpy(client->host, host, sizeof(client->host) - 1);
+            client->host[sizeof(client->host) - 1] = '\0';
+            client->port = port;
+            if (https_handshake(client, host, timing) < 0) {
+                https_client_close(client);
+                return -1;
+            }
+        }
+        timing->reused = reused;
+
+        int status = https_exchange(client, host, path, cb, ctx, timing, &keep, &answered);
+        if (status < 0 || !keep) {
+            https_client_close(client);
+        }
+        /* Only a request that got no answer at all can be repeated, cb may
+         * have seen part of the body otherwise */
+        if (status >= 0 || !reused || answered) {
+            if (reused && status >= 0) {
+                client->reused++;
+            }
+            timing->total_us = esp_timer_get_time() - start_us;
+            return status;
+        }
+        /* The server dropped the idle connection, try once on a fresh one */
+        ESP_LOGW(TAG, "Kept-alive connection to %s lost, reconnecting", host);
+    }
+    return -1;
+}
+
+struct https_buf {
+    char *body;
+    int   size;
+    int   len;
+};
+
+/* Copy what fits, keep reading so the connection stays usable */
+static int https_buf_append(void *ctx, const char *data, int len)
+{
+    struct https_buf *buf = ctx;
+    int n = buf->size - 1 - buf->len;
+
+    if (n > len) {
+        n = len;
+    }
+    memcpy(&buf->body[buf->len], data, n);
+    buf->len += n;
+    return 0;
+}
+
+int https_get(https_client_t *client, const char *host, uint16_t port, const char *path,
+              char *body, int size, https_timing_t *timing)
+{
+    struct https_buf buf = { .body = body, .size = size };
+
+    if (size < 1) {
+        return -1;
+    }
+    int status = https_get_stream(client, host, port, path, https_buf_append, &buf, timing);
+    body[buf.len] = '\0';
+    return status;
+}
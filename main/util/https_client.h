@@ -0,0 +1,105 @@
+#ifndef HTTPS_CLIENT_H
+#define HTTPS_CLIENT_H
+
+/*
+ * Small HTTPS GET client that keeps its TLS state between requests: the
+ * mbedTLS config, DRBG and CA chain are set up once, the last TLS session
+ * of each host is cached for resumption and the connection is kept alive
+ * while requests go to the same host.
+ *
+ * Like mysql_client it builds on a Linux host against mbedTLS and POSIX
+ * sockets (without ESP_PLATFORM). Pointed at a local stand-in such as
+ *   openssl s_server -accept 8443 -cert cert.pem -key key.pem -WWW
+ * with cert.pem as the CA, the timings show what resumption and keep-alive
+ * save without depending on the public services.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/x509_crt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTTPS_SESSION_CACHE_SIZE   4
+#define HTTPS_TIMEOUT_SEC          10     /* each read or write */
+#define HTTPS_CONNECT_TIMEOUT_SEC  5
+#define HTTPS_RX_BUF_SIZE          512
+
+/* Where the time of one request went, in microseconds. Steps that were
+ * skipped (kept-alive connection) are 0 */
+typedef struct {
+    int64_t dns_us;
+    int64_t connect_us;
+    int64_t handshake_us;
+    int64_t first_byte_us;      /* request sent until the first response byte */
+    int64_t total_us;
+    bool    reused;             /* ran on a kept-alive connection */
+    bool    resumed;            /* TLS session resumed, no full key exchange */
+} https_timing_t;
+
+typedef struct {
+    char     host[64];
+    bool     valid;
+    uint32_t used;              /* LRU stamp */
+    mbedtls_ssl_session session;
+} https_session_t;
+
+typedef struct {
+    bool     ready;
+    mbedtls_entropy_context  entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+    mbedtls_x509_crt         ca;
+    mbedtls_ssl_config       conf;
+    mbedtls_ssl_context      ssl;
+
+    /* Open connection */
+    int      sock;
+    char     host[64];
+    uint16_t port;
+    uint8_t  rx_buf[HTTPS_RX_BUF_SIZE];
+    int      rx_pos;
+    int      rx_len;
+
+    https_session_t sessions[HTTPS_SESSION_CACHE_SIZE];
+    uint32_t use_clock;
+
+    /* Counters */
+    uint32_t requests;
+    uint32_t reused;
+    uint32_t full_handshakes;
+    uint32_t resumed_handshakes;
+} https_client_t;
+
+/* Set up the TLS state once. ca_pem (with its terminating NUL counted in
+ * ca_len) is parsed into the trust chain; NULL uses the ESP-IDF certificate
+ * bundle, or on a host accepts any certificate with a warning. 0 on success */
+int https_client_init(https_client_t *client, const char *ca_pem, size_t ca_len);
+
+/* Receives the response body in the pieces it arrives in, chunked transfer
+ * coding already removed. A non-zero return stops reading and closes the
+ * connection */
+typedef int (*https_body_cb_t)(void *ctx, const char *data, int len);
+
+/* GET path from host, handing the body to cb as it is read so it never has
+ * to be held in one buffer. Returns the HTTP status or -1; timing may be NULL */
+int https_get_stream(https_client_t *client, const char *host, uint16_t port, const char *path,
+                     https_body_cb_t cb, void *ctx, https_timing_t *timing);
+
+/* Same, the body stored NUL-terminated in body (truncated to size - 1) */
+int https_get(https_client_t *client, const char *host, uint16_t port, const char *path,
+              char *body, int size, https_timing_t *timing);
+
+/* Close the connection, the cached sessions are kept */
+void https_client_close(https_client_t *client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
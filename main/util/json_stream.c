@@ -0,0 +1,335 @@
+#include "json_stream.h"
+#include <string.h>
+
+enum {
+    JS_VALUE,           /* a value is expected */
+    JS_OBJ_FIRST,       /* after '{': a key or '}' */
+    JS_OBJ_KEY,         /* after ',' in an object: a key */
+    JS_COLON,
+    JS_ARR_FIRST,       /* after '[': a value or ']' */
+    JS_NEXT,            /* after a value: ',' or the closing bracket */
+    JS_STRING,          /* in a key or string value */
+    JS_ESCAPE,
+    JS_UNICODE,
+    JS_SCALAR,          /* number, true, false, null */
+    JS_DONE,
+};
+
+static bool __is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool __is_scalar(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           c == '-' || c == '+' || c == '.';
+}
+
+/* Key idx of path and its length, NULL past the last one */
+static const char *__segment(const char *path, int idx, int *len)
+{
+    for (; idx > 0; idx--) {
+        path = strchr(path, '.');
+        if (!path) {
+            return NULL;
+        }
+        path++;
+    }
+    const char *end = strchr(path, '.');
+    *len = end ? end - path : (int)strlen(path);
+    return path;
+}
+
+static int __segment_cnt(const char *path)
+{
+    int cnt = 1;
+    for (; *path; path++) {
+        if (*path == '.') {
+            cnt++;
+        }
+    }
+    return cnt;
+}
+
+/* Fields of mask whose path has exactly (leaf) or more than (!leaf) depth keys */
+static uint32_t __filter_depth(const json_stream_t *js, uint32_t mask, bool leaf)
+{
+    uint32_t out = 0;
+
+    for (uint32_t m = mask; m; m &= m - 1) {
+        int i = __builtin_ctz(m);
+        int cnt = __segment_cnt(js->fields[i].path);
+        if (leaf ? cnt == js->depth : cnt > js->depth) {
+            out |= 1u << i;
+        }
+    }
+    return out;
+}
+
+static void __key_end(json_stream_t *js)
+{
+    js->key_mask = 0;
+    if (js->key_len >= JSON_STREAM_KEY_MAX) {
+        return;
+    }
+    for (uint32_t m = js->mask[js->depth]; m; m &= m - 1) {
+        int i = __builtin_ctz(m);
+        int len;
+        const char *seg = __segment(js->fields[i].path, js->depth - 1, &len);
+        if (seg && len == js->key_len && memcmp(seg, js->key, len) == 0) {
+            js->key_mask |= 1u << i;
+        }
+    }
+}
+
+/* Fields the value starting here belongs to, if they were asked for */
+static uint32_t __selected(const json_stream_t *js)
+{
+    return (js->depth == 0 || js->container[js->depth] == '{') ? js->key_mask : 0;
+}
+
+static void __append(json_stream_t *js, char c)
+{
+    if (js->in_key) {
+        if (js->key_len < JSON_STREAM_KEY_MAX) {
+            js->key[js->key_len] = c;
+        }
+        js->key_len++;
+        return;
+    }
+    for (uint32_t m = js->capture; m; m &= m - 1) {
+        json_stream_field_t *f = &js->fields[__builtin_ctz(m)];
+        if (js->value_len < f->size - 1) {
+            f->value[js->value_len] = c;
+        }
+    }
+    js->value_len++;
+}
+
+/* \uXXXX as UTF-8; surrogate pairs are not joined */
+static void __append_unicode(json_stream_t *js, uint16_t cp)
+{
+    if (cp < 0x80) {
+        __append(js, cp);
+    } else if (cp < 0x800) {
+        __append(js, 0xc0 | (cp >> 6));
+        __append(js, 0x80 | (cp & 0x3f));
+    } else if (cp >= 0xd800 && cp <= 0xdfff) {
+        __append(js, '?');
+    } else {
+        __append(js, 0xe0 | (cp >> 12));
+        __append(js, 0x80 | ((cp >> 6) & 0x3f));
+        __append(js, 0x80 | (cp & 0x3f));
+    }
+}
+
+static void __value_begin(json_stream_t *js)
+{
+    js->capture = __filter_depth(js, __selected(js), true);
+    js->value_len = 0;
+}
+
+static void __value_end(json_stream_t *js)
+{
+    for (uint32_t m = js->capture; m; m &= m - 1) {
+        json_stream_field_t *f = &js->fields[__builtin_ctz(m)];
+        if (f->size > 0) {
+            f->value[js->value_len < f->size - 1 ? js->value_len : f->size - 1] = '\0';
+        }
+        f->found = true;
+    }
+    js->capture = 0;
+    js->state = js->depth ? JS_NEXT : JS_DONE;
+}
+
+static int __push(json_stream_t *js, char container)
+{
+    uint32_t mask = container == '{' ? __filter_depth(js, __selected(js), false) : 0;
+
+    if (js->depth == JSON_STREAM_DEPTH_MAX) {
+        return -1;
+    }
+    js->depth++;
+    js->container[js->depth] = container;
+    js->mask[js->depth] = mask;
+    js->state = container == '{' ? JS_OBJ_FIRST : JS_ARR_FIRST;
+    return 0;
+}
+
+static void __pop(json_stream_t *js)
+{
+    js->depth--;
+    js->state = js->depth ? JS_NEXT : JS_DONE;
+}
+
+static int __hex(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* One character; returns 1 when it has to be looked at again in the new state */
+static int __step(json_stream_t *js, char c)
+{
+    switch (js->state) {
+        case JS_OBJ_FIRST:
+        case JS_OBJ_KEY:
+            if (__is_space(c)) return 0;
+            if (c == '}' && js->state == JS_OBJ_FIRST) {
+                __pop(js);
+                return 0;
+            }
+            if (c != '"') return -1;
+            js->in_key = true;
+            js->key_len = 0;
+            js->state = JS_STRING;
+            return 0;
+
+        case JS_COLON:
+            if (__is_space(c)) return 0;
+            if (c != ':') return -1;
+            js->state = JS_VALUE;
+            return 0;
+
+        case JS_ARR_FIRST:
+            if (__is_space(c)) return 0;
+            if (c == ']') {
+                __pop(js);
+                return 0;
+            }
+            js->state = JS_VALUE;
+            return 1;
+
+        case JS_VALUE:
+            if (__is_space(c)) return 0;
+            if (c == '{' || c == '[') {
+                return __push(js, c);
+            }
+            __value_begin(js);
+            if (c == '"') {
+                js->in_key = false;
+                js->state = JS_STRING;
+                return 0;
+            }
+            if (!__is_scalar(c)) return -1;
+            js->in_key = false;
+            __append(js, c);
+            js->state = JS_SCALAR;
+            return 0;
+
+        case JS_SCALAR:
+            if (__is_scalar(c)) {
+                __append(js, c);
+                return 0;
+            }
+            __value_end(js);
+            return 1;
+
+        case JS_STRING:
+            if (c == '"') {
+                if (js->in_key) {
+                    __key_end(js);
+                    js->in_key = false;
+                    js->state = JS_COLON;
+                } else {
+                    __value_end(js);
+                }
+                return 0;
+            }
+            if (c == '\\') {
+                js->state = JS_ESCAPE;
+                return 0;
+            }
+            if ((unsigned char)c < 0x20) return -1;
+            __append(js, c);
+            return 0;
+
+        case JS_ESCAPE: {
+            static const char from[] = "\"\\/bfnrt";
+            static const char to[]   = "\"\\/\b\f\n\r\t";
+            const char *p = strchr(from, c);
+            if (c == 'u') {
+                js->unicode = 0;
+                js->unicode_digits = 0;
+                js->state = JS_UNICODE;
+                return 0;
+            }
+            if (!p || !c) return -1;
+            __append(js, to[p - from]);
+            js->state = JS_STRING;
+            return 0;
+        }
+
+        case JS_UNICODE: {
+            int digit = __hex(c);
+            if (digit < 0) return -1;
+            js->unicode = (js->unicode << 4) | digit;
+            if (++js->unicode_digits == 4) {
+                __append_unicode(js, js->unicode);
+                js->state = JS_STRING;
+            }
+            return 0;
+        }
+
+        case JS_NEXT:
+            if (__is_space(c)) return 0;
+            if (c == ',') {
+                js->state = js->container[js->depth] == '{' ? JS_OBJ_KEY : JS_VALUE;
+                return 0;
+            }
+            if ((c == '}' && js->container[js->depth] == '{') ||
+                (c == ']' && js->container[js->depth] == '[')) {
+                __pop(js);
+                return 0;
+            }
+            return -1;
+
+        case JS_DONE:
+            return __is_space(c) ? 0 : -1;
+    }
+    return -1;
+}
+
+void json_stream_init(json_stream_t *js, json_stream_field_t *fields, int field_cnt)
+{
+    memset(js, 0, sizeof(*js));
+    if (field_cnt > JSON_STREAM_FIELD_MAX) {
+        field_cnt = JSON_STREAM_FIELD_MAX;
+    }
+    js->fields = fields;
+    js->field_cnt = field_cnt;
+    js->state = JS_VALUE;
+    /* The root object is selected by every path */
+    js->key_mask = field_cnt == 32 ? 0xffffffffu : (1u << field_cnt) - 1;
+    for (int i = 0; i < field_cnt; i++) {
+        fields[i].found = false;
+        if (fields[i].size > 0) {
+            fields[i].value[0] = '\0';
+        }
+    }
+}
+
+int json_stream_feed(json_stream_t *js, const char *data, int len)
+{
+    if (js->error) {
+        return -1;
+    }
+    for (int i = 0; i < len; i++) {
+        int ret;
+        while ((ret = __step(js, data[i])) == 1) {
+        }
+        if (ret < 0) {
+            js->error = true;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+bool json_stream_done(const json_stream_t *js)
+{
+    return js->state == JS_DONE && !js->error;
+}
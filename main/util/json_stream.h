@@ -0,0 +1,64 @@
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+/*
+ * Streaming JSON field extractor. The document is fed in pieces as they come
+ * off the connection and the values of a few known paths are copied out on
+ * the way; no tree is built and the body is never held in one buffer. The
+ * parser state is a fixed struct, nothing is allocated.
+ *
+ * Pure C, builds on a Linux host as is.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JSON_STREAM_DEPTH_MAX   8       /* nesting of objects and arrays */
+#define JSON_STREAM_KEY_MAX     32      /* longer keys never match */
+#define JSON_STREAM_FIELD_MAX   32
+
+typedef struct {
+    const char *path;           /* keys from the root object joined by '.', e.g. "currentUtcOffset.seconds" */
+    char       *value;          /* strings unescaped, numbers and literals as written, truncated to size - 1 */
+    int         size;
+    bool        found;
+} json_stream_field_t;
+
+typedef struct {
+    json_stream_field_t *fields;
+    int      field_cnt;
+
+    uint8_t  state;
+    uint8_t  depth;
+    bool     in_key;
+    bool     error;
+    char     container[JSON_STREAM_DEPTH_MAX + 1];   /* '{' or '[' per level */
+    uint32_t mask[JSON_STREAM_DEPTH_MAX + 1];        /* fields whose path leads into the level */
+    uint32_t key_mask;          /* fields the current key selects */
+    uint32_t capture;           /* fields receiving the current value */
+    int      value_len;
+    char     key[JSON_STREAM_KEY_MAX];
+    int      key_len;
+    uint16_t unicode;
+    uint8_t  unicode_digits;
+} json_stream_t;
+
+/* Start a document, clearing the fields' found flags and values */
+void json_stream_init(json_stream_t *js, json_stream_field_t *fields, int field_cnt);
+
+/* Parse the next len bytes. Returns 0, or -1 once the input is not valid
+ * JSON or nests deeper than JSON_STREAM_DEPTH_MAX */
+int json_stream_feed(json_stream_t *js, const char *data, int len);
+
+/* The root value has been closed */
+bool json_stream_done(const json_stream_t *js);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
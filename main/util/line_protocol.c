@@ -0,0 +1,368 @@
+#include "line_protocol.h"
+#include "dns_cache.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#else
+/* Host build: POSIX sockets, log to stderr */
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) fprintf(stderr, "I (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#endif
+
+#define LINE_HTTP_HEADER_MAX  512
+
+static const char *TAG = "line";
+
+/* ========== Formatting ========== */
+
+int line_protocol_escape(char *dst, int size, const char *src, bool tag)
+{
+    int len = 0;
+
+    if (size < 1) {
+        return -1;
+    }
+    for (; *src; src++) {
+        bool special = *src == ',' || *src == ' ' || (tag && *src == '=');
+        if (len + special + 1 >= size) {
+            return -1;
+        }
+        if (special) {
+            dst[len++] = '\\';
+        }
+        dst[len++] = *src;
+    }
+    dst[len] = '\0';
+    return len;
+}
+
+int line_protocol_append(char *buf, int size, const char *measurement, const char *tags,
+                         const char *const *names, const float *values, const uint8_t *precision,
+                         int cnt, int64_t timestamp, bool nanoseconds)
+{
+    int fields = 0;
+    int len = line_protocol_escape(buf, size, measurement, false);
+
+    if (len < 0) {
+        return -1;
+    }
+    if (tags && tags[0]) {
+        len += snprintf(&buf[len], size - len, ",%s ", tags);
+    } else {
+        len += snprintf(&buf[len], size - len, " ");
+    }
+    if (len >= size) {
+        return -1;
+    }
+
+    for (int i = 0; i < cnt; i++) {
+        /* The protocol has no null, a missing reading is simply not sent */
+        if (!isfinite(values[i])) {
+            continue;
+        }
+        len += snprintf(&buf[len], size - len, "%s%s=%.*f", fields ? "," : "",
+                        names[i], precision ? precision[i] : 2, values[i]);
+        if (len >= size) {
+            return -1;
+        }
+        fields++;
+    }
+    if (fields == 0) {
+        return 0;
+    }
+
+    len += snprintf(&buf[len], size - len, " %lld%s\n", (long long)timestamp, nanoseconds ? "000000000" : "");
+    if (len >= size) {
+        return -1;
+    }
+    return len;
+}
+
+/* ========== Sockets ========== */
+
+static int line_resolve(const char *host, uint32_t *addr)
+{
+    if (dns_cache_resolve(host, addr) < 0) {
+        ESP_LOGE(TAG, "DNS lookup failed for %s", host);
+        return -1;
+    }
+    return 0;
+}
+
+/* TCP connect bounded by LINE_CONNECT_TIMEOUT_SEC, then blocking I/O with
+ * per-call timeouts */
+static int line_tcp_connect(const char *host, uint16_t port)
+{
+    struct sockaddr_in server_addr;
+    struct timeval tv = { .tv_sec = LINE_CONNECT_TIMEOUT_SEC };
+    fd_set fds;
+    uint32_t addr;
+    int err = 0;
+    socklen_t err_len = sizeof(err);
+
+    if (line_resolve(host, &addr) < 0) {
+        return -1;
+    }
+
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Socket creation failed");
+        return -1;
+    }
+
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port);
+    server_addr.sin_addr.s_addr = addr;
+
+    int flags = fcntl(sock, F_GETFL, 0);
+    fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+    if (connect(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        err = errno;
+        if (err == EINPROGRESS) {
+            FD_ZERO(&fds);
+            FD_SET(sock, &fds);
+            if (select(sock + 1, NULL, &fds, NULL, &tv) == 1) {
+                getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &err_len);
+            } else {
+                err = ETIMEDOUT;
+            }
+        }
+    }
+    if (err != 0) {
+        ESP_LOGE(TAG, "Connection failed to %s:%d (errno %d)", host, port, err);
+        dns_cache_invalidate(host);
+        close(sock);
+        return -1;
+    }
+    fcntl(sock, F_SETFL, flags);
+
+    tv.tv_sec = LINE_TIMEOUT_SEC;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    return sock;
+}
+
+static int line_send_all(int sock, const char *data, int len)
+{
+    while (len > 0) {
+        int n = send(sock, data, len, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* ========== HTTP ========== */
+
+void line_http_close(line_http_t *http)
+{
+    if (http->sock >= 0) {
+        close(http->sock);
+    }
+    http->sock = -1;
+}
+
+/* Value of a response header, NULL if absent */
+static const char *line_http_header(const char *headers, const char *name)
+{
+    int name_len = strlen(name);
+    const char *line = strstr(headers, "\r\n");
+
+    while (line && line[2] != '\r') {
+        line += 2;
+        if (strncasecmp(line, name, name_len) == 0 && line[name_len] == ':') {
+            line += name_len + 1;
+            while (*line == ' ') line++;
+            return line;
+        }
+        line = strstr(line, "\r\n");
+    }
+    return NULL;
+}
+
+/* One request/response on the open connection. Returns the status, -1 on a
+ * transport error; the connection is closed unless it can be reused */
+static int line_http_request(line_http_t *http, const char *path, const char *auth,
+                             const char *body, int len)
+{
+    char header[LINE_HTTP_HEADER_MAX + 1];
+    int hlen;
+    int status = 0;
+    bool keep = true;
+
+    hlen = snprintf(header, sizeof(header),
+                    "POST %s HTTP/1.1\r\n"
+                    "Host: %s:%d\r\n"
+                    "Content-Type: text/plain; charset=utf-8\r\n"
+                    "Content-Length: %d\r\n"
+                    "%s%s%s"
+                    "Connection: keep-alive\r\n\r\n",
+                    path, http->host, http->port, len,
+                    auth && auth[0] ? "Authorization: " : "", auth && auth[0] ? auth : "",
+                    auth && auth[0] ? "\r\n" : "");
+    if (hlen >= (int)sizeof(header)) {
+        ESP_LOGE(TAG, "Request header too long");
+        return -1;
+    }
+    if (line_send_all(http->sock, header, hlen) < 0 || line_send_all(http->sock, body, len) < 0) {
+        line_http_close(http);
+        return -1;
+    }
+
+    /* Status line and headers */
+    hlen = 0;
+    char *end = NULL;
+    while (!end) {
+        if (hlen == LINE_HTTP_HEADER_MAX) {
+            ESP_LOGE(TAG, "Response header too long");
+            line_http_close(http);
+            return -1;
+        }
+        int n = recv(http->sock, &header[hlen], LINE_HTTP_HEADER_MAX - hlen, 0);
+        if (n <= 0) {
+            line_http_close(http);
+            return -1;
+        }
+        hlen += n;
+        header[hlen] = '\0';
+        end = strstr(header, "\r\n\r\n");
+    }
+    if (sscanf(header, "HTTP/1.%*d %d", &status) != 1) {
+        ESP_LOGE(TAG, "Malformed response");
+        line_http_close(http);
+        return -1;
+    }
+    end[2] = '\0';
+
+    /* Keep the start of the body, the server's reason for an error status */
+    int got = hlen - (int)(end + 4 - header);
+    int kept = got < LINE_HTTP_REPLY_MAX - 1 ? got : LINE_HTTP_REPLY_MAX - 1;
+    memcpy(http->reply, end + 4, kept);
+    http->reply[kept] = '\0';
+
+    const char *value = line_http_header(header, "Connection");
+    if (value && strncasecmp(value, "close", 5) == 0) {
+        keep = false;
+    }
+
+    /* Read the rest of the body (an error description at most) and drop what
+     * does not fit in reply. Without a length the connection cannot be reused */
+    value = line_http_header(header, "Content-Length");
+    if (value) {
+        int remain = atoi(value) - got;
+        while (remain > 0 && keep) {
+            int n = recv(http->sock, header, remain < LINE_HTTP_HEADER_MAX ? remain : LINE_HTTP_HEADER_MAX, 0);
+            if (n <= 0) {
+                keep = false;
+                break;
+            }
+            if (kept < LINE_HTTP_REPLY_MAX - 1) {
+                int add = n < LINE_HTTP_REPLY_MAX - 1 - kept ? n : LINE_HTTP_REPLY_MAX - 1 - kept;
+                memcpy(&http->reply[kept], header, add);
+                kept += add;
+                http->reply[kept] = '\0';
+            }
+            remain -= n;
+        }
+    } else if (status != 204 && status != 304) {
+        keep = false;
+    }
+
+    if (!keep) {
+        line_http_close(http);
+    }
+    return status;
+}
+
+int line_http_post(line_http_t *http, const char *host, uint16_t port, const char *path,
+                   const char *auth, const char *body, int len)
+{
+    http->reply[0] = '\0';
+    if (http->sock >= 0 && (strcmp(http->host, host) != 0 || http->port != port)) {
+        line_http_close(http);
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused = http->sock >= 0;
+        if (!reused) {
+            http->sock = line_tcp_connect(host, port);
+            if (http->sock < 0) {
+                return -1;
+            }
+            strncpy(http->host, host, sizeof(http->host) - 1);
+            http->host[sizeof(http->host) - 1] = '\0';
+            http->port = port;
+        }
+
+        int status = line_http_request(http, path, auth, body, len);
+        if (status >= 0 || !reused) {
+            return status;
+        }
+        /* The server dropped the idle connection, try once on a fresh one */
+        ESP_LOGW(TAG, "Kept-alive connection lost, reconnecting");
+    }
+    return -1;
+}
+
+/* ========== UDP ========== */
+
+int line_udp_open(line_udp_t *udp, const char *host, uint16_t port)
+{
+    line_udp_close(udp);
+    if (line_resolve(host, &udp->addr) < 0) {
+        return -1;
+    }
+    udp->sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (udp->sock < 0) {
+        ESP_LOGE(TAG, "Socket creation failed");
+        return -1;
+    }
+    udp->port = port;
+    return 0;
+}
+
+int line_udp_send(line_udp_t *udp, const char *buf, int len)
+{
+    struct sockaddr_in dest;
+
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(udp->port);
+    dest.sin_addr.s_addr = udp->addr;
+
+    if (sendto(udp->sock, buf, len, 0, (struct sockaddr *)&dest, sizeof(dest)) != len) {
+        ESP_LOGW(TAG, "sendto failed: errno %d", errno);
+        return -1;
+    }
+    return 0;
+}
+
+void line_udp_close(line_udp_t *udp)
+{
+    if (udp->sock >= 0) {
+        close(udp->sock);
+    }
+    udp->sock = -1;
+}
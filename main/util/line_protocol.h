@@ -0,0 +1,68 @@
+#ifndef LINE_PROTOCOL_H
+#define LINE_PROTOCOL_H
+
+/*
+ * InfluxDB line protocol: point formatting, HTTP writes over a keep-alive
+ * connection and fire-and-forget UDP datagrams. Like mysql_client, no ESP-IDF
+ * dependency beyond logging and the clock, so it builds on a Linux host
+ * against POSIX sockets (without ESP_PLATFORM) and can be pointed at a local
+ * listener (nc -l, nc -lu) there.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LINE_TIMEOUT_SEC          10      /* one HTTP request/response */
+#define LINE_CONNECT_TIMEOUT_SEC  5       /* TCP connect */
+#define LINE_UDP_PAYLOAD_MAX      1400    /* keeps a datagram below a typical MTU */
+#define LINE_HTTP_REPLY_MAX       192     /* kept from the start of a response body */
+
+/* Copy src to dst with the line-protocol escapes: '\' before ',' and ' ' in
+ * a measurement, also before '=' in a tag key or value. Returns the length,
+ * -1 when it does not fit */
+int line_protocol_escape(char *dst, int size, const char *src, bool tag);
+
+/* Append one point "measurement[,tags] field=value,... timestamp\n" to buf.
+ * The measurement is escaped here; tags are "key=value[,key=value]" with key
+ * and value escaped by the caller. Non-finite values are left out. Returns the
+ * bytes appended, 0 when no field is left, -1 when the point does not fit */
+int line_protocol_append(char *buf, int size, const char *measurement, const char *tags,
+                         const char *const *names, const float *values, const uint8_t *precision,
+                         int cnt, int64_t timestamp, bool nanoseconds);
+
+/* HTTP/1.1 client connection, kept open between writes */
+typedef struct {
+    int      sock;
+    char     host[64];
+    uint16_t port;
+    char     reply[LINE_HTTP_REPLY_MAX];  /* start of the last response body */
+} line_http_t;
+
+/* POST body to path. The connection is reused while the server keeps it open,
+ * a stale one is replaced once. Returns the HTTP status or -1; the start of
+ * the response body (an error description) is left in http->reply */
+int line_http_post(line_http_t *http, const char *host, uint16_t port, const char *path,
+                   const char *auth, const char *body, int len);
+void line_http_close(line_http_t *http);
+
+/* UDP socket with the resolved destination */
+typedef struct {
+    int      sock;
+    uint32_t addr;               /* network byte order */
+    uint16_t port;
+} line_udp_t;
+
+int line_udp_open(line_udp_t *udp, const char *host, uint16_t port);
+/* One datagram, 0 when handed to the stack */
+int line_udp_send(line_udp_t *udp, const char *buf, int len);
+void line_udp_close(line_udp_t *udp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
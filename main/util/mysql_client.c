@@ -0,0 +1,1407 @@
+#include "mysql_client.h"
+#include "dns_cache.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/rsa.h"
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/version.h"
+#include <errno.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_crt_bundle.h"
+#include "esp_heap_caps.h"
+#include "rom/miniz.h"
+
+#define MYSQL_HAVE_COMPRESS  1
+#define MYSQL_ZALLOC(size)   heap_caps_malloc(size, MALLOC_CAP_SPIRAM)
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#else
+/* Host build: POSIX sockets, log to stderr */
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) fprintf(stderr, "I (%s) " fmt "\n", tag, ##__VA_ARGS__)
+
+/* Compression uses the ROM miniz on the device. A host build may define
+ * MYSQL_HAVE_COMPRESS and provide the single-file miniz */
+#ifndef MYSQL_HAVE_COMPRESS
+#define MYSQL_HAVE_COMPRESS  0
+#endif
+#if MYSQL_HAVE_COMPRESS
+#include <stdlib.h>
+#include "miniz.h"
+#define MYSQL_ZALLOC(size)   malloc(size)
+#endif
+
+static int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+#endif
+
+/* Host distributions may still ship mbedTLS 2.28: fields are public there and
+ * the RSA padding setter returns nothing */
+#if MBEDTLS_VERSION_MAJOR < 3
+#define MBEDTLS_PRIVATE(member) member
+#endif
+
+#define MYSQL_WAIT_SLICE_MS  100         /* cancel flag poll interval while blocked in select */
+
+/* mysql_io_recv/mysql_io_send results asking to wait and retry */
+#define MYSQL_IO_WANT_READ   -2
+#define MYSQL_IO_WANT_WRITE  -3
+
+#define MYSQL_AUTH_MAX_ROUNDS 4          /* auth switch + caching_sha2_password exchanges */
+
+/* Deflate effort: greedy parsing with few probes, the rows are repetitive
+ * enough that a deeper search buys little */
+#define MYSQL_COMPRESS_PROBES 32
+
+/* TCP keep-alive for long-lived sessions */
+#define MYSQL_TCP_KEEPIDLE_SEC  60
+#define MYSQL_TCP_KEEPINTVL_SEC 15
+#define MYSQL_TCP_KEEPCNT       4
+
+static const char *TAG = "mysql";
+
+void mysql_conn_close(mysql_conn_t *conn)
+{
+    if (conn->tls_active) {
+        /* Best effort, the socket is non-blocking and closed right after */
+        mbedtls_ssl_close_notify(&conn->tls->ssl);
+        conn->tls_active = false;
+    }
+    if (conn->compressed) {
+        conn->z->plain_pos = 0;
+        conn->z->plain_len = 0;
+        conn->compressed = false;
+    }
+    if (conn->sock >= 0) {
+        close(conn->sock);
+    }
+    conn->sock = -1;
+    conn->rx_pos = 0;
+    conn->rx_len = 0;
+}
+
+/* Start the deadline for the next phase (connect, handshake, one command) */
+static void mysql_conn_arm(mysql_conn_t *conn, int timeout_sec)
+{
+    conn->deadline_us = esp_timer_get_time() + (int64_t)timeout_sec * 1000000;
+}
+
+static void mysql_conn_phase(mysql_conn_t *conn, int phase, int timeout_sec)
+{
+    mysql_conn_arm(conn, timeout_sec);
+    if (conn->on_phase) {
+        conn->on_phase(phase);
+    }
+}
+
+/* Wait until the socket is readable/writable, in short slices so a
+ * cancellation is noticed quickly */
+static int mysql_conn_wait(mysql_conn_t *conn, bool for_write)
+{
+    while (1) {
+        if (conn->gen != 0 && conn->cancel_gen == conn->gen) {
+            conn->error = MYSQL_CONN_ERR_CANCELLED;
+            ESP_LOGW(TAG, "Operation cancelled");
+            return -1;
+        }
+        int64_t remain_us = conn->deadline_us - esp_timer_get_time();
+        if (remain_us <= 0) {
+            conn->error = MYSQL_CONN_ERR_TIMEOUT;
+            ESP_LOGE(TAG, "%s timeout", for_write ? "Send" : "Receive");
+            return -1;
+        }
+        if (remain_us > MYSQL_WAIT_SLICE_MS * 1000) {
+            remain_us = MYSQL_WAIT_SLICE_MS * 1000;
+        }
+
+        fd_set fds;
+        struct timeval tv = {
+            .tv_sec = 0,
+            .tv_usec = remain_us,
+        };
+        FD_ZERO(&fds);
+        FD_SET(conn->sock, &fds);
+        int n = select(conn->sock + 1, for_write ? NULL : &fds, for_write ? &fds : NULL, NULL, &tv);
+        if (n > 0) {
+            return 0;
+        }
+        if (n < 0 && errno != EINTR) {
+            conn->error = MYSQL_CONN_ERR_IO;
+            ESP_LOGE(TAG, "select failed: errno %d", errno);
+            return -1;
+        }
+    }
+}
+
+/* One recv, through TLS when active: bytes read, 0 when the peer closed,
+ * -1 on error or MYSQL_IO_WANT_READ/WRITE to retry after waiting */
+static int mysql_io_recv(mysql_conn_t *conn, uint8_t *buf, int len)
+{
+    int n;
+
+    if (conn->tls_active) {
+        n = mbedtls_ssl_read(&conn->tls->ssl, buf, len);
+        if (n >= 0) return n;
+        if (n == MBEDTLS_ERR_SSL_WANT_READ) return MYSQL_IO_WANT_READ;
+        if (n == MBEDTLS_ERR_SSL_WANT_WRITE) return MYSQL_IO_WANT_WRITE;
+        if (n == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) return 0;
+        ESP_LOGE(TAG, "TLS read failed: -0x%04x", -n);
+        return -1;
+    }
+
+    n = recv(conn->sock, buf, len, 0);
+    if (n >= 0) return n;
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return MYSQL_IO_WANT_READ;
+    ESP_LOGE(TAG, "recv failed: errno %d", errno);
+    return -1;
+}
+
+/* One send, through TLS when active: bytes written, -1 on error or
+ * MYSQL_IO_WANT_READ/WRITE to retry after waiting */
+static int mysql_io_send(mysql_conn_t *conn, const uint8_t *buf, int len)
+{
+    int n;
+
+    if (conn->tls_active) {
+        n = mbedtls_ssl_write(&conn->tls->ssl, buf, len);
+        if (n >= 0) return n;
+        if (n == MBEDTLS_ERR_SSL_WANT_READ) return MYSQL_IO_WANT_READ;
+        if (n == MBEDTLS_ERR_SSL_WANT_WRITE) return MYSQL_IO_WANT_WRITE;
+        ESP_LOGE(TAG, "TLS write failed: -0x%04x", -n);
+        return -1;
+    }
+
+    n = send(conn->sock, buf, len, 0);
+    if (n >= 0) return n;
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return MYSQL_IO_WANT_WRITE;
+    ESP_LOGE(TAG, "send failed: errno %d", errno);
+    return -1;
+}
+
+/* Refill the receive buffer, at least one byte or an error */
+static int mysql_conn_fill(mysql_conn_t *conn)
+{
+    if (conn->rx_pos == conn->rx_len) {
+        conn->rx_pos = 0;
+        conn->rx_len = 0;
+    }
+
+    while (1) {
+        int n = mysql_io_recv(conn, &conn->rx_buf[conn->rx_len], MYSQL_RX_BUF_SIZE - conn->rx_len);
+        if (n > 0) {
+            conn->rx_len += n;
+            return n;
+        }
+        if (n == 0) {
+            conn->error = MYSQL_CONN_ERR_IO;
+            ESP_LOGE(TAG, "Connection closed by server");
+            return -1;
+        }
+        if (n == -1) {
+            conn->error = MYSQL_CONN_ERR_IO;
+            return -1;
+        }
+        if (mysql_conn_wait(conn, n == MYSQL_IO_WANT_WRITE) < 0) {
+            return -1;
+        }
+    }
+}
+
+/* Read exactly len bytes off the socket, dst NULL discards them */
+static int mysql_read_raw(mysql_conn_t *conn, uint8_t *dst, int len)
+{
+    while (len > 0) {
+        if (conn->rx_pos == conn->rx_len && mysql_conn_fill(conn) < 0) {
+            return -1;
+        }
+        int n = conn->rx_len - conn->rx_pos;
+        if (n > len) n = len;
+        if (dst) {
+            memcpy(dst, &conn->rx_buf[conn->rx_pos], n);
+            dst += n;
+        }
+        conn->rx_pos += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* Write exactly len bytes */
+static int mysql_write_full(mysql_conn_t *conn, const uint8_t *data, int len)
+{
+    while (len > 0) {
+        int n = mysql_io_send(conn, data, len);
+        if (n == -1) {
+            conn->error = MYSQL_CONN_ERR_IO;
+            return -1;
+        }
+        if (n < 0) {
+            if (mysql_conn_wait(conn, n == MYSQL_IO_WANT_WRITE) < 0) {
+                return -1;
+            }
+            continue;
+        }
+        data += n;
+        len -= n;
+        conn->tx_wire_bytes += n;
+    }
+    return 0;
+}
+
+#if MYSQL_HAVE_COMPRESS
+int mysql_zstream_alloc(mysql_zstream_t *z, int size)
+{
+    z->deflate = MYSQL_ZALLOC(sizeof(tdefl_compressor));
+    z->inflate = MYSQL_ZALLOC(sizeof(tinfl_decompressor));
+    z->frame = MYSQL_ZALLOC(size);
+    z->plain = MYSQL_ZALLOC(size);
+    z->size = size;
+    z->plain_pos = 0;
+    z->plain_len = 0;
+    if (!z->deflate || !z->inflate || !z->frame || !z->plain) {
+        ESP_LOGE(TAG, "No memory for compression buffers");
+        return -1;
+    }
+    return 0;
+}
+
+/* Read the next compressed frame, its packet bytes end up in z->plain */
+static int mysql_read_frame(mysql_conn_t *conn)
+{
+    mysql_zstream_t *z = conn->z;
+    uint8_t header[7];
+
+    if (mysql_read_raw(conn, header, 7) < 0) {
+        return -1;
+    }
+    int clen = header[0] | (header[1] << 8) | (header[2] << 16);
+    int ulen = header[4] | (header[5] << 8) | (header[6] << 16);
+    z->seq = header[3] + 1;
+    z->plain_pos = 0;
+    z->plain_len = 0;
+
+    if (clen > z->size || ulen > z->size) {
+        conn->error = MYSQL_CONN_ERR_IO;
+        ESP_LOGE(TAG, "Compressed frame of %d bytes exceeds the %d byte buffer", clen > ulen ? clen : ulen, z->size);
+        return -1;
+    }
+
+    /* Uncompressed length 0: the server sent the packets as they are */
+    if (ulen == 0) {
+        if (mysql_read_raw(conn, z->plain, clen) < 0) {
+            return -1;
+        }
+        z->plain_len = clen;
+        return 0;
+    }
+
+    if (mysql_read_raw(conn, z->frame, clen) < 0) {
+        return -1;
+    }
+    size_t in_len = clen;
+    size_t out_len = ulen;
+    tinfl_init((tinfl_decompressor *)z->inflate);
+    tinfl_status st = tinfl_decompress(z->inflate, z->frame, &in_len, z->plain, z->plain, &out_len,
+                                       TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF);
+    if (st != TINFL_STATUS_DONE || (int)out_len != ulen) {
+        conn->error = MYSQL_CONN_ERR_IO;
+        ESP_LOGE(TAG, "Inflate failed: status %d, %d of %d bytes", st, (int)out_len, ulen);
+        return -1;
+    }
+    z->plain_len = ulen;
+    return 0;
+}
+
+/* Send one packet as a compressed frame, deflated when it is large enough
+ * and actually shrinks */
+static int mysql_send_frame(mysql_conn_t *conn, const uint8_t *header, const uint8_t *data, int len)
+{
+    mysql_zstream_t *z = conn->z;
+    int plain_len = MYSQL_PACKET_HEADER_SIZE + len;
+    size_t out_len = 0;
+    uint8_t fh[7];
+
+    if (plain_len >= MYSQL_COMPRESS_MIN) {
+        size_t in_len = MYSQL_PACKET_HEADER_SIZE;
+        size_t out_avail = z->size;
+
+        tdefl_init(z->deflate, NULL, NULL, TDEFL_WRITE_ZLIB_HEADER | TDEFL_GREEDY_PARSING_FLAG | MYSQL_COMPRESS_PROBES);
+        tdefl_status st = tdefl_compress(z->deflate, header, &in_len, z->frame, &out_avail, TDEFL_NO_FLUSH);
+        if (st == TDEFL_STATUS_OKAY) {
+            out_len = out_avail;
+            in_len = len;
+            out_avail = z->size - out_len;
+            st = tdefl_compress(z->deflate, data, &in_len, z->frame + out_len, &out_avail, TDEFL_FINISH);
+            out_len += out_avail;
+        }
+        if (st != TDEFL_STATUS_DONE || out_len >= (size_t)plain_len) {
+            out_len = 0;
+        }
+    }
+
+    int frame_len = out_len ? (int)out_len : plain_len;
+    int ulen = out_len ? plain_len : 0;
+    fh[0] = frame_len & 0xFF;
+    fh[1] = (frame_len >> 8) & 0xFF;
+    fh[2] = (frame_len >> 16) & 0xFF;
+    fh[3] = z->seq++;
+    fh[4] = ulen & 0xFF;
+    fh[5] = (ulen >> 8) & 0xFF;
+    fh[6] = (ulen >> 16) & 0xFF;
+
+    if (mysql_write_full(conn, fh, 7) < 0) return -1;
+    if (out_len) {
+        return mysql_write_full(conn, z->frame, out_len);
+    }
+    if (mysql_write_full(conn, header, MYSQL_PACKET_HEADER_SIZE) < 0) return -1;
+    return mysql_write_full(conn, data, len);
+}
+#else
+int mysql_zstream_alloc(mysql_zstream_t *z, int size)
+{
+    ESP_LOGW(TAG, "Built without compression support");
+    return -1;
+}
+
+static int mysql_read_frame(mysql_conn_t *conn)
+{
+    conn->error = MYSQL_CONN_ERR_IO;
+    return -1;
+}
+
+static int mysql_send_frame(mysql_conn_t *conn, const uint8_t *header, const uint8_t *data, int len)
+{
+    conn->error = MYSQL_CONN_ERR_IO;
+    return -1;
+}
+#endif
+
+/* Read exactly len bytes of packet data, unwrapping compressed frames */
+static int mysql_read_full(mysql_conn_t *conn, uint8_t *dst, int len)
+{
+    mysql_zstream_t *z = conn->z;
+
+    if (!conn->compressed) {
+        return mysql_read_raw(conn, dst, len);
+    }
+
+    while (len > 0) {
+        if (z->plain_pos == z->plain_len && mysql_read_frame(conn) < 0) {
+            return -1;
+        }
+        int n = z->plain_len - z->plain_pos;
+        if (n > len) n = len;
+        if (dst) {
+            memcpy(dst, &z->plain[z->plain_pos], n);
+            dst += n;
+        }
+        z->plain_pos += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* Read one logical packet. Payloads of 16MB-1 continue in the next packet.
+ * Bytes past the packet buffer are drained and dropped, pkt->truncated tells */
+int mysql_read_packet(mysql_conn_t *conn, mysql_packet_t *pkt)
+{
+    uint8_t header[4];
+    int chunk;
+
+    pkt->length = 0;
+    pkt->truncated = false;
+
+    do {
+        if (mysql_read_full(conn, header, 4) < 0) {
+            ESP_LOGE(TAG, "Failed to read packet header");
+            return -1;
+        }
+        chunk = header[0] | (header[1] << 8) | (header[2] << 16);
+        pkt->sequence = header[3];
+
+        int keep = MYSQL_MAX_PACKET_SIZE - pkt->length;
+        if (keep > chunk) keep = chunk;
+        if (mysql_read_full(conn, &pkt->data[pkt->length], keep) < 0 ||
+            mysql_read_full(conn, NULL, chunk - keep) < 0) {
+            ESP_LOGE(TAG, "Failed to read packet data");
+            return -1;
+        }
+        pkt->length += keep;
+        if (keep < chunk) {
+            pkt->truncated = true;
+        }
+    } while (chunk == MYSQL_MAX_PAYLOAD);
+
+    if (pkt->truncated) {
+        ESP_LOGW(TAG, "Packet larger than %d bytes, tail skipped", MYSQL_MAX_PACKET_SIZE);
+    }
+    return 0;
+}
+
+/* Write a payload, split into 16MB-1 chunks as the protocol requires */
+static int mysql_send_payload(mysql_conn_t *conn, const uint8_t *data, int len, uint8_t seq)
+{
+    uint8_t header[4];
+
+    while (1) {
+        int chunk = len < MYSQL_MAX_PAYLOAD ? len : MYSQL_MAX_PAYLOAD;
+        header[0] = chunk & 0xFF;
+        header[1] = (chunk >> 8) & 0xFF;
+        header[2] = (chunk >> 16) & 0xFF;
+        header[3] = seq++;
+
+        if (conn->compressed) {
+            if (mysql_send_frame(conn, header, data, chunk) < 0) return -1;
+        } else {
+            if (mysql_write_full(conn, header, 4) < 0) return -1;
+            if (mysql_write_full(conn, data, chunk) < 0) return -1;
+        }
+        conn->tx_packet_bytes += 4 + chunk;
+        data += chunk;
+        len -= chunk;
+
+        /* A full chunk is always followed by another, possibly empty one */
+        if (chunk < MYSQL_MAX_PAYLOAD) {
+            return 0;
+        }
+    }
+}
+
+int mysql_send_packet(mysql_conn_t *conn, const uint8_t *data, int len, uint8_t seq)
+{
+    /* Sequence 0 starts a new command, and with it a new response deadline */
+    if (seq == 0) {
+        mysql_conn_phase(conn, MYSQL_PHASE_QUERY, MYSQL_TIMEOUT_SEC);
+        if (conn->compressed) {
+            conn->z->seq = 0;
+        }
+    }
+    return mysql_send_payload(conn, data, len, seq);
+}
+
+void mysql_quit(mysql_conn_t *conn)
+{
+    uint8_t cmd = 0x01; /* COM_QUIT */
+
+    /* A failed connection may have a command half sent, or nobody listening */
+    if (conn->sock < 0 || conn->error != MYSQL_CONN_OK) {
+        return;
+    }
+    conn->deadline_us = esp_timer_get_time() + (int64_t)MYSQL_QUIT_TIMEOUT_MS * 1000;
+    if (conn->compressed) {
+        conn->z->seq = 0;
+    }
+    mysql_send_payload(conn, &cmd, 1, 0);
+}
+
+/* Native password auth (mysql_native_password) - SHA1 based
+ * Algorithm: SHA1(password) XOR SHA1(scramble + SHA1(SHA1(password)))
+ */
+static void mysql_native_auth(const char *password, const uint8_t *scramble, uint8_t *out)
+{
+    uint8_t stage1[20];  /* SHA1(password) */
+    uint8_t stage2[20];  /* SHA1(stage1) */
+    uint8_t combined[40]; /* scramble (20) + stage2 (20) */
+    uint8_t stage3[20];  /* SHA1(combined) */
+
+    /* Stage 1: SHA1(password) */
+    mbedtls_sha1((const unsigned char *)password, strlen(password), stage1);
+
+    /* Stage 2: SHA1(SHA1(password)) */
+    mbedtls_sha1(stage1, 20, stage2);
+
+    /* Combine: scramble + stage2 */
+    memcpy(combined, scramble, 20);
+    memcpy(combined + 20, stage2, 20);
+
+    /* Stage 3: SHA1(scramble + stage2) */
+    mbedtls_sha1(combined, 40, stage3);
+
+    /* Result: stage1 XOR stage3 */
+    for (int i = 0; i < 20; i++) {
+        out[i] = stage1[i] ^ stage3[i];
+    }
+}
+
+/* caching_sha2_password scramble - SHA256 based
+ * Algorithm: SHA256(password) XOR SHA256(SHA256(SHA256(password)) + nonce)
+ */
+static void mysql_sha2_auth(const char *password, const uint8_t *scramble, uint8_t *out)
+{
+    uint8_t stage1[32];  /* SHA256(password) */
+    uint8_t stage2[32];  /* SHA256(stage1) */
+    uint8_t stage3[32];  /* SHA256(stage2 + nonce) */
+    mbedtls_sha256_context ctx;
+
+    mbedtls_sha256((const unsigned char *)password, strlen(password), stage1, 0);
+    mbedtls_sha256(stage1, 32, stage2, 0);
+
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    mbedtls_sha256_update(&ctx, stage2, 32);
+    mbedtls_sha256_update(&ctx, scramble, 20);
+    mbedtls_sha256_finish(&ctx, stage3);
+    mbedtls_sha256_free(&ctx);
+
+    for (int i = 0; i < 32; i++) {
+        out[i] = stage1[i] ^ stage3[i];
+    }
+}
+
+/* Scrambled password for the given auth plugin, returns its length or -1
+ * if the plugin is not supported */
+static int mysql_auth_scramble(const char *plugin, const char *password, const uint8_t *scramble, uint8_t *out)
+{
+    if (strcmp(plugin, "mysql_native_password") != 0 && strcmp(plugin, "caching_sha2_password") != 0) {
+        return -1;
+    }
+    if (!password || password[0] == '\0') {
+        return 0;
+    }
+    if (plugin[0] == 'c') {
+        mysql_sha2_auth(password, scramble, out);
+        return 32;
+    }
+    mysql_native_auth(password, scramble, out);
+    return 20;
+}
+
+/* ========== TLS ========== */
+
+static int mysql_tls_bio_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    mysql_conn_t *conn = ctx;
+    int n = send(conn->sock, buf, len, 0);
+    if (n >= 0) return n;
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return MBEDTLS_ERR_SSL_WANT_WRITE;
+    return MBEDTLS_ERR_NET_SEND_FAILED;
+}
+
+static int mysql_tls_bio_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    mysql_conn_t *conn = ctx;
+    int n = recv(conn->sock, buf, len, 0);
+    if (n >= 0) return n;
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return MBEDTLS_ERR_SSL_WANT_READ;
+    return MBEDTLS_ERR_NET_RECV_FAILED;
+}
+
+/* Seed the RNG, on its own for RSA password encryption without TLS */
+static int mysql_rng_init(mysql_tls_t *tls)
+{
+    int ret;
+
+    if (tls->rng_ready) {
+        return 0;
+    }
+
+    mbedtls_entropy_init(&tls->entropy);
+    mbedtls_ctr_drbg_init(&tls->ctr_drbg);
+    ret = mbedtls_ctr_drbg_seed(&tls->ctr_drbg, mbedtls_entropy_func, &tls->entropy,
+                                (const unsigned char *)TAG, strlen(TAG));
+    if (ret != 0) {
+        ESP_LOGE(TAG, "RNG seed failed: -0x%04x", -ret);
+        mbedtls_ctr_drbg_free(&tls->ctr_drbg);
+        mbedtls_entropy_free(&tls->entropy);
+        return -1;
+    }
+    tls->rng_ready = true;
+    return 0;
+}
+
+int mysql_tls_init(mysql_tls_t *tls)
+{
+    int ret;
+
+    if (tls->ready) {
+        return 0;
+    }
+    if (mysql_rng_init(tls) < 0) {
+        return -1;
+    }
+
+    mbedtls_ssl_config_init(&tls->conf);
+    mbedtls_ssl_init(&tls->ssl);
+    mbedtls_ssl_session_init(&tls->session);
+    tls->session_valid = false;
+
+    ret = mbedtls_ssl_config_defaults(&tls->conf, MBEDTLS_SSL_IS_CLIENT,
+                                      MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret == 0) {
+        /* The password goes to this server: a certificate that verifies
+         * neither against the bundle nor against the pin fails the handshake */
+        mbedtls_ssl_conf_authmode(&tls->conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+#ifdef ESP_PLATFORM
+        ret = esp_crt_bundle_attach(&tls->conf);
+#else
+        mbedtls_x509_crt_init(&tls->ca);
+        if (mbedtls_x509_crt_parse_path(&tls->ca, "/etc/ssl/certs") < 0) {
+            ESP_LOGW(TAG, "No system CA certificates, only a pinned server will verify");
+        }
+        mbedtls_ssl_conf_ca_chain(&tls->conf, &tls->ca, NULL);
+#endif
+    }
+    if (ret == 0) {
+        mbedtls_ssl_conf_rng(&tls->conf, mbedtls_ctr_drbg_random, &tls->ctr_drbg);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+        mbedtls_ssl_conf_session_tickets(&tls->conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+        ret = mbedtls_ssl_setup(&tls->ssl, &tls->conf);
+    }
+
+    if (ret != 0) {
+        ESP_LOGE(TAG, "TLS setup failed: -0x%04x", -ret);
+        mbedtls_ssl_session_free(&tls->session);
+        mbedtls_ssl_free(&tls->ssl);
+        mbedtls_ssl_config_free(&tls->conf);
+#ifndef ESP_PLATFORM
+        mbedtls_x509_crt_free(&tls->ca);
+#endif
+        return -1;
+    }
+    tls->ready = true;
+    return 0;
+}
+
+void mysql_tls_forget(mysql_tls_t *tls)
+{
+    if (tls->ready) {
+        mbedtls_ssl_session_free(&tls->session);
+        mbedtls_ssl_session_init(&tls->session);
+    }
+    tls->session_valid = false;
+}
+
+static int mysql_hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+int mysql_parse_sha256(const char *hex, uint8_t out[32])
+{
+    int digits = 0;
+
+    for (const char *p = hex; p && *p; p++) {
+        if (*p == ':' || *p == ' ') {
+            continue;
+        }
+        int d = mysql_hex_digit(*p);
+        if (d < 0 || digits >= 64) {
+            return -1;
+        }
+        if (digits % 2 == 0) {
+            out[digits / 2] = d << 4;
+        } else {
+            out[digits / 2] |= d;
+        }
+        digits++;
+    }
+    if (digits == 0) {
+        return 0;
+    }
+    return digits == 64 ? 1 : -1;
+}
+
+int mysql_tls_pin(mysql_tls_t *tls, const char *sha256_hex)
+{
+    uint8_t pin[sizeof(tls->pin)];
+    int ret = mysql_parse_sha256(sha256_hex, pin);
+
+    if (ret < 0) {
+        return -1;
+    }
+
+    bool pinned = ret > 0;
+    if (pinned != tls->pinned || (pinned && memcmp(pin, tls->pin, sizeof(pin)) != 0)) {
+        /* A resumed session skips the certificate, it must not outlive the pin */
+        mysql_tls_forget(tls);
+    }
+    tls->pinned = pinned;
+    if (pinned) {
+        memcpy(tls->pin, pin, sizeof(pin));
+    }
+    return 0;
+}
+
+/* Verify callback with a pin: the server certificate is trusted when its
+ * SHA-256 matches, whatever its issuer, so the chain above it is not checked */
+static int mysql_tls_verify_pin(void *ctx, mbedtls_x509_crt *crt, int depth, uint32_t *flags)
+{
+    mysql_tls_t *tls = ctx;
+    uint8_t hash[32];
+
+    if (depth != 0) {
+        *flags = 0;
+        return 0;
+    }
+    mbedtls_sha256(crt->raw.p, crt->raw.len, hash, 0);
+    if (memcmp(hash, tls->pin, sizeof(hash)) == 0) {
+        *flags = 0;
+    } else {
+        *flags |= MBEDTLS_X509_BADCERT_NOT_TRUSTED;
+    }
+    return 0;
+}
+
+/* Run the TLS handshake on the connected socket, offering the cached session */
+static int mysql_tls_handshake(mysql_conn_t *conn, const char *host)
+{
+    mysql_tls_t *tls = conn->tls;
+    mbedtls_ssl_session fresh;
+    int64_t start_us = esp_timer_get_time();
+    int ret;
+
+    mbedtls_ssl_session_reset(&tls->ssl);
+    mbedtls_ssl_set_hostname(&tls->ssl, host);
+    mbedtls_ssl_set_bio(&tls->ssl, conn, mysql_tls_bio_send, mysql_tls_bio_recv, NULL);
+    /* NULL falls back to the bundle's callback on the config */
+    mbedtls_ssl_set_verify(&tls->ssl, tls->pinned ? mysql_tls_verify_pin : NULL, tls);
+    tls->offered = tls->session_valid && mbedtls_ssl_set_session(&tls->ssl, &tls->session) == 0;
+    tls->resumed = false;
+
+    while ((ret = mbedtls_ssl_handshake(&tls->ssl)) != 0) {
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            if (ret == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) {
+                conn->error = MYSQL_CONN_ERR_CERT;
+                ESP_LOGE(TAG, "Server certificate not trusted (flags 0x%lx)%s",
+                         (unsigned long)mbedtls_ssl_get_verify_result(&tls->ssl),
+                         tls->pinned ? ", it does not match the pinned fingerprint" :
+                                       ", pin its SHA-256 fingerprint for a self-signed server");
+            } else {
+                ESP_LOGE(TAG, "TLS handshake failed: -0x%04x", -ret);
+            }
+            /* Don't let a stale session fail every following attempt */
+            mysql_tls_forget(tls);
+            return -1;
+        }
+        if (mysql_conn_wait(conn, ret == MBEDTLS_ERR_SSL_WANT_WRITE) < 0) {
+            return -1;
+        }
+    }
+    conn->tls_active = true;
+    tls->handshake_us = esp_timer_get_time() - start_us;
+
+    /* Keep the session for the next connect. A resumed handshake carries the
+     * master secret over, a full one derives a new one; mbedTLS has no public
+     * getter for this */
+    mbedtls_ssl_session_init(&fresh);
+    if (mbedtls_ssl_get_session(&tls->ssl, &fresh) == 0) {
+        tls->resumed = tls->offered &&
+                       memcmp(fresh.MBEDTLS_PRIVATE(master), tls->session.MBEDTLS_PRIVATE(master),
+                              sizeof(fresh.MBEDTLS_PRIVATE(master))) == 0;
+        mbedtls_ssl_session_free(&tls->session);
+        tls->session = fresh;
+        tls->session_valid = true;
+    } else {
+        mbedtls_ssl_session_free(&fresh);
+    }
+
+    ESP_LOGI(TAG, "TLS %s handshake (%s) in %lld us",
+             tls->resumed ? "resumed" : "full", mbedtls_ssl_get_ciphersuite(&tls->ssl), (long long)tls->handshake_us);
+    return 0;
+}
+
+/* ========== Authentication ========== */
+
+/* caching_sha2_password full authentication, after the server found no cached
+ * entry: the cleartext password over TLS to a verified server, otherwise
+ * encrypted with the server's RSA public key (OAEP), XORed with the nonce first */
+static int mysql_sha2_full_auth(mysql_conn_t *conn, mysql_packet_t *pkt, const char *password,
+                                const uint8_t *scramble)
+{
+    uint8_t plain[80];
+    uint8_t cipher[512];
+    size_t cipher_len = 0;
+    int pw_len = strlen(password) + 1;  /* sent with its terminator */
+    uint8_t req = 0x02;                 /* request public key */
+    mbedtls_pk_context pk;
+    int ret;
+
+    if (conn->tls_active && mbedtls_ssl_get_verify_result(&conn->tls->ssl) == 0) {
+        return mysql_send_packet(conn, (const uint8_t *)password, pw_len, pkt->sequence + 1);
+    }
+
+    if (!conn->tls || mysql_rng_init(conn->tls) < 0 || pw_len > (int)sizeof(plain)) {
+        ESP_LOGE(TAG, "caching_sha2_password full auth needs TLS or RSA");
+        return -1;
+    }
+
+    if (mysql_send_packet(conn, &req, 1, pkt->sequence + 1) < 0 ||
+        mysql_read_packet(conn, pkt) < 0) {
+        return -1;
+    }
+    if (pkt->length < 2 || pkt->data[0] != 0x01 || pkt->truncated) {
+        ESP_LOGE(TAG, "Server sent no public key");
+        return -1;
+    }
+
+    /* PEM follows the 0x01 marker, mbedTLS wants it NUL-terminated */
+    memmove(pkt->data, &pkt->data[1], pkt->length - 1);
+    pkt->data[pkt->length - 1] = '\0';
+
+    for (int i = 0; i < pw_len; i++) {
+        plain[i] = password[i] ^ scramble[i % 20];
+    }
+
+    mbedtls_pk_init(&pk);
+    ret = mbedtls_pk_parse_public_key(&pk, pkt->data, pkt->length);
+    if (ret == 0 && mbedtls_pk_get_type(&pk) == MBEDTLS_PK_RSA) {
+#if MBEDTLS_VERSION_MAJOR < 3
+        mbedtls_rsa_set_padding(mbedtls_pk_rsa(pk), MBEDTLS_RSA_PKCS_V21, MBEDTLS_MD_SHA1);
+#else
+        ret = mbedtls_rsa_set_padding(mbedtls_pk_rsa(pk), MBEDTLS_RSA_PKCS_V21, MBEDTLS_MD_SHA1);
+#endif
+    }
+    if (ret == 0) {
+        ret = mbedtls_pk_encrypt(&pk, plain, pw_len, cipher, &cipher_len, sizeof(cipher),
+                                 mbedtls_ctr_drbg_random, &conn->tls->ctr_drbg);
+    }
+    mbedtls_pk_free(&pk);
+    memset(plain, 0, sizeof(plain));
+
+    if (ret != 0) {
+        ESP_LOGE(TAG, "RSA password encryption failed: -0x%04x", -ret);
+        return -1;
+    }
+    return mysql_send_packet(conn, cipher, cipher_len, pkt->sequence + 1);
+}
+
+/* Follow the server through auth switch and caching_sha2_password rounds
+ * until it answers OK or ERR */
+static int mysql_auth_result(mysql_conn_t *conn, mysql_packet_t *pkt, char *plugin, int plugin_size,
+                             const char *password, uint8_t *scramble)
+{
+    uint8_t auth_response[32];
+
+    for (int round = 0; round < MYSQL_AUTH_MAX_ROUNDS; round++) {
+        if (mysql_read_packet(conn, pkt) < 0) {
+            return -1;
+        }
+
+        if (pkt->data[0] == 0x00) {
+            ESP_LOGI(TAG, "MySQL authentication successful (%s)", plugin);
+            return 0;
+        }
+
+        if (pkt->data[0] == 0xFF) {
+            uint16_t err_code = pkt->data[1] | (pkt->data[2] << 8);
+            ESP_LOGE(TAG, "MySQL auth error %d: %.*s", err_code, pkt->length - 9, &pkt->data[9]);
+            return -1;
+        }
+
+        if (pkt->data[0] == 0xFE) {
+            /* Auth switch request: plugin name, then a new scramble */
+            int j = 1;
+            int k = 0;
+            while (j < pkt->length && pkt->data[j] != 0) {
+                if (k < plugin_size - 1) {
+                    plugin[k++] = pkt->data[j];
+                }
+                j++;
+            }
+            plugin[k] = '\0';
+            j++;
+            if (j + 20 <= pkt->length) {
+                memcpy(scramble, &pkt->data[j], 20);
+            }
+            ESP_LOGI(TAG, "Server requests auth switch to %s", plugin);
+
+            int n = mysql_auth_scramble(plugin, password, scramble, auth_response);
+            if (n < 0) {
+                ESP_LOGE(TAG, "Unsupported auth method %s", plugin);
+                return -1;
+            }
+            if (mysql_send_packet(conn, auth_response, n, pkt->sequence + 1) < 0) {
+                ESP_LOGE(TAG, "Failed to send auth switch response");
+                return -1;
+            }
+            continue;
+        }
+
+        /* caching_sha2_password: 0x01 0x03 fast auth succeeded (OK follows),
+         * 0x01 0x04 the server wants the full password */
+        if (pkt->data[0] == 0x01 && pkt->length >= 2 && strcmp(plugin, "caching_sha2_password") == 0) {
+            if (pkt->data[1] == 0x03) {
+                ESP_LOGI(TAG, "Fast auth from the server's password cache");
+                continue;
+            }
+            if (pkt->data[1] == 0x04) {
+                ESP_LOGI(TAG, "Full authentication requested");
+                if (mysql_sha2_full_auth(conn, pkt, password ? password : "", scramble) < 0) {
+                    return -1;
+                }
+                continue;
+            }
+        }
+        break;
+    }
+
+    ESP_LOGE(TAG, "Unexpected auth response 0x%02x", pkt->data[0]);
+    return -1;
+}
+
+int mysql_connect(mysql_conn_t *conn, const char *host, uint16_t port, const char *user,
+                         const char *password, const char *database)
+{
+    struct sockaddr_in server_addr;
+    uint32_t addr;
+    int sock;
+    mysql_packet_t pkt;
+
+    conn->error = MYSQL_CONN_ERR_IO;
+
+    /* Resolve hostname - lwIP bounds this with its own DNS retry timeout */
+    if (conn->on_phase) {
+        conn->on_phase(MYSQL_PHASE_RESOLVE);
+    }
+    if (dns_cache_resolve(host, &addr) < 0) {
+        ESP_LOGE(TAG, "DNS lookup failed for %s", host);
+        return -1;
+    }
+
+    /* Create socket */
+    sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "Socket creation failed");
+        return -1;
+    }
+
+    /* Never block in the socket calls, all waits go through mysql_conn_wait */
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+
+    /* The session outlives a single export, let TCP notice a dead peer */
+    int keepalive = 1;
+    int keepidle = MYSQL_TCP_KEEPIDLE_SEC;
+    int keepintvl = MYSQL_TCP_KEEPINTVL_SEC;
+    int keepcnt = MYSQL_TCP_KEEPCNT;
+    setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &keepalive, sizeof(keepalive));
+    setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &keepidle, sizeof(keepidle));
+    setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &keepintvl, sizeof(keepintvl));
+    setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &keepcnt, sizeof(keepcnt));
+
+    /* A command goes out as header and payload writes, then waits for the
+     * reply: Nagle would hold the payload until the server's delayed ACK */
+    int nodelay = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    /* Connect */
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port);
+    server_addr.sin_addr.s_addr = addr;
+
+    conn->sock = sock;
+    conn->rx_pos = 0;
+    conn->rx_len = 0;
+    conn->tls_active = false;
+    conn->compressed = false;
+    mysql_conn_phase(conn, MYSQL_PHASE_CONNECT, MYSQL_CONNECT_TIMEOUT_SEC);
+
+    if (connect(sock, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        int err = errno;
+        if (err == EINPROGRESS) {
+            if (mysql_conn_wait(conn, true) < 0) {
+                /* timed out or cancelled, conn->error says which */
+                ESP_LOGE(TAG, "Connection to %s:%d not established", host, port);
+                dns_cache_invalidate(host);  /* the server may have moved */
+                mysql_conn_close(conn);
+                return -1;
+            }
+            socklen_t len = sizeof(err);
+            getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len);
+        }
+        if (err != 0) {
+            conn->error = MYSQL_CONN_ERR_IO;
+            ESP_LOGE(TAG, "Connection failed to %s:%d (errno %d)", host, port, err);
+            dns_cache_invalidate(host);
+            mysql_conn_close(conn);
+            return -1;
+        }
+    }
+
+    ESP_LOGI(TAG, "Connected to MySQL server %s:%d", host, port);
+    mysql_conn_phase(conn, MYSQL_PHASE_HANDSHAKE, MYSQL_HANDSHAKE_TIMEOUT_SEC);
+
+    /* Read initial handshake packet */
+    if (mysql_read_packet(conn, &pkt) < 0) {
+        mysql_conn_close(conn);
+        return -1;
+    }
+
+    /* Check for error */
+    if (pkt.data[0] == 0xFF) {
+        ESP_LOGE(TAG, "Server error during handshake");
+        mysql_conn_close(conn);
+        return -1;
+    }
+
+    /* Parse handshake - extract scramble (auth data) */
+    uint8_t protocol_version = pkt.data[0];
+    ESP_LOGI(TAG, "MySQL protocol version: %d", protocol_version);
+
+    /* Find end of server version string */
+    int i = 1;
+    while (i < pkt.length && pkt.data[i] != 0) i++;
+    i++; /* Skip null terminator */
+
+    /* Skip connection id (4 bytes) */
+    i += 4;
+
+    /* Auth plugin data part 1 (8 bytes) */
+    uint8_t scramble[20];
+    char plugin[32] = "mysql_native_password";
+    memset(scramble, 0, sizeof(scramble));
+    memcpy(scramble, &pkt.data[i], 8);
+    i += 8;
+
+    /* Skip filler (1 byte) */
+    i++;
+
+    /* Capability flags lower 2 bytes */
+    uint32_t server_caps = pkt.data[i] | (pkt.data[i+1] << 8);
+    i += 2;
+
+    /* If there's more data, parse extended handshake */
+    if (i < pkt.length) {
+        /* Character set (1 byte) */
+        i++;
+        /* Status flags (2 bytes) */
+        i += 2;
+        /* Capability flags upper 2 bytes */
+        server_caps |= (pkt.data[i] | (pkt.data[i+1] << 8)) << 16;
+        i += 2;
+        /* Auth plugin data length or 0 (1 byte) */
+        int auth_plugin_data_len = pkt.data[i];
+        i++;
+        /* Reserved (10 bytes) */
+        i += 10;
+        /* Auth plugin data part 2 (rest of scramble, 12 bytes typically) */
+        if (auth_plugin_data_len > 8 && i + 12 <= pkt.length) {
+            memcpy(scramble + 8, &pkt.data[i], 12);
+        }
+        /* max(13, len - 8) bytes including a terminator, then the plugin name */
+        i += auth_plugin_data_len - 8 > 13 ? auth_plugin_data_len - 8 : 13;
+        if ((server_caps & 0x00080000) && i < pkt.length) {
+            int k = 0;
+            while (i < pkt.length && pkt.data[i] != 0 && k < (int)sizeof(plugin) - 1) {
+                plugin[k++] = pkt.data[i++];
+            }
+            plugin[k] = '\0';
+        }
+    }
+
+    ESP_LOGI(TAG, "Server capabilities: 0x%08lx, auth plugin %s", (unsigned long)server_caps, plugin);
+
+    /* Build handshake response */
+    uint8_t response[512];
+    int resp_len = 0;
+    uint8_t seq = pkt.sequence + 1;
+
+    /* Client capabilities (4 bytes) */
+    uint32_t client_caps = 0x000FA685; /* CLIENT_PROTOCOL_41 + CLIENT_SECURE_CONNECTION + others */
+    if (database && strlen(database) > 0) {
+        client_caps |= 0x00000008; /* CLIENT_CONNECT_WITH_DB */
+    }
+    client_caps |= 0x00080000; /* CLIENT_PLUGIN_AUTH */
+    if (conn->use_tls) {
+        /* Never fall back to plain text when TLS was asked for */
+        if (!(server_caps & 0x00000800) || !conn->tls || mysql_tls_init(conn->tls) < 0) {
+            ESP_LOGE(TAG, "TLS requested but not available");
+            mysql_conn_close(conn);
+            return -1;
+        }
+        client_caps |= 0x00000800; /* CLIENT_SSL */
+    }
+    if (conn->use_compress && conn->z && (server_caps & 0x00000020)) {
+        client_caps |= 0x00000020; /* CLIENT_COMPRESS */
+    }
+    response[resp_len++] = client_caps & 0xFF;
+    response[resp_len++] = (client_caps >> 8) & 0xFF;
+    response[resp_len++] = (client_caps >> 16) & 0xFF;
+    response[resp_len++] = (client_caps >> 24) & 0xFF;
+
+    /* Max packet size (4 bytes) */
+    response[resp_len++] = 0x00;
+    response[resp_len++] = 0x00;
+    response[resp_len++] = 0x00;
+    response[resp_len++] = 0x01; /* 16MB */
+
+    /* Character set (1 byte) - utf8mb4 */
+    response[resp_len++] = 45; /* utf8mb4_general_ci */
+
+    /* Reserved (23 bytes) */
+    memset(&response[resp_len], 0, 23);
+    resp_len += 23;
+
+    /* SSLRequest is this 32 byte prefix, the full response follows over TLS */
+    if (conn->use_tls) {
+        if (mysql_send_packet(conn, response, resp_len, seq++) < 0 ||
+            mysql_tls_handshake(conn, host) < 0) {
+            mysql_conn_close(conn);
+            return -1;
+        }
+    }
+
+    /* Username (null terminated) */
+    strcpy((char *)&response[resp_len], user);
+    resp_len += strlen(user) + 1;
+
+    /* Password, scrambled for the server's default plugin. For a plugin we
+     * don't support answer with native auth, the server then switches */
+    uint8_t auth_response[32];
+    int auth_len = mysql_auth_scramble(plugin, password, scramble, auth_response);
+    if (auth_len < 0) {
+        strcpy(plugin, "mysql_native_password");
+        auth_len = mysql_auth_scramble(plugin, password, scramble, auth_response);
+    }
+    response[resp_len++] = auth_len;  /* Length of auth response */
+    memcpy(&response[resp_len], auth_response, auth_len);
+    resp_len += auth_len;
+
+    /* Database (if specified) */
+    if (database && strlen(database) > 0) {
+        strcpy((char *)&response[resp_len], database);
+        resp_len += strlen(database) + 1;
+    }
+
+    /* Auth plugin name */
+    strcpy((char *)&response[resp_len], plugin);
+    resp_len += strlen(plugin) + 1;
+
+    /* Send handshake response */
+    if (mysql_send_packet(conn, response, resp_len, seq) < 0) {
+        ESP_LOGE(TAG, "Failed to send auth response");
+        mysql_conn_close(conn);
+        return -1;
+    }
+
+    if (mysql_auth_result(conn, &pkt, plugin, sizeof(plugin), password, scramble) < 0) {
+        mysql_conn_close(conn);
+        return -1;
+    }
+
+    /* Everything after the auth OK travels in compressed frames */
+    if (client_caps & 0x00000020) {
+        conn->compressed = true;
+        conn->z->seq = 0;
+        conn->z->plain_pos = 0;
+        conn->z->plain_len = 0;
+        ESP_LOGI(TAG, "Compressed protocol enabled");
+    }
+    conn->error = MYSQL_CONN_OK;
+    return 0;
+}
+
+/* Send the command already built in conn->tx_buf and wait for OK */
+int mysql_command_tx(mysql_conn_t *conn, int len)
+{
+    mysql_packet_t pkt;
+
+    if (mysql_send_packet(conn, conn->tx_buf, len, 0) < 0) {
+        return -1;
+    }
+
+    /* Read response */
+    if (mysql_read_packet(conn, &pkt) < 0) {
+        return -1;
+    }
+
+    if (pkt.data[0] == 0x00) {
+        ESP_LOGI(TAG, "Query OK");
+        return 0;
+    } else if (pkt.data[0] == 0xFF) {
+        uint16_t err_code = pkt.data[1] | (pkt.data[2] << 8);
+        ESP_LOGE(TAG, "Query error %d: %.*s", err_code, pkt.length - 9, &pkt.data[9]);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* Send the statement already placed in conn->tx_buf after the command byte */
+int mysql_query_tx(mysql_conn_t *conn, int query_len)
+{
+    conn->tx_buf[0] = 0x03; /* COM_QUERY */
+    return mysql_command_tx(conn, query_len + 1);
+}
+
+int mysql_query(mysql_conn_t *conn, const char *query)
+{
+    int query_len = strlen(query);
+    if (query_len > conn->tx_size - 1) return -1;
+
+    memcpy(&conn->tx_buf[1], query, query_len);
+    return mysql_query_tx(conn, query_len);
+}
+
+/* Length-encoded integer, returns bytes consumed or -1 */
+int mysql_read_lenenc(const uint8_t *p, int avail, uint64_t *val)
+{
+    if (avail < 1) return -1;
+    if (p[0] < 0xFB) {
+        *val = p[0];
+        return 1;
+    }
+    if (p[0] == 0xFC && avail >= 3) {
+        *val = p[1] | (p[2] << 8);
+        return 3;
+    }
+    if (p[0] == 0xFD && avail >= 4) {
+        *val = p[1] | (p[2] << 8) | ((uint32_t)p[3] << 16);
+        return 4;
+    }
+    if (p[0] == 0xFE && avail >= 9) {
+        *val = 0;
+        for (int i = 8; i >= 1; i--) {
+            *val = (*val << 8) | p[i];
+        }
+        return 9;
+    }
+    return -1;
+}
+
+bool mysql_is_eof(const mysql_packet_t *pkt)
+{
+    return pkt->length > 0 && pkt->length < 9 && pkt->data[0] == 0xFE;
+}
+
+/* Run a query returning a single value (first column of the first row) */
+int mysql_query_scalar(mysql_conn_t *conn, const char *query, char *out, int out_size)
+{
+    mysql_packet_t pkt;
+    uint64_t len;
+    int found = -1;
+    int query_len = strlen(query);
+    if (query_len > conn->tx_size - 1) return -1;
+
+    conn->tx_buf[0] = 0x03; /* COM_QUERY */
+    memcpy(&conn->tx_buf[1], query, query_len);
+    if (mysql_send_packet(conn, conn->tx_buf, query_len + 1, 0) < 0) {
+        return -1;
+    }
+
+    /* Column count */
+    if (mysql_read_packet(conn, &pkt) < 0) {
+        return -1;
+    }
+    if (pkt.data[0] == 0x00 || pkt.data[0] == 0xFF) {
+        return -1;
+    }
+
+    /* Column definitions, then rows, each list ends with an EOF packet */
+    for (int section = 0; section < 2; ) {
+        if (mysql_read_packet(conn, &pkt) < 0) {
+            return -1;
+        }
+        if (pkt.data[0] == 0xFF) {
+            return -1;
+        }
+        if (mysql_is_eof(&pkt)) {
+            section++;
+            continue;
+        }
+        if (section == 1 && found < 0) {
+            int n = mysql_read_lenenc(pkt.data, pkt.length, &len);
+            if (n < 0 || n + (int)len > pkt.length || (int)len >= out_size) {
+                continue;
+            }
+            memcpy(out, &pkt.data[n], len);
+            out[len] = '\0';
+            found = 0;
+        }
+    }
+    return found;
+}
+
+/* Read column definition packets up to the closing EOF */
+static int mysql_skip_definitions(mysql_conn_t *conn)
+{
+    mysql_packet_t pkt;
+
+    do {
+        if (mysql_read_packet(conn, &pkt) < 0) {
+            return -1;
+        }
+        if (pkt.data[0] == 0xFF) {
+            return -1;
+        }
+    } while (!mysql_is_eof(&pkt));
+    return 0;
+}
+
+/* COM_STMT_PREPARE - returns the parameter count, the statement id in *stmt_id */
+int mysql_stmt_prepare(mysql_conn_t *conn, const char *query, uint32_t *stmt_id)
+{
+    mysql_packet_t pkt;
+    int query_len = strlen(query);
+    if (query_len > conn->tx_size - 1) return -1;
+
+    conn->tx_buf[0] = 0x16; /* COM_STMT_PREPARE */
+    memcpy(&conn->tx_buf[1], query, query_len);
+    if (mysql_send_packet(conn, conn->tx_buf, query_len + 1, 0) < 0) {
+        return -1;
+    }
+
+    if (mysql_read_packet(conn, &pkt) < 0) {
+        return -1;
+    }
+    if (pkt.data[0] == 0xFF) {
+        uint16_t err_code = pkt.data[1] | (pkt.data[2] << 8);
+        ESP_LOGE(TAG, "Prepare error %d: %.*s", err_code, pkt.length - 9, &pkt.data[9]);
+        return -1;
+    }
+    if (pkt.data[0] != 0x00 || pkt.length < 12) {
+        return -1;
+    }
+
+    /* OK: stmt_id(4) num_columns(2) num_params(2) reserved(1) warnings(2) */
+    *stmt_id = pkt.data[1] | (pkt.data[2] << 8) | (pkt.data[3] << 16) | ((uint32_t)pkt.data[4] << 24);
+    int num_columns = pkt.data[5] | (pkt.data[6] << 8);
+    int num_params = pkt.data[7] | (pkt.data[8] << 8);
+
+    if (num_params > 0 && mysql_skip_definitions(conn) < 0) {
+        return -1;
+    }
+    if (num_columns > 0 && mysql_skip_definitions(conn) < 0) {
+        return -1;
+    }
+    return num_params;
+}
+
+/* COM_PING - one round trip to check that an idle session is still alive */
+int mysql_ping(mysql_conn_t *conn)
+{
+    mysql_packet_t pkt;
+    uint8_t cmd = 0x0E; /* COM_PING */
+
+    if (mysql_send_packet(conn, &cmd, 1, 0) < 0) {
+        return -1;
+    }
+    if (mysql_read_packet(conn, &pkt) < 0) {
+        return -1;
+    }
+    return (pkt.length > 0 && pkt.data[0] == 0x00) ? 0 : -1;
+}
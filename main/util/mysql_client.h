@@ -0,0 +1,171 @@
+#ifndef MYSQL_CLIENT_H
+#define MYSQL_CLIENT_H
+
+/*
+ * Minimal MySQL/MariaDB client protocol: handshake v10 with native and
+ * caching_sha2_password auth, optional TLS, COM_QUERY, COM_PING and
+ * COM_STMT_PREPARE, over one buffered non-blocking socket. No ESP-IDF
+ * dependency beyond logging, the clock and the certificate bundle, so the
+ * same file builds on a Linux host against POSIX sockets and mbedTLS
+ * (without ESP_PLATFORM).
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/x509_crt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MYSQL_TIMEOUT_SEC           10      /* one command round trip */
+#define MYSQL_CONNECT_TIMEOUT_SEC   5       /* TCP connect */
+#define MYSQL_HANDSHAKE_TIMEOUT_SEC 5       /* greeting + authentication */
+#define MYSQL_QUIT_TIMEOUT_MS       200     /* COM_QUIT write, nothing is read back */
+#define MYSQL_RX_BUF_SIZE           2048    /* socket receive buffer, reused for every response */
+
+#define MYSQL_COMPRESS_MIN          512     /* smaller packets travel in uncompressed frames */
+
+#define MYSQL_PACKET_HEADER_SIZE    4
+#define MYSQL_MAX_PACKET_SIZE       1024
+#define MYSQL_MAX_PAYLOAD           0xFFFFFF
+
+enum mysql_conn_error {
+    MYSQL_CONN_OK = 0,
+    MYSQL_CONN_ERR_IO,
+    MYSQL_CONN_ERR_TIMEOUT,
+    MYSQL_CONN_ERR_CANCELLED,
+    MYSQL_CONN_ERR_CERT,         /* the server certificate did not verify */
+};
+
+/* Progress reported through on_phase, in order */
+enum mysql_phase {
+    MYSQL_PHASE_RESOLVE = 1,
+    MYSQL_PHASE_CONNECT,
+    MYSQL_PHASE_HANDSHAKE,
+    MYSQL_PHASE_QUERY,
+};
+
+/* TLS state that outlives a connection: the mbedTLS config, RNG and SSL
+ * context are set up once, and the last session is kept so the next connect
+ * can resume it (session ticket or session id) with an abbreviated handshake.
+ * The server certificate must verify against the CA bundle, or match the
+ * pinned SHA-256 fingerprint. The RNG is also used for RSA password
+ * encryption on plain connections, and is seeded on its own for those */
+typedef struct {
+    bool                     ready;
+    bool                     rng_ready;
+    bool                     session_valid;  /* session may be offered for resumption */
+    bool                     pinned;         /* trust only the certificate hashing to pin */
+    uint8_t                  pin[32];
+    mbedtls_entropy_context  entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+    mbedtls_ssl_config       conf;
+    mbedtls_ssl_context      ssl;
+    mbedtls_ssl_session      session;
+#ifndef ESP_PLATFORM
+    mbedtls_x509_crt         ca;             /* host build: system CA store instead of the bundle */
+#endif
+    /* Last TLS handshake */
+    int64_t                  handshake_us;
+    bool                     offered;        /* a cached session was offered */
+    bool                     resumed;        /* the server accepted it */
+} mysql_tls_t;
+
+/* Compressed protocol (CLIENT_COMPRESS) state. Caller-owned and allocated
+ * once, the deflate state alone is ~300KB and belongs in PSRAM */
+typedef struct {
+    void     *deflate;           /* tdefl_compressor */
+    void     *inflate;           /* tinfl_decompressor */
+    uint8_t  *frame;             /* one compressed frame, sent or received */
+    uint8_t  *plain;             /* packet bytes carried by the last received frame */
+    int      size;               /* capacity of frame and plain */
+    int      plain_pos;
+    int      plain_len;
+    uint8_t  seq;                /* frame sequence id, restarts with each command */
+} mysql_zstream_t;
+
+/* Buffered non-blocking socket: responses are read through one reusable buffer
+ * so short reads and packets spanning several TCP segments are handled in one
+ * place. Every wait is bounded by the phase deadline and by cancellation: the
+ * owner numbers its operations in gen, another task cancels one by storing its
+ * number in cancel_gen. A cancel for an operation that has not started yet
+ * takes effect when it does. Generation 0 is never cancelled */
+typedef struct {
+    int      sock;
+    int64_t  deadline_us;        /* the current phase fails after this time */
+    uint32_t gen;                /* operation in progress, set by the owner */
+    volatile uint32_t cancel_gen; /* set from another task to abort operation gen */
+    enum mysql_conn_error error; /* why the last operation failed */
+    void     (*on_phase)(int phase);
+    mysql_tls_t *tls;            /* caller-owned, NULL disables TLS and RSA password exchange */
+    bool     use_tls;            /* require TLS, the connect fails if the server lacks it */
+    bool     tls_active;         /* this connection runs over TLS */
+    mysql_zstream_t *z;          /* caller-owned, NULL disables compression */
+    bool     use_compress;       /* negotiate CLIENT_COMPRESS when the server offers it */
+    bool     compressed;         /* this connection uses compressed frames */
+    uint32_t tx_packet_bytes;    /* packet bytes sent, headers included */
+    uint32_t tx_wire_bytes;      /* bytes those took on the wire, before TLS */
+    uint8_t  *tx_buf;            /* caller-owned, commands are built here */
+    int      tx_size;
+    int      rx_pos;
+    int      rx_len;
+    uint8_t  rx_buf[MYSQL_RX_BUF_SIZE];
+} mysql_conn_t;
+
+/* Simple MySQL packet structure */
+typedef struct {
+    uint8_t data[MYSQL_MAX_PACKET_SIZE];
+    int length;
+    uint8_t sequence;
+    bool truncated;         /* payload was larger than data[], the rest was skipped */
+} mysql_packet_t;
+
+/* Set up tls once before the first connect, 0 on success */
+int mysql_tls_init(mysql_tls_t *tls);
+/* Drop the cached session, e.g. when the server changes */
+void mysql_tls_forget(mysql_tls_t *tls);
+/* Trust the server certificate with this SHA-256 fingerprint instead of the
+ * CA bundle, for self-signed servers. NULL or "" goes back to the bundle.
+ * -1 if it is not a fingerprint, see mysql_parse_sha256() */
+int mysql_tls_pin(mysql_tls_t *tls, const char *sha256_hex);
+/* SHA-256 fingerprint from hex, ':' and spaces ignored: 1 when out was filled,
+ * 0 for NULL or "", -1 if it is not 32 bytes of hex */
+int mysql_parse_sha256(const char *hex, uint8_t out[32]);
+
+/* Allocate z for frames up to size bytes, 0 on success */
+int mysql_zstream_alloc(mysql_zstream_t *z, int size);
+
+/* Connect and authenticate, 0 on success. conn->sock is -1 on failure */
+int mysql_connect(mysql_conn_t *conn, const char *host, uint16_t port, const char *user,
+                  const char *password, const char *database);
+void mysql_conn_close(mysql_conn_t *conn);
+/* COM_QUIT before closing, best effort: a short write with no phase report,
+ * nothing sent after a failed operation (conn->error set) */
+void mysql_quit(mysql_conn_t *conn);
+
+int mysql_read_packet(mysql_conn_t *conn, mysql_packet_t *pkt);
+int mysql_send_packet(mysql_conn_t *conn, const uint8_t *data, int len, uint8_t seq);
+
+/* Send the len bytes already built in conn->tx_buf (command byte first), expect OK */
+int mysql_command_tx(mysql_conn_t *conn, int len);
+/* COM_QUERY with the statement already placed at conn->tx_buf + 1 */
+int mysql_query_tx(mysql_conn_t *conn, int query_len);
+int mysql_query(mysql_conn_t *conn, const char *query);
+/* First column of the first row, as text */
+int mysql_query_scalar(mysql_conn_t *conn, const char *query, char *out, int out_size);
+/* Returns the parameter count, the statement id in *stmt_id */
+int mysql_stmt_prepare(mysql_conn_t *conn, const char *query, uint32_t *stmt_id);
+int mysql_ping(mysql_conn_t *conn);
+
+int mysql_read_lenenc(const uint8_t *p, int avail, uint64_t *val);
+bool mysql_is_eof(const mysql_packet_t *pkt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
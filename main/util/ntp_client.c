@@ -0,0 +1,196 @@
+#include "ntp_client.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#else
+/* Host build: POSIX sockets, log to stderr */
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...)
+#endif
+
+#define NTP_PACKET_SIZE     48
+#define NTP_UNIX_OFFSET     2208988800u     /* 1900-01-01 to 1970-01-01 */
+
+static const char *TAG = "ntp";
+
+static int64_t ntp_now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/* 64-bit NTP timestamp <-> Unix microseconds. Seconds below 2^31 are read as
+ * the era after 2036 (RFC 4330, section 3) */
+static void ntp_put_ts(uint8_t *p, int64_t us)
+{
+    uint32_t sec = (uint32_t)(us / 1000000 + NTP_UNIX_OFFSET);
+    uint32_t frac = (uint32_t)(((uint64_t)(us % 1000000) << 32) / 1000000);
+
+    for (int i = 0; i < 4; i++) {
+        p[i] = sec >> (24 - 8 * i);
+        p[4 + i] = frac >> (24 - 8 * i);
+    }
+}
+
+static int64_t ntp_get_ts(const uint8_t *p)
+{
+    uint32_t sec = (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+    uint32_t frac = (uint32_t)p[4] << 24 | p[5] << 16 | p[6] << 8 | p[7];
+    int64_t unix_sec = (int64_t)sec - NTP_UNIX_OFFSET;
+
+    if (!(sec & 0x80000000u)) {
+        unix_sec += 1LL << 32;
+    }
+    return unix_sec * 1000000 + (int64_t)(((uint64_t)frac * 1000000) >> 32);
+}
+
+int ntp_query(const char *host, uint16_t port, int timeout_ms, ntp_sample_t *sample)
+{
+    const struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = SOCK_DGRAM,
+    };
+    struct addrinfo *res = NULL;
+    struct timeval tv = { .tv_sec = timeout_ms / 1000, .tv_usec = (timeout_ms % 1000) * 1000 };
+    uint8_t request[NTP_PACKET_SIZE] = { 0 };
+    uint8_t reply[NTP_PACKET_SIZE];
+    char port_str[8];
+    int ret = -1;
+
+    memset(sample, 0, sizeof(*sample));
+    snprintf(port_str, sizeof(port_str), "%u", port);
+    if (getaddrinfo(host, port_str, &hints, &res) != 0 || !res) {
+        ESP_LOGW(TAG, "DNS lookup failed for %s", host);
+        return -1;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        freeaddrinfo(res);
+        return -1;
+    }
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    /* LI 0, version 4, client mode. The transmit time comes back as origin
+     * time, which ties the answer to this request */
+    request[0] = 0x23;
+    int64_t t1 = ntp_now_us();
+    ntp_put_ts(&request[40], t1);
+    if (sendto(sock, request, sizeof(request), 0, res->ai_addr, res->ai_addrlen) != sizeof(request)) {
+        ESP_LOGW(TAG, "Send to %s failed", host);
+        goto out;
+    }
+
+    while (1) {
+        int n = recv(sock, reply, sizeof(reply), 0);
+        int64_t t4 = ntp_now_us();
+        if (n < 0) {
+            ESP_LOGW(TAG, "No answer from %s", host);
+            goto out;
+        }
+        if (n < NTP_PACKET_SIZE || memcmp(&reply[24], &request[40], 8) != 0) {
+            continue;           /* late answer to an earlier request */
+        }
+
+        int li = reply[0] >> 6;
+        int mode = reply[0] & 0x07;
+        sample->stratum = reply[1];
+        if (mode != 4 || li == 3 || sample->stratum == 0 || sample->stratum > 15) {
+            /* Stratum 0 is a kiss-o'-death, the code is in the reference id */
+            ESP_LOGW(TAG, "%s not usable: mode %d, LI %d, stratum %d%s%.4s", host, mode, li,
+                     sample->stratum, sample->stratum == 0 ? ", kiss code " : "",
+                     sample->stratum == 0 ? (const char *)&reply[12] : "");
+            goto out;
+        }
+
+        int64_t t2 = ntp_get_ts(&reply[32]);
+        int64_t t3 = ntp_get_ts(&reply[40]);
+        sample->offset_us = ((t2 - t1) + (t3 - t4)) / 2;
+        sample->delay_us = (t4 - t1) - (t3 - t2);
+        if (sample->delay_us < 0) {
+            sample->delay_us = 0;
+        }
+        sample->valid = true;
+        ESP_LOGD(TAG, "%s: offset %lld us, delay %lld us, stratum %d", host,
+                 (long long)sample->offset_us, (long long)sample->delay_us, sample->stratum);
+        ret = 0;
+        break;
+    }
+
+out:
+    close(sock);
+    freeaddrinfo(res);
+    return ret;
+}
+
+static int ntp_cmp(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a;
+    int64_t y = *(const int64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static bool ntp_agree(const ntp_sample_t *a, const ntp_sample_t *b)
+{
+    return llabs(a->offset_us - b->offset_us) <= (a->delay_us + b->delay_us) / 2 + NTP_AGREE_US;
+}
+
+int ntp_combine(const ntp_sample_t *samples, int cnt, int64_t *offset_us, int *used)
+{
+    int64_t group[NTP_SERVER_MAX];
+    int valid = 0;
+    int best = -1;
+    int best_cnt = 0;
+
+    if (cnt > NTP_SERVER_MAX) {
+        cnt = NTP_SERVER_MAX;
+    }
+
+    /* The sample most others agree with, the shorter round trip on a tie */
+    for (int i = 0; i < cnt; i++) {
+        if (!samples[i].valid) {
+            continue;
+        }
+        valid++;
+        int agree = 0;
+        for (int j = 0; j < cnt; j++) {
+            if (samples[j].valid && ntp_agree(&samples[i], &samples[j])) {
+                agree++;
+            }
+        }
+        if (agree > best_cnt || (agree == best_cnt && samples[i].delay_us < samples[best].delay_us)) {
+            best = i;
+            best_cnt = agree;
+        }
+    }
+    if (valid == 0 || best_cnt * 2 <= valid) {
+        return -1;
+    }
+
+    int n = 0;
+    for (int j = 0; j < cnt; j++) {
+        if (samples[j].valid && ntp_agree(&samples[best], &samples[j])) {
+            group[n++] = samples[j].offset_us;
+        }
+    }
+    qsort(group, n, sizeof(group[0]), ntp_cmp);
+    *offset_us = n % 2 ? group[n / 2] : (group[n / 2 - 1] + group[n / 2]) / 2;
+    if (used) {
+        *used = n;
+    }
+    return 0;
+}
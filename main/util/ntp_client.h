@@ -0,0 +1,48 @@
+#ifndef NTP_CLIENT_H
+#define NTP_CLIENT_H
+
+/*
+ * SNTP queries against several servers and a majority vote over their
+ * answers. Clock discipline is left to the caller.
+ *
+ * Like line_protocol it builds on a Linux host against POSIX sockets
+ * (without ESP_PLATFORM). There it can be pointed at a few instances of
+ * tools/ntp_standin.py, each with its own --offset, --jitter and --drop, to
+ * see outliers rejected and offsets combined. main/util/test/test_ntp_client.c
+ * does the same against fake servers it forks itself.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NTP_PORT            123
+#define NTP_SERVER_MAX      8
+#define NTP_AGREE_US        25000   /* slack on top of the samples' own error bounds */
+
+typedef struct {
+    int64_t offset_us;          /* server clock minus local clock */
+    int64_t delay_us;           /* round trip without the server's processing time */
+    uint8_t stratum;
+    bool    valid;
+} ntp_sample_t;
+
+/* One request/response exchange. Returns 0 with a valid sample, or -1 on a
+ * timeout, a kiss-o'-death or an unsynchronized server (sample->valid false) */
+int ntp_query(const char *host, uint16_t port, int timeout_ms, ntp_sample_t *sample);
+
+/* Combine the samples of several servers. Two samples agree when their
+ * offsets are closer than half their delays plus NTP_AGREE_US; the largest
+ * group of agreeing samples must be a majority of the valid ones, its median
+ * offset is the result. Returns 0 and the group size in *used, or -1 when
+ * no majority agrees */
+int ntp_combine(const ntp_sample_t *samples, int cnt, int64_t *offset_us, int *used);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,146 @@
+#include "rect_set.h"
+
+static bool rect_intersect(rect_t *out, const rect_t *a, const rect_t *b)
+{
+    out->x1 = a->x1 > b->x1 ? a->x1 : b->x1;
+    out->y1 = a->y1 > b->y1 ? a->y1 : b->y1;
+    out->x2 = a->x2 < b->x2 ? a->x2 : b->x2;
+    out->y2 = a->y2 < b->y2 ? a->y2 : b->y2;
+    return out->x1 <= out->x2 && out->y1 <= out->y2;
+}
+
+static uint32_t rect_area(const rect_t *r)
+{
+    return (uint32_t)(r->x2 - r->x1 + 1) * (uint32_t)(r->y2 - r->y1 + 1);
+}
+
+/* a minus b into out[], at most 4 pieces: the bands above and below the
+ * overlap at full width, then left and right of it. Returns the count */
+static int rect_diff(rect_t *out, const rect_t *a, const rect_t *b)
+{
+    rect_t o;
+    int n = 0;
+
+    if (!rect_intersect(&o, a, b)) {
+        out[n++] = *a;
+        return n;
+    }
+    if (a->y1 < o.y1) {
+        out[n++] = (rect_t) { a->x1, a->y1, a->x2, o.y1 - 1 };
+    }
+    if (o.y2 < a->y2) {
+        out[n++] = (rect_t) { a->x1, o.y2 + 1, a->x2, a->y2 };
+    }
+    if (a->x1 < o.x1) {
+        out[n++] = (rect_t) { a->x1, o.y1, o.x1 - 1, o.y2 };
+    }
+    if (o.x2 < a->x2) {
+        out[n++] = (rect_t) { o.x2 + 1, o.y1, a->x2, o.y2 };
+    }
+    return n;
+}
+
+static void rect_set_collapse(rect_set_t *s, const rect_t *extra)
+{
+    rect_t box = *extra;
+
+    for (int i = 0; i < s->cnt; i++) {
+        if (s->r[i].x1 < box.x1) box.x1 = s->r[i].x1;
+        if (s->r[i].y1 < box.y1) box.y1 = s->r[i].y1;
+        if (s->r[i].x2 > box.x2) box.x2 = s->r[i].x2;
+        if (s->r[i].y2 > box.y2) box.y2 = s->r[i].y2;
+    }
+    s->r[0] = box;
+    s->cnt = 1;
+}
+
+void rect_set_clear(rect_set_t *s)
+{
+    s->cnt = 0;
+}
+
+void rect_set_add(rect_set_t *s, const rect_t *r, const rect_t *clip)
+{
+    rect_t pieces[RECT_SET_MAX];
+    rect_t next[RECT_SET_MAX];
+    rect_t diff[4];
+    int cnt = 1;
+
+    if (!rect_intersect(&pieces[0], r, clip)) {
+        return;
+    }
+
+    /* Only the part not in the set yet */
+    for (int i = 0; i < s->cnt && cnt > 0; i++) {
+        int n = 0;
+        for (int j = 0; j < cnt; j++) {
+            int d = rect_diff(diff, &pieces[j], &s->r[i]);
+            if (n + d > RECT_SET_MAX) {
+                /* pieces[] only holds fragments by now, take all of r */
+                rect_intersect(&pieces[0], r, clip);
+                rect_set_collapse(s, &pieces[0]);
+                return;
+            }
+            for (int k = 0; k < d; k++) {
+                next[n++] = diff[k];
+            }
+        }
+        for (int j = 0; j < n; j++) {
+            pieces[j] = next[j];
+        }
+        cnt = n;
+    }
+
+    if (s->cnt + cnt > RECT_SET_MAX) {
+        rect_intersect(&pieces[0], r, clip);
+        rect_set_collapse(s, &pieces[0]);
+        return;
+    }
+    for (int j = 0; j < cnt; j++) {
+        s->r[s->cnt++] = pieces[j];
+    }
+}
+
+void rect_set_subtract(rect_set_t *s, const rect_t *r)
+{
+    rect_t diff[4];
+    int cnt = s->cnt;
+
+    for (int i = 0; i < cnt; ) {
+        int d = rect_diff(diff, &s->r[i], r);
+        if (d == 1 && diff[0].x1 == s->r[i].x1 && diff[0].y1 == s->r[i].y1 &&
+            diff[0].x2 == s->r[i].x2 && diff[0].y2 == s->r[i].y2) {
+            i++;                            /* untouched */
+            continue;
+        }
+        if (s->cnt - 1 + d > RECT_SET_MAX) {
+            i++;                            /* no room, copy a bit more */
+            continue;
+        }
+        /* Replace r[i] by the pieces: the first in place, the rest at the end */
+        if (d == 0) {
+            s->r[i] = s->r[--s->cnt];
+            if (s->cnt < cnt) {
+                cnt--;                      /* moved in from the unvisited part */
+            } else {
+                i++;
+            }
+            continue;
+        }
+        s->r[i] = diff[0];
+        for (int k = 1; k < d; k++) {
+            s->r[s->cnt++] = diff[k];
+        }
+        i++;
+    }
+}
+
+uint32_t rect_set_area(const rect_set_t *s)
+{
+    uint32_t area = 0;
+
+    for (int i = 0; i < s->cnt; i++) {
+        area += rect_area(&s->r[i]);
+    }
+    return area;
+}
@@ -0,0 +1,48 @@
+#ifndef RECT_SET_H
+#define RECT_SET_H
+
+/*
+ * A set of pixels kept as disjoint rectangles, for the framebuffer sync in
+ * lv_port: areas added twice are only counted (and copied) once. When a
+ * result doesn't fit RECT_SET_MAX rectangles the set grows to a superset,
+ * its bounding box, never loses pixels.
+ *
+ * Plain C, builds on a Linux host like cobs.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RECT_SET_MAX    48
+
+/* Inclusive corners, like lv_area_t */
+typedef struct {
+    int16_t x1, y1, x2, y2;
+} rect_t;
+
+typedef struct {
+    rect_t r[RECT_SET_MAX];
+    int    cnt;
+} rect_set_t;
+
+void rect_set_clear(rect_set_t *s);
+
+/* Add r clipped to clip */
+void rect_set_add(rect_set_t *s, const rect_t *r, const rect_t *clip);
+
+/* Remove the pixels of r from the set. Where the pieces don't fit, a
+ * rectangle is kept whole */
+void rect_set_subtract(rect_set_t *s, const rect_t *r);
+
+/* Pixels in the set */
+uint32_t rect_set_area(const rect_set_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
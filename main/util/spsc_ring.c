@@ -0,0 +1,83 @@
+#include "spsc_ring.h"
+#include <string.h>
+
+#define SPSC_TAG_WRAP   0xffff      /* rest of the buffer unused, go on at 0 */
+
+struct spsc_hdr {
+    uint16_t tag;
+    uint16_t reserved;
+    uint32_t len;
+};
+
+#define SPSC_ROUND(n)   (((n) + SPSC_RING_ALIGN - 1) & ~(uint32_t)(SPSC_RING_ALIGN - 1))
+#define SPSC_SPAN(len)  (SPSC_ROUND(sizeof(struct spsc_hdr) + (len)))
+
+int spsc_ring_init(spsc_ring_t *r, void *buf, uint32_t size)
+{
+    if (buf == NULL || size < 2 * SPSC_RING_ALIGN || (size & (size - 1)) != 0) {
+        return -1;
+    }
+    r->buf = buf;
+    r->size = size;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    return 0;
+}
+
+int spsc_ring_push(spsc_ring_t *r, uint16_t tag, const void *data, uint32_t len)
+{
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    uint32_t pos = head & (r->size - 1);
+    uint32_t to_end = r->size - pos;
+    uint32_t span = SPSC_SPAN(len);
+    uint32_t skip = span > to_end ? to_end : 0;    /* a record never wraps */
+
+    if (tag == SPSC_TAG_WRAP || skip + span > r->size - (head - tail)) {
+        return -1;
+    }
+    if (skip) {
+        struct spsc_hdr wrap = { .tag = SPSC_TAG_WRAP };
+        memcpy(r->buf + pos, &wrap, sizeof(wrap));
+        pos = 0;
+    }
+    struct spsc_hdr hdr = { .tag = tag, .len = len };
+    memcpy(r->buf + pos, &hdr, sizeof(hdr));
+    if (len) {
+        memcpy(r->buf + pos + sizeof(hdr), data, len);
+    }
+    /* The record is complete before the consumer can see it */
+    atomic_store_explicit(&r->head, head + skip + span, memory_order_release);
+    return 0;
+}
+
+const void *spsc_ring_peek(spsc_ring_t *r, uint16_t *tag, uint32_t *len)
+{
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    struct spsc_hdr hdr;
+
+    while (tail != head) {
+        uint32_t pos = tail & (r->size - 1);
+        memcpy(&hdr, r->buf + pos, sizeof(hdr));
+        if (hdr.tag == SPSC_TAG_WRAP) {
+            tail += r->size - pos;
+            atomic_store_explicit(&r->tail, tail, memory_order_release);
+            continue;
+        }
+        *tag = hdr.tag;
+        *len = hdr.len;
+        return r->buf + pos + sizeof(hdr);
+    }
+    return NULL;
+}
+
+void spsc_ring_pop(spsc_ring_t *r)
+{
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    struct spsc_hdr hdr;
+
+    memcpy(&hdr, r->buf + (tail & (r->size - 1)), sizeof(hdr));
+    /* Done with the data before the producer may overwrite it */
+    atomic_store_explicit(&r->tail, tail + SPSC_SPAN(hdr.len), memory_order_release);
+}
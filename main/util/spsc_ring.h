@@ -0,0 +1,46 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+/*
+ * Lock-free ring of variable-length records for one producer task and one
+ * consumer task. A record is copied in whole by push and read in place by
+ * the consumer until it pops it. Neither side ever waits for the other:
+ * push fails when the record doesn't fit, peek returns NULL when empty.
+ *
+ * Portable C11 atomics, builds on a Linux host like cobs and dns_cache.
+ */
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SPSC_RING_ALIGN     8       /* records start on this boundary */
+
+typedef struct {
+    uint8_t *buf;
+    uint32_t size;                  /* power of two, multiple of SPSC_RING_ALIGN */
+    _Atomic uint32_t head;          /* bytes pushed, written by the producer only */
+    _Atomic uint32_t tail;          /* bytes popped, written by the consumer only */
+} spsc_ring_t;
+
+/* buf of size bytes, size a power of two. Returns 0 or -1 */
+int spsc_ring_init(spsc_ring_t *r, void *buf, uint32_t size);
+
+/* Producer: append a record. Returns 0, or -1 when it doesn't fit now */
+int spsc_ring_push(spsc_ring_t *r, uint16_t tag, const void *data, uint32_t len);
+
+/* Consumer: the oldest record, NULL when empty. The data stays valid until
+ * spsc_ring_pop */
+const void *spsc_ring_peek(spsc_ring_t *r, uint16_t *tag, uint32_t *len);
+
+/* Consumer: release the record spsc_ring_peek returned */
+void spsc_ring_pop(spsc_ring_t *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
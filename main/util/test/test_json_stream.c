@@ -0,0 +1,288 @@
+/*
+ * Host test and parse benchmark for json_stream. The bodies follow the
+ * documented ip-api.com /json and timeapi.io /api/TimeZone/ip responses,
+ * with documentation addresses in place of real ones. Each is fed whole,
+ * byte by byte and in random chunks, and must give the same fields. Then
+ * escapes, truncation, invalid input and the nesting limit.
+ */
+
+#include "json_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ROUNDS    20000
+#define CHUNK_ROUNDS    50
+
+static int s_failed;
+
+static const char s_ip_api[] =
+    "{\"status\":\"success\",\"country\":\"Switzerland\",\"countryCode\":\"CH\",\"region\":\"ZH\","
+    "\"regionName\":\"Zurich\",\"city\":\"Z\\u00fcrich\",\"zip\":\"8000\",\"lat\":47.3769,"
+    "\"lon\":8.5417,\"timezone\":\"Europe/Zurich\",\"isp\":\"Example Telecom AG\","
+    "\"org\":\"Example Telecom AG\",\"as\":\"AS64500 Example Telecom AG\",\"query\":\"203.0.113.7\"}";
+
+static const char s_ip_api_fail[] =
+    "{\"status\":\"fail\",\"message\":\"private range\",\"query\":\"192.168.1.20\"}";
+
+static const char s_timeapi[] =
+    "{\"timeZone\":\"America/New_York\",\"currentLocalTime\":\"2024-07-04T12:30:45.1234567\","
+    "\"currentUtcOffset\":{\"seconds\":-14400,\"milliseconds\":-14400000,\"ticks\":-144000000000,"
+    "\"nanoseconds\":-14400000000000},"
+    "\"standardUtcOffset\":{\"seconds\":-18000,\"milliseconds\":-18000000,\"ticks\":-180000000000,"
+    "\"nanoseconds\":-18000000000000},"
+    "\"hasDayLightSaving\":true,\"isDayLightSavingActive\":true,"
+    "\"dstInterval\":{\"dstName\":\"EDT\","
+    "\"dstOffsetToUtc\":{\"seconds\":-14400,\"milliseconds\":-14400000,\"ticks\":-144000000000,"
+    "\"nanoseconds\":-14400000000000},"
+    "\"dstOffsetToStandardTime\":{\"seconds\":3600,\"milliseconds\":3600000,\"ticks\":36000000000,"
+    "\"nanoseconds\":3600000000000},"
+    "\"dstStart\":\"2024-03-10T07:00:00Z\",\"dstEnd\":\"2024-11-03T06:00:00Z\","
+    "\"dstDuration\":{\"days\":238,\"nanosecondOfDay\":82800000000000,\"hours\":23,\"minutes\":0,"
+    "\"seconds\":0,\"milliseconds\":0,\"subsecondTicks\":0,\"subsecondNanoseconds\":0,"
+    "\"bclCompatibleTicks\":206460000000000,\"totalDays\":238.95833333333334,"
+    "\"totalHours\":5735,\"totalMinutes\":344100,\"totalSeconds\":20646000,"
+    "\"totalMilliseconds\":20646000000,\"totalTicks\":206460000000000,"
+    "\"totalNanoseconds\":20646000000000000}}}";
+
+/* A body the way indicator_city.c asks for it */
+struct body {
+    const char *name;
+    const char *json;
+    const char *const *paths;
+    const char *const *want;    /* NULL: not in the body */
+    int cnt;
+};
+
+static const char *const s_ip_api_paths[] = { "status", "city", "query", "timezone" };
+static const char *const s_ip_api_want[] = { "success", "Z\xc3\xbcrich", "203.0.113.7", "Europe/Zurich" };
+static const char *const s_ip_api_fail_want[] = { "fail", NULL, "192.168.1.20", NULL };
+static const char *const s_timeapi_paths[] = { "timeZone", "currentUtcOffset.seconds" };
+static const char *const s_timeapi_want[] = { "America/New_York", "-14400" };
+
+static const struct body s_bodies[] = {
+    { "ip-api", s_ip_api, s_ip_api_paths, s_ip_api_want, 4 },
+    { "ip-api fail", s_ip_api_fail, s_ip_api_paths, s_ip_api_fail_want, 4 },
+    { "timeapi", s_timeapi, s_timeapi_paths, s_timeapi_want, 2 },
+};
+
+static void expect_int(const char *what, int got, int want)
+{
+    if (got != want) {
+        printf("FAIL %s: got %d, want %d\n", what, got, want);
+        s_failed = 1;
+    }
+}
+
+/* Feeds json in chunks of at most chunk bytes, random sizes when rnd is set */
+static int parse(json_stream_t *js, json_stream_field_t *fields, int cnt,
+                 const char *json, int chunk, unsigned *rnd)
+{
+    int len = strlen(json);
+
+    json_stream_init(js, fields, cnt);
+    for (int off = 0; off < len;) {
+        int n = rnd ? 1 + rand_r(rnd) % chunk : chunk;
+        if (n > len - off) {
+            n = len - off;
+        }
+        if (json_stream_feed(js, &json[off], n) != 0) {
+            return -1;
+        }
+        off += n;
+    }
+    return json_stream_done(js) ? 0 : -1;
+}
+
+static void check_body(const struct body *b, int chunk, unsigned *rnd)
+{
+    char values[JSON_STREAM_FIELD_MAX][48];
+    json_stream_field_t fields[JSON_STREAM_FIELD_MAX];
+    json_stream_t js;
+
+    for (int i = 0; i < b->cnt; i++) {
+        fields[i] = (json_stream_field_t){ .path = b->paths[i], .value = values[i], .size = sizeof(values[i]) };
+    }
+    if (parse(&js, fields, b->cnt, b->json, chunk, rnd) != 0) {
+        printf("FAIL %s, chunk %d%s: not parsed\n", b->name, chunk, rnd ? " (random)" : "");
+        s_failed = 1;
+        return;
+    }
+    for (int i = 0; i < b->cnt; i++) {
+        if (fields[i].found != (b->want[i] != NULL) ||
+            (b->want[i] && strcmp(values[i], b->want[i]) != 0)) {
+            printf("FAIL %s, chunk %d%s: %s got %s\"%s\", want \"%s\"\n", b->name, chunk,
+                   rnd ? " (random)" : "", b->paths[i], fields[i].found ? "" : "(missing) ",
+                   values[i], b->want[i] ? b->want[i] : "(missing)");
+            s_failed = 1;
+        }
+    }
+}
+
+static void test_bodies(void)
+{
+    unsigned rnd = 1;
+
+    for (size_t i = 0; i < sizeof(s_bodies) / sizeof(s_bodies[0]); i++) {
+        check_body(&s_bodies[i], strlen(s_bodies[i].json), NULL);
+        check_body(&s_bodies[i], 1, NULL);
+        for (int r = 0; r < CHUNK_ROUNDS; r++) {
+            check_body(&s_bodies[i], 64, &rnd);
+        }
+    }
+}
+
+/* One string field at path, "" when it is not found or the input is rejected */
+static int parse_one(const char *json, const char *path, char *value, int size)
+{
+    json_stream_field_t field = { .path = path, .value = value, .size = size };
+    json_stream_t js;
+    int ret = parse(&js, &field, 1, json, strlen(json), NULL);
+
+    return ret == 0 && field.found ? 0 : -1;
+}
+
+static void expect_value(const char *json, const char *path, int size, const char *want)
+{
+    char value[64];
+
+    if (parse_one(json, path, value, size) != 0 || strcmp(value, want) != 0) {
+        printf("FAIL %s in %s: got \"%s\", want \"%s\"\n", path, json, value, want);
+        s_failed = 1;
+    }
+}
+
+static void expect_missing(const char *json, const char *path)
+{
+    char value[64];
+
+    if (parse_one(json, path, value, sizeof(value)) == 0) {
+        printf("FAIL %s in %s: got \"%s\", want none\n", path, json, value);
+        s_failed = 1;
+    }
+}
+
+static void test_values(void)
+{
+    expect_value("{\"a\":\"q\\\"b\\\\s\\/n\\n\"}", "a", 64, "q\"b\\s/n\n");
+    expect_value("{\"a\":\"\\u0041\\u00e9\\u20ac\"}", "a", 64, "A\xc3\xa9\xe2\x82\xac");
+    expect_value("{\"a\":\"\\ud83d\\ude00\"}", "a", 64, "??");
+    expect_value("{\"a\":\"abcdefgh\"}", "a", 4, "abc");
+    expect_value("{\"a\":12.5e-3}", "a", 64, "12.5e-3");
+    expect_value("{\"a\":null}", "a", 64, "null");
+
+    /* Same key in other objects and in arrays must not match */
+    expect_value("{\"b\":{\"a\":\"no\"},\"c\":[{\"a\":\"no\"}],\"a\":\"yes\"}", "a", 64, "yes");
+    expect_value("{\"b\":{\"a\":\"no\"},\"a\":{\"b\":\"yes\"}}", "a.b", 64, "yes");
+    expect_value("{\"a\":[\"no\"],\"b\":{\"x\":{\"c\":1},\"c\":\"yes\"}}", "b.c", 64, "yes");
+    expect_missing("{\"a\":[\"no\",{\"a\":\"no\"}]}", "a");
+    expect_missing("{\"a\":\"no\"}", "a.b");
+    expect_missing("{\"a\":{\"a\":\"no\"}}", "a");
+
+    /* A key longer than JSON_STREAM_KEY_MAX never matches */
+    char json[128];
+    char key[JSON_STREAM_KEY_MAX + 8];
+    memset(key, 'k', sizeof(key) - 1);
+    key[sizeof(key) - 1] = '\0';
+    snprintf(json, sizeof(json), "{\"%s\":\"no\"}", key);
+    char value[8];
+    expect_int("long key", parse_one(json, key, value, sizeof(value)), -1);
+}
+
+static void test_invalid(void)
+{
+    static const char *const bad[] = {
+        "{\"a\":}", "{\"a\" 1}", "{\"a\":1,}", "{a:1}", "{\"a\":1]", "[1,2}",
+        "{\"a\":\"x\\q\"}", "{\"a\":\"\\u12g4\"}", "{\"a\":\"x\ty\"}", "{} x", "<html>",
+    };
+    static const char *const truncated[] = {
+        "", "{", "{\"a\"", "{\"a\":", "{\"a\":\"x", "{\"a\":[1,2", "{\"a\":{\"b\":1}",
+    };
+    char value[8];
+
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        json_stream_field_t field = { .path = "a", .value = value, .size = sizeof(value) };
+        json_stream_t js;
+
+        json_stream_init(&js, &field, 1);
+        if (json_stream_feed(&js, bad[i], strlen(bad[i])) == 0 || json_stream_done(&js)) {
+            printf("FAIL invalid %s: accepted\n", bad[i]);
+            s_failed = 1;
+        }
+        /* Stays failed */
+        expect_int("feed after error", json_stream_feed(&js, " ", 1), -1);
+    }
+    for (size_t i = 0; i < sizeof(truncated) / sizeof(truncated[0]); i++) {
+        if (parse_one(truncated[i], "a", value, sizeof(value)) == 0) {
+            printf("FAIL truncated %s: accepted\n", truncated[i]);
+            s_failed = 1;
+        }
+    }
+}
+
+static void test_depth(void)
+{
+    char json[6 * JSON_STREAM_DEPTH_MAX + 16];
+    char value[8];
+
+    /* DEPTH_MAX objects deep is fine, one more is not */
+    for (int depth = JSON_STREAM_DEPTH_MAX; depth <= JSON_STREAM_DEPTH_MAX + 1; depth++) {
+        int n = 0;
+        for (int i = 0; i < depth - 1; i++) {
+            n += sprintf(&json[n], "{\"a\":");
+        }
+        n += sprintf(&json[n], "[1]");
+        for (int i = 0; i < depth - 1; i++) {
+            json[n++] = '}';
+        }
+        json[n] = '\0';
+        json_stream_field_t field = { .path = "a", .value = value, .size = sizeof(value) };
+        json_stream_t js;
+        int ret = parse(&js, &field, 1, json, 1, NULL);
+        expect_int(depth > JSON_STREAM_DEPTH_MAX ? "too deep" : "deepest", ret,
+                   depth > JSON_STREAM_DEPTH_MAX ? -1 : 0);
+    }
+
+    /* The full path down to the limit still resolves */
+    expect_value("{\"a\":{\"b\":{\"c\":{\"d\":{\"e\":{\"f\":{\"g\":{\"h\":\"deep\"}}}}}}}}",
+                 "a.b.c.d.e.f.g.h", 64, "deep");
+}
+
+static void bench(const struct body *b)
+{
+    char values[JSON_STREAM_FIELD_MAX][48];
+    json_stream_field_t fields[JSON_STREAM_FIELD_MAX];
+    json_stream_t js;
+    struct timespec t0, t1;
+    int len = strlen(b->json);
+
+    for (int i = 0; i < b->cnt; i++) {
+        fields[i] = (json_stream_field_t){ .path = b->paths[i], .value = values[i], .size = sizeof(values[i]) };
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        json_stream_init(&js, fields, b->cnt);
+        json_stream_feed(&js, b->json, len);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / BENCH_ROUNDS;
+    printf("json_stream: %s, %d bytes, %d fields, %.2f us per body, %.1f ns per byte\n",
+           b->name, len, b->cnt, ns / 1000, ns / len);
+}
+
+int main(void)
+{
+    test_bodies();
+    test_values();
+    test_invalid();
+    test_depth();
+    if (!s_failed) {
+        printf("json_stream: %u bytes of parser state\n", (unsigned)sizeof(json_stream_t));
+        for (size_t i = 0; i < sizeof(s_bodies) / sizeof(s_bodies[0]); i++) {
+            bench(&s_bodies[i]);
+        }
+    }
+    printf("json_stream: %s\n", s_failed ? "FAILED" : "ok");
+    return s_failed;
+}
@@ -0,0 +1,168 @@
+/*
+ * Host test for line_protocol: point formatting and escaping, then HTTP writes
+ * against a forked fake server on 127.0.0.1 that answers with an error body,
+ * a long error body and a 204, all on one kept-alive connection.
+ */
+
+#define _GNU_SOURCE
+#include "line_protocol.h"
+#include <arpa/inet.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static int s_failed;
+
+static void expect_str(const char *what, const char *got, const char *want)
+{
+    if (strcmp(got, want) != 0) {
+        printf("FAIL %s: got \"%s\", want \"%s\"\n", what, got, want);
+        s_failed = 1;
+    }
+}
+
+static void expect_int(const char *what, int got, int want)
+{
+    if (got != want) {
+        printf("FAIL %s: got %d, want %d\n", what, got, want);
+        s_failed = 1;
+    }
+}
+
+static void test_format(void)
+{
+    static const char *const names[] = { "temp", "co2", "pm2_5" };
+    static const uint8_t precision[] = { 2, 0, 1 };
+    float values[] = { 21.5f, 612.0f, NAN };
+    char buf[256];
+    char tags[64];
+    int n;
+
+    n = line_protocol_append(buf, sizeof(buf), "indicator", "device=ab12", names, values, precision,
+                             3, 1700000000, false);
+    expect_str("point", buf, "indicator,device=ab12 temp=21.50,co2=612 1700000000\n");
+    expect_int("point length", n, (int)strlen(buf));
+
+    n = line_protocol_append(buf, sizeof(buf), "indicator", NULL, names, values, precision,
+                             3, 1700000000, true);
+    expect_str("no tags, ns", buf, "indicator temp=21.50,co2=612 1700000000000000000\n");
+
+    /* Spaces and commas in the measurement, also '=' in a tag value */
+    line_protocol_escape(tags, sizeof(tags), "a=b c,d", true);
+    expect_str("tag escape", tags, "a\\=b\\ c\\,d");
+    line_protocol_escape(tags, sizeof(tags), "a=b c,d", false);
+    expect_str("measurement escape", tags, "a=b\\ c\\,d");
+    n = line_protocol_append(buf, sizeof(buf), "living room,2", "device=ab12", names, values, precision,
+                             1, 1, false);
+    expect_str("escaped point", buf, "living\\ room\\,2,device=ab12 temp=21.50 1\n");
+
+    /* No reading left, and a point that does not fit */
+    values[0] = values[1] = NAN;
+    expect_int("no fields", line_protocol_append(buf, sizeof(buf), "m", NULL, names, values, NULL,
+                                                 3, 1, false), 0);
+    values[0] = 1.0f;
+    expect_int("too long", line_protocol_append(buf, 12, "m", NULL, names, values, NULL,
+                                                3, 1700000000, false), -1);
+    expect_int("escape too long", line_protocol_escape(tags, 4, "a b", false), -1);
+}
+
+/* Answers each request on one connection with the next reply */
+static void fake_server(int listener)
+{
+    char body[600];
+    char req[4096];
+    int sock = accept(listener, NULL, NULL);
+
+    /* A parse error, a body longer than reply, no content */
+    memset(body, 'x', sizeof(body) - 1);
+    body[sizeof(body) - 1] = '\0';
+    memcpy(body, "{\"error\":\"database not found\"}", 30);
+    const char *const bodies[] = { "{\"error\":\"unable to parse 'm f=': missing value\"}", body, NULL };
+
+    for (int i = 0; i < 3 && sock >= 0; i++) {
+        int len = 0;
+        char *end = NULL;
+
+        /* Header, then the Content-Length bytes of the body */
+        while (!end || len < (int)(end - req) + 4 + atoi(strcasestr(req, "Content-Length:") + 15)) {
+            int n = recv(sock, &req[len], sizeof(req) - 1 - len, 0);
+            if (n <= 0) {
+                _exit(1);
+            }
+            len += n;
+            req[len] = '\0';
+            end = strstr(req, "\r\n\r\n");
+        }
+        if (bodies[i]) {
+            len = snprintf(req, sizeof(req), "HTTP/1.1 400 Bad Request\r\nContent-Length: %d\r\n\r\n%s",
+                           (int)strlen(bodies[i]), bodies[i]);
+        } else {
+            len = snprintf(req, sizeof(req), "HTTP/1.1 204 No Content\r\n\r\n");
+        }
+        send(sock, req, len, 0);
+    }
+    _exit(0);
+}
+
+static void test_http(void)
+{
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+    socklen_t addr_len = sizeof(addr);
+    line_http_t http = { .sock = -1 };
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listener, 1) < 0 || getsockname(listener, (struct sockaddr *)&addr, &addr_len) < 0) {
+        printf("FAIL http: no listener\n");
+        s_failed = 1;
+        return;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        fake_server(listener);
+    }
+    close(listener);
+
+    uint16_t port = ntohs(addr.sin_port);
+    int status = line_http_post(&http, "127.0.0.1", port, "/write?db=x", "", "m f=\n", 5);
+    expect_int("parse error status", status, 400);
+    expect_str("parse error body", http.reply, "{\"error\":\"unable to parse 'm f=': missing value\"}");
+    int sock = http.sock;
+
+    status = line_http_post(&http, "127.0.0.1", port, "/write?db=x", "", "m f=1\n", 6);
+    expect_int("long body status", status, 400);
+    expect_int("long body kept", (int)strlen(http.reply), LINE_HTTP_REPLY_MAX - 1);
+    expect_int("long body reused", http.sock, sock);
+    if (strncmp(http.reply, "{\"error\":\"database not found\"}", 30) != 0) {
+        printf("FAIL long body: got \"%.40s\"\n", http.reply);
+        s_failed = 1;
+    }
+
+    status = line_http_post(&http, "127.0.0.1", port, "/write?db=x", "", "m f=1\n", 6);
+    expect_int("no content status", status, 204);
+    expect_str("no content body", http.reply, "");
+    expect_int("no content reused", http.sock, sock);
+
+    line_http_close(&http);
+    int wstatus;
+    waitpid(pid, &wstatus, 0);
+    if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) {
+        printf("FAIL http: fake server failed\n");
+        s_failed = 1;
+    }
+}
+
+int main(void)
+{
+    signal(SIGPIPE, SIG_IGN);
+    test_format();
+    test_http();
+    printf("line_protocol: %s\n", s_failed ? "FAILED" : "ok");
+    return s_failed;
+}
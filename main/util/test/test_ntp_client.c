@@ -0,0 +1,297 @@
+/*
+ * Host test for ntp_client. ntp_combine is checked on made-up samples: median
+ * of the agreeing group, a falseticker voted out, no majority. ntp_query and
+ * the two together run against fake SNTP servers in a forked child, one UDP
+ * socket each on 127.0.0.1 with its own offset and jitter, or answering with
+ * a kiss-o'-death, as unsynchronized, a stale reply first, or not at all.
+ */
+
+#include "ntp_client.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define NTP_UNIX_OFFSET     2208988800u
+#define QUERY_TIMEOUT_MS    300
+#define LOCAL_SLACK_US      3000        /* loopback round trip and scheduling */
+
+enum fake_kind { FAKE_OK, FAKE_KOD, FAKE_UNSYNC, FAKE_STALE_FIRST, FAKE_DROP };
+
+struct fake_server {
+    enum fake_kind kind;
+    int64_t offset_us;
+    int64_t jitter_us;          /* uniform +/- per answer */
+    int sock;
+    uint16_t port;
+};
+
+static int s_failed;
+
+static void expect(bool ok, const char *fmt, long long got, long long want)
+{
+    if (!ok) {
+        printf("FAIL ");
+        printf(fmt, got, want);
+        printf("\n");
+        s_failed = 1;
+    }
+}
+
+static int64_t now_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static void put_ts(uint8_t *p, int64_t us)
+{
+    uint32_t sec = (uint32_t)(us / 1000000 + NTP_UNIX_OFFSET);
+    uint32_t frac = (uint32_t)(((uint64_t)(us % 1000000) << 32) / 1000000);
+
+    for (int i = 0; i < 4; i++) {
+        p[i] = sec >> (24 - 8 * i);
+        p[4 + i] = frac >> (24 - 8 * i);
+    }
+}
+
+/* ========== ntp_combine ========== */
+
+static ntp_sample_t sample(int64_t offset_us, int64_t delay_us)
+{
+    return (ntp_sample_t) { .offset_us = offset_us, .delay_us = delay_us, .stratum = 2, .valid = true };
+}
+
+static void test_combine(void)
+{
+    ntp_sample_t s[NTP_SERVER_MAX];
+    int64_t offset = 0;
+    int used = 0;
+    int ret;
+
+    /* Three close together, median of them */
+    s[0] = sample(1000, 2000);
+    s[1] = sample(9000, 2000);
+    s[2] = sample(4000, 2000);
+    ret = ntp_combine(s, 3, &offset, &used);
+    expect(ret == 0 && offset == 4000, "median of 3: offset %lld, want %lld", offset, 4000);
+    expect(used == 3, "median of 3: used %lld, want %lld", used, 3);
+
+    /* Even group: mean of the middle two. The falseticker is out */
+    s[3] = sample(3000000, 2000);
+    s[4] = sample(6000, 2000);
+    ret = ntp_combine(s, 5, &offset, &used);
+    expect(ret == 0 && offset == 5000, "falseticker: offset %lld, want %lld", offset, 5000);
+    expect(used == 4, "falseticker: used %lld, want %lld", used, 4);
+
+    /* Invalid samples don't count, whatever their offset */
+    s[3].valid = false;
+    s[3].offset_us = 4000;
+    ret = ntp_combine(s, 5, &offset, &used);
+    expect(ret == 0 && used == 4, "invalid ignored: used %lld, want %lld", used, 4);
+
+    /* Two against two: no majority, the clock is left alone */
+    s[0] = sample(0, 1000);
+    s[1] = sample(2000, 1000);
+    s[2] = sample(500000, 1000);
+    s[3] = sample(502000, 1000);
+    ret = ntp_combine(s, 4, &offset, &used);
+    expect(ret == -1, "2 vs 2: returned %lld, want %lld", ret, -1);
+
+    /* A long round trip widens the error bound: 100 ms apart agree at 160 ms delay */
+    s[0] = sample(0, 160000);
+    s[1] = sample(100000, 160000);
+    ret = ntp_combine(s, 2, &offset, &used);
+    expect(ret == 0 && used == 2, "delay bound: used %lld, want %lld", used, 2);
+    s[1].delay_us = s[0].delay_us = 10000;
+    ret = ntp_combine(s, 2, &offset, &used);
+    expect(ret == -1, "tight bound: returned %lld, want %lld", ret, -1);
+
+    /* None valid */
+    s[0].valid = s[1].valid = false;
+    expect(ntp_combine(s, 2, &offset, &used) == -1, "none valid: returned %lld, want %lld", 0, -1);
+}
+
+/* ========== Fake servers ========== */
+
+static void fake_answer(struct fake_server *f, const uint8_t *req, struct sockaddr_in *peer, socklen_t peer_len)
+{
+    uint8_t reply[48] = { 0 };
+    int64_t shift = f->offset_us + (f->jitter_us ? rand() % (2 * f->jitter_us + 1) - f->jitter_us : 0);
+    int64_t receive = now_us() + shift;
+
+    reply[0] = (f->kind == FAKE_UNSYNC ? 3 << 6 : 0) | 4 << 3 | 4;     /* LI, version 4, server */
+    reply[1] = f->kind == FAKE_KOD ? 0 : 2;
+    memcpy(&reply[12], f->kind == FAKE_KOD ? "RATE" : "LOCL", 4);
+    put_ts(&reply[16], receive - 1000000);
+    memcpy(&reply[24], &req[40], 8);                                  /* origin */
+    put_ts(&reply[32], receive);
+    put_ts(&reply[40], now_us() + shift);
+
+    if (f->kind == FAKE_STALE_FIRST) {
+        /* An answer to some earlier request, 10 s off: must be skipped */
+        uint8_t stale[48];
+        memcpy(stale, reply, sizeof(stale));
+        stale[31] ^= 0xff;
+        put_ts(&stale[32], receive + 10000000);
+        put_ts(&stale[40], receive + 10000000);
+        sendto(f->sock, stale, sizeof(stale), 0, (struct sockaddr *)peer, peer_len);
+    }
+    sendto(f->sock, reply, sizeof(reply), 0, (struct sockaddr *)peer, peer_len);
+}
+
+static void fake_run(struct fake_server *fakes, int cnt)
+{
+    srand(getpid());
+    while (1) {
+        fd_set rd;
+        int max_fd = -1;
+
+        FD_ZERO(&rd);
+        for (int i = 0; i < cnt; i++) {
+            FD_SET(fakes[i].sock, &rd);
+            max_fd = fakes[i].sock > max_fd ? fakes[i].sock : max_fd;
+        }
+        if (select(max_fd + 1, &rd, NULL, NULL, NULL) < 0) {
+            _exit(1);
+        }
+        for (int i = 0; i < cnt; i++) {
+            uint8_t req[512];
+            struct sockaddr_in peer;
+            socklen_t peer_len = sizeof(peer);
+
+            if (!FD_ISSET(fakes[i].sock, &rd)) {
+                continue;
+            }
+            int n = recvfrom(fakes[i].sock, req, sizeof(req), 0, (struct sockaddr *)&peer, &peer_len);
+            if (n >= 48 && (req[0] & 0x07) == 3 && fakes[i].kind != FAKE_DROP) {
+                fake_answer(&fakes[i], req, &peer, peer_len);
+            }
+        }
+    }
+}
+
+static pid_t fake_start(struct fake_server *fakes, int cnt)
+{
+    for (int i = 0; i < cnt; i++) {
+        struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+        socklen_t len = sizeof(addr);
+
+        fakes[i].sock = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fakes[i].sock < 0 || bind(fakes[i].sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+            getsockname(fakes[i].sock, (struct sockaddr *)&addr, &len) < 0) {
+            return -1;
+        }
+        fakes[i].port = ntohs(addr.sin_port);
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        fake_run(fakes, cnt);
+    }
+    for (int i = 0; i < cnt; i++) {
+        close(fakes[i].sock);
+    }
+    return pid;
+}
+
+/* ========== ntp_query ========== */
+
+enum { SRV_HONEST_A, SRV_HONEST_B, SRV_FALSETICKER, SRV_KOD, SRV_DROP, SRV_UNSYNC, SRV_STALE, SRV_CNT };
+
+static void test_query(struct fake_server *fakes)
+{
+    ntp_sample_t s;
+    int ret;
+
+    ret = ntp_query("127.0.0.1", fakes[SRV_HONEST_B].port, QUERY_TIMEOUT_MS, &s);
+    expect(ret == 0 && s.valid, "honest: returned %lld, want %lld", ret, 0);
+    expect(llabs(s.offset_us - 10000) <= 2000 + LOCAL_SLACK_US, "honest: offset %lld us, want %lld +- jitter",
+           s.offset_us, 10000);
+    expect(s.delay_us >= 0 && s.delay_us < 50000, "honest: delay %lld us, want < %lld", s.delay_us, 50000);
+    expect(s.stratum == 2, "honest: stratum %lld, want %lld", s.stratum, 2);
+
+    ret = ntp_query("127.0.0.1", fakes[SRV_FALSETICKER].port, QUERY_TIMEOUT_MS, &s);
+    expect(ret == 0 && llabs(s.offset_us - 3000000) <= LOCAL_SLACK_US, "3 s off: offset %lld us, want %lld",
+           s.offset_us, 3000000);
+
+    ret = ntp_query("127.0.0.1", fakes[SRV_KOD].port, QUERY_TIMEOUT_MS, &s);
+    expect(ret == -1 && !s.valid, "kiss-o'-death: returned %lld, want %lld", ret, -1);
+
+    int64_t start = now_us();
+    ret = ntp_query("127.0.0.1", fakes[SRV_DROP].port, QUERY_TIMEOUT_MS, &s);
+    int64_t waited_ms = (now_us() - start) / 1000;
+    expect(ret == -1 && !s.valid, "dropped: returned %lld, want %lld", ret, -1);
+    expect(waited_ms < QUERY_TIMEOUT_MS * 2, "dropped: waited %lld ms, timeout %lld ms", waited_ms, QUERY_TIMEOUT_MS);
+
+    ret = ntp_query("127.0.0.1", fakes[SRV_UNSYNC].port, QUERY_TIMEOUT_MS, &s);
+    expect(ret == -1 && !s.valid, "unsynchronized: returned %lld, want %lld", ret, -1);
+
+    ret = ntp_query("127.0.0.1", fakes[SRV_STALE].port, QUERY_TIMEOUT_MS, &s);
+    expect(ret == 0 && llabs(s.offset_us) <= LOCAL_SLACK_US, "stale reply skipped: offset %lld us, want %lld",
+           s.offset_us, 0);
+}
+
+/* All of them, as the time task polls: the rejected ones are left out, the
+ * falseticker is outvoted, the result is between the two honest servers */
+static void test_round(struct fake_server *fakes)
+{
+    ntp_sample_t s[SRV_CNT];
+    int64_t offset = 0;
+    int used = 0;
+
+    for (int round = 0; round < 5; round++) {
+        int valid = 0;
+        for (int i = 0; i < SRV_CNT; i++) {
+            ntp_query("127.0.0.1", fakes[i].port, QUERY_TIMEOUT_MS, &s[i]);
+            valid += s[i].valid;
+        }
+        int ret = ntp_combine(s, SRV_CNT, &offset, &used);
+        expect(valid == 4, "round: %lld valid answers, want %lld", valid, 4);
+        expect(ret == 0, "round: combine returned %lld, want %lld", ret, 0);
+        expect(used == 3, "round: used %lld, want %lld (falseticker out)", used, 3);
+        expect(offset >= -2000 - LOCAL_SLACK_US && offset <= 12000 + LOCAL_SLACK_US,
+               "round: offset %lld us, want the honest range around %lld", offset, 5000);
+        if (s_failed) {
+            return;
+        }
+    }
+    printf("ntp_client: last round %lld us from %d servers\n", (long long)offset, used);
+}
+
+int main(void)
+{
+    struct fake_server fakes[SRV_CNT] = {
+        [SRV_HONEST_A]    = { .kind = FAKE_OK, .offset_us = 0, .jitter_us = 2000 },
+        [SRV_HONEST_B]    = { .kind = FAKE_OK, .offset_us = 10000, .jitter_us = 2000 },
+        [SRV_FALSETICKER] = { .kind = FAKE_OK, .offset_us = 3000000 },
+        [SRV_KOD]         = { .kind = FAKE_KOD },
+        [SRV_DROP]        = { .kind = FAKE_DROP },
+        [SRV_UNSYNC]      = { .kind = FAKE_UNSYNC },
+        [SRV_STALE]       = { .kind = FAKE_STALE_FIRST },
+    };
+
+    test_combine();
+
+    pid_t pid = fake_start(fakes, SRV_CNT);
+    if (pid < 0) {
+        printf("FAIL fake servers: no socket\n");
+        return 1;
+    }
+    test_query(fakes);
+    if (!s_failed) {
+        test_round(fakes);
+    }
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+
+    printf("ntp_client: %s\n", s_failed ? "FAILED" : "ok");
+    return s_failed;
+}
@@ -0,0 +1,170 @@
+/*
+ * Host test for rect_set: every add and subtract is checked pixel by pixel
+ * against a bitmap. The set may cover more than the bitmap (a collapse to
+ * the bounding box), but it must never lose a pixel or count one twice.
+ */
+
+#include "rect_set.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define W   64
+#define H   64
+
+static const rect_t s_clip = { 0, 0, W - 1, H - 1 };
+static uint8_t s_want[H][W];        /* pixels that must be in the set */
+static uint8_t s_have[H][W];        /* times the set covers each pixel */
+
+static void paint(uint8_t m[H][W], const rect_t *r, uint8_t v)
+{
+    rect_t c = *r;
+
+    if (c.x1 < 0) c.x1 = 0;
+    if (c.y1 < 0) c.y1 = 0;
+    if (c.x2 > W - 1) c.x2 = W - 1;
+    if (c.y2 > H - 1) c.y2 = H - 1;
+    for (int y = c.y1; y <= c.y2; y++) {
+        for (int x = c.x1; x <= c.x2; x++) {
+            m[y][x] = v;
+        }
+    }
+}
+
+/* 0 when s still holds every wanted pixel exactly once */
+static int check(const rect_set_t *s, const char *what, int step)
+{
+    uint32_t covered = 0;
+
+    memset(s_have, 0, sizeof(s_have));
+    for (int i = 0; i < s->cnt; i++) {
+        const rect_t *r = &s->r[i];
+        if (r->x1 > r->x2 || r->y1 > r->y2 ||
+            r->x1 < s_clip.x1 || r->y1 < s_clip.y1 || r->x2 > s_clip.x2 || r->y2 > s_clip.y2) {
+            printf("FAIL %s step %d: bad rectangle %d,%d-%d,%d\n", what, step, r->x1, r->y1, r->x2, r->y2);
+            return -1;
+        }
+        for (int y = r->y1; y <= r->y2; y++) {
+            for (int x = r->x1; x <= r->x2; x++) {
+                s_have[y][x]++;
+            }
+        }
+    }
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            if (s_want[y][x] && !s_have[y][x]) {
+                printf("FAIL %s step %d: pixel %d,%d lost\n", what, step, x, y);
+                return -1;
+            }
+            if (s_have[y][x] > 1) {
+                printf("FAIL %s step %d: pixel %d,%d counted %d times\n", what, step, x, y, s_have[y][x]);
+                return -1;
+            }
+            covered += s_have[y][x];
+        }
+    }
+    if (covered != rect_set_area(s)) {
+        printf("FAIL %s step %d: area %lu, %lu pixels covered\n", what, step,
+               (unsigned long)rect_set_area(s), (unsigned long)covered);
+        return -1;
+    }
+    return 0;
+}
+
+static rect_t random_rect(int max_size)
+{
+    rect_t r;
+
+    r.x1 = rand() % (W + 8) - 4;
+    r.y1 = rand() % (H + 8) - 4;
+    r.x2 = r.x1 + rand() % max_size;
+    r.y2 = r.y1 + rand() % max_size;
+    return r;
+}
+
+/* Pixels on a diagonal, then a rectangle over them: subtracting them splits the
+ * new rectangle into more pieces than fit, mid-way through the set. The
+ * collapse must take all of the new rectangle, not the piece it got to */
+static int test_overflow_while_splitting(void)
+{
+    rect_set_t s;
+    rect_t big = { 0, 0, W - 1, H - 1 };
+
+    rect_set_clear(&s);
+    memset(s_want, 0, sizeof(s_want));
+    for (int i = 0; i < 20; i++) {
+        rect_t dot = { 8 + i * 2, 4 + i * 2, 8 + i * 2, 4 + i * 2 };
+        rect_set_add(&s, &dot, &s_clip);
+        paint(s_want, &dot, 1);
+    }
+    if (check(&s, "overflow setup", 0) < 0) {
+        return -1;
+    }
+    rect_set_add(&s, &big, &s_clip);
+    paint(s_want, &big, 1);
+    return check(&s, "overflow", 1);
+}
+
+static int test_random_add(int trials)
+{
+    for (int t = 0; t < trials; t++) {
+        rect_set_t s;
+        int steps = rand() % 80;
+
+        rect_set_clear(&s);
+        memset(s_want, 0, sizeof(s_want));
+        for (int k = 0; k < steps; k++) {
+            rect_t r = random_rect(k % 5 == 0 ? W : 6);
+            rect_set_add(&s, &r, &s_clip);
+            paint(s_want, &r, 1);
+            if (check(&s, "add", k) < 0) {
+                printf("  trial %d\n", t);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static int test_random_subtract(int trials)
+{
+    for (int t = 0; t < trials; t++) {
+        rect_set_t s;
+        int steps = rand() % 20;
+
+        rect_set_clear(&s);
+        memset(s_want, 0, sizeof(s_want));
+        for (int k = 0; k < steps; k++) {
+            rect_t r = random_rect(8);
+            rect_set_add(&s, &r, &s_clip);
+            paint(s_want, &r, 1);
+        }
+        if (check(&s, "subtract setup", 0) < 0) {
+            printf("  trial %d\n", t);
+            return -1;
+        }
+        /* Pixels a collapse added don't have to go, but the rest must stay */
+        for (int k = 0; k < 8; k++) {
+            rect_t r = random_rect(20);
+            rect_set_subtract(&s, &r);
+            paint(s_want, &r, 0);
+            if (check(&s, "subtract", k) < 0) {
+                printf("  trial %d\n", t);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    srand(1);
+    failed |= test_overflow_while_splitting();
+    failed |= test_random_add(20000);
+    failed |= test_random_subtract(20000);
+    printf("rect_set: %s\n", failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
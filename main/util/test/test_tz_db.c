@@ -0,0 +1,142 @@
+/*
+ * Host test and lookup benchmark for tz_db. tz_db.c is included so every key
+ * of the generated table can be walked: each one must resolve to its own
+ * rule, also upper-cased and with '_' and ' ' swapped. Then a few known
+ * names, aliases and links, and names that must be rejected.
+ */
+
+#include "../tz_db.c"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_ROUNDS    2000
+
+static int s_failed;
+
+static void expect(const char *name, const char *rule)
+{
+    const char *got = tz_db_lookup(name);
+
+    if ((got == NULL) != (rule == NULL) || (got && strcmp(got, rule) != 0)) {
+        printf("FAIL \"%s\": got %s%s%s, want %s%s%s\n", name ? name : "(null)",
+               got ? "\"" : "", got ? got : "NULL", got ? "\"" : "",
+               rule ? "\"" : "", rule ? rule : "NULL", rule ? "\"" : "");
+        s_failed = 1;
+    }
+}
+
+/* Same key, other spelling: upper case, '_' and ' ' swapped */
+static void respell(char *out, const char *name, size_t size)
+{
+    size_t i = 0;
+
+    for (; name[i] && i < size - 1; i++) {
+        char c = name[i];
+        if (c >= 'a' && c <= 'z') {
+            c = c - 'a' + 'A';
+        } else if (c == '_') {
+            c = ' ';
+        } else if (c == ' ') {
+            c = '_';
+        }
+        out[i] = c;
+    }
+    out[i] = '\0';
+}
+
+static void test_every_key(void)
+{
+    char other[64];
+
+    for (int i = 0; i < TZ_DB_KEY_CNT; i++) {
+        const char *name = &__tz_db_names[__tz_db_entries[i].name];
+        const char *rule = &__tz_db_rules[__tz_db_entries[i].rule];
+
+        expect(name, rule);
+        respell(other, name, sizeof(other));
+        expect(other, rule);
+    }
+}
+
+static void test_known_names(void)
+{
+    const char *vienna = "CET-1CEST,M3.5.0,M10.5.0/3";
+    const char *new_york = "EST5EDT,M3.2.0,M11.1.0";
+    const char *kyiv = "EET-2EEST,M3.5.0/3,M10.5.0/4";
+
+    /* Zone names and cities */
+    expect("Europe/Vienna", vienna);
+    expect("Vienna", vienna);
+    expect("America/New_York", new_york);
+    expect("New York", new_york);
+    expect("Asia/Kolkata", "IST-5:30");
+    expect("Etc/UTC", "UTC0");
+
+    /* Case and '_' vs ' ' */
+    expect("europe/vienna", vienna);
+    expect("VIENNA", vienna);
+    expect("new_york", new_york);
+    expect("america/new york", new_york);
+
+    /* Aliases and backward links */
+    expect("Wien", vienna);
+    expect("wien", vienna);
+    expect("Boston", new_york);
+    expect("Kiev", kyiv);
+    expect("Europe/Kiev", kyiv);
+    expect("Europe/Kyiv", kyiv);
+    expect("Asia/Calcutta", "IST-5:30");
+
+    /* Unknown names */
+    expect(NULL, NULL);
+    expect("", NULL);
+    expect("Atlantis", NULL);
+    expect("Europe/Vienn", NULL);
+    expect("Europe/Viennaa", NULL);
+    expect("Europe/", NULL);
+    expect("Vienna ", NULL);
+    expect("New-York", NULL);
+}
+
+static double bench_ns(const char *const *names, int cnt)
+{
+    struct timespec t0, t1;
+    volatile const char *sink;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        for (int i = 0; i < cnt; i++) {
+            sink = tz_db_lookup(names[i]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    (void)sink;
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / ((double)BENCH_ROUNDS * cnt);
+}
+
+static void bench(void)
+{
+    static const char *hits[TZ_DB_KEY_CNT];
+    static const char *const misses[] = {
+        "Atlantis", "Europe/Vienn", "Springfield", "Mars/Olympus_Mons",
+        "Gotham", "Asia/Kolkatta", "Narnia", "America/New_Yorkk",
+    };
+
+    for (int i = 0; i < TZ_DB_KEY_CNT; i++) {
+        hits[i] = &__tz_db_names[__tz_db_entries[i].name];
+    }
+    printf("tz_db: %d keys, lookup %.1f ns (hit), %.1f ns (miss)\n", TZ_DB_KEY_CNT,
+           bench_ns(hits, TZ_DB_KEY_CNT), bench_ns(misses, sizeof(misses) / sizeof(misses[0])));
+}
+
+int main(void)
+{
+    test_every_key();
+    test_known_names();
+    if (!s_failed) {
+        bench();
+    }
+    printf("tz_db: %s\n", s_failed ? "FAILED" : "ok");
+    return s_failed;
+}
@@ -0,0 +1,59 @@
+#include "tz_db.h"
+#include <stddef.h>
+#include <stdint.h>
+
+struct tz_db_entry {
+    uint16_t name;      /* offset in __tz_db_names */
+    uint16_t rule;      /* offset in __tz_db_rules */
+};
+
+#include "tz_db_data.h"
+
+#define TZ_DB_FNV_OFFSET  2166136261u
+#define TZ_DB_FNV_PRIME   16777619u
+
+/* Keys compare in ASCII lower case with '_' as ' ', like the generator */
+static char __normalize(char c)
+{
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A' + 'a';
+    }
+    return c == '_' ? ' ' : c;
+}
+
+static uint32_t __hash(const char *name, uint32_t seed)
+{
+    uint32_t h = seed ? seed : TZ_DB_FNV_OFFSET;
+
+    for (; *name; name++) {
+        h ^= (uint8_t)__normalize(*name);
+        h *= TZ_DB_FNV_PRIME;
+    }
+    return h;
+}
+
+static int __equal(const char *a, const char *b)
+{
+    for (; *a && *b; a++, b++) {
+        if (__normalize(*a) != __normalize(*b)) {
+            return 0;
+        }
+    }
+    return *a == *b;
+}
+
+const char *tz_db_lookup(const char *name)
+{
+    if (!name || !*name) {
+        return NULL;
+    }
+
+    uint16_t disp = __tz_db_disp[__hash(name, 0) % TZ_DB_BUCKET_CNT];
+    const struct tz_db_entry *entry = &__tz_db_entries[__hash(name, disp) % TZ_DB_KEY_CNT];
+
+    /* Unknown names land on some slot too, the compare rejects them */
+    if (!__equal(name, &__tz_db_names[entry->name])) {
+        return NULL;
+    }
+    return &__tz_db_rules[entry->rule];
+}
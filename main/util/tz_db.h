@@ -0,0 +1,26 @@
+#ifndef TZ_DB_H
+#define TZ_DB_H
+
+/*
+ * Compiled-in time zone rules. tools/gen_tz_db.py turns the IANA database
+ * into tz_db_data.h: the POSIX TZ rule of every zone, keyed by zone name and
+ * city, behind a minimal perfect hash. A lookup is two hashes and one string
+ * compare, and needs no network.
+ *
+ * Builds on a Linux host as is.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* POSIX TZ rule for setenv("TZ"), e.g. "CET-1CEST,M3.5.0,M10.5.0/3" for
+ * "Europe/Vienna", "Vienna" or "wien". Case, and '_' vs ' ', are ignored.
+ * NULL if the name is unknown */
+const char *tz_db_lookup(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1642 @@
+/* Generated by tools/gen_tz_db.py, do not edit */
+
+#define TZ_DB_KEY_CNT     969
+#define TZ_DB_BUCKET_CNT  242
+
+static const char __tz_db_names[] =
+    "Africa/Abidjan\0"
+    "Africa/Accra\0"
+    "Africa/Addis_Ababa\0"
+    "Africa/Algiers\0"
+    "Africa/Asmara\0"
+    "Africa/Asmera\0"
+    "Africa/Bamako\0"
+    "Africa/Bangui\0"
+    "Africa/Banjul\0"
+    "Africa/Bissau\0"
+    "Africa/Blantyre\0"
+    "Africa/Brazzaville\0"
+    "Africa/Bujumbura\0"
+    "Africa/Cairo\0"
+    "Africa/Casablanca\0"
+    "Africa/Ceuta\0"
+    "Africa/Conakry\0"
+    "Africa/Dakar\0"
+    "Africa/Dar_es_Salaam\0"
+    "Africa/Djibouti\0"
+    "Africa/Douala\0"
+    "Africa/El_Aaiun\0"
+    "Africa/Freetown\0"
+    "Africa/Gaborone\0"
+    "Africa/Harare\0"
+    "Africa/Johannesburg\0"
+    "Africa/Juba\0"
+    "Africa/Kampala\0"
+    "Africa/Khartoum\0"
+    "Africa/Kigali\0"
+    "Africa/Kinshasa\0"
+    "Africa/Lagos\0"
+    "Africa/Libreville\0"
+    "Africa/Lome\0"
+    "Africa/Luanda\0"
+    "Africa/Lubumbashi\0"
+    "Africa/Lusaka\0"
+    "Africa/Malabo\0"
+    "Africa/Maputo\0"
+    "Africa/Maseru\0"
+    "Africa/Mbabane\0"
+    "Africa/Mogadishu\0"
+    "Africa/Monrovia\0"
+    "Africa/Nairobi\0"
+    "Africa/Ndjamena\0"
+    "Africa/Niamey\0"
+    "Africa/Nouakchott\0"
+    "Africa/Ouagadougou\0"
+    "Africa/Porto-Novo\0"
+    "Africa/Sao_Tome\0"
+    "Africa/Timbuktu\0"
+    "Africa/Tripoli\0"
+    "Africa/Tunis\0"
+    "Africa/Windhoek\0"
+    "America/Adak\0"
+    "America/Anchorage\0"
+    "America/Anguilla\0"
+    "America/Antigua\0"
+    "America/Araguaina\0"
+    "America/Argentina/Buenos_Aires\0"
+    "America/Argentina/Catamarca\0"
+    "America/Argentina/ComodRivadavia\0"
+    "America/Argentina/Cordoba\0"
+    "America/Argentina/Jujuy\0"
+    "America/Argentina/La_Rioja\0"
+    "America/Argentina/Mendoza\0"
+    "America/Argentina/Rio_Gallegos\0"
+    "America/Argentina/Salta\0"
+    "America/Argentina/San_Juan\0"
+    "America/Argentina/San_Luis\0"
+    "America/Argentina/Tucuman\0"
+    "America/Argentina/Ushuaia\0"
+    "America/Aruba\0"
+    "America/Asuncion\0"
+    "America/Atikokan\0"
+    "America/Atka\0"
+    "America/Bahia\0"
+    "America/Bahia_Banderas\0"
+    "America/Barbados\0"
+    "America/Belem\0"
+    "America/Belize\0"
+    "America/Blanc-Sablon\0"
+    "America/Boa_Vista\0"
+    "America/Bogota\0"
+    "America/Boise\0"
+    "America/Buenos_Aires\0"
+    "America/Cambridge_Bay\0"
+    "America/Campo_Grande\0"
+    "America/Cancun\0"
+    "America/Caracas\0"
+    "America/Catamarca\0"
+    "America/Cayenne\0"
+    "America/Cayman\0"
+    "America/Chicago\0"
+    "America/Chihuahua\0"
+    "America/Ciudad_Juarez\0"
+    "America/Coral_Harbour\0"
+    "America/Cordoba\0"
+    "America/Costa_Rica\0"
+    "America/Coyhaique\0"
+    "America/Creston\0"
+    "America/Cuiaba\0"
+    "America/Curacao\0"
+    "America/Danmarkshavn\0"
+    "America/Dawson\0"
+    "America/Dawson_Creek\0"
+    "America/Denver\0"
+    "America/Detroit\0"
+    "America/Dominica\0"
+    "America/Edmonton\0"
+    "America/Eirunepe\0"
+    "America/El_Salvador\0"
+    "America/Ensenada\0"
+    "America/Fort_Nelson\0"
+    "America/Fort_Wayne\0"
+    "America/Fortaleza\0"
+    "America/Glace_Bay\0"
+    "America/Godthab\0"
+    "America/Goose_Bay\0"
+    "America/Grand_Turk\0"
+    "America/Grenada\0"
+    "America/Guadeloupe\0"
+    "America/Guatemala\0"
+    "America/Guayaquil\0"
+    "America/Guyana\0"
+    "America/Halifax\0"
+    "America/Havana\0"
+    "America/Hermosillo\0"
+    "America/Indiana/Indianapolis\0"
+    "America/Indiana/Knox\0"
+    "America/Indiana/Marengo\0"
+    "America/Indiana/Petersburg\0"
+    "America/Indiana/Tell_City\0"
+    "America/Indiana/Vevay\0"
+    "America/Indiana/Vincennes\0"
+    "America/Indiana/Winamac\0"
+    "America/Indianapolis\0"
+    "America/Inuvik\0"
+    "America/Iqaluit\0"
+    "America/Jamaica\0"
+    "America/Jujuy\0"
+    "America/Juneau\0"
+    "America/Kentucky/Louisville\0"
+    "America/Kentucky/Monticello\0"
+    "America/Knox_IN\0"
+    "America/Kralendijk\0"
+    "America/La_Paz\0"
+    "America/Lima\0"
+    "America/Los_Angeles\0"
+    "America/Louisville\0"
+    "America/Lower_Princes\0"
+    "America/Maceio\0"
+    "America/Managua\0"
+    "America/Manaus\0"
+    "America/Marigot\0"
+    "America/Martinique\0"
+    "America/Matamoros\0"
+    "America/Mazatlan\0"
+    "America/Mendoza\0"
+    "America/Menominee\0"
+    "America/Merida\0"
+    "America/Metlakatla\0"
+    "America/Mexico_City\0"
+    "America/Miquelon\0"
+    "America/Moncton\0"
+    "America/Monterrey\0"
+    "America/Montevideo\0"
+    "America/Montreal\0"
+    "America/Montserrat\0"
+    "America/Nassau\0"
+    "America/New_York\0"
+    "America/Nipigon\0"
+    "America/Nome\0"
+    "America/Noronha\0"
+    "America/North_Dakota/Beulah\0"
+    "America/North_Dakota/Center\0"
+    "America/North_Dakota/New_Salem\0"
+    "America/Nuuk\0"
+    "America/Ojinaga\0"
+    "America/Panama\0"
+    "America/Pangnirtung\0"
+    "America/Paramaribo\0"
+    "America/Phoenix\0"
+    "America/Port-au-Prince\0"
+    "America/Port_of_Spain\0"
+    "America/Porto_Acre\0"
+    "America/Porto_Velho\0"
+    "America/Puerto_Rico\0"
+    "America/Punta_Arenas\0"
+    "America/Rainy_River\0"
+    "America/Rankin_Inlet\0"
+    "America/Recife\0"
+    "America/Regina\0"
+    "America/Resolute\0"
+    "America/Rio_Branco\0"
+    "America/Rosario\0"
+    "America/Santa_Isabel\0"
+    "America/Santarem\0"
+    "America/Santiago\0"
+    "America/Santo_Domingo\0"
+    "America/Sao_Paulo\0"
+    "America/Scoresbysund\0"
+    "America/Shiprock\0"
+    "America/Sitka\0"
+    "America/St_Barthelemy\0"
+    "America/St_Johns\0"
+    "America/St_Kitts\0"
+    "America/St_Lucia\0"
+    "America/St_Thomas\0"
+    "America/St_Vincent\0"
+    "America/Swift_Current\0"
+    "America/Tegucigalpa\0"
+    "America/Thule\0"
+    "America/Thunder_Bay\0"
+    "America/Tijuana\0"
+    "America/Toronto\0"
+    "America/Tortola\0"
+    "America/Vancouver\0"
+    "America/Virgin\0"
+    "America/Whitehorse\0"
+    "America/Winnipeg\0"
+    "America/Yakutat\0"
+    "America/Yellowknife\0"
+    "Antarctica/Casey\0"
+    "Antarctica/Davis\0"
+    "Antarctica/DumontDUrville\0"
+    "Antarctica/Macquarie\0"
+    "Antarctica/Mawson\0"
+    "Antarctica/McMurdo\0"
+    "Antarctica/Palmer\0"
+    "Antarctica/Rothera\0"
+    "Antarctica/South_Pole\0"
+    "Antarctica/Syowa\0"
+    "Antarctica/Troll\0"
+    "Antarctica/Vostok\0"
+    "Antwerp\0"
+    "Arctic/Longyearbyen\0"
+    "Asia/Aden\0"
+    "Asia/Almaty\0"
+    "Asia/Amman\0"
+    "Asia/Anadyr\0"
+    "Asia/Aqtau\0"
+    "Asia/Aqtobe\0"
+    "Asia/Ashgabat\0"
+    "Asia/Ashkhabad\0"
+    "Asia/Atyrau\0"
+    "Asia/Baghdad\0"
+    "Asia/Bahrain\0"
+    "Asia/Baku\0"
+    "Asia/Bangkok\0"
+    "Asia/Barnaul\0"
+    "Asia/Beirut\0"
+    "Asia/Bishkek\0"
+    "Asia/Brunei\0"
+    "Asia/Calcutta\0"
+    "Asia/Chita\0"
+    "Asia/Choibalsan\0"
+    "Asia/Chongqing\0"
+    "Asia/Chungking\0"
+    "Asia/Colombo\0"
+    "Asia/Dacca\0"
+    "Asia/Damascus\0"
+    "Asia/Dhaka\0"
+    "Asia/Dili\0"
+    "Asia/Dubai\0"
+    "Asia/Dushanbe\0"
+    "Asia/Famagusta\0"
+    "Asia/Gaza\0"
+    "Asia/Harbin\0"
+    "Asia/Hebron\0"
+    "Asia/Ho_Chi_Minh\0"
+    "Asia/Hong_Kong\0"
+    "Asia/Hovd\0"
+    "Asia/Irkutsk\0"
+    "Asia/Istanbul\0"
+    "Asia/Jakarta\0"
+    "Asia/Jayapura\0"
+    "Asia/Jerusalem\0"
+    "Asia/Kabul\0"
+    "Asia/Kamchatka\0"
+    "Asia/Karachi\0"
+    "Asia/Kashgar\0"
+    "Asia/Kathmandu\0"
+    "Asia/Katmandu\0"
+    "Asia/Khandyga\0"
+    "Asia/Kolkata\0"
+    "Asia/Krasnoyarsk\0"
+    "Asia/Kuala_Lumpur\0"
+    "Asia/Kuching\0"
+    "Asia/Kuwait\0"
+    "Asia/Macao\0"
+    "Asia/Macau\0"
+    "Asia/Magadan\0"
+    "Asia/Makassar\0"
+    "Asia/Manila\0"
+    "Asia/Muscat\0"
+    "Asia/Nicosia\0"
+    "Asia/Novokuznetsk\0"
+    "Asia/Novosibirsk\0"
+    "Asia/Omsk\0"
+    "Asia/Oral\0"
+    "Asia/Phnom_Penh\0"
+    "Asia/Pontianak\0"
+    "Asia/Pyongyang\0"
+    "Asia/Qatar\0"
+    "Asia/Qostanay\0"
+    "Asia/Qyzylorda\0"
+    "Asia/Rangoon\0"
+    "Asia/Riyadh\0"
+    "Asia/Saigon\0"
+    "Asia/Sakhalin\0"
+    "Asia/Samarkand\0"
+    "Asia/Seoul\0"
+    "Asia/Shanghai\0"
+    "Asia/Singapore\0"
+    "Asia/Srednekolymsk\0"
+    "Asia/Taipei\0"
+    "Asia/Tashkent\0"
+    "Asia/Tbilisi\0"
+    "Asia/Tehran\0"
+    "Asia/Tel_Aviv\0"
+    "Asia/Thimbu\0"
+    "Asia/Thimphu\0"
+    "Asia/Tokyo\0"
+    "Asia/Tomsk\0"
+    "Asia/Ujung_Pandang\0"
+    "Asia/Ulaanbaatar\0"
+    "Asia/Ulan_Bator\0"
+    "Asia/Urumqi\0"
+    "Asia/Ust-Nera\0"
+    "Asia/Vientiane\0"
+    "Asia/Vladivostok\0"
+    "Asia/Yakutsk\0"
+    "Asia/Yangon\0"
+    "Asia/Yekaterinburg\0"
+    "Asia/Yerevan\0"
+    "Atlanta\0"
+    "Atlantic/Azores\0"
+    "Atlantic/Bermuda\0"
+    "Atlantic/Canary\0"
+    "Atlantic/Cape_Verde\0"
+    "Atlantic/Faeroe\0"
+    "Atlantic/Faroe\0"
+    "Atlantic/Jan_Mayen\0"
+    "Atlantic/Madeira\0"
+    "Atlantic/Reykjavik\0"
+    "Atlantic/South_Georgia\0"
+    "Atlantic/St_Helena\0"
+    "Atlantic/Stanley\0"
+    "Austin\0"
+    "Australia/ACT\0"
+    "Australia/Adelaide\0"
+    "Australia/Brisbane\0"
+    "Australia/Broken_Hill\0"
+    "Australia/Canberra\0"
+    "Australia/Currie\0"
+    "Australia/Darwin\0"
+    "Australia/Eucla\0"
+    "Australia/Hobart\0"
+    "Australia/LHI\0"
+    "Australia/Lindeman\0"
+    "Australia/Lord_Howe\0"
+    "Australia/Melbourne\0"
+    "Australia/NSW\0"
+    "Australia/North\0"
+    "Australia/Perth\0"
+    "Australia/Queensland\0"
+    "Australia/South\0"
+    "Australia/Sydney\0"
+    "Australia/Tasmania\0"
+    "Australia/Victoria\0"
+    "Australia/West\0"
+    "Australia/Yancowinna\0"
+    "Bangalore\0"
+    "Barcelona\0"
+    "Basel\0"
+    "Beijing\0"
+    "Bergen\0"
+    "Bern\0"
+    "Birmingham\0"
+    "Boston\0"
+    "Brno\0"
+    "Canberra\0"
+    "Cologne\0"
+    "Dallas\0"
+    "Delhi\0"
+    "Edinburgh\0"
+    "Etc/UTC\0"
+    "Europe/Amsterdam\0"
+    "Europe/Andorra\0"
+    "Europe/Astrakhan\0"
+    "Europe/Athens\0"
+    "Europe/Belfast\0"
+    "Europe/Belgrade\0"
+    "Europe/Berlin\0"
+    "Europe/Bratislava\0"
+    "Europe/Brussels\0"
+    "Europe/Bucharest\0"
+    "Europe/Budapest\0"
+    "Europe/Busingen\0"
+    "Europe/Chisinau\0"
+    "Europe/Copenhagen\0"
+    "Europe/Dublin\0"
+    "Europe/Gibraltar\0"
+    "Europe/Guernsey\0"
+    "Europe/Helsinki\0"
+    "Europe/Isle_of_Man\0"
+    "Europe/Istanbul\0"
+    "Europe/Jersey\0"
+    "Europe/Kaliningrad\0"
+    "Europe/Kiev\0"
+    "Europe/Kirov\0"
+    "Europe/Kyiv\0"
+    "Europe/Lisbon\0"
+    "Europe/Ljubljana\0"
+    "Europe/London\0"
+    "Europe/Luxembourg\0"
+    "Europe/Madrid\0"
+    "Europe/Malta\0"
+    "Europe/Mariehamn\0"
+    "Europe/Minsk\0"
+    "Europe/Monaco\0"
+    "Europe/Moscow\0"
+    "Europe/Nicosia\0"
+    "Europe/Oslo\0"
+    "Europe/Paris\0"
+    "Europe/Podgorica\0"
+    "Europe/Prague\0"
+    "Europe/Riga\0"
+    "Europe/Rome\0"
+    "Europe/Samara\0"
+    "Europe/San_Marino\0"
+    "Europe/Sarajevo\0"
+    "Europe/Saratov\0"
+    "Europe/Simferopol\0"
+    "Europe/Skopje\0"
+    "Europe/Sofia\0"
+    "Europe/Stockholm\0"
+    "Europe/Tallinn\0"
+    "Europe/Tirane\0"
+    "Europe/Tiraspol\0"
+    "Europe/Ulyanovsk\0"
+    "Europe/Uzhgorod\0"
+    "Europe/Vaduz\0"
+    "Europe/Vatican\0"
+    "Europe/Vienna\0"
+    "Europe/Vilnius\0"
+    "Europe/Volgograd\0"
+    "Europe/Warsaw\0"
+    "Europe/Zagreb\0"
+    "Europe/Zaporozhye\0"
+    "Europe/Zurich\0"
+    "Frankfurt\0"
+    "Geneva\0"
+    "Gothenburg\0"
+    "Graz\0"
+    "Guangzhou\0"
+    "Hamburg\0"
+    "Houston\0"
+    "Indian/Antananarivo\0"
+    "Indian/Chagos\0"
+    "Indian/Christmas\0"
+    "Indian/Cocos\0"
+    "Indian/Comoro\0"
+    "Indian/Kerguelen\0"
+    "Indian/Mahe\0"
+    "Indian/Maldives\0"
+    "Indian/Mauritius\0"
+    "Indian/Mayotte\0"
+    "Indian/Reunion\0"
+    "Innsbruck\0"
+    "Kiev\0"
+    "Krakow\0"
+    "Linz\0"
+    "Lyon\0"
+    "Manchester\0"
+    "Marseille\0"
+    "Miami\0"
+    "Milan\0"
+    "Montreal\0"
+    "Mumbai\0"
+    "Munich\0"
+    "Naples\0"
+    "New Delhi\0"
+    "Odesa\0"
+    "Osaka\0"
+    "Ottawa\0"
+    "Pacific/Apia\0"
+    "Pacific/Auckland\0"
+    "Pacific/Bougainville\0"
+    "Pacific/Chatham\0"
+    "Pacific/Chuuk\0"
+    "Pacific/Easter\0"
+    "Pacific/Efate\0"
+    "Pacific/Enderbury\0"
+    "Pacific/Fakaofo\0"
+    "Pacific/Fiji\0"
+    "Pacific/Funafuti\0"
+    "Pacific/Galapagos\0"
+    "Pacific/Gambier\0"
+    "Pacific/Guadalcanal\0"
+    "Pacific/Guam\0"
+    "Pacific/Honolulu\0"
+    "Pacific/Johnston\0"
+    "Pacific/Kanton\0"
+    "Pacific/Kiritimati\0"
+    "Pacific/Kosrae\0"
+    "Pacific/Kwajalein\0"
+    "Pacific/Majuro\0"
+    "Pacific/Marquesas\0"
+    "Pacific/Midway\0"
+    "Pacific/Nauru\0"
+    "Pacific/Niue\0"
+    "Pacific/Norfolk\0"
+    "Pacific/Noumea\0"
+    "Pacific/Pago_Pago\0"
+    "Pacific/Palau\0"
+    "Pacific/Pitcairn\0"
+    "Pacific/Pohnpei\0"
+    "Pacific/Ponape\0"
+    "Pacific/Port_Moresby\0"
+    "Pacific/Rarotonga\0"
+    "Pacific/Saipan\0"
+    "Pacific/Samoa\0"
+    "Pacific/Tahiti\0"
+    "Pacific/Tarawa\0"
+    "Pacific/Tongatapu\0"
+    "Pacific/Truk\0"
+    "Pacific/Wake\0"
+    "Pacific/Wallis\0"
+    "Pacific/Yap\0"
+    "Philadelphia\0"
+    "Porto\0"
+    "Rotterdam\0"
+    "Saint Petersburg\0"
+    "Salzburg\0"
+    "San Diego\0"
+    "San Francisco\0"
+    "San Jose\0"
+    "Seattle\0"
+    "Seville\0"
+    "Shenzhen\0"
+    "Stuttgart\0"
+    "The Hague\0"
+    "Toulouse\0"
+    "Turin\0"
+    "UTC\0"
+    "Valencia\0"
+    "Washington\0"
+    "Wien\0"
+    "Wroclaw\0"
+    ;
+
+static const char __tz_db_rules[] =
+    "<+00>0<+02>-2,M3.5.0/1,M10.5.0/3\0"
+    "<+01>-1\0"
+    "<+0330>-3:30\0"
+    "<+03>-3\0"
+    "<+0430>-4:30\0"
+    "<+04>-4\0"
+    "<+0530>-5:30\0"
+    "<+0545>-5:45\0"
+    "<+05>-5\0"
+    "<+0630>-6:30\0"
+    "<+06>-6\0"
+    "<+07>-7\0"
+    "<+0845>-8:45\0"
+    "<+08>-8\0"
+    "<+09>-9\0"
+    "<+1030>-10:30<+11>-11,M10.1.0,M4.1.0\0"
+    "<+10>-10\0"
+    "<+11>-11\0"
+    "<+11>-11<+12>,M10.1.0,M4.1.0/3\0"
+    "<+1245>-12:45<+1345>,M9.5.0/2:45,M4.1.0/3:45\0"
+    "<+12>-12\0"
+    "<+13>-13\0"
+    "<+14>-14\0"
+    "<-01>1\0"
+    "<-01>1<+00>,M3.5.0/0,M10.5.0/1\0"
+    "<-02>2\0"
+    "<-02>2<-01>,M3.5.0/-1,M10.5.0/0\0"
+    "<-03>3\0"
+    "<-03>3<-02>,M3.2.0,M11.1.0\0"
+    "<-04>4\0"
+    "<-04>4<-03>,M9.1.6/24,M4.1.6/24\0"
+    "<-05>5\0"
+    "<-06>6\0"
+    "<-06>6<-05>,M9.1.6/22,M4.1.6/22\0"
+    "<-08>8\0"
+    "<-0930>9:30\0"
+    "<-09>9\0"
+    "<-10>10\0"
+    "<-11>11\0"
+    "ACST-9:30\0"
+    "ACST-9:30ACDT,M10.1.0,M4.1.0/3\0"
+    "AEST-10\0"
+    "AEST-10AEDT,M10.1.0,M4.1.0/3\0"
+    "AKST9AKDT,M3.2.0,M11.1.0\0"
+    "AST4\0"
+    "AST4ADT,M3.2.0,M11.1.0\0"
+    "AWST-8\0"
+    "CAT-2\0"
+    "CET-1\0"
+    "CET-1CEST,M3.5.0,M10.5.0/3\0"
+    "CST-8\0"
+    "CST5CDT,M3.2.0/0,M11.1.0/1\0"
+    "CST6\0"
+    "CST6CDT,M3.2.0,M11.1.0\0"
+    "ChST-10\0"
+    "EAT-3\0"
+    "EET-2\0"
+    "EET-2EEST,M3.4.4/50,M10.4.4/50\0"
+    "EET-2EEST,M3.5.0,M10.5.0/3\0"
+    "EET-2EEST,M3.5.0/0,M10.5.0/0\0"
+    "EET-2EEST,M3.5.0/3,M10.5.0/4\0"
+    "EET-2EEST,M4.5.5/0,M10.5.4/24\0"
+    "EST5\0"
+    "EST5EDT,M3.2.0,M11.1.0\0"
+    "GMT0\0"
+    "GMT0BST,M3.5.0/1,M10.5.0\0"
+    "HKT-8\0"
+    "HST10\0"
+    "HST10HDT,M3.2.0,M11.1.0\0"
+    "IST-1GMT0,M10.5.0,M3.5.0/1\0"
+    "IST-2IDT,M3.4.4/26,M10.5.0\0"
+    "IST-5:30\0"
+    "JST-9\0"
+    "KST-9\0"
+    "MSK-3\0"
+    "MST7\0"
+    "MST7MDT,M3.2.0,M11.1.0\0"
+    "NST3:30NDT,M3.2.0,M11.1.0\0"
+    "NZST-12NZDT,M9.5.0,M4.1.0/3\0"
+    "PKT-5\0"
+    "PST-8\0"
+    "PST8PDT,M3.2.0,M11.1.0\0"
+    "SAST-2\0"
+    "SST11\0"
+    "UTC0\0"
+    "WAT-1\0"
+    "WET0WEST,M3.5.0/1,M10.5.0\0"
+    "WIB-7\0"
+    "WIT-9\0"
+    "WITA-8\0"
+    ;
+
+static const uint16_t __tz_db_disp[TZ_DB_BUCKET_CNT] = {
+    99, 1, 33, 4, 52, 4, 2, 14, 76, 33, 257, 4, 1, 4, 3, 23,
+    34, 274, 13, 24, 11, 2, 31, 17, 33, 1, 63, 82, 18, 80, 31, 1,
+    25, 113, 14, 41, 14, 8, 146, 10, 730, 52, 5, 216, 1, 7, 3, 61,
+    58, 61, 180, 77, 248, 94, 1, 11, 3, 1, 2, 339, 427, 1, 4, 310,
+    1, 15, 24, 489, 100, 303, 398, 5, 218, 41, 3, 22, 1, 3, 3, 83,
+    34, 257, 265, 59, 10, 365, 24, 0, 61, 32, 22, 13, 9, 68, 9, 431,
+    275, 1, 162, 582, 51, 29, 8, 13, 17, 426, 6, 83, 53, 831, 18, 174,
+    95, 252, 0, 137, 27, 10, 0, 365, 1, 40, 1, 62, 2, 29, 5, 163,
+    213, 1, 97, 50, 107, 56, 177, 7, 36, 89, 11, 3, 231, 134, 1, 72,
+    59, 200, 30, 173, 9, 1, 123, 0, 115, 1835, 1, 130, 99, 18, 8, 157,
+    165, 25, 18, 1, 3, 263, 559, 45, 674, 210, 1, 38, 741, 94, 2429, 77,
+    816, 191, 142, 4, 0, 419, 6, 351, 2, 103, 5, 22, 25, 173, 44, 1,
+    1247, 34, 6, 29, 1022, 3, 42, 91, 31, 4, 1, 4, 644, 29, 2, 750,
+    4045, 2, 69, 319, 19, 205, 179, 15, 213, 104, 238, 1086, 75, 607, 22, 130,
+    2, 190, 361, 5, 5, 1158, 1, 59, 1052, 111, 3, 526, 1180, 66, 424, 446,
+    530, 3,
+};
+
+static const struct tz_db_entry __tz_db_entries[TZ_DB_KEY_CNT] = {
+    {  1308,  975 },   /* atikokan */
+    {  6327,  786 },   /* dallas */
+    {   496, 1285 },   /* libreville */
+    {  2851,  786 },   /* america/menominee */
+    {   446,  709 },   /* africa/kigali */
+    {  6375,  721 },   /* europe/andorra */
+    {  2288,  786 },   /* knox */
+    {  4791, 1096 },   /* asia/jerusalem */
+    {  5100,  130 },   /* omsk */
+    {  7026,  721 },   /* europe/sarajevo */
+    {  4410,   54 },   /* bahrain */
+    {  3496,  786 },   /* resolute */
+    {  4671,  748 },   /* asia/harbin */
+    {   211,   33 },   /* africa/casablanca */
+    {  1031,  410 },   /* america/argentina/jujuy */
+    {  7520,   75 },   /* mauritius */
+    {  6305,  721 },   /* brno */
+    {  6970,  916 },   /* europe/riga */
+    {  5877,  612 },   /* brisbane */
+    {  5490,  130 },   /* asia/urumqi */
+    {  7849,  306 },   /* funafuti */
+    {   903,  410 },   /* araguaina */
+    {  3673,  649 },   /* america/sitka */
+    {   707, 1003 },   /* nouakchott */
+    {  6334, 1123 },   /* delhi */
+    {  7545,   75 },   /* indian/reunion */
+    {  2096,  980 },   /* grand turk */
+    {   622,  817 },   /* africa/mogadishu */
+    {  4220,    0 },   /* antarctica/troll */
+    {  4263,  721 },   /* arctic/longyearbyen */
+    {  7448,  117 },   /* cocos */
+    {  3364,  444 },   /* porto velho */
+    {  1594,  410 },   /* america/cayenne */
+    {  5896,  581 },   /* broken hill */
+    {  6134,  581 },   /* australia/south */
+    {  7271,  721 },   /* europe/warsaw */
+    {  4466,  130 },   /* asia/bishkek */
+    {  2835,  410 },   /* america/mendoza */
+    {  6590, 1069 },   /* dublin */
+    {  7475,  109 },   /* kerguelen */
+    {  5331,  748 },   /* taipei */
+    {  7497,  109 },   /* indian/maldives */
+    {  4441,  138 },   /* asia/barnaul */
+    {  2666, 1244 },   /* los angeles */
+    {  6037,  175 },   /* lord howe */
+    {  2678,  980 },   /* america/louisville */
+    {  6160,  620 },   /* sydney */
+    {    47,  715 },   /* africa/algiers */
+    {  3201,  378 },   /* nuuk */
+    {   236,  721 },   /* ceuta */
+    {  4764, 1317 },   /* asia/jakarta */
+    {   328,   33 },   /* el aaiun */
+    {  7552,   75 },   /* reunion */
+    {  6878,  721 },   /* monaco */
+    {   314, 1285 },   /* douala */
+    {  5040,   75 },   /* muscat */
+    {  3300,  980 },   /* port-au-prince */
+    {  7892,  221 },   /* pacific/guadalcanal */
+    {  4385,  109 },   /* atyrau */
+    {  3913,  674 },   /* tortola */
+    {  7042,   75 },   /* europe/saratov */
+    {  5827,  786 },   /* austin */
+    {  4270,  721 },   /* longyearbyen */
+    {  8164,  529 },   /* pacific/pitcairn */
+    {  6287, 1008 },   /* birmingham */
+    {  1413,  674 },   /* america/blanc-sablon */
+    {  7075,  721 },   /* europe/skopje */
+    {     0, 1003 },   /* africa/abidjan */
+    {  7655, 1123 },   /* new delhi */
+    {  7417,  130 },   /* chagos */
+    {  8132, 1274 },   /* pacific/pago pago */
+    {  5136, 1317 },   /* pontianak */
+    {  4782, 1323 },   /* jayapura */
+    {    35,  817 },   /* addis ababa */
+    {  7397,  817 },   /* antananarivo */
+    {  1460,  483 },   /* bogota */
+    {  7331,  721 },   /* frankfurt */
+    {  6081,  571 },   /* australia/north */
+    {  1633,  786 },   /* chicago */
+    {  4727,  138 },   /* asia/hovd */
+    {  7858,  490 },   /* pacific/galapagos */
+    {   422,  817 },   /* kampala */
+    {  1502, 1155 },   /* america/cambridge bay */
+    {  6630,  916 },   /* europe/helsinki */
+    {  2386,  980 },   /* vevay */
+    {  4118,  109 },   /* mawson */
+    {   198,  945 },   /* africa/cairo */
+    {  5908,  620 },   /* australia/canberra */
+    {  2243,  980 },   /* america/indiana/indianapolis */
+    {  6397,   75 },   /* astrakhan */
+    {  5186,  109 },   /* asia/qyzylorda */
+    {  6390,   75 },   /* europe/astrakhan */
+    {  3540, 1244 },   /* america/santa isabel */
+    {   755, 1003 },   /* africa/sao tome */
+    {  5457,  159 },   /* asia/ulaanbaatar */
+    {  6275,  721 },   /* bergen */
+    {  6583, 1069 },   /* europe/dublin */
+    {  8288,  555 },   /* tahiti */
+    {  3954, 1150 },   /* america/whitehorse */
+    {  2750,  444 },   /* america/manaus */
+    {  7225,  721 },   /* europe/vienna */
+    {  6789, 1008 },   /* london */
+    {   369,  709 },   /* africa/harare */
+    {  4397,   54 },   /* baghdad */
+    {  7735,  261 },   /* pacific/chatham */
+    {  8362,  306 },   /* wallis */
+    {  5561,  117 },   /* asia/yangon */
+    {  1568,  444 },   /* caracas */
+    {  3222,  975 },   /* america/panama */
+    {  7967,  315 },   /* kanton */
+    {     7, 1003 },   /* abidjan */
+    {  4611,  167 },   /* asia/dili */
+    {  6597,  721 },   /* europe/gibraltar */
+    {  4026,  159 },   /* antarctica/casey */
+    {  1139,  410 },   /* america/argentina/salta */
+    {  7246,  916 },   /* vilnius */
+    {  8117,  221 },   /* pacific/noumea */
+    {  7057, 1144 },   /* europe/simferopol */
+    {  1421,  674 },   /* blanc-sablon */
+    {  6963,  721 },   /* prague */
+    {  5214,   54 },   /* asia/riyadh */
+    {  8381,  980 },   /* philadelphia */
+    {  7613,  980 },   /* miami */
+    {  3018,  674 },   /* montserrat */
+    {   540,  709 },   /* lubumbashi */
+    {  3214,  786 },   /* ojinaga */
+    {  1649,  781 },   /* chihuahua */
+    {  8318,  315 },   /* tongatapu */
+    {  7866,  490 },   /* galapagos */
+    {  4646,  916 },   /* asia/famagusta */
+    {   639, 1003 },   /* africa/monrovia */
+    {  4321,  306 },   /* anadyr */
+    {  1049,  410 },   /* jujuy */
+    {  8341,  306 },   /* pacific/wake */
+    {  5768,  371 },   /* atlantic/south georgia */
+    {  5083,  138 },   /* novosibirsk */
+    {  5597,   75 },   /* yerevan */
+    {   291,  817 },   /* africa/djibouti */
+    {  2556,  980 },   /* louisville */
+    {  1055,  410 },   /* america/argentina/la rioja */
+    {  6436,  721 },   /* europe/belgrade */
+    {  5944,  571 },   /* australia/darwin */
+    {  2765,  674 },   /* america/marigot */
+    {  7828,  306 },   /* pacific/fiji */
+    {  4231,    0 },   /* troll */
+    {  4616,  167 },   /* dili */
+    {  7780,  221 },   /* pacific/efate */
+    {  1510, 1155 },   /* cambridge bay */
+    {  6205,  702 },   /* australia/west */
+    {  2884,  649 },   /* america/metlakatla */
+    {  8303,  306 },   /* tarawa */
+    {  4931,  159 },   /* asia/kuala lumpur */
+    {  4974,  748 },   /* asia/macao */
+    {  3077,  649 },   /* america/nome */
+    {   852,  649 },   /* anchorage */
+    {  3237,  980 },   /* america/pangnirtung */
+    {  2293,  980 },   /* america/indiana/marengo */
+    {  5408,  130 },   /* thimphu */
+    {  2595,  786 },   /* america/knox in */
+    {  5427,  138 },   /* asia/tomsk */
+    {  7181,  916 },   /* europe/uzhgorod */
+    {  6865,   54 },   /* minsk */
+    {  7049,   75 },   /* saratov */
+    {  4666,  829 },   /* gaza */
+    {  5191,  109 },   /* qyzylorda */
+    {   489, 1285 },   /* africa/libreville */
+    {   870,  674 },   /* anguilla */
+    {  4817,  306 },   /* asia/kamchatka */
+    {  7504,  109 },   /* maldives */
+    {  8067, 1274 },   /* midway */
+    {  5462,  159 },   /* ulaanbaatar */
+    {  1738,  410 },   /* america/coyhaique */
+    {  3695,  674 },   /* st barthelemy */
+    {  4985,  748 },   /* asia/macau */
+    {  4742,  159 },   /* irkutsk */
+    {  6540,  721 },   /* busingen */
+    {  5961,  146 },   /* australia/eucla */
+    {  4356,  109 },   /* ashgabat */
+    {  1344,  781 },   /* america/bahia banderas */
+    {  5357,   75 },   /* tbilisi */
+    {  3323,  674 },   /* port of spain */
+    {  5432,  138 },   /* tomsk */
+    {  1891,  674 },   /* america/dominica */
+    {  3768,  674 },   /* st thomas */
+    {  1756, 1150 },   /* america/creston */
+    {  3726,  674 },   /* america/st kitts */
+    {  6751, 1291 },   /* europe/lisbon */
+    {  7468,  109 },   /* indian/kerguelen */
+    {  1082,  410 },   /* america/argentina/mendoza */
+    {  5819,  410 },   /* stanley */
+    {  3595,  674 },   /* america/santo domingo */
+    {  3998,  649 },   /* yakutat */
+    {   614, 1267 },   /* mbabane */
+    {  7461,  817 },   /* comoro */
+    {  7008,  721 },   /* europe/san marino */
+    {  5438, 1329 },   /* asia/ujung pandang */
+    {  5403,  130 },   /* asia/thimphu */
+    {  6714,  916 },   /* europe/kiev */
+    {  6057,  620 },   /* melbourne */
+    {  5338,  109 },   /* asia/tashkent */
+    {  3709, 1178 },   /* america/st johns */
+    {  5977,  620 },   /* australia/hobart */
+    {   188,  709 },   /* bujumbura */
+    {  3183,  786 },   /* new salem */
+    {  1875,  980 },   /* america/detroit */
+    {  7015,  721 },   /* san marino */
+    {  8189,  221 },   /* pohnpei */
+    {   415,  817 },   /* africa/kampala */
+    {  4446,  138 },   /* barnaul */
+    {  7513,   75 },   /* indian/mauritius */
+    {  5052,  916 },   /* nicosia */
+    {  1618,  975 },   /* cayman */
+    {  5267, 1138 },   /* asia/seoul */
+    {  1772,  444 },   /* america/cuiaba */
+    {  8427,  721 },   /* salzburg */
+    {  1979, 1150 },   /* america/fort nelson */
+    {  7164,   75 },   /* europe/ulyanovsk */
+    {   844,  649 },   /* america/anchorage */
+    {  4181, 1204 },   /* antarctica/south pole */
+    {  8410, 1144 },   /* saint petersburg */
+    {  2036,  679 },   /* america/glace bay */
+    {  3376,  674 },   /* america/puerto rico */
+    {  1367,  674 },   /* america/barbados */
+    {  1681,  975 },   /* america/coral harbour */
+    {   944,  410 },   /* america/argentina/catamarca */
+    {  2630,  444 },   /* america/la paz */
+    {  5682, 1291 },   /* atlantic/faeroe */
+    {  2418,  980 },   /* america/indiana/winamac */
+    {  7841,  306 },   /* pacific/funafuti */
+    {  1847, 1150 },   /* dawson creek */
+    {  4351,  109 },   /* asia/ashgabat */
+    {  5161,   54 },   /* asia/qatar */
+    {  1950,  781 },   /* el salvador */
+    {  3481,  781 },   /* regina */
+    {  7587,  721 },   /* lyon */
+    {  1883,  980 },   /* detroit */
+    {  7382,  786 },   /* houston */
+    {  3635,  378 },   /* america/scoresbysund */
+    {  4737,  159 },   /* asia/irkutsk */
+    {  6921,  721 },   /* oslo */
+    {  8494,  721 },   /* stuttgart */
+    {   321,   33 },   /* africa/el aaiun */
+    {  7560,  721 },   /* innsbruck */
+    {  4822,  306 },   /* kamchatka */
+    {   410,  709 },   /* juba */
+    {  5994,  175 },   /* australia/lhi */
+    {  5578,  109 },   /* yekaterinburg */
+    {  3206,  786 },   /* america/ojinaga */
+    {  4712, 1033 },   /* asia/hong kong */
+    {   839, 1045 },   /* adak */
+    {  2088,  980 },   /* america/grand turk */
+    {  6443,  721 },   /* belgrade */
+    {  7925, 1039 },   /* pacific/honolulu */
+    {  1442,  444 },   /* boa vista */
+    {  1868, 1155 },   /* denver */
+    {  6796,  721 },   /* europe/luxembourg */
+    {  3561,  410 },   /* america/santarem */
+    {  6517,  721 },   /* europe/budapest */
+    {  1330,  410 },   /* america/bahia */
+    {  1434,  444 },   /* america/boa vista */
+    {  1641,  781 },   /* america/chihuahua */
+    {  3578,  451 },   /* america/santiago */
+    {  7431,  138 },   /* christmas */
+    {  8212,  212 },   /* pacific/port moresby */
+    {  2442,  980 },   /* america/indianapolis */
+    {  8436, 1244 },   /* san diego */
+    {  2018,  410 },   /* america/fortaleza */
+    {    69,  817 },   /* asmara */
+    {  8542,  980 },   /* washington */
+    {   607, 1267 },   /* africa/mbabane */
+    {  5605,  980 },   /* atlanta */
+    {   700, 1003 },   /* africa/nouakchott */
+    {  7292,  721 },   /* zagreb */
+    {   514, 1003 },   /* lome */
+    {  5078,  138 },   /* asia/novosibirsk */
+    {  5791, 1003 },   /* atlantic/st helena */
+    {  6858,   54 },   /* europe/minsk */
+    {  3458,  410 },   /* america/recife */
+    {  1899,  674 },   /* dominica */
+    {  2645,  483 },   /* america/lima */
+    {   242, 1003 },   /* africa/conakry */
+    {  7765,  497 },   /* pacific/easter */
+    {   533,  709 },   /* africa/lubumbashi */
+    {  4695,  138 },   /* asia/ho chi minh */
+    {  1999,  980 },   /* america/fort wayne */
+    {   270,  817 },   /* africa/dar es salaam */
+    {  7204,  721 },   /* vaduz */
+    {  7096,  916 },   /* sofia */
+    {  7812,  315 },   /* pacific/fakaofo */
+    {  8446, 1244 },   /* san francisco */
+    {   507, 1003 },   /* africa/lome */
+    {  1787,  674 },   /* america/curacao */
+    {  5326,  748 },   /* asia/taipei */
+    {  4605,  130 },   /* dhaka */
+    {  3586,  451 },   /* santiago */
+    {  7788,  221 },   /* efate */
+    {  6484,  721 },   /* europe/brussels */
+    {  5047,  916 },   /* asia/nicosia */
+    {   815,  709 },   /* africa/windhoek */
+    {  5987,  620 },   /* hobart */
+    {  4283,   54 },   /* asia/aden */
+    {  4845,  130 },   /* asia/kashgar */
+    {  2892,  649 },   /* metlakatla */
+    {  6892, 1144 },   /* moscow */
+    {  6982,  721 },   /* europe/rome */
+    {  8266, 1274 },   /* pacific/samoa */
+    {  4071,  212 },   /* dumontdurville */
+    {  1553,  975 },   /* cancun */
+    {  1933,  483 },   /* eirunepe */
+    {  3315,  674 },   /* america/port of spain */
+    {  3085,  649 },   /* nome */
+    {  7625,  980 },   /* montreal */
+    {  1942,  781 },   /* america/el salvador */
+    {  6459,  721 },   /* berlin */
+    {  7364,  748 },   /* guangzhou */
+    {  5105,  109 },   /* asia/oral */
+    {   809,  715 },   /* tunis */
+    {  6267,  748 },   /* beijing */
+    {  3292,  980 },   /* america/port-au-prince */
+    {  3106,  786 },   /* america/north dakota/beulah */
+    {  6533,  721 },   /* europe/busingen */
+    {   519, 1285 },   /* africa/luanda */
+    {  2742,  781 },   /* managua */
+    {  6841,  916 },   /* europe/mariehamn */
+    {  7454,  817 },   /* indian/comoro */
+    {  7359,  721 },   /* graz */
+    {  6298,  980 },   /* boston */
+    {  8485,  748 },   /* shenzhen */
+    {  8096,  563 },   /* niue */
+    {  5516,  138 },   /* asia/vientiane */
+    {   118, 1003 },   /* africa/banjul */
+    {  7197,  721 },   /* europe/vaduz */
+    {  2107,  674 },   /* america/grenada */
+    {  3873, 1244 },   /* america/tijuana */
+    {  2818, 1150 },   /* america/mazatlan */
+    {  5352,   75 },   /* asia/tbilisi */
+    {  2309,  980 },   /* marengo */
+    {  4155,  410 },   /* palmer */
+    {  3778,  674 },   /* america/st vincent */
+    {   353,  709 },   /* africa/gaborone */
+    {  2486,  980 },   /* iqaluit */
+    {  6994,   75 },   /* europe/samara */
+    {  4043,  138 },   /* antarctica/davis */
+    {  1481,  410 },   /* america/buenos aires */
+    {  6067,  620 },   /* australia/nsw */
+    {  7317,  721 },   /* europe/zurich */
+    {  2734,  781 },   /* america/managua */
+    {  5035,   75 },   /* asia/muscat */
+    {  4459,  887 },   /* beirut */
+    {  8008,  306 },   /* pacific/kwajalein */
+    {  3760,  674 },   /* america/st thomas */
+    {  7759,  212 },   /* chuuk */
+    {  1795,  674 },   /* curacao */
+    {  2478,  980 },   /* america/iqaluit */
+    {  2974,  410 },   /* america/montevideo */
+    {  2993,  980 },   /* america/montreal */
+    {   460, 1285 },   /* africa/kinshasa */
+    {  6765,  721 },   /* europe/ljubljana */
+    {  3819,  781 },   /* america/tegucigalpa */
+    {  1467, 1155 },   /* america/boise */
+    {   483, 1285 },   /* lagos */
+    {  3010,  674 },   /* america/montserrat */
+    {  1398,  781 },   /* america/belize */
+    {  1860, 1155 },   /* america/denver */
+    {   565, 1285 },   /* africa/malabo */
+    {  6835,  721 },   /* malta */
+    {  2808,  786 },   /* matamoros */
+    {  1235,  410 },   /* tucuman */
+    {  3569,  410 },   /* santarem */
+    {  1475, 1155 },   /* boise */
+    {  5028, 1238 },   /* manila */
+    {  4632,  109 },   /* asia/dushanbe */
+    {  1375,  674 },   /* barbados */
+    {  5065,  138 },   /* novokuznetsk */
+    {  1108,  410 },   /* america/argentina/rio gallegos */
+    {  8504,  721 },   /* the hague */
+    {  1317, 1045 },   /* america/atka */
+    {  5115,  138 },   /* asia/phnom penh */
+    {  2948,  679 },   /* moncton */
+    {  7390,  817 },   /* indian/antananarivo */
+    {  2758,  444 },   /* manaus */
+    {  5257,  109 },   /* samarkand */
+    {  2360,  786 },   /* tell city */
+    {  1524,  444 },   /* america/campo grande */
+    {  7722,  221 },   /* bougainville */
+    {  2209,  754 },   /* america/havana */
+    {  4423,   75 },   /* baku */
+    {  2911,  781 },   /* mexico city */
+    {  5834,  620 },   /* australia/act */
+    {  3473,  781 },   /* america/regina */
+    {  2193,  679 },   /* america/halifax */
+    {  7126,  916 },   /* tallinn */
+    {   972,  410 },   /* america/argentina/comodrivadavia */
+    {  4796, 1096 },   /* jerusalem */
+    {  2150,  781 },   /* guatemala */
+    {  4479,  159 },   /* asia/brunei */
+    {  7692,  315 },   /* apia */
+    {  5592,   75 },   /* asia/yerevan */
+    {  6319,  721 },   /* cologne */
+    {  5312,  221 },   /* srednekolymsk */
+    {  5655, 1291 },   /* canary */
+    {  2619,  674 },   /* kralendijk */
+    {  2653,  483 },   /* lima */
+    {  7648,  721 },   /* naples */
+    {  2224, 1150 },   /* america/hermosillo */
+    {  4097,  620 },   /* macquarie */
+    {  5638,  679 },   /* bermuda */
+    {  4255,  721 },   /* antwerp */
+    {  5707, 1291 },   /* faroe */
+    {  2877,  781 },   /* merida */
+    {  1352,  781 },   /* bahia banderas */
+    {  5848,  581 },   /* australia/adelaide */
+    {  3524,  410 },   /* america/rosario */
+    {  7634, 1123 },   /* mumbai */
+    {  7254, 1144 },   /* europe/volgograd */
+    {  4136, 1204 },   /* mcmurdo */
+    {  2471, 1155 },   /* inuvik */
+    {  2392,  980 },   /* america/indiana/vincennes */
+    {  8553,  721 },   /* wien */
+    {  2859,  786 },   /* menominee */
+    {  3230,  975 },   /* panama */
+    {  7278,  721 },   /* warsaw */
+    {  8477,  721 },   /* seville */
+    {  2217,  754 },   /* havana */
+    {  7570,  916 },   /* kiev */
+    {  3681,  649 },   /* sitka */
+    {  4832, 1232 },   /* asia/karachi */
+    {  5177,  109 },   /* qostanay */
+    {  2539,  980 },   /* america/kentucky/louisville */
+    {  7836,  306 },   /* fiji */
+    {   895,  410 },   /* america/araguaina */
+    {  6018,  612 },   /* lindeman */
+    {  6167,  620 },   /* australia/tasmania */
+    {  4418,   75 },   /* asia/baku */
+    {  2317,  980 },   /* america/indiana/petersburg */
+    {  4750,   54 },   /* asia/istanbul */
+    {  8349,  306 },   /* wake */
+    {   125, 1003 },   /* banjul */
+    {  5474,  159 },   /* asia/ulan bator */
+    {  1780,  444 },   /* cuiaba */
+    {  1338,  410 },   /* bahia */
+    {  8074,  306 },   /* pacific/nauru */
+    {   307, 1285 },   /* africa/douala */
+    {  4144,  410 },   /* antarctica/palmer */
+    {  7492,   75 },   /* mahe */
+    {  4591,   54 },   /* damascus */
+    {  5713,  721 },   /* atlantic/jan mayen */
+    {  3797,  781 },   /* america/swift current */
+    {  2178,  444 },   /* america/guyana */
+    {  4949,  159 },   /* asia/kuching */
+    {  3687,  674 },   /* america/st barthelemy */
+    {  4173,  410 },   /* rothera */
+    {  6524,  721 },   /* budapest */
+    {  2201,  679 },   /* halifax */
+    {  4990,  748 },   /* macau */
+    {  2727,  410 },   /* maceio */
+    {   931,  410 },   /* buenos aires */
+    {  4887,  167 },   /* asia/khandyga */
+    {  2494,  975 },   /* america/jamaica */
+    {  7982,  324 },   /* kiritimati */
+    {  2940,  679 },   /* america/moncton */
+    {  8034,  306 },   /* majuro */
+    {  4433,  138 },   /* bangkok */
+    {  1659, 1155 },   /* america/ciudad juarez */
+    {   153,  709 },   /* blantyre */
+    {   913,  410 },   /* america/argentina/buenos aires */
+    {  3881, 1244 },   /* tijuana */
+    {  7773,  497 },   /* easter */
+    {  6008,  612 },   /* australia/lindeman */
+    {  4214,   54 },   /* syowa */
+    {   403,  709 },   /* africa/juba */
+    {  5272, 1138 },   /* seoul */
+    {  7148,  860 },   /* europe/tiraspol */
+    {  7920,  809 },   /* guam */
+    {  3417,  786 },   /* america/rainy river */
+    {  3973,  786 },   /* america/winnipeg */
+    {  3098,  371 },   /* noronha */
+    {  3734,  674 },   /* st kitts */
+    {  5278,  748 },   /* asia/shanghai */
+    {  5219,   54 },   /* riyadh */
+    {  8514,  721 },   /* toulouse */
+    {  7876,  548 },   /* pacific/gambier */
+    {   718, 1003 },   /* africa/ouagadougou */
+    {  7671, 1132 },   /* osaka */
+    {  6739,  916 },   /* europe/kyiv */
+    {   229,  721 },   /* africa/ceuta */
+    {  7575,  721 },   /* krakow */
+    {  1719,  781 },   /* america/costa rica */
+    {  4086,  620 },   /* antarctica/macquarie */
+    {  4700,  138 },   /* ho chi minh */
+    {   831, 1045 },   /* america/adak */
+    {  4806,   62 },   /* asia/kabul */
+    {  3643,  378 },   /* scoresbysund */
+    {  3929, 1244 },   /* vancouver */
+    {  4901, 1123 },   /* asia/kolkata */
+    {  6507,  916 },   /* bucharest */
+    {  6473,  721 },   /* bratislava */
+    {  7285,  721 },   /* europe/zagreb */
+    {  6871,  721 },   /* europe/monaco */
+    {  5252,  109 },   /* asia/samarkand */
+    {  2923,  417 },   /* america/miquelon */
+    {  6772,  721 },   /* ljubljana */
+    {   139, 1003 },   /* bissau */
+    {  2333,  980 },   /* petersburg */
+    {  5927,  620 },   /* australia/currie */
+    {  5146, 1138 },   /* asia/pyongyang */
+    {  6621, 1008 },   /* guernsey */
+    {   586,  709 },   /* maputo */
+    {  4661,  829 },   /* asia/gaza */
+    {  3656, 1155 },   /* america/shiprock */
+    {  8088,  563 },   /* pacific/niue */
+    {  5646, 1291 },   /* atlantic/canary */
+    {  8354,  306 },   /* pacific/wallis */
+    {  5566,  117 },   /* yangon */
+    {  3617,  410 },   /* america/sao paulo */
+    {  7141,  721 },   /* tirane */
+    {  2719,  410 },   /* america/maceio */
+    {  1126,  410 },   /* rio gallegos */
+    {   725, 1003 },   /* ouagadougou */
+    {  7485,   75 },   /* indian/mahe */
+    {  8140, 1274 },   /* pago pago */
+    {  3155,  786 },   /* center */
+    {  4858,   96 },   /* asia/kathmandu */
+    {    97, 1003 },   /* bamako */
+    {  3847,  679 },   /* thule */
+    {  4769, 1317 },   /* jakarta */
+    {  5531,  212 },   /* asia/vladivostok */
+    {  8197,  221 },   /* pacific/ponape */
+    {  3437,  786 },   /* america/rankin inlet */
+    {  6549,  860 },   /* europe/chisinau */
+    {  4626,   75 },   /* dubai */
+    {  5172,  109 },   /* asia/qostanay */
+    {   646, 1003 },   /* monrovia */
+    {  8328,  212 },   /* pacific/truk */
+    {   430,  709 },   /* africa/khartoum */
+    {  6848,  916 },   /* mariehamn */
+    {  6107,  702 },   /* perth */
+    {  2931,  417 },   /* miquelon */
+    {   593, 1267 },   /* africa/maseru */
+    {   629,  817 },   /* mogadishu */
+    {  5095,  130 },   /* asia/omsk */
+    {  7794,  315 },   /* pacific/enderbury */
+    {  4288,   54 },   /* aden */
+    {   104, 1285 },   /* africa/bangui */
+    {  4837, 1232 },   /* karachi */
+    {  6646, 1008 },   /* europe/isle of man */
+    {  1277,  674 },   /* aruba */
+    {  7064, 1144 },   /* simferopol */
+    {  5292,  159 },   /* asia/singapore */
+    {  4567,   83 },   /* colombo */
+    {  5502,  212 },   /* asia/ust-nera */
+    {  4621,   75 },   /* asia/dubai */
+    {  3839,  679 },   /* america/thule */
+    {  4125, 1204 },   /* antarctica/mcmurdo */
+    {  4380,  109 },   /* asia/atyrau */
+    {  8125,  221 },   /* noumea */
+    {    15, 1003 },   /* africa/accra */
+    {  7705, 1204 },   /* auckland */
+    {  1452,  483 },   /* america/bogota */
+    {    62,  817 },   /* africa/asmara */
+    {  7299,  916 },   /* europe/zaporozhye */
+    {  6688, 1008 },   /* jersey */
+    {  7677,  980 },   /* ottawa */
+    {   249, 1003 },   /* conakry */
+    {  7537,  817 },   /* mayotte */
+    {  2956,  781 },   /* america/monterrey */
+    {   344, 1003 },   /* freetown */
+    {  7714,  221 },   /* pacific/bougainville */
+    {  5243,  221 },   /* sakhalin */
+    {  1208,  410 },   /* san luis */
+    {  4962,   54 },   /* asia/kuwait */
+    {  6421, 1008 },   /* europe/belfast */
+    {  2697,  674 },   /* america/lower princes */
+    {  5662,  333 },   /* atlantic/cape verde */
+    {  6814,  721 },   /* europe/madrid */
+    {  6241, 1123 },   /* bangalore */
+    {  2160,  483 },   /* america/guayaquil */
+    {  5120,  138 },   /* phnom penh */
+    {   771, 1003 },   /* africa/timbuktu */
+    {  1625,  786 },   /* america/chicago */
+    {  6733, 1144 },   /* kirov */
+    {  5131, 1317 },   /* asia/pontianak */
+    {  6365,  721 },   /* amsterdam */
+    {  5370,   41 },   /* tehran */
+    {   802,  715 },   /* africa/tunis */
+    {  3134,  786 },   /* america/north dakota/center */
+    {  3404,  410 },   /* punta arenas */
+    {  2826, 1150 },   /* mazatlan */
+    {  8082,  306 },   /* nauru */
+    {  5023, 1238 },   /* asia/manila */
+    {  1157,  410 },   /* salta */
+    {   762, 1003 },   /* sao tome */
+    {  6572,  721 },   /* copenhagen */
+    {  4505,  167 },   /* asia/chita */
+    {  7033,  721 },   /* sarajevo */
+    {  3029,  980 },   /* america/nassau */
+    {  3284, 1150 },   /* phoenix */
+    {  4037,  159 },   /* casey */
+    {  2142,  781 },   /* america/guatemala */
+    {  2044,  679 },   /* glace bay */
+    {  5954,  571 },   /* darwin */
+    {  8109,  230 },   /* norfolk */
+    {   169, 1285 },   /* brazzaville */
+    {    22, 1003 },   /* accra */
+    {   467, 1285 },   /* kinshasa */
+    {  4293,  109 },   /* asia/almaty */
+    {   298,  817 },   /* djibouti */
+    {  2168,  483 },   /* guayaquil */
+    {  5060,  138 },   /* asia/novokuznetsk */
+    {  5749, 1003 },   /* atlantic/reykjavik */
+    {  1560,  444 },   /* america/caracas */
+    {  5416, 1132 },   /* asia/tokyo */
+    {  1384,  410 },   /* america/belem */
+    {  7665,  916 },   /* odesa */
+    {  5391,  130 },   /* asia/thimbu */
+    {  1545,  975 },   /* america/cancun */
+    {  7441,  117 },   /* indian/cocos */
+    {  3905,  674 },   /* america/tortola */
+    {  4906, 1123 },   /* kolkata */
+    {  3127,  786 },   /* beulah */
+    {  7424,  138 },   /* indian/christmas */
+    {  3356,  444 },   /* america/porto velho */
+    {  6261,  721 },   /* basel */
+    {   453,  709 },   /* kigali */
+    {  3939,  674 },   /* america/virgin */
+    {  5014, 1329 },   /* makassar */
+    {  7942, 1039 },   /* pacific/johnston */
+    {  8158,  167 },   /* palau */
+    {  1300,  975 },   /* america/atikokan */
+    {   277,  817 },   /* dar es salaam */
+    {  8280,  555 },   /* pacific/tahiti */
+    {   162, 1285 },   /* africa/brazzaville */
+    {  7697, 1204 },   /* pacific/auckland */
+    {  2524,  649 },   /* america/juneau */
+    {  1261,  410 },   /* ushuaia */
+    {  7410,  130 },   /* indian/chagos */
+    {  4914,  138 },   /* asia/krasnoyarsk */
+    {  3257,  410 },   /* america/paramaribo */
+    {    54,  715 },   /* algiers */
+    {  6695,  823 },   /* europe/kaliningrad */
+    {  1217,  410 },   /* america/argentina/tucuman */
+    {  6782, 1008 },   /* europe/london */
+    {  3265,  410 },   /* paramaribo */
+    {   887,  674 },   /* antigua */
+    {  4586,   54 },   /* asia/damascus */
+    {  7912,  809 },   /* pacific/guam */
+    {  4060,  212 },   /* antarctica/dumontdurville */
+    {    28,  817 },   /* africa/addis ababa */
+    {  8026,  306 },   /* pacific/majuro */
+    {  1908, 1155 },   /* america/edmonton */
+    {  7603,  721 },   /* marseille */
+    {  1832, 1150 },   /* dawson */
+    {  4298,  109 },   /* almaty */
+    {  5800, 1003 },   /* st helena */
+    {  8523,  721 },   /* turin */
+    {  8533,  721 },   /* valencia */
+    {  4203,   54 },   /* antarctica/syowa */
+    {  4717, 1033 },   /* hong kong */
+    {   218,   33 },   /* casablanca */
+    {  3827,  781 },   /* tegucigalpa */
+    {  5698, 1291 },   /* atlantic/faroe */
+    {   787,  823 },   /* africa/tripoli */
+    {  6614, 1008 },   /* europe/guernsey */
+    {  8394, 1291 },   /* porto */
+    {  2611,  674 },   /* america/kralendijk */
+    {  4484,  159 },   /* brunei */
+    {  2186,  444 },   /* guyana */
+    {  2584,  980 },   /* monticello */
+    {  2705,  674 },   /* lower princes */
+    {  6933,  721 },   /* paris */
+    {  7684,  315 },   /* pacific/apia */
+    {   655,  817 },   /* africa/nairobi */
+    {  2800,  786 },   /* america/matamoros */
+    {  3962, 1150 },   /* whitehorse */
+    {  1576,  410 },   /* america/catamarca */
+    {  6556,  860 },   /* chisinau */
+    {  3384,  674 },   /* puerto rico */
+    {  1163,  410 },   /* america/argentina/san juan */
+    {  8059, 1274 },   /* pacific/midway */
+    {  6452,  721 },   /* europe/berlin */
+    {   257, 1003 },   /* africa/dakar */
+    {  2463, 1155 },   /* america/inuvik */
+    {  5166,   54 },   /* qatar */
+    {  5758, 1003 },   /* reykjavik */
+    {   558,  709 },   /* lusaka */
+    {  6350, 1280 },   /* etc/utc */
+    {  2532,  649 },   /* juneau */
+    {  6414,  916 },   /* athens */
+    {  6653, 1008 },   /* isle of man */
+    {  3743,  674 },   /* america/st lucia */
+    {  7102,  721 },   /* europe/stockholm */
+    {  6565,  721 },   /* europe/copenhagen */
+    {    76,  817 },   /* africa/asmera */
+    {  8016,  306 },   /* kwajalein */
+    {  4310,   54 },   /* amman */
+    {  3889,  980 },   /* america/toronto */
+    {  6828,  721 },   /* europe/malta */
+    {  4333,  109 },   /* aqtau */
+    {  2131,  674 },   /* guadeloupe */
+    {  3853,  980 },   /* america/thunder bay */
+    {  2272,  786 },   /* america/indiana/knox */
+    {  7232,  721 },   /* vienna */
+    {  4547,  748 },   /* asia/chungking */
+    {  6150,  620 },   /* australia/sydney */
+    {  4562,   83 },   /* asia/colombo */
+    {  3603,  674 },   /* santo domingo */
+    {  5009, 1329 },   /* asia/makassar */
+    {  4996,  221 },   /* asia/magadan */
+    {   662,  817 },   /* nairobi */
+    {  5343,  109 },   /* tashkent */
+    {  8233,  555 },   /* pacific/rarotonga */
+    {  8469, 1244 },   /* seattle */
+    {  8400,  721 },   /* rotterdam */
+    {  2773,  674 },   /* marigot */
+    {  7751,  212 },   /* pacific/chuuk */
+    {  2781,  674 },   /* america/martinique */
+    {  2658, 1244 },   /* america/los angeles */
+    {   146,  709 },   /* africa/blantyre */
+    {  4054,  138 },   /* davis */
+    {  6047,  620 },   /* australia/melbourne */
+    {  1100,  410 },   /* mendoza */
+    {  1667, 1155 },   /* ciudad juarez */
+    {  2026,  410 },   /* fortaleza */
+    {  6097,  702 },   /* australia/perth */
+    {  7239,  916 },   /* europe/vilnius */
+    {  7592, 1008 },   /* manchester */
+    {  1803, 1003 },   /* america/danmarkshavn */
+    {  4006, 1155 },   /* america/yellowknife */
+    {  8181,  221 },   /* pacific/pohnpei */
+    {  3466,  410 },   /* recife */
+    {   693, 1285 },   /* niamey */
+    {  1406,  781 },   /* belize */
+    {  4471,  130 },   /* bishkek */
+    {  1839, 1150 },   /* america/dawson creek */
+    {  5536,  212 },   /* vladivostok */
+    {  4863,   96 },   /* kathmandu */
+    {  7530,  817 },   /* indian/mayotte */
+    {  1610,  975 },   /* america/cayman */
+    {  6665,   54 },   /* europe/istanbul */
+    {  5110,  109 },   /* oral */
+    {  4237,  109 },   /* antarctica/vostok */
+    {  5613,  340 },   /* atlantic/azores */
+    {  6672,   54 },   /* istanbul */
+    {  6939,  721 },   /* europe/podgorica */
+    {  5201,  117 },   /* asia/rangoon */
+    {  1532,  444 },   /* campo grande */
+    {  6637,  916 },   /* helsinki */
+    {   526, 1285 },   /* luanda */
+    {  4344,  109 },   /* aqtobe */
+    {  8150,  167 },   /* pacific/palau */
+    {  1727,  781 },   /* costa rica */
+    {  7993,  221 },   /* pacific/kosrae */
+    {  6803,  721 },   /* luxembourg */
+    {  2070,  679 },   /* america/goose bay */
+    {  4651,  916 },   /* famagusta */
+    {  3990,  649 },   /* america/yakutat */
+    {  5365,   41 },   /* asia/tehran */
+    {  5810,  410 },   /* atlantic/stanley */
+    {  6726, 1144 },   /* europe/kirov */
+    {  3037,  980 },   /* nassau */
+    {  1811, 1003 },   /* danmarkshavn */
+    {  8041,  536 },   /* pacific/marquesas */
+    {  6821,  721 },   /* madrid */
+    {  3445,  786 },   /* rankin inlet */
+    {  6899,  916 },   /* europe/nicosia */
+    {  6358,  721 },   /* europe/amsterdam */
+    {   600, 1267 },   /* maseru */
+    {  8369,  212 },   /* pacific/yap */
+    {  4365,  109 },   /* asia/ashkhabad */
+    {  7641,  721 },   /* munich */
+    {  4919,  138 },   /* krasnoyarsk */
+    {  6914,  721 },   /* europe/oslo */
+    {  5151, 1138 },   /* pyongyang */
+    {  3162,  786 },   /* america/north dakota/new salem */
+    {   360,  709 },   /* gaborone */
+    {  4510,  167 },   /* chita */
+    {  7884,  548 },   /* gambier */
+    {  2964,  781 },   /* monterrey */
+    {  5777,  371 },   /* south georgia */
+    {  6956,  721 },   /* europe/prague */
+    {  4107,  109 },   /* antarctica/mawson */
+    {  8220,  212 },   /* port moresby */
+    {  3897,  980 },   /* toronto */
+    {  3090,  371 },   /* america/noronha */
+    {  7134,  721 },   /* europe/tirane */
+    {  1005,  410 },   /* america/argentina/cordoba */
+    {  1916, 1155 },   /* edmonton */
+    {  5886,  581 },   /* australia/broken hill */
+    {  7171,   75 },   /* ulyanovsk */
+    {  7933, 1039 },   /* honolulu */
+    {  7974,  324 },   /* pacific/kiritimati */
+    {  5867,  612 },   /* australia/brisbane */
+    {  5553,  167 },   /* yakutsk */
+    {  4873,   96 },   /* asia/katmandu */
+    {  6758, 1291 },   /* lisbon */
+    {  4954,  159 },   /* kuching */
+    {  4600,  130 },   /* asia/dhaka */
+    {  1181,  410 },   /* san juan */
+    {  3396,  410 },   /* america/punta arenas */
+    {   862,  674 },   /* america/anguilla */
+    {    90, 1003 },   /* africa/bamako */
+    {  3044,  980 },   /* america/new york */
+    {  8558,  721 },   /* wroclaw */
+    {  5971,  146 },   /* eucla */
+    {  1190,  410 },   /* america/argentina/san luis */
+    {  4491, 1123 },   /* asia/calcutta */
+    {   677, 1285 },   /* ndjamena */
+    {  5226,  138 },   /* asia/saigon */
+    {  5001,  221 },   /* magadan */
+    {  6382,  721 },   /* andorra */
+    {   962,  410 },   /* catamarca */
+    {  5671,  333 },   /* cape verde */
+    {  4732,  138 },   /* hovd */
+    {  8295,  306 },   /* pacific/tarawa */
+    {  5858,  581 },   /* adelaide */
+    {  6702,  823 },   /* kaliningrad */
+    {   205,  945 },   /* cairo */
+    {  5283,  748 },   /* shanghai */
+    {  6885, 1144 },   /* europe/moscow */
+    {  2638,  444 },   /* la paz */
+    {   737, 1285 },   /* africa/porto-novo */
+    {  7619,  721 },   /* milan */
+    {  4316,  306 },   /* asia/anadyr */
+    {  1987, 1150 },   /* fort nelson */
+    {   579,  709 },   /* africa/maputo */
+    {   264, 1003 },   /* dakar */
+    {  3717, 1178 },   /* st johns */
+    {  3505,  483 },   /* america/rio branco */
+    {  6604,  721 },   /* gibraltar */
+    {  3052,  980 },   /* new york */
+    {   337, 1003 },   /* africa/freetown */
+    {  2789,  674 },   /* martinique */
+    {  1824, 1150 },   /* america/dawson */
+    {  1962, 1244 },   /* america/ensenada */
+    {  7900,  221 },   /* guadalcanal */
+    {  1073,  410 },   /* la rioja */
+    {   132, 1003 },   /* africa/bissau */
+    {  7119,  916 },   /* europe/tallinn */
+    {   572, 1285 },   /* malabo */
+    {   390, 1267 },   /* johannesburg */
+    {  4967,   54 },   /* kuwait */
+    {  5377, 1096 },   /* asia/tel aviv */
+    {  1764, 1150 },   /* creston */
+    {  7001,   75 },   /* samara */
+    {  6926,  721 },   /* europe/paris */
+    {  1243,  410 },   /* america/argentina/ushuaia */
+    {  5307,  221 },   /* asia/srednekolymsk */
+    {  7210,  721 },   /* europe/vatican */
+    {  5548,  167 },   /* asia/yakutsk */
+    {  4575,  130 },   /* asia/dacca */
+    {  7959,  315 },   /* pacific/kanton */
+    {  5507,  212 },   /* ust-nera */
+    {  2115,  674 },   /* grenada */
+    {  2232, 1150 },   /* hermosillo */
+    {  3513,  483 },   /* rio branco */
+    {   794,  823 },   /* tripoli */
+    {  1023,  410 },   /* cordoba */
+    {  6340, 1008 },   /* edinburgh */
+    {  7324,  721 },   /* zurich */
+    {  8001,  221 },   /* kosrae */
+    {  8251,  809 },   /* pacific/saipan */
+    {  3276, 1150 },   /* america/phoenix */
+    {  2502,  975 },   /* jamaica */
+    {  2344,  786 },   /* america/indiana/tell city */
+    {  4683,  829 },   /* asia/hebron */
+    {  1392,  410 },   /* belem */
+    {  8460, 1244 },   /* san jose */
+    {  4405,   54 },   /* asia/bahrain */
+    {   383, 1267 },   /* africa/johannesburg */
+    {  7261, 1144 },   /* volgograd */
+    {  3193,  378 },   /* america/nuuk */
+    {   437,  709 },   /* khartoum */
+    {  6251,  721 },   /* barcelona */
+    {  2123,  674 },   /* america/guadeloupe */
+    {   376,  709 },   /* harare */
+    {  7341,  721 },   /* geneva */
+    {   476, 1285 },   /* africa/lagos */
+    {  5629,  679 },   /* atlantic/bermuda */
+    {  6466,  721 },   /* europe/bratislava */
+    {  6407,  916 },   /* europe/athens */
+    {   111, 1285 },   /* bangui */
+    {  6681, 1008 },   /* europe/jersey */
+    {  7374,  721 },   /* hamburg */
+    {  3488,  786 },   /* america/resolute */
+    {  4392,   54 },   /* asia/baghdad */
+    {  7089,  916 },   /* europe/sofia */
+    {  8241,  555 },   /* rarotonga */
+    {  6282,  721 },   /* bern */
+    {  5622,  340 },   /* azores */
+    {  2567,  980 },   /* america/kentucky/monticello */
+    {  5238,  221 },   /* asia/sakhalin */
+    {  4688,  829 },   /* hebron */
+    {  6989,  721 },   /* rome */
+    {  6946,  721 },   /* podgorica */
+    {   551,  709 },   /* africa/lusaka */
+    {  2408,  980 },   /* vincennes */
+    {  7743,  261 },   /* chatham */
+    {  5521,  138 },   /* vientiane */
+    {  8259,  809 },   /* saipan */
+    {  6310,  620 },   /* canberra */
+    {  3981,  786 },   /* winnipeg */
+    {  7348,  721 },   /* gothenburg */
+    {  1925,  483 },   /* america/eirunepe */
+    {  7820,  315 },   /* fakaofo */
+    {  2510,  410 },   /* america/jujuy */
+    {  8101,  230 },   /* pacific/norfolk */
+    {  6746,  916 },   /* kyiv */
+    {   879,  674 },   /* america/antigua */
+    {  2434,  980 },   /* winamac */
+    {  3786,  674 },   /* st vincent */
+    {  6186,  620 },   /* australia/victoria */
+    {  2078,  679 },   /* goose bay */
+    {  2982,  410 },   /* montevideo */
+    {  3921, 1244 },   /* america/vancouver */
+    {  4516,  159 },   /* asia/choibalsan */
+    {  7109,  721 },   /* stockholm */
+    {  7082,  721 },   /* skopje */
+    {  2869,  781 },   /* america/merida */
+    {  4936,  159 },   /* kuala lumpur */
+    {  3751,  674 },   /* st lucia */
+    {  5732, 1291 },   /* atlantic/madeira */
+    {  4339,  109 },   /* asia/aqtobe */
+    {  6977,  916 },   /* riga */
+    {  8529, 1280 },   /* utc */
+    {  8172,  529 },   /* pitcairn */
+    {  1703,  410 },   /* america/cordoba */
+    {  5297,  159 },   /* singapore */
+    {  1746,  410 },   /* coyhaique */
+    {  6491,  721 },   /* brussels */
+    {  4328,  109 },   /* asia/aqtau */
+    {   670, 1285 },   /* africa/ndjamena */
+    {  5421, 1132 },   /* tokyo */
+    {  1283,  410 },   /* america/asuncion */
+    {  6113,  612 },   /* australia/queensland */
+    {  4248,  109 },   /* vostok */
+    {  5741, 1291 },   /* madeira */
+    {  4777, 1323 },   /* asia/jayapura */
+    {  2054,  378 },   /* america/godthab */
+    {  7217,  721 },   /* vatican */
+    {  4532,  748 },   /* asia/chongqing */
+    {   181,  709 },   /* africa/bujumbura */
+    {  4811,   62 },   /* kabul */
+    {  1269,  674 },   /* america/aruba */
+    {  2370,  980 },   /* america/indiana/vevay */
+    {  4454,  887 },   /* asia/beirut */
+    {  4305,   54 },   /* asia/amman */
+    {  4892,  167 },   /* khandyga */
+    {  8049,  536 },   /* marquesas */
+    {  4162,  410 },   /* antarctica/rothera */
+    {  8310,  315 },   /* pacific/tongatapu */
+    {  6027,  175 },   /* australia/lord howe */
+    {  2903,  781 },   /* america/mexico city */
+    {  6220,  581 },   /* australia/yancowinna */
+    {  5573,  109 },   /* asia/yekaterinburg */
+    {   686, 1285 },   /* africa/niamey */
+    {   744, 1285 },   /* porto-novo */
+    {  4428,  138 },   /* asia/bangkok */
+    {  1602,  410 },   /* cayenne */
+    {  3337,  483 },   /* america/porto acre */
+    {  7582,  721 },   /* linz */
+    {   822,  709 },   /* windhoek */
+    {  6500,  916 },   /* europe/bucharest */
+    {  1291,  410 },   /* asuncion */
+    {  4637,  109 },   /* dushanbe */
+    {  5495,  130 },   /* urumqi */
+    {  2259,  980 },   /* indianapolis */
+    {  3805,  781 },   /* swift current */
+    {  3625,  410 },   /* sao paulo */
+    {  3061,  980 },   /* america/nipigon */
+};
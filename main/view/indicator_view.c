@@ -6,6 +6,13 @@
 #include "indicator_util.h"
 #include "indicator_sensor.h"
 #include "indicator_mariadb.h"
+#include "indicator_influx.h"
+#include "indicator_store.h"
+#include "view_bind.h"
+#include "spsc_ring.h"
+
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
 
 #include "esp_wifi.h"
 #include <time.h>
@@ -15,6 +22,14 @@
 
 static const char *TAG = "view";
 
+/* Model events reach the LVGL task through this ring, drained before each
+ * frame; the event loop never takes the LVGL lock */
+#define VIEW_EVENT_RING_SIZE        (16 * 1024)
+#define VIEW_EVENT_STATS_PERIOD_US  (10 * 60 * 1000000LL)
+#define VIEW_EVENT_FULL_WAIT_MS     1000
+
+static spsc_ring_t __g_event_ring;
+
 /*****************************************************************/
 // Extended sensor panels - added to main sensor screen
 /*****************************************************************/
@@ -44,9 +59,6 @@ static lv_obj_t *btn_co = NULL;
 /* Sensor scroll container */
 static lv_obj_t *sensor_scroll_cont = NULL;
 
-/* Timer for updating extended sensor values */
-static lv_timer_t *sensor_ext_update_timer = NULL;
-
 /* Color definitions for sensor panels - harmonized palette */
 #define COLOR_TEMP_EXT 0xEEBF41  /* Warm yellow - matches original temp */
 #define COLOR_HUM_EXT  0x4EACE4  /* Blue - matches original humidity */
@@ -102,54 +114,43 @@ static lv_obj_t* create_sensor_panel(lv_obj_t *parent, const char *title,
     return panel;
 }
 
-static void sensor_ext_update_timer_cb(lv_timer_t *timer)
-{
-    struct view_data_sensor data;
-    if (indicator_sensor_get_data(&data) != 0) return;
-
-    char buf[32];
-
+/* Extended sensor labels and the fields they show */
+static struct view_bind sensor_ext_binds[] = {
     /* PM sensors */
-    if (lbl_pm1_0_data) {
-        snprintf(buf, sizeof(buf), "%.0f", data.pm1_0);
-        lv_label_set_text(lbl_pm1_0_data, buf);
-    }
-    if (lbl_pm2_5_data) {
-        snprintf(buf, sizeof(buf), "%.0f", data.pm2_5);
-        lv_label_set_text(lbl_pm2_5_data, buf);
-    }
-    if (lbl_pm10_data) {
-        snprintf(buf, sizeof(buf), "%.0f", data.pm10);
-        lv_label_set_text(lbl_pm10_data, buf);
-    }
-
+    VIEW_BIND_FLOAT(lbl_pm1_0_data,    struct view_data_sensor, pm1_0,              "%.0f"),
+    VIEW_BIND_FLOAT(lbl_pm2_5_data,    struct view_data_sensor, pm2_5,              "%.0f"),
+    VIEW_BIND_FLOAT(lbl_pm10_data,     struct view_data_sensor, pm10,               "%.0f"),
     /* External temp/humidity */
-    if (lbl_temp_ext_data) {
-        snprintf(buf, sizeof(buf), "%.1f", data.temp_external);
-        lv_label_set_text(lbl_temp_ext_data, buf);
-    }
-    if (lbl_hum_ext_data) {
-        snprintf(buf, sizeof(buf), "%.0f", data.humidity_external);
-        lv_label_set_text(lbl_hum_ext_data, buf);
-    }
-
+    VIEW_BIND_FLOAT(lbl_temp_ext_data, struct view_data_sensor, temp_external,      "%.1f"),
+    VIEW_BIND_FLOAT(lbl_hum_ext_data,  struct view_data_sensor, humidity_external,  "%.0f"),
     /* Gas sensors - ppm(eq) values */
-    if (lbl_no2_data) {
-        snprintf(buf, sizeof(buf), "%.2f", data.multigas_gm102b[0]);  /* 0.05-10 ppm range */
-        lv_label_set_text(lbl_no2_data, buf);
-    }
-    if (lbl_c2h5oh_data) {
-        snprintf(buf, sizeof(buf), "%.0f", data.multigas_gm302b[0]);  /* 10-500 ppm range */
-        lv_label_set_text(lbl_c2h5oh_data, buf);
-    }
-    if (lbl_voc_data) {
-        snprintf(buf, sizeof(buf), "%.0f", data.multigas_gm502b[0]);  /* 1-500 ppm range */
-        lv_label_set_text(lbl_voc_data, buf);
-    }
-    if (lbl_co_data) {
-        snprintf(buf, sizeof(buf), "%.0f", data.multigas_gm702b[0]);  /* 1-1000 ppm range */
-        lv_label_set_text(lbl_co_data, buf);
-    }
+    VIEW_BIND_FLOAT(lbl_no2_data,      struct view_data_sensor, multigas_gm102b[0], "%.2f"),  /* 0.05-10 ppm range */
+    VIEW_BIND_FLOAT(lbl_c2h5oh_data,   struct view_data_sensor, multigas_gm302b[0], "%.0f"),  /* 10-500 ppm range */
+    VIEW_BIND_FLOAT(lbl_voc_data,      struct view_data_sensor, multigas_gm502b[0], "%.0f"),  /* 1-500 ppm range */
+    VIEW_BIND_FLOAT(lbl_co_data,       struct view_data_sensor, multigas_gm702b[0], "%.0f"),  /* 1-1000 ppm range */
+};
+
+/* Main sensor screen labels */
+static struct view_bind sensor_main_binds[] = {
+    VIEW_BIND_FLOAT(ui_co2_data,        struct view_data_sensor, co2,               "%.0f"),
+    VIEW_BIND_FLOAT(ui_tvoc_data,       struct view_data_sensor, tvoc,              "%.0f"),
+    VIEW_BIND_FLOAT(ui_temp_data_2,     struct view_data_sensor, temp_internal,     "%.1f"),
+    VIEW_BIND_FLOAT(ui_humidity_data_2, struct view_data_sensor, humidity_internal, "%.0f"),
+};
+
+/* From the store, on the LVGL task once per frame when a shown field changed.
+ * Only labels whose text changes are set, an unchanged reading redraws nothing */
+static void sensor_store_cb(enum store_topic topic, uint32_t changed, const void *state, void *arg)
+{
+    view_bind_update(sensor_main_binds, sizeof(sensor_main_binds) / sizeof(sensor_main_binds[0]), state);
+    view_bind_update(sensor_ext_binds, sizeof(sensor_ext_binds) / sizeof(sensor_ext_binds[0]), state);
+}
+
+static void sensor_store_subscribe(void)
+{
+    uint32_t mask = view_bind_mask(sensor_main_binds, sizeof(sensor_main_binds) / sizeof(sensor_main_binds[0])) |
+                    view_bind_mask(sensor_ext_binds, sizeof(sensor_ext_binds) / sizeof(sensor_ext_binds[0]));
+    indicator_store_subscribe(STORE_TOPIC_SENSOR, mask, sensor_store_cb, NULL);
 }
 
 static void restyle_original_panel(lv_obj_t *panel)
@@ -418,9 +419,6 @@ static void extend_sensor_screen(void)
     lv_obj_set_pos(btn_co, col3, y_pos);
     lv_obj_add_event_cb(btn_co, sensor_co_click_cb, LV_EVENT_CLICKED, NULL);
 
-    /* Start update timer for extended sensors */
-    sensor_ext_update_timer = lv_timer_create(sensor_ext_update_timer_cb, 1000, NULL);
-
     ESP_LOGI(TAG, "Sensor screen: 11 panels in 4 rows, balanced layout");
 }
 
@@ -437,10 +435,11 @@ static lv_obj_t *ui_db_name_ta = NULL;
 static lv_obj_t *ui_db_table_ta = NULL;
 static lv_obj_t *ui_db_interval_ta = NULL;
 static lv_obj_t *ui_db_enabled_sw = NULL;
+static lv_obj_t *ui_db_tls_sw = NULL;
+static lv_obj_t *ui_db_pin_ta = NULL;
 static lv_obj_t *ui_db_status_lbl = NULL;
 static lv_obj_t *ui_db_last_export_lbl = NULL;
 static lv_obj_t *ui_db_keyboard = NULL;
-static lv_timer_t *ui_db_status_update_timer = NULL;
 
 #define COLOR_DATABASE  0x9370DB  /* Medium purple */
 
@@ -464,14 +463,17 @@ static void db_save_click_cb(lv_event_t *e)
         const char *dbname = lv_textarea_get_text(ui_db_name_ta);
         const char *table = lv_textarea_get_text(ui_db_table_ta);
         const char *interval_str = lv_textarea_get_text(ui_db_interval_ta);
+        const char *pin = lv_textarea_get_text(ui_db_pin_ta);
 
         memset(&config, 0, sizeof(config));
         config.enabled = lv_obj_has_state(ui_db_enabled_sw, LV_STATE_CHECKED);
+        config.tls = lv_obj_has_state(ui_db_tls_sw, LV_STATE_CHECKED);
         strncpy(config.host, host, sizeof(config.host) - 1);
         strncpy(config.user, user, sizeof(config.user) - 1);
         strncpy(config.password, pass, sizeof(config.password) - 1);
         strncpy(config.database, dbname, sizeof(config.database) - 1);
         strncpy(config.table, table, sizeof(config.table) - 1);
+        strncpy(config.tls_pin, pin, sizeof(config.tls_pin) - 1);
         config.port = atoi(port_str);
         config.interval_minutes = atoi(interval_str);
 
@@ -480,7 +482,11 @@ static void db_save_click_cb(lv_event_t *e)
         if (strlen(config.table) == 0) strncpy(config.table, "sensor_data", sizeof(config.table) - 1);
         if (strlen(config.database) == 0) strncpy(config.database, "sensors", sizeof(config.database) - 1);
 
-        indicator_mariadb_set_config(&config);
+        if (indicator_mariadb_set_config(&config) == -2) {
+            lv_label_set_text(ui_db_status_lbl, "Certificate SHA-256: 64 hex digits");
+            lv_obj_set_style_text_color(ui_db_status_lbl, lv_color_hex(0xFF4444), 0);
+            return;
+        }
 
         lv_label_set_text(ui_db_status_lbl, "Config saved!");
         lv_obj_set_style_text_color(ui_db_status_lbl, lv_color_hex(0x00FF00), 0);
@@ -489,50 +495,44 @@ static void db_save_click_cb(lv_event_t *e)
     }
 }
 
-static lv_timer_t *db_test_timer = NULL;
-static int db_test_timeout_counter = 0;
+static bool db_test_running = false;
 
-static void db_test_timer_cb(lv_timer_t *timer)
+/* Progress and result of a test, from STORE_TOPIC_DB_STATUS */
+static void db_test_status_show(const struct view_data_db_status *st)
 {
-    int status = indicator_mariadb_get_last_status();
-
-    db_test_timeout_counter++;
-
-    /* Timeout after 30 seconds (150 * 200ms) */
-    if (db_test_timeout_counter > 150) {
-        lv_timer_del(db_test_timer);
-        db_test_timer = NULL;
-        lv_label_set_text(ui_db_status_lbl, "Timeout - check logs");
-        lv_obj_set_style_text_color(ui_db_status_lbl, lv_color_hex(0xFF4444), 0);
-        return;
-    }
-
-    if (status == -99) {
-        /* Still pending, keep waiting */
-        int dots = db_test_timeout_counter % 4;
-        const char *msgs[] = {"Testing", "Testing.", "Testing..", "Testing..."};
-        lv_label_set_text(ui_db_status_lbl, msgs[dots]);
+    if (!db_test_running || ui_db_status_lbl == NULL) return;
+
+    if (st->status == -99) {
+        const char *msg = "Testing...";
+        switch (st->phase) {
+            case DB_PHASE_RESOLVE:   msg = "Resolving host..."; break;
+            case DB_PHASE_CONNECT:   msg = "Connecting..."; break;
+            case DB_PHASE_HANDSHAKE: msg = "Logging in..."; break;
+            case DB_PHASE_QUERY:     msg = "Sending data..."; break;
+        }
+        lv_label_set_text(ui_db_status_lbl, msg);
         return;
     }
 
-    /* Test complete, stop timer */
-    lv_timer_del(db_test_timer);
-    db_test_timer = NULL;
+    /* Test complete */
+    db_test_running = false;
 
-    if (status == 0) {
+    if (st->status == 0) {
         lv_label_set_text(ui_db_status_lbl, "OK! Data exported");
         lv_obj_set_style_text_color(ui_db_status_lbl, lv_color_hex(0x00FF00), 0);
     } else {
         char buf[48];
         const char *err_msg = "Unknown error";
-        switch (status) {
+        switch (st->status) {
             case -1: err_msg = "Not configured"; break;
             case -2: err_msg = "Sensor/memory error"; break;
             case -3: err_msg = "Connection failed"; break;
             case -4: err_msg = "Query failed"; break;
             case -5: err_msg = "Timeout"; break;
+            case -6: err_msg = "Cancelled"; break;
+            case -7: err_msg = "Certificate not trusted"; break;
         }
-        snprintf(buf, sizeof(buf), "Error %d: %s", status, err_msg);
+        snprintf(buf, sizeof(buf), "Error %d: %s", st->status, err_msg);
         lv_label_set_text(ui_db_status_lbl, buf);
         lv_obj_set_style_text_color(ui_db_status_lbl, lv_color_hex(0xFF4444), 0);
     }
@@ -541,10 +541,11 @@ static void db_test_timer_cb(lv_timer_t *timer)
 static void db_test_click_cb(lv_event_t *e)
 {
     if (lv_event_get_code(e) == LV_EVENT_CLICKED) {
-        /* Stop any existing timer */
-        if (db_test_timer) {
-            lv_timer_del(db_test_timer);
-            db_test_timer = NULL;
+        /* A second click while testing cancels */
+        if (db_test_running) {
+            indicator_mariadb_cancel();
+            lv_label_set_text(ui_db_status_lbl, "Cancelling...");
+            return;
         }
 
         /* First save current config */
@@ -553,19 +554,14 @@ static void db_test_click_cb(lv_event_t *e)
         lv_label_set_text(ui_db_status_lbl, "Testing...");
         lv_obj_set_style_text_color(ui_db_status_lbl, lv_color_hex(0xFFFF00), 0);
 
-        /* Reset timeout counter */
-        db_test_timeout_counter = 0;
-
-        /* Trigger async test */
+        /* Trigger async test, the result arrives as STORE_TOPIC_DB_STATUS */
         int ret = indicator_mariadb_test_connection();
         if (ret < 0) {
             lv_label_set_text(ui_db_status_lbl, "Error: Task not running");
             lv_obj_set_style_text_color(ui_db_status_lbl, lv_color_hex(0xFF4444), 0);
             return;
         }
-
-        /* Start timer to check result */
-        db_test_timer = lv_timer_create(db_test_timer_cb, 200, NULL);
+        db_test_running = true;
     }
 }
 
@@ -587,42 +583,322 @@ static void db_ta_focus_cb(lv_event_t *e)
     }
 }
 
-static void db_status_update_timer_cb(lv_timer_t *timer)
+/* "Last Export" from the published status. Redrawn when the status
+ * changes and on each wall-clock minute, so "ago" is in minutes */
+static void db_last_export_show(void)
 {
-    if (ui_db_last_export_lbl == NULL) return;
+    struct view_data_db_status st;
+    time_t now;
 
-    time_t last_export = indicator_mariadb_get_last_export_time();
-    int last_status = indicator_mariadb_get_last_status();
+    if (ui_db_last_export_lbl == NULL) return;
 
-    if (last_export == 0) {
+    if (indicator_store_get(STORE_TOPIC_DB_STATUS, &st, sizeof(st)) == 0 || st.last_export == 0) {
         lv_label_set_text(ui_db_last_export_lbl, "Last Export: Never");
         lv_obj_set_style_text_color(ui_db_last_export_lbl, lv_color_hex(0x888888), 0);
+        return;
+    }
+
+    time(&now);
+    int seconds_ago = (int)(now - st.last_export);
+
+    char buf[64];
+    if (seconds_ago < 60) {
+        snprintf(buf, sizeof(buf), "Last Export: just now");
+    } else if (seconds_ago < 3600) {
+        snprintf(buf, sizeof(buf), "Last Export: %dm ago", seconds_ago / 60);
     } else {
-        time_t now;
-        time(&now);
-        int seconds_ago = (int)(now - last_export);
-
-        char buf[64];
-        if (seconds_ago < 60) {
-            snprintf(buf, sizeof(buf), "Last Export: %ds ago", seconds_ago);
-        } else if (seconds_ago < 3600) {
-            snprintf(buf, sizeof(buf), "Last Export: %dm ago", seconds_ago / 60);
-        } else {
-            snprintf(buf, sizeof(buf), "Last Export: %dh %dm ago",
-                     seconds_ago / 3600, (seconds_ago % 3600) / 60);
+        snprintf(buf, sizeof(buf), "Last Export: %dh %dm ago",
+                 seconds_ago / 3600, (seconds_ago % 3600) / 60);
+    }
+
+    if (st.status == 0) {
+        strncat(buf, " - OK", sizeof(buf) - strlen(buf) - 1);
+        lv_obj_set_style_text_color(ui_db_last_export_lbl, lv_color_hex(0x00FF00), 0);
+    } else if (st.status == -99) {
+        strncat(buf, " - Running...", sizeof(buf) - strlen(buf) - 1);
+        lv_obj_set_style_text_color(ui_db_last_export_lbl, lv_color_hex(0xFFFF00), 0);
+    } else {
+        strncat(buf, " - Failed", sizeof(buf) - strlen(buf) - 1);
+        lv_obj_set_style_text_color(ui_db_last_export_lbl, lv_color_hex(0xFF4444), 0);
+    }
+    lv_label_set_text(ui_db_last_export_lbl, buf);
+}
+
+static void db_store_cb(enum store_topic topic, uint32_t changed, const void *state, void *arg)
+{
+    if (topic == STORE_TOPIC_DB_STATUS) {
+        db_test_status_show(state);
+    }
+    db_last_export_show();
+}
+
+/*****************************************************************/
+// InfluxDB Settings Screen (HTTP write and UDP), opened from the database screen
+/*****************************************************************/
+
+static lv_obj_t *ui_screen_influx = NULL;
+static lv_obj_t *ui_ifx_enabled_sw = NULL;
+static lv_obj_t *ui_ifx_udp_sw = NULL;
+static lv_obj_t *ui_ifx_host_ta = NULL;
+static lv_obj_t *ui_ifx_port_ta = NULL;
+static lv_obj_t *ui_ifx_bucket_ta = NULL;
+static lv_obj_t *ui_ifx_org_ta = NULL;
+static lv_obj_t *ui_ifx_token_ta = NULL;
+static lv_obj_t *ui_ifx_meas_ta = NULL;
+static lv_obj_t *ui_ifx_udp_host_ta = NULL;
+static lv_obj_t *ui_ifx_udp_port_ta = NULL;
+static lv_obj_t *ui_ifx_status_lbl = NULL;
+static lv_obj_t *ui_ifx_keyboard = NULL;
+
+static void ifx_back_click_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) == LV_EVENT_CLICKED) {
+        _ui_screen_change(ui_screen_database, LV_SCR_LOAD_ANIM_OVER_RIGHT, 200, 0);
+    }
+}
+
+static void ifx_save_click_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) == LV_EVENT_CLICKED) {
+        struct influx_config config;
+        struct influx_udp_config udp;
+
+        /* The measurement name is shared by both sinks. Spaces and commas are
+         * escaped when points are built; a backslash or a leading '#' cannot be */
+        const char *measurement = lv_textarea_get_text(ui_ifx_meas_ta);
+        if (measurement[0] == '#' || strchr(measurement, '\\') != NULL) {
+            lv_label_set_text(ui_ifx_status_lbl, "Measurement: no '\\' and no leading '#'");
+            lv_obj_set_style_text_color(ui_ifx_status_lbl, lv_color_hex(0xFF4444), 0);
+            return;
         }
 
-        if (last_status == 0) {
-            strncat(buf, " - OK", sizeof(buf) - strlen(buf) - 1);
-            lv_obj_set_style_text_color(ui_db_last_export_lbl, lv_color_hex(0x00FF00), 0);
-        } else if (last_status == -99) {
-            strncat(buf, " - Running...", sizeof(buf) - strlen(buf) - 1);
-            lv_obj_set_style_text_color(ui_db_last_export_lbl, lv_color_hex(0xFFFF00), 0);
-        } else {
-            strncat(buf, " - Failed", sizeof(buf) - strlen(buf) - 1);
-            lv_obj_set_style_text_color(ui_db_last_export_lbl, lv_color_hex(0xFF4444), 0);
+        memset(&config, 0, sizeof(config));
+        config.enabled = lv_obj_has_state(ui_ifx_enabled_sw, LV_STATE_CHECKED);
+        strncpy(config.host, lv_textarea_get_text(ui_ifx_host_ta), sizeof(config.host) - 1);
+        strncpy(config.bucket, lv_textarea_get_text(ui_ifx_bucket_ta), sizeof(config.bucket) - 1);
+        strncpy(config.org, lv_textarea_get_text(ui_ifx_org_ta), sizeof(config.org) - 1);
+        strncpy(config.token, lv_textarea_get_text(ui_ifx_token_ta), sizeof(config.token) - 1);
+        strncpy(config.measurement, measurement, sizeof(config.measurement) - 1);
+        config.port = atoi(lv_textarea_get_text(ui_ifx_port_ta));
+
+        memset(&udp, 0, sizeof(udp));
+        udp.enabled = lv_obj_has_state(ui_ifx_udp_sw, LV_STATE_CHECKED);
+        strncpy(udp.host, lv_textarea_get_text(ui_ifx_udp_host_ta), sizeof(udp.host) - 1);
+        strncpy(udp.measurement, measurement, sizeof(udp.measurement) - 1);
+        udp.port = atoi(lv_textarea_get_text(ui_ifx_udp_port_ta));
+
+        if (config.port == 0) config.port = 8086;
+        if (udp.port == 0) udp.port = 8089;
+        if (strlen(config.bucket) == 0) strncpy(config.bucket, "sensors", sizeof(config.bucket) - 1);
+        if (strlen(config.measurement) == 0) {
+            strncpy(config.measurement, "indicator", sizeof(config.measurement) - 1);
+            strncpy(udp.measurement, "indicator", sizeof(udp.measurement) - 1);
+        }
+
+        if (indicator_influx_set_config(&config) != 0 || indicator_influx_udp_set_config(&udp) != 0) {
+            lv_label_set_text(ui_ifx_status_lbl, "Save failed");
+            lv_obj_set_style_text_color(ui_ifx_status_lbl, lv_color_hex(0xFF4444), 0);
+            return;
+        }
+
+        lv_label_set_text(ui_ifx_status_lbl, "Config saved! Sent with the next export");
+        lv_obj_set_style_text_color(ui_ifx_status_lbl, lv_color_hex(0x00FF00), 0);
+        ESP_LOGI(TAG, "InfluxDB config saved: http=%d %s:%d bucket=%s, udp=%d %s:%d",
+                 config.enabled, config.host, config.port, config.bucket, udp.enabled, udp.host, udp.port);
+    }
+}
+
+static void ifx_ta_focus_cb(lv_event_t *e)
+{
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t *ta = lv_event_get_target(e);
+
+    if (code == LV_EVENT_FOCUSED) {
+        if (ui_ifx_keyboard == NULL) {
+            ui_ifx_keyboard = lv_keyboard_create(ui_screen_influx);
+        }
+        lv_keyboard_set_textarea(ui_ifx_keyboard, ta);
+        lv_obj_clear_flag(ui_ifx_keyboard, LV_OBJ_FLAG_HIDDEN);
+    } else if (code == LV_EVENT_DEFOCUSED) {
+        if (ui_ifx_keyboard) {
+            lv_obj_add_flag(ui_ifx_keyboard, LV_OBJ_FLAG_HIDDEN);
+        }
+    }
+}
+
+/* Label above a one-line text field */
+static lv_obj_t *ifx_field_create(lv_obj_t *parent, const char *label, const char *placeholder,
+                                  int x, int y, int w)
+{
+    lv_obj_t *lbl = lv_label_create(parent);
+    lv_label_set_text(lbl, label);
+    lv_obj_set_style_text_font(lbl, &lv_font_montserrat_14, 0);
+    lv_obj_set_style_text_color(lbl, lv_color_hex(0xAAAAAA), 0);
+    lv_obj_set_pos(lbl, x, y);
+
+    lv_obj_t *ta = lv_textarea_create(parent);
+    lv_obj_set_size(ta, w, 36);
+    lv_obj_set_pos(ta, x, y + 18);
+    lv_textarea_set_placeholder_text(ta, placeholder);
+    lv_textarea_set_one_line(ta, true);
+    lv_obj_add_event_cb(ta, ifx_ta_focus_cb, LV_EVENT_ALL, NULL);
+    return ta;
+}
+
+static void create_influx_screen(void)
+{
+    ui_screen_influx = lv_obj_create(NULL);
+    lv_obj_set_size(ui_screen_influx, 480, 480);
+    lv_obj_set_style_bg_color(ui_screen_influx, lv_color_hex(0x1a1a2e), 0);
+
+    const int margin = 15;
+    const int content_width = 480 - (margin * 2);
+
+    /* Header bar */
+    lv_obj_t *header = lv_obj_create(ui_screen_influx);
+    lv_obj_set_size(header, 480, 50);
+    lv_obj_set_pos(header, 0, 0);
+    lv_obj_set_style_bg_color(header, lv_color_hex(0x252545), 0);
+    lv_obj_set_style_border_width(header, 0, 0);
+    lv_obj_set_style_radius(header, 0, 0);
+    lv_obj_set_style_pad_all(header, 0, 0);
+
+    lv_obj_t *back_btn = lv_btn_create(header);
+    lv_obj_set_size(back_btn, 80, 36);
+    lv_obj_set_pos(back_btn, margin, 7);
+    lv_obj_set_style_bg_color(back_btn, lv_color_hex(0x3a3a5a), 0);
+    lv_obj_t *back_lbl = lv_label_create(back_btn);
+    lv_label_set_text(back_lbl, LV_SYMBOL_LEFT " Back");
+    lv_obj_center(back_lbl);
+    lv_obj_add_event_cb(back_btn, ifx_back_click_cb, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t *title = lv_label_create(header);
+    lv_label_set_text(title, "InfluxDB Export");
+    lv_obj_set_style_text_font(title, &lv_font_montserrat_20, 0);
+    lv_obj_set_style_text_color(title, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_align(title, LV_ALIGN_CENTER, 30, 0);
+
+    /* Main content area, UDP rows below the buttons */
+    lv_obj_t *content = lv_obj_create(ui_screen_influx);
+    lv_obj_set_size(content, content_width, 340);
+    lv_obj_set_pos(content, margin, 60);
+    lv_obj_set_style_bg_color(content, lv_color_hex(0x222244), 0);
+    lv_obj_set_style_border_width(content, 1, 0);
+    lv_obj_set_style_border_color(content, lv_color_hex(0x3a3a5a), 0);
+    lv_obj_set_style_radius(content, 10, 0);
+    lv_obj_set_style_pad_all(content, 15, 0);
+    lv_obj_set_scroll_dir(content, LV_DIR_VER);
+
+    int y = 0;
+    int rs = 58;   /* Row spacing */
+    int field_w = content_width - 30;
+    int half_w = (field_w - 10) / 2;
+
+    /* Row 1: HTTP + UDP switches */
+    lv_obj_t *enable_lbl = lv_label_create(content);
+    lv_label_set_text(enable_lbl, "HTTP Write");
+    lv_obj_set_style_text_font(enable_lbl, &lv_font_montserrat_16, 0);
+    lv_obj_set_pos(enable_lbl, 0, 5);
+
+    ui_ifx_enabled_sw = lv_switch_create(content);
+    lv_obj_set_size(ui_ifx_enabled_sw, 50, 25);
+    lv_obj_set_pos(ui_ifx_enabled_sw, 130, 2);
+
+    lv_obj_t *udp_lbl = lv_label_create(content);
+    lv_label_set_text(udp_lbl, "UDP");
+    lv_obj_set_style_text_font(udp_lbl, &lv_font_montserrat_16, 0);
+    lv_obj_set_pos(udp_lbl, field_w - 130, 5);
+
+    ui_ifx_udp_sw = lv_switch_create(content);
+    lv_obj_set_size(ui_ifx_udp_sw, 50, 25);
+    lv_obj_set_pos(ui_ifx_udp_sw, field_w - 50, 2);
+    y += 50;
+
+    /* Row 2-4: HTTP server */
+    ui_ifx_host_ta = ifx_field_create(content, "Host", "hostname or IP", 0, y, field_w - 100);
+    ui_ifx_port_ta = ifx_field_create(content, "Port", "8086", field_w - 90, y, 90);
+    lv_textarea_set_accepted_chars(ui_ifx_port_ta, "0123456789");
+    y += rs;
+
+    ui_ifx_bucket_ta = ifx_field_create(content, "Bucket / Database", "sensors", 0, y, half_w);
+    ui_ifx_org_ta = ifx_field_create(content, "Org (v2)", "organization", (field_w + 10) / 2, y, half_w);
+    y += rs;
+
+    ui_ifx_token_ta = ifx_field_create(content, "Token (v2, empty for v1)", "API token", 0, y, field_w);
+    lv_textarea_set_password_mode(ui_ifx_token_ta, true);
+    lv_textarea_set_max_length(ui_ifx_token_ta, 95);
+    y += rs;
+
+    /* Row 5: Measurement + Save */
+    ui_ifx_meas_ta = ifx_field_create(content, "Measurement", "indicator", 0, y, half_w);
+
+    lv_obj_t *save_btn = lv_btn_create(content);
+    lv_obj_set_size(save_btn, 110, 40);
+    lv_obj_set_pos(save_btn, field_w - 110, y + 14);
+    lv_obj_set_style_bg_color(save_btn, lv_color_hex(0x529D53), 0);
+    lv_obj_t *save_lbl = lv_label_create(save_btn);
+    lv_label_set_text(save_lbl, LV_SYMBOL_SAVE " Save");
+    lv_obj_set_style_text_font(save_lbl, &lv_font_montserrat_16, 0);
+    lv_obj_center(save_lbl);
+    lv_obj_add_event_cb(save_btn, ifx_save_click_cb, LV_EVENT_CLICKED, NULL);
+    y += rs;
+
+    /* Row 6: UDP listener */
+    ui_ifx_udp_host_ta = ifx_field_create(content, "UDP Host", "hostname or IP", 0, y, field_w - 100);
+    ui_ifx_udp_port_ta = ifx_field_create(content, "UDP Port", "8089", field_w - 90, y, 90);
+    lv_textarea_set_accepted_chars(ui_ifx_udp_port_ta, "0123456789");
+
+    /* Status bar at bottom */
+    lv_obj_t *status_bar = lv_obj_create(ui_screen_influx);
+    lv_obj_set_size(status_bar, content_width, 60);
+    lv_obj_set_pos(status_bar, margin, 410);
+    lv_obj_set_style_bg_color(status_bar, lv_color_hex(0x202040), 0);
+    lv_obj_set_style_border_width(status_bar, 1, 0);
+    lv_obj_set_style_border_color(status_bar, lv_color_hex(0x3a3a5a), 0);
+    lv_obj_set_style_radius(status_bar, 10, 0);
+    lv_obj_set_style_pad_all(status_bar, 10, 0);
+
+    ui_ifx_status_lbl = lv_label_create(status_bar);
+    lv_label_set_text(ui_ifx_status_lbl, "Interval as set on the database screen");
+    lv_obj_set_style_text_font(ui_ifx_status_lbl, &lv_font_montserrat_14, 0);
+    lv_obj_set_style_text_color(ui_ifx_status_lbl, lv_color_hex(0x888888), 0);
+    lv_obj_set_pos(ui_ifx_status_lbl, 0, 0);
+
+    /* Load current config */
+    struct influx_config config;
+    struct influx_udp_config udp;
+    char buf[16];
+    if (indicator_influx_get_config(&config) == 0) {
+        if (config.enabled) {
+            lv_obj_add_state(ui_ifx_enabled_sw, LV_STATE_CHECKED);
         }
-        lv_label_set_text(ui_db_last_export_lbl, buf);
+        lv_textarea_set_text(ui_ifx_host_ta, config.host);
+        lv_textarea_set_text(ui_ifx_bucket_ta, config.bucket);
+        lv_textarea_set_text(ui_ifx_org_ta, config.org);
+        lv_textarea_set_text(ui_ifx_token_ta, config.token);
+        lv_textarea_set_text(ui_ifx_meas_ta, config.measurement);
+        snprintf(buf, sizeof(buf), "%d", config.port);
+        lv_textarea_set_text(ui_ifx_port_ta, buf);
+    }
+    if (indicator_influx_udp_get_config(&udp) == 0) {
+        if (udp.enabled) {
+            lv_obj_add_state(ui_ifx_udp_sw, LV_STATE_CHECKED);
+        }
+        lv_textarea_set_text(ui_ifx_udp_host_ta, udp.host);
+        snprintf(buf, sizeof(buf), "%d", udp.port);
+        lv_textarea_set_text(ui_ifx_udp_port_ta, buf);
+    }
+
+    ESP_LOGI(TAG, "InfluxDB settings screen created");
+}
+
+static void influx_settings_click_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) == LV_EVENT_CLICKED) {
+        if (ui_screen_influx == NULL) {
+            create_influx_screen();
+        }
+        _ui_screen_change(ui_screen_influx, LV_SCR_LOAD_ANIM_OVER_LEFT, 200, 0);
     }
 }
 
@@ -658,7 +934,16 @@ static void create_database_screen(void)
     lv_label_set_text(title, "Database Export");
     lv_obj_set_style_text_font(title, &lv_font_montserrat_20, 0);
     lv_obj_set_style_text_color(title, lv_color_hex(0xFFFFFF), 0);
-    lv_obj_align(title, LV_ALIGN_CENTER, 30, 0);
+    lv_obj_align(title, LV_ALIGN_CENTER, 0, 0);
+
+    lv_obj_t *influx_btn = lv_btn_create(header);
+    lv_obj_set_size(influx_btn, 80, 36);
+    lv_obj_set_pos(influx_btn, 480 - margin - 80, 7);
+    lv_obj_set_style_bg_color(influx_btn, lv_color_hex(0x3a3a5a), 0);
+    lv_obj_t *influx_lbl = lv_label_create(influx_btn);
+    lv_label_set_text(influx_lbl, "Influx " LV_SYMBOL_RIGHT);
+    lv_obj_center(influx_lbl);
+    lv_obj_add_event_cb(influx_btn, influx_settings_click_cb, LV_EVENT_CLICKED, NULL);
 
     /* Main content area */
     lv_obj_t *content = lv_obj_create(ui_screen_database);
@@ -669,14 +954,14 @@ static void create_database_screen(void)
     lv_obj_set_style_border_color(content, lv_color_hex(0x3a3a5a), 0);
     lv_obj_set_style_radius(content, 10, 0);
     lv_obj_set_style_pad_all(content, 15, 0);
-    lv_obj_clear_flag(content, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_scroll_dir(content, LV_DIR_VER);   /* the certificate row is below the buttons */
 
     int y = 0;
     int fh = 36;   /* Field height */
     int rs = 50;   /* Row spacing */
     int field_w = content_width - 30;  /* Full width minus padding */
 
-    /* Row 1: Enable switch */
+    /* Row 1: Enable + TLS switches */
     lv_obj_t *enable_lbl = lv_label_create(content);
     lv_label_set_text(enable_lbl, "Enable Export");
     lv_obj_set_style_text_font(enable_lbl, &lv_font_montserrat_16, 0);
@@ -684,7 +969,16 @@ static void create_database_screen(void)
 
     ui_db_enabled_sw = lv_switch_create(content);
     lv_obj_set_size(ui_db_enabled_sw, 50, 25);
-    lv_obj_set_pos(ui_db_enabled_sw, field_w - 50, y + 2);
+    lv_obj_set_pos(ui_db_enabled_sw, 130, y + 2);
+
+    lv_obj_t *tls_lbl = lv_label_create(content);
+    lv_label_set_text(tls_lbl, "Use TLS");
+    lv_obj_set_style_text_font(tls_lbl, &lv_font_montserrat_16, 0);
+    lv_obj_set_pos(tls_lbl, field_w - 130, y + 5);
+
+    ui_db_tls_sw = lv_switch_create(content);
+    lv_obj_set_size(ui_db_tls_sw, 50, 25);
+    lv_obj_set_pos(ui_db_tls_sw, field_w - 50, y + 2);
     y += rs;
 
     /* Row 2: Host + Port */
@@ -808,6 +1102,23 @@ static void create_database_screen(void)
     lv_obj_set_style_text_font(test_lbl, &lv_font_montserrat_16, 0);
     lv_obj_center(test_lbl);
     lv_obj_add_event_cb(test_btn, db_test_click_cb, LV_EVENT_CLICKED, NULL);
+    y += rs + 8;
+
+    /* Row 6: certificate pin, for a self-signed server */
+    lv_obj_t *pin_lbl = lv_label_create(content);
+    lv_label_set_text(pin_lbl, "TLS Certificate SHA-256 (self-signed server)");
+    lv_obj_set_style_text_font(pin_lbl, &lv_font_montserrat_14, 0);
+    lv_obj_set_style_text_color(pin_lbl, lv_color_hex(0xAAAAAA), 0);
+    lv_obj_set_pos(pin_lbl, 0, y);
+
+    ui_db_pin_ta = lv_textarea_create(content);
+    lv_obj_set_size(ui_db_pin_ta, field_w, fh);
+    lv_obj_set_pos(ui_db_pin_ta, 0, y + 18);
+    lv_textarea_set_placeholder_text(ui_db_pin_ta, "empty: CA bundle");
+    lv_textarea_set_one_line(ui_db_pin_ta, true);
+    lv_textarea_set_max_length(ui_db_pin_ta, 95);
+    lv_textarea_set_accepted_chars(ui_db_pin_ta, "0123456789abcdefABCDEF:");
+    lv_obj_add_event_cb(ui_db_pin_ta, db_ta_focus_cb, LV_EVENT_ALL, NULL);
 
     /* Status bar at bottom */
     lv_obj_t *status_bar = lv_obj_create(ui_screen_database);
@@ -831,17 +1142,15 @@ static void create_database_screen(void)
     lv_obj_set_style_text_color(ui_db_last_export_lbl, lv_color_hex(0x888888), 0);
     lv_obj_set_pos(ui_db_last_export_lbl, 0, 20);
 
-    /* Start status update timer */
-    if (ui_db_status_update_timer == NULL) {
-        ui_db_status_update_timer = lv_timer_create(db_status_update_timer_cb, 1000, NULL);
-    }
-
     /* Load current config */
     struct mariadb_config config;
     if (indicator_mariadb_get_config(&config) == 0) {
         if (config.enabled) {
             lv_obj_add_state(ui_db_enabled_sw, LV_STATE_CHECKED);
         }
+        if (config.tls) {
+            lv_obj_add_state(ui_db_tls_sw, LV_STATE_CHECKED);
+        }
         if (strlen(config.host) > 0) {
             lv_textarea_set_text(ui_db_host_ta, config.host);
         }
@@ -857,6 +1166,9 @@ static void create_database_screen(void)
         if (strlen(config.table) > 0) {
             lv_textarea_set_text(ui_db_table_ta, config.table);
         }
+        if (strlen(config.tls_pin) > 0) {
+            lv_textarea_set_text(ui_db_pin_ta, config.tls_pin);
+        }
         char buf[16];
         snprintf(buf, sizeof(buf), "%d", config.port);
         lv_textarea_set_text(ui_db_port_ta, buf);
@@ -864,8 +1176,8 @@ static void create_database_screen(void)
         lv_textarea_set_text(ui_db_interval_ta, buf);
     }
 
-    /* Trigger initial status update */
-    db_status_update_timer_cb(NULL);
+    /* Initial status, later ones come from the store */
+    db_last_export_show();
 
     ESP_LOGI(TAG, "Database settings screen created (480x480)");
 }
@@ -1243,6 +1555,24 @@ static lv_obj_t * ui_wifi_connect_ret;
 
 static char __g_cur_wifi_ssid[32];;
 
+/* Rows ui_wifi_list shows, so a new scan result only redraws what changed */
+struct wifi_list_row
+{
+    char   ssid[32];
+    bool   auth_mode;
+    int8_t rssi;
+    bool   is_connect;
+};
+static struct wifi_list_row __g_wifi_rows[WIFI_SCAN_LIST_SIZE + 1];
+static int __g_wifi_row_cnt = 0;
+
+/* Same on screen: the icon shows the signal level, not the RSSI */
+static bool __wifi_row_same(const struct wifi_list_row *a, const struct wifi_list_row *b)
+{
+    return strcmp(a->ssid, b->ssid) == 0 && a->auth_mode == b->auth_mode && a->is_connect == b->is_connect &&
+           wifi_rssi_level_get(a->rssi) == wifi_rssi_level_get(b->rssi);
+}
+
 static uint8_t password_ready = false;
 
 static void event_wifi_connect_cancel(lv_event_t * e)
@@ -1596,7 +1926,7 @@ static void event_wifi_details(lv_event_t * e)
     }
 }
 
-static void create_wifi_item(lv_obj_t * parent, const char *p_ssid, bool have_password, int rssi, bool is_connect)
+static lv_obj_t * create_wifi_item(lv_obj_t * parent, const char *p_ssid, bool have_password, int rssi, bool is_connect)
 {
     lv_obj_t * btn = lv_btn_create(parent);
     lv_obj_set_width(btn, 380);
@@ -1647,6 +1977,7 @@ static void create_wifi_item(lv_obj_t * parent, const char *p_ssid, bool have_pa
         lv_obj_set_align( wifi_lock_icon, LV_ALIGN_RIGHT_MID );
         lv_obj_set_x( wifi_lock_icon, -60 );
     }
+    return btn;
 }
 
 static void wifi_list_init(void)
@@ -1697,9 +2028,29 @@ void wifi_list_event_init(void)
 
 /***********************************************************************************************************/
 
-static void __view_event_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data)
+/* Payload size of the events the view shows, -1 for the ones it ignores */
+static int __view_event_size(int32_t id)
+{
+    switch (id)
+    {
+        case VIEW_EVENT_SCREEN_START:       return sizeof(uint8_t);
+        case VIEW_EVENT_TIME:               return sizeof(bool);
+        case VIEW_EVENT_TIME_CFG_UPDATE:    return sizeof(struct view_data_time_cfg);
+        case VIEW_EVENT_CITY:               return 32;
+        case VIEW_EVENT_DISPLAY_CFG:        return sizeof(struct view_data_display);
+        case VIEW_EVENT_WIFI_ST:            return sizeof(struct view_data_wifi_st);
+        case VIEW_EVENT_WIFI_LIST:          return sizeof(struct view_data_wifi_list);
+        case VIEW_EVENT_WIFI_CONNECT_RET:   return sizeof(struct view_data_wifi_connet_ret_msg);
+        case VIEW_EVENT_SENSOR_DATA_HISTORY: return sizeof(struct view_data_sensor_history_data);
+        case VIEW_EVENT_SCREEN_CTRL:        return sizeof(bool);
+        case VIEW_EVENT_FACTORY_RESET:      return 0;
+        default:                            return -1;
+    }
+}
+
+/* Runs on the LVGL task, from indicator_view_event_drain */
+static void __view_event_apply(int32_t id, void* event_data)
 {
-    lv_port_sem_take();
     switch (id)
     {
         case VIEW_EVENT_SCREEN_START: {
@@ -1875,7 +2226,10 @@ static void __view_event_handler(void* handler_args, esp_event_base_t base, int3
         case VIEW_EVENT_WIFI_LIST: {
             ESP_LOGI(TAG, "event: VIEW_DATA_WIFI_LIST");
 
-            wifi_list_init(); // clear and init
+            if( ui_wifi_list == NULL ) {
+                wifi_list_init();
+                __g_wifi_row_cnt = 0;
+            }
 
             lv_obj_clear_flag( ui_wifi_list, LV_OBJ_FLAG_HIDDEN );
             lv_obj_add_flag( ui_wifi_scan_wait, LV_OBJ_FLAG_HIDDEN );
@@ -1885,21 +2239,44 @@ static void __view_event_handler(void* handler_args, esp_event_base_t base, int3
                 break;
             }
             struct view_data_wifi_list *p_list = ( struct view_data_wifi_list *)event_data;
-            bool have_password = true;
-        
+            struct wifi_list_row rows[WIFI_SCAN_LIST_SIZE + 1];
+            int row_cnt = 0;
+
+            memset(rows, 0, sizeof(rows));
             if( p_list->is_connect) {
-                create_wifi_item(ui_wifi_list,  p_list->connect.ssid, p_list->connect.auth_mode, p_list->connect.ssid, true);
+                strncpy(rows[row_cnt].ssid, p_list->connect.ssid, sizeof(rows[row_cnt].ssid) - 1);
+                rows[row_cnt].auth_mode = p_list->connect.auth_mode;
+                rows[row_cnt].rssi = p_list->connect.rssi;
+                rows[row_cnt].is_connect = true;
+                row_cnt++;
             }
             for( int i = 0; i < p_list->cnt; i++ ) {
-                ESP_LOGI(TAG, "ssid:%s, rssi:%d, auth mode:%d", p_list->aps[i].ssid, p_list->aps[i].rssi, p_list->aps[i].auth_mode);
-                if( p_list->is_connect ) {
-                    if( strcmp(p_list->aps[i].ssid, p_list->connect.ssid)  != 0) {
-                        create_wifi_item(ui_wifi_list, p_list->aps[i].ssid, p_list->aps[i].auth_mode, p_list->aps[i].rssi, false);
-                    }
-                } else {
-                    create_wifi_item(ui_wifi_list, p_list->aps[i].ssid, p_list->aps[i].auth_mode, p_list->aps[i].rssi, false);
+                if( p_list->is_connect && strcmp(p_list->aps[i].ssid, p_list->connect.ssid) == 0 ) {
+                    continue;
                 }
+                strncpy(rows[row_cnt].ssid, p_list->aps[i].ssid, sizeof(rows[row_cnt].ssid) - 1);
+                rows[row_cnt].auth_mode = p_list->aps[i].auth_mode;
+                rows[row_cnt].rssi = p_list->aps[i].rssi;
+                row_cnt++;
             }
+
+            /* Redraw the rows that differ, in place, so the list keeps its scroll position */
+            for( int i = 0; i < row_cnt; i++ ) {
+                if( i < __g_wifi_row_cnt && __wifi_row_same(&rows[i], &__g_wifi_rows[i]) ) {
+                    continue;
+                }
+                if( i < __g_wifi_row_cnt ) {
+                    lv_obj_del(lv_obj_get_child(ui_wifi_list, i));
+                }
+                lv_obj_t *btn = create_wifi_item(ui_wifi_list, rows[i].ssid, rows[i].auth_mode,
+                                                 rows[i].rssi, rows[i].is_connect);
+                lv_obj_move_to_index(btn, i);
+            }
+            for( int i = __g_wifi_row_cnt - 1; i >= row_cnt; i-- ) {
+                lv_obj_del(lv_obj_get_child(ui_wifi_list, i));
+            }
+            memcpy(__g_wifi_rows, rows, sizeof(rows));
+            __g_wifi_row_cnt = row_cnt;
             break;
         }
         case VIEW_EVENT_WIFI_CONNECT_RET: {
@@ -1921,44 +2298,6 @@ static void __view_event_handler(void* handler_args, esp_event_base_t base, int3
             break;
         }
 
-        case VIEW_EVENT_SENSOR_DATA: {
-            ESP_LOGI(TAG, "event: VIEW_EVENT_SENSOR_DATA");
-            
-            struct view_data_sensor_data  *p_data = (struct view_data_sensor_data *) event_data;
-            char data_buf[32];
-
-            memset(data_buf, 0, sizeof(data_buf));
-            switch (p_data->sensor_type)
-            {
-                case SENSOR_DATA_CO2: {
-                    snprintf(data_buf, sizeof(data_buf), "%d", (int)p_data->vaule);
-                    ESP_LOGI(TAG, "update co2:%s", data_buf);
-                    lv_label_set_text(ui_co2_data, data_buf);
-                    break;
-                }
-                case SENSOR_DATA_TVOC: {
-                    snprintf(data_buf, sizeof(data_buf), "%d", (int)p_data->vaule);
-                    ESP_LOGI(TAG, "update tvoc:%s", data_buf);
-                    lv_label_set_text(ui_tvoc_data, data_buf);
-                    break;
-                }           
-                case SENSOR_DATA_TEMP: {
-                    snprintf(data_buf, sizeof(data_buf), "%.1f", p_data->vaule);
-                    ESP_LOGI(TAG, "update temp:%s", data_buf);
-                    lv_label_set_text(ui_temp_data_2, data_buf);
-                    break;
-                }
-                case SENSOR_DATA_HUMIDITY: {
-                    snprintf(data_buf, sizeof(data_buf), "%d",(int) p_data->vaule);
-                    ESP_LOGI(TAG, "update humidity:%s", data_buf);
-                    lv_label_set_text(ui_humidity_data_2, data_buf);
-                    break;
-                }
-            default:
-                break;
-            }
-            break;
-        }
         case VIEW_EVENT_SENSOR_DATA_HISTORY: {
             ESP_LOGI(TAG, "event: VIEW_EVENT_SENSOR_DATA_HISTORY");
             struct view_data_sensor_history_data  *p_data = (struct view_data_sensor_history_data *) event_data;
@@ -2074,13 +2413,89 @@ static void __view_event_handler(void* handler_args, esp_event_base_t base, int3
         default:
             break;
     }
-    lv_port_sem_give();
+}
+
+/* Time the event loop spends in the handler, microseconds: <10, <100,
+ * <1000, <10000, <100000 and longer */
+static uint32_t __g_event_block_hist[6];
+static int64_t  __g_event_block_max_us;
+static int64_t  __g_event_stats_since_us;
+static uint32_t __g_event_full_waits;
+
+static void __view_event_block_account(int64_t start_us)
+{
+    int64_t now_us = esp_timer_get_time();
+    int64_t us = now_us - start_us;
+    int bucket = 0;
+
+    for (int64_t limit = 10; bucket < 5 && us >= limit; limit *= 10) {
+        bucket++;
+    }
+    __g_event_block_hist[bucket]++;
+    if (us > __g_event_block_max_us) {
+        __g_event_block_max_us = us;
+    }
+
+    if (now_us - __g_event_stats_since_us >= VIEW_EVENT_STATS_PERIOD_US) {
+        ESP_LOGI(TAG, "Event handler blocking: <10us %lu, <100us %lu, <1ms %lu, <10ms %lu, <100ms %lu, more %lu, max %lld us, %lu waits for room",
+                 __g_event_block_hist[0], __g_event_block_hist[1], __g_event_block_hist[2],
+                 __g_event_block_hist[3], __g_event_block_hist[4], __g_event_block_hist[5],
+                 __g_event_block_max_us, __g_event_full_waits);
+        memset(__g_event_block_hist, 0, sizeof(__g_event_block_hist));
+        __g_event_block_max_us = 0;
+        __g_event_full_waits = 0;
+        __g_event_stats_since_us = now_us;
+    }
+}
+
+/* On the event loop task: copy the event for the LVGL task and return,
+ * never waiting for the LVGL lock or a frame to finish */
+static void __view_event_handler(void* handler_args, esp_event_base_t base, int32_t id, void* event_data)
+{
+    int64_t start_us = esp_timer_get_time();
+    int size = __view_event_size(id);
+
+    if (size < 0) {
+        return;
+    }
+    if (event_data == NULL) {
+        size = 0;
+    }
+    for (int waited = 0; spsc_ring_push(&__g_event_ring, (uint16_t)id, event_data, size) != 0; waited++) {
+        /* Full: the LVGL task is behind, let it catch up. Not forever, it
+         * may itself be waiting for room in this event loop's queue */
+        if (waited == pdMS_TO_TICKS(VIEW_EVENT_FULL_WAIT_MS)) {
+            ESP_LOGW(TAG, "Event %ld dropped, the LVGL task is not draining", id);
+            break;
+        }
+        __g_event_full_waits++;
+        vTaskDelay(1);
+    }
+    __view_event_block_account(start_us);
+}
+
+void indicator_view_event_drain(void)
+{
+    const void *data;
+    uint16_t id;
+    uint32_t len;
+
+    while ((data = spsc_ring_peek(&__g_event_ring, &id, &len)) != NULL) {
+        __view_event_apply(id, len ? (void *)data : NULL);
+        spsc_ring_pop(&__g_event_ring);
+    }
 }
 
 
 
 int indicator_view_init(void)
 {
+    /* Sized for a few chart histories, the largest events */
+    void *ring_buf = heap_caps_malloc(VIEW_EVENT_RING_SIZE, MALLOC_CAP_SPIRAM);
+    assert(ring_buf);
+    spsc_ring_init(&__g_event_ring, ring_buf, VIEW_EVENT_RING_SIZE);
+    __g_event_stats_since_us = esp_timer_get_time();
+
     ui_init();
 
     wifi_list_event_init();
@@ -2088,6 +2503,11 @@ int indicator_view_init(void)
     extend_sensor_screen();   /* Add extended sensors to main sensor screen */
     extend_settings_screen(); /* Add database settings to settings screen */
 
+    /* Model state the screens show, delivered by the LVGL task */
+    sensor_store_subscribe();
+    indicator_store_subscribe(STORE_TOPIC_DB_STATUS, STORE_ALL, db_store_cb, NULL);
+    indicator_store_subscribe(STORE_TOPIC_CLOCK, STORE_ALL, db_store_cb, NULL);
+
     int i  = 0;
     for( i = 0; i < VIEW_EVENT_ALL; i++ ) {
         ESP_ERROR_CHECK(esp_event_handler_instance_register_with(view_event_handle,
@@ -10,6 +10,10 @@ extern "C" {
 
 int indicator_view_init(void);
 
+/* Apply the model events queued since the last call. LVGL task, once per
+ * frame with the LVGL lock held */
+void indicator_view_event_drain(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,48 @@
+#include "view_bind.h"
+#include <stdio.h>
+#include <string.h>
+
+bool view_bind_set_text(struct view_bind *bind, const char *text)
+{
+    lv_obj_t *label = *bind->label;
+
+    if (label == NULL) {
+        return false;
+    }
+    /* A rebuilt screen has new labels, whatever they show */
+    if (label == bind->bound && strncmp(bind->text, text, sizeof(bind->text)) == 0) {
+        return false;
+    }
+    lv_label_set_text(label, text);
+    bind->bound = label;
+    strncpy(bind->text, text, sizeof(bind->text) - 1);
+    bind->text[sizeof(bind->text) - 1] = '\0';
+    return true;
+}
+
+uint32_t view_bind_mask(const struct view_bind *binds, int cnt)
+{
+    uint32_t mask = 0;
+
+    for (int i = 0; i < cnt; i++) {
+        size_t word = binds[i].offset / 4;
+        mask |= 1u << (word < 31 ? word : 31);
+    }
+    return mask;
+}
+
+int view_bind_update(struct view_bind *binds, int cnt, const void *model)
+{
+    char buf[sizeof(binds[0].text)];
+    int touched = 0;
+
+    for (int i = 0; i < cnt; i++) {
+        float value;
+        memcpy(&value, (const char *)model + binds[i].offset, sizeof(value));
+        snprintf(buf, sizeof(buf), binds[i].fmt, value);
+        if (view_bind_set_text(&binds[i], buf)) {
+            touched++;
+        }
+    }
+    return touched;
+}
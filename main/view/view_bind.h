@@ -0,0 +1,43 @@
+#ifndef VIEW_BIND_H
+#define VIEW_BIND_H
+
+#include "lvgl.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A label showing one float field of a model struct. The text last put on
+ * the label is kept, so an update that formats to the same string doesn't
+ * touch LVGL: no invalidation, no redraw, no framebuffer copy.
+ */
+struct view_bind {
+    lv_obj_t  **label;      /* may point to NULL until the screen is built */
+    size_t      offset;     /* of the float in the model struct */
+    const char *fmt;        /* printf format of the value */
+
+    /* Owned by view_bind_update */
+    lv_obj_t   *bound;      /* the label `text` was rendered on */
+    char        text[16];
+};
+
+#define VIEW_BIND_FLOAT(label_ptr, type, field, format) \
+    { .label = &(label_ptr), .offset = offsetof(type, field), .fmt = (format) }
+
+/* Set each label whose text changes. Returns the number of labels touched */
+int view_bind_update(struct view_bind *binds, int cnt, const void *model);
+
+/* The 32-bit words of the model struct the bindings read, as change bits
+ * in the form indicator_store uses */
+uint32_t view_bind_mask(const struct view_bind *binds, int cnt);
+
+/* Set the label of one binding to text, when it differs */
+bool view_bind_set_text(struct view_bind *bind, const char *text);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
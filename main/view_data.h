@@ -143,6 +143,37 @@ struct view_data_sensor {
     float multigas_gm702b[2];  // [0]=ppm(eq), [1]=voltage (CO)
 };
 
+/* Progress of a database export, in order */
+enum db_phase {
+    DB_PHASE_IDLE = 0,
+    DB_PHASE_RESOLVE,
+    DB_PHASE_CONNECT,
+    DB_PHASE_HANDSHAKE,
+    DB_PHASE_QUERY,
+};
+
+/* Published as STORE_TOPIC_DB_STATUS */
+struct view_data_db_status {
+    int      status;        /* 0 ok, -99 running, <0 error code of the last operation */
+    uint8_t  phase;         /* enum db_phase while running */
+    bool     is_test;
+    time_t   last_export;
+};
+
+/* Outcomes of real traffic to one destination (NTP server, HTTPS host,
+ * export sink, the idle probe) */
+#define NET_HEALTH_RTT_BUCKETS   8   /* <10, <25, <50, <100, <250, <500, <1000, >=1000 ms */
+#define NET_HEALTH_LOSS_BUCKETS  5   /* windows with 0, <=10, <=50, <100, 100 % lost */
+
+struct view_data_net_health {
+    char     dest[32];
+    uint32_t ok;
+    uint32_t fail;
+    uint32_t rtt_hist[NET_HEALTH_RTT_BUCKETS];
+    uint32_t loss_hist[NET_HEALTH_LOSS_BUCKETS];
+    uint8_t  last_loss;     /* percent, in the window just closed */
+};
+
 enum {
     VIEW_EVENT_SCREEN_START = 0,  // uint8_t, enum start_screen, which screen when start
 
@@ -151,8 +182,6 @@ enum {
     VIEW_EVENT_WIFI_ST,   //view_data_wifi_st_t
     VIEW_EVENT_CITY,      // char city[32], max display 24 char
 
-    VIEW_EVENT_SENSOR_DATA, // struct view_data_sensor_data
-
     VIEW_EVENT_SENSOR_TEMP,  
     VIEW_EVENT_SENSOR_HUMIDITY,
     VIEW_EVENT_SENSOR_TVOC,
@@ -193,7 +222,6 @@ enum {
     VIEW_EVENT_BRIGHTNESS_UPDATE,   // uint8_t brightness
     VIEW_EVENT_DISPLAY_CFG_APPLY,   // struct view_data_display. will save
 
-
     VIEW_EVENT_SHUTDOWN,      //NULL
     VIEW_EVENT_FACTORY_RESET, //NULL
     VIEW_EVENT_SCREEN_CTRL,   // bool  0:disable , 1:enable
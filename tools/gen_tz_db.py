@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""
+Generate main/util/tz_db_data.h: POSIX TZ rules for the IANA zones, keyed by
+zone name ("Europe/Vienna") and city ("Vienna", "New York", plus the aliases
+below), with a minimal perfect hash over the keys for tz_db_lookup().
+
+The rules are the footer strings of the compiled TZif files, so the output
+follows the tzdata installed on the build host:
+
+    python3 tools/gen_tz_db.py [--zoneinfo /usr/share/zoneinfo] [-o main/util/tz_db_data.h]
+
+The hash and key normalization must match tz_db.c.
+"""
+
+import argparse
+import os
+import sys
+
+# Cities people know that are not the name of a zone
+ALIASES = {
+    "Wien": "Europe/Vienna",
+    "Munich": "Europe/Berlin", "Frankfurt": "Europe/Berlin", "Hamburg": "Europe/Berlin",
+    "Cologne": "Europe/Berlin", "Stuttgart": "Europe/Berlin",
+    "Bern": "Europe/Zurich", "Geneva": "Europe/Zurich", "Basel": "Europe/Zurich",
+    "Lyon": "Europe/Paris", "Marseille": "Europe/Paris", "Toulouse": "Europe/Paris",
+    "Rotterdam": "Europe/Amsterdam", "The Hague": "Europe/Amsterdam",
+    "Antwerp": "Europe/Brussels",
+    "Milan": "Europe/Rome", "Naples": "Europe/Rome", "Turin": "Europe/Rome",
+    "Barcelona": "Europe/Madrid", "Valencia": "Europe/Madrid", "Seville": "Europe/Madrid",
+    "Krakow": "Europe/Warsaw", "Wroclaw": "Europe/Warsaw",
+    "Brno": "Europe/Prague",
+    "Graz": "Europe/Vienna", "Linz": "Europe/Vienna", "Salzburg": "Europe/Vienna",
+    "Innsbruck": "Europe/Vienna",
+    "Gothenburg": "Europe/Stockholm", "Bergen": "Europe/Oslo",
+    "Kiev": "Europe/Kyiv", "Odesa": "Europe/Kyiv",
+    "Porto": "Europe/Lisbon",
+    "Manchester": "Europe/London", "Birmingham": "Europe/London", "Edinburgh": "Europe/London",
+    "Saint Petersburg": "Europe/Moscow",
+    "Boston": "America/New_York", "Philadelphia": "America/New_York",
+    "Washington": "America/New_York", "Miami": "America/New_York", "Atlanta": "America/New_York",
+    "Houston": "America/Chicago", "Dallas": "America/Chicago", "Austin": "America/Chicago",
+    "San Francisco": "America/Los_Angeles", "Seattle": "America/Los_Angeles",
+    "San Diego": "America/Los_Angeles", "San Jose": "America/Los_Angeles",
+    "Montreal": "America/Toronto", "Ottawa": "America/Toronto",
+    "Beijing": "Asia/Shanghai", "Shenzhen": "Asia/Shanghai", "Guangzhou": "Asia/Shanghai",
+    "Mumbai": "Asia/Kolkata", "Delhi": "Asia/Kolkata", "New Delhi": "Asia/Kolkata",
+    "Bangalore": "Asia/Kolkata",
+    "Osaka": "Asia/Tokyo",
+    "Canberra": "Australia/Sydney",
+}
+
+AREAS = ("Africa/", "America/", "Antarctica/", "Arctic/", "Asia/", "Atlantic/",
+         "Australia/", "Europe/", "Indian/", "Pacific/")
+
+FNV_OFFSET = 2166136261
+FNV_PRIME = 16777619
+
+
+def normalize(name):
+    """ASCII lower case, '_' as ' ': "New_York" and "new york" are one key"""
+    return name.replace("_", " ").lower()
+
+
+def fnv1a(key, seed):
+    h = seed if seed else FNV_OFFSET
+    for c in key.encode():
+        h ^= c
+        h = (h * FNV_PRIME) & 0xffffffff
+    return h
+
+
+def posix_rule(path):
+    """Footer of a version 2+ TZif file: "\\n<rule>\\n" at the very end"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if not data.startswith(b"TZif") or data[4:5] < b"2" or not data.endswith(b"\n"):
+        return None
+    start = data.rfind(b"\n", 0, len(data) - 1)
+    rule = data[start + 1:-1].decode()
+    return rule or None
+
+
+def read_zones(zoneinfo):
+    zones = []
+    with open(os.path.join(zoneinfo, "zone.tab")) as f:
+        for line in f:
+            if line.startswith("#") or not line.strip():
+                continue
+            zones.append(line.split("\t")[2].strip())
+    # Backward names that still turn up in API answers ("Europe/Kiev")
+    links = []
+    zi = os.path.join(zoneinfo, "tzdata.zi")
+    if os.path.exists(zi):
+        with open(zi) as f:
+            for line in f:
+                parts = line.split()
+                if len(parts) == 3 and parts[0] == "L" and parts[2].startswith(AREAS):
+                    links.append(parts[2])
+    return sorted(zones), sorted(links)
+
+
+def build_keys(zoneinfo):
+    """(key, string pool offset source, rule) triples; keys are unique after normalize"""
+    zones, links = read_zones(zoneinfo)
+    keys = {}
+
+    def add(key, text, zone):
+        rule = posix_rule(os.path.join(zoneinfo, zone))
+        if rule is None:
+            print("skipping %s: no POSIX rule" % zone, file=sys.stderr)
+            return
+        norm = normalize(key)
+        if norm in keys:
+            if keys[norm][1] != rule:
+                print("duplicate key %s (%s), keeping the first" % (key, zone), file=sys.stderr)
+            return
+        keys[norm] = (text, rule)
+
+    for zone in zones + links + ["Etc/UTC"]:
+        add(zone, zone, zone)
+    for zone in zones:
+        city = zone.rsplit("/", 1)[1]
+        add(city, zone, zone)      # stored as the tail of the zone name
+    for city, zone in sorted(ALIASES.items()):
+        add(city, city, zone)
+    add("UTC", "UTC", "Etc/UTC")
+    return keys
+
+
+def perfect_hash(keys, bucket_cnt):
+    """Hash and displace: bucket = h(key, 0) % buckets, slot = h(key, d[bucket]) % n"""
+    n = len(keys)
+    buckets = [[] for _ in range(bucket_cnt)]
+    for key in keys:
+        buckets[fnv1a(key, 0) % bucket_cnt].append(key)
+
+    slots = [None] * n
+    disp = [0] * bucket_cnt
+    for b in sorted(range(bucket_cnt), key=lambda i: -len(buckets[i])):
+        if not buckets[b]:
+            break
+        for d in range(1, 1 << 16):
+            taken = [fnv1a(k, d) % n for k in buckets[b]]
+            if len(set(taken)) == len(taken) and all(slots[s] is None for s in taken):
+                break
+        else:
+            sys.exit("no displacement for bucket %d" % b)
+        disp[b] = d
+        for k, s in zip(buckets[b], taken):
+            slots[s] = k
+    return slots, disp
+
+
+def c_string(s):
+    return '"' + s.replace("\\", "\\\\").replace('"', '\\"') + '\\0"'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--zoneinfo", default="/usr/share/zoneinfo")
+    parser.add_argument("-o", "--output", default=os.path.join(os.path.dirname(__file__), "..",
+                                                                 "main", "util", "tz_db_data.h"))
+    args = parser.parse_args()
+
+    keys = build_keys(args.zoneinfo)
+    bucket_cnt = max(1, len(keys) // 4)
+    slots, disp = perfect_hash(list(keys), bucket_cnt)
+
+    # Name pool: zone names and aliases; city keys point at the zone name's tail
+    names = bytearray()
+    name_off = {}
+    for text, _ in sorted(set(keys.values())):
+        if text not in name_off:
+            name_off[text] = len(names)
+            names += text.encode() + b"\0"
+    rules = bytearray()
+    rule_off = {}
+    for _, rule in sorted(set(keys.values()), key=lambda v: v[1]):
+        if rule not in rule_off:
+            rule_off[rule] = len(rules)
+            rules += rule.encode() + b"\0"
+    if len(names) >= 0xffff or len(rules) >= 0xffff:
+        sys.exit("string pools exceed 16-bit offsets")
+
+    entries = []
+    for norm in slots:
+        text, rule = keys[norm]
+        off = name_off[text]
+        if normalize(text) != norm:
+            # City key: the last component of the zone name
+            off += len(text) - len(norm)
+        assert normalize(names[off:names.index(b"\0", off)].decode()) == norm
+        entries.append((off, rule_off[rule], norm))
+
+    # Self-check: every key hashes to its own slot
+    for i, (_, _, norm) in enumerate(entries):
+        assert fnv1a(norm, disp[fnv1a(norm, 0) % bucket_cnt]) % len(entries) == i
+
+    with open(args.output, "w") as out:
+        out.write("/* Generated by tools/gen_tz_db.py, do not edit */\n\n")
+        out.write("#define TZ_DB_KEY_CNT     %d\n" % len(entries))
+        out.write("#define TZ_DB_BUCKET_CNT  %d\n\n" % bucket_cnt)
+        out.write("static const char __tz_db_names[] =\n")
+        for text in sorted(name_off, key=name_off.get):
+            out.write("    %s\n" % c_string(text))
+        out.write("    ;\n\n")
+        out.write("static const char __tz_db_rules[] =\n")
+        for rule in sorted(rule_off, key=rule_off.get):
+            out.write("    %s\n" % c_string(rule))
+        out.write("    ;\n\n")
+        out.write("static const uint16_t __tz_db_disp[TZ_DB_BUCKET_CNT] = {\n")
+        for i in range(0, bucket_cnt, 16):
+            out.write("    " + ", ".join(str(d) for d in disp[i:i + 16]) + ",\n")
+        out.write("};\n\n")
+        out.write("static const struct tz_db_entry __tz_db_entries[TZ_DB_KEY_CNT] = {\n")
+        for off, roff, norm in entries:
+            out.write("    { %5d, %4d },   /* %s */\n" % (off, roff, norm))
+        out.write("};\n")
+
+    size = len(names) + len(rules) + 2 * bucket_cnt + 4 * len(entries)
+    print("%d keys, %d rules, %d buckets, %d bytes of flash" %
+          (len(entries), len(rule_off), bucket_cnt, size), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,342 @@
+/*
+ * Host benchmark for main/util/mysql_client.c, run against
+ * tools/mysql_standin.py or a real MariaDB/MySQL server:
+ *
+ *  - connect: TCP connect, handshake and authentication, then COM_QUIT
+ *  - insert:  rows/s with multi-row text INSERTs and with a prepared
+ *             statement executed in binary, 14 columns like the exporter
+ *  - recover: sends batches for a while and times every failure, from the
+ *             start of the batch that failed (so detection time counts) until
+ *             the next batch goes through, reconnecting as the exporter does
+ *
+ * Usage: mysql_bench [-h host] [-P port] [-u user] [-p password] [-D database]
+ *                    [-c connects] [-n rows] [-b batch] [-r recover_sec] [-s]
+ *                    [-f sha256]
+ *
+ * -s requires TLS, -f trusts the server certificate with that fingerprint
+ */
+
+#include "mysql_client.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_COLUMNS      14           /* timestamp + 13 sensor values */
+#define BENCH_TX_SIZE      (256 * 1024)
+#define BENCH_TABLE        "bench_rows"
+#define BENCH_RETRY_MS     50
+
+struct bench_opts {
+    const char *host;
+    int         port;
+    const char *user;
+    const char *password;
+    const char *database;
+    int         connects;
+    int         rows;
+    int         batch;
+    int         recover_sec;
+    bool        tls;
+};
+
+static mysql_tls_t s_tls;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void conn_setup(mysql_conn_t *conn, const struct bench_opts *o)
+{
+    static uint8_t *tx_buf;
+
+    if (!tx_buf) {
+        tx_buf = malloc(BENCH_TX_SIZE);
+    }
+    memset(conn, 0, sizeof(*conn));
+    conn->sock = -1;
+    conn->tx_buf = tx_buf;
+    conn->tx_size = BENCH_TX_SIZE;
+    conn->tls = &s_tls;
+    conn->use_tls = o->tls;
+}
+
+static int conn_open(mysql_conn_t *conn, const struct bench_opts *o)
+{
+    return mysql_connect(conn, o->host, o->port, o->user, o->password, o->database);
+}
+
+static void conn_close(mysql_conn_t *conn)
+{
+    mysql_quit(conn);
+    mysql_conn_close(conn);
+}
+
+static void bench_connect(const struct bench_opts *o)
+{
+    double *ms = calloc(o->connects, sizeof(double));
+    int ok = 0;
+    mysql_conn_t conn;
+
+    for (int i = 0; i < o->connects; i++) {
+        conn_setup(&conn, o);
+        double start = now_ms();
+        if (conn_open(&conn, o) == 0) {
+            ms[ok++] = now_ms() - start;
+            conn_close(&conn);
+        }
+    }
+    if (ok == 0) {
+        printf("connect: all %d attempts failed\n", o->connects);
+        free(ms);
+        return;
+    }
+    qsort(ms, ok, sizeof(double), cmp_double);
+    double sum = 0;
+    for (int i = 0; i < ok; i++) {
+        sum += ms[i];
+    }
+    printf("connect: %d/%d ok, avg %.2f ms, p50 %.2f ms, p95 %.2f ms, max %.2f ms\n",
+           ok, o->connects, sum / ok, ms[ok / 2], ms[ok * 95 / 100], ms[ok - 1]);
+    free(ms);
+}
+
+static float sample_value(int row, int col)
+{
+    return 20.0f + (float)((row * 7 + col * 13) % 1000) / 10.0f;
+}
+
+/* Multi-row text INSERT of rows [first, first + cnt) */
+static int send_text_batch(mysql_conn_t *conn, int first, int cnt)
+{
+    char *q = (char *)conn->tx_buf + 1;
+    int size = conn->tx_size - 1;
+    int len = snprintf(q, size, "INSERT INTO " BENCH_TABLE " VALUES ");
+
+    for (int r = first; r < first + cnt && len < size; r++) {
+        len += snprintf(q + len, size - len, "%s(%d", r > first ? "," : "", 1700000000 + r);
+        for (int c = 1; c < BENCH_COLUMNS && len < size; c++) {
+            len += snprintf(q + len, size - len, ",%.2f", sample_value(r, c));
+        }
+        len += snprintf(q + len, size - len, ")");
+    }
+    if (len >= size) {
+        return -1;
+    }
+    return mysql_query_tx(conn, len);
+}
+
+static int prepare_batch(mysql_conn_t *conn, int rows, uint32_t *stmt_id)
+{
+    static char query[16384];
+    int len = snprintf(query, sizeof(query), "INSERT INTO " BENCH_TABLE " VALUES ");
+
+    for (int r = 0; r < rows && len < (int)sizeof(query); r++) {
+        len += snprintf(query + len, sizeof(query) - len, "%s(?", r ? "," : "");
+        for (int c = 1; c < BENCH_COLUMNS; c++) {
+            len += snprintf(query + len, sizeof(query) - len, ",?");
+        }
+        len += snprintf(query + len, sizeof(query) - len, ")");
+    }
+    if (len >= (int)sizeof(query)) {
+        return -1;
+    }
+    return mysql_stmt_prepare(conn, query, stmt_id) == rows * BENCH_COLUMNS ? 0 : -1;
+}
+
+/* COM_STMT_EXECUTE with BIGINT timestamps and FLOAT values */
+static int send_stmt_batch(mysql_conn_t *conn, uint32_t stmt_id, int first, int cnt)
+{
+    uint8_t *p = conn->tx_buf;
+    int params = cnt * BENCH_COLUMNS;
+    int len = 0;
+
+    p[len++] = 0x17;                            /* COM_STMT_EXECUTE */
+    memcpy(&p[len], &stmt_id, 4);               /* little endian host */
+    len += 4;
+    p[len++] = 0;                               /* no cursor */
+    p[len++] = 1;                               /* iteration count */
+    p[len++] = 0;
+    p[len++] = 0;
+    p[len++] = 0;
+    memset(&p[len], 0, (params + 7) / 8);       /* no NULLs */
+    len += (params + 7) / 8;
+    p[len++] = 1;                               /* types follow */
+    for (int i = 0; i < params; i++) {
+        p[len++] = (i % BENCH_COLUMNS) ? 0x04 : 0x08;   /* FLOAT, LONGLONG */
+        p[len++] = 0;
+    }
+    for (int r = first; r < first + cnt; r++) {
+        int64_t ts = 1700000000 + r;
+        memcpy(&p[len], &ts, 8);
+        len += 8;
+        for (int c = 1; c < BENCH_COLUMNS; c++) {
+            float v = sample_value(r, c);
+            memcpy(&p[len], &v, 4);
+            len += 4;
+        }
+    }
+    return mysql_command_tx(conn, len);
+}
+
+static void bench_insert(const struct bench_opts *o)
+{
+    mysql_conn_t conn;
+    uint32_t stmt_id;
+
+    conn_setup(&conn, o);
+    if (conn_open(&conn, o) < 0) {
+        printf("insert: connect failed\n");
+        return;
+    }
+    mysql_query(&conn, "CREATE TABLE IF NOT EXISTS " BENCH_TABLE " (ts BIGINT,"
+                       "v1 FLOAT,v2 FLOAT,v3 FLOAT,v4 FLOAT,v5 FLOAT,v6 FLOAT,v7 FLOAT,"
+                       "v8 FLOAT,v9 FLOAT,v10 FLOAT,v11 FLOAT,v12 FLOAT,v13 FLOAT)");
+
+    uint32_t wire = conn.tx_wire_bytes;
+    double start = now_ms();
+    int sent = 0;
+    while (sent < o->rows) {
+        int cnt = o->rows - sent < o->batch ? o->rows - sent : o->batch;
+        if (send_text_batch(&conn, sent, cnt) < 0) {
+            break;
+        }
+        sent += cnt;
+    }
+    double ms = now_ms() - start;
+    printf("insert text:     %d rows in %.0f ms, %.0f rows/s, %.0f bytes/row\n",
+           sent, ms, sent * 1000.0 / ms, sent ? (double)(conn.tx_wire_bytes - wire) / sent : 0);
+
+    if (prepare_batch(&conn, o->batch, &stmt_id) < 0) {
+        printf("insert prepared: prepare failed\n");
+        conn_close(&conn);
+        return;
+    }
+    wire = conn.tx_wire_bytes;
+    start = now_ms();
+    sent = 0;
+    while (sent + o->batch <= o->rows) {
+        if (send_stmt_batch(&conn, stmt_id, sent, o->batch) < 0) {
+            break;
+        }
+        sent += o->batch;
+    }
+    ms = now_ms() - start;
+    printf("insert prepared: %d rows in %.0f ms, %.0f rows/s, %.0f bytes/row\n",
+           sent, ms, sent * 1000.0 / ms, sent ? (double)(conn.tx_wire_bytes - wire) / sent : 0);
+    conn_close(&conn);
+}
+
+static void bench_recover(const struct bench_opts *o)
+{
+    mysql_conn_t conn;
+    double end = now_ms() + o->recover_sec * 1000.0;
+    double failed_at = 0;
+    double worst = 0;
+    double total = 0;
+    int failures = 0;
+    int recoveries = 0;
+    int rows = 0;
+
+    conn_setup(&conn, o);
+    double start = now_ms();
+    while (now_ms() < end) {
+        double attempt = now_ms();
+        if (conn.sock < 0 && conn_open(&conn, o) < 0) {
+            if (failed_at == 0) {
+                failed_at = attempt;
+                failures++;
+            }
+            usleep(BENCH_RETRY_MS * 1000);
+            continue;
+        }
+        if (send_text_batch(&conn, rows, o->batch) < 0) {
+            /* Like the exporter: the session state is unknown, start over */
+            if (failed_at == 0) {
+                failed_at = attempt;
+                failures++;
+            }
+            mysql_conn_close(&conn);
+            continue;
+        }
+        rows += o->batch;
+        if (failed_at) {
+            double ms = now_ms() - failed_at;
+            total += ms;
+            worst = ms > worst ? ms : worst;
+            recoveries++;
+            failed_at = 0;
+        }
+    }
+    double ms = now_ms() - start;
+    conn_close(&conn);
+    printf("recover: %d rows in %.0f s (%.0f rows/s), %d failures, recovery avg %.0f ms, max %.0f ms\n",
+           rows, ms / 1000, rows * 1000.0 / ms, failures,
+           recoveries ? total / recoveries : 0, worst);
+}
+
+int main(int argc, char **argv)
+{
+    struct bench_opts o = {
+        .host = "127.0.0.1",
+        .port = 13306,
+        .user = "sensor",
+        .password = "secret",
+        .database = "sensors",
+        .connects = 50,
+        .rows = 20000,
+        .batch = 50,
+        .recover_sec = 0,
+    };
+    int opt;
+
+    while ((opt = getopt(argc, argv, "h:P:u:p:D:c:n:b:r:sf:")) != -1) {
+        switch (opt) {
+            case 'h': o.host = optarg; break;
+            case 'P': o.port = atoi(optarg); break;
+            case 'u': o.user = optarg; break;
+            case 'p': o.password = optarg; break;
+            case 'D': o.database = optarg; break;
+            case 'c': o.connects = atoi(optarg); break;
+            case 'n': o.rows = atoi(optarg); break;
+            case 'b': o.batch = atoi(optarg); break;
+            case 'r': o.recover_sec = atoi(optarg); break;
+            case 's': o.tls = true; break;
+            case 'f':
+                if (mysql_tls_pin(&s_tls, optarg) < 0) {
+                    fprintf(stderr, "-f wants a SHA-256 fingerprint in hex\n");
+                    return 2;
+                }
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-h host] [-P port] [-u user] [-p password] [-D database]"
+                                " [-c connects] [-n rows] [-b batch] [-r recover_sec] [-s] [-f sha256]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (o.batch < 1) {
+        o.batch = 1;
+    }
+
+    if (o.connects > 0) {
+        bench_connect(&o);
+    }
+    if (o.rows > 0) {
+        bench_insert(&o);
+    }
+    if (o.recover_sec > 0) {
+        bench_recover(&o);
+    }
+    return 0;
+}
@@ -0,0 +1,400 @@
+#!/usr/bin/env python3
+"""
+Local MySQL server stand-in for exercising main/util/mysql_client.c and the
+exporter on a host. It speaks enough of the wire protocol for what the
+device sends: handshake v10 with mysql_native_password, COM_QUERY,
+COM_PING, COM_INIT_DB, COM_QUIT and COM_STMT_PREPARE/EXECUTE/RESET/CLOSE.
+Nothing is stored; INSERTs are counted by the rows they carry.
+
+    python3 tools/mysql_standin.py --port 13306 --user sensor --password secret
+
+With --tls-cert and --tls-key the server offers TLS. --sha2 switches to
+caching_sha2_password with an empty cache, so every login takes the full
+authentication: the cleartext password over TLS, or without TLS encrypted
+with the RSA key from --tls-key (decrypted with the openssl command). A
+self-signed certificate for testing, and its fingerprint for the client:
+
+    openssl req -x509 -newkey rsa:2048 -nodes -subj /CN=standin -days 30 \
+        -keyout standin.key -out standin.crt
+    openssl x509 -in standin.crt -noout -fingerprint -sha256
+
+Network and server trouble can be injected per response:
+
+    --latency 0.020       hold every response 20 ms
+    --fragment 7          write responses in 7-byte pieces
+    --loss 0.02           2% of the pieces are "lost": held for --rto seconds,
+                          doubling while the loss repeats, like a TCP
+                          retransmission would
+    --stall 0.01          1% of the commands are never answered
+    --reset 0.01          1% of the commands close the connection unanswered
+    --error 0.01          1% of the commands get ERR 1213 (deadlock)
+
+For real packet loss on Linux use netem on the loopback instead, e.g.
+`tc qdisc add dev lo root netem loss 2%`. Counters are printed every
+--report seconds.
+"""
+
+import argparse
+import hashlib
+import os
+import random
+import re
+import socket
+import socketserver
+import ssl
+import struct
+import subprocess
+import threading
+import time
+
+CLIENT_CONNECT_WITH_DB = 0x00000008
+CLIENT_PROTOCOL_41 = 0x00000200
+CLIENT_SSL = 0x00000800
+CLIENT_TRANSACTIONS = 0x00002000
+CLIENT_SECURE_CONNECTION = 0x00008000
+CLIENT_MULTI_RESULTS = 0x00020000
+CLIENT_PLUGIN_AUTH = 0x00080000
+SERVER_CAPS = (CLIENT_CONNECT_WITH_DB | CLIENT_PROTOCOL_41 | CLIENT_TRANSACTIONS |
+               CLIENT_SECURE_CONNECTION | CLIENT_MULTI_RESULTS | CLIENT_PLUGIN_AUTH | 0x0001 | 0x0004)
+
+COM_QUIT = 0x01
+COM_INIT_DB = 0x02
+COM_QUERY = 0x03
+COM_PING = 0x0e
+COM_STMT_PREPARE = 0x16
+COM_STMT_EXECUTE = 0x17
+COM_STMT_CLOSE = 0x19
+COM_STMT_RESET = 0x1a
+
+MAX_ALLOWED_PACKET = 16 * 1024 * 1024
+
+
+class Counters:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.values = dict(connections=0, tls=0, sha2_cleartext=0, sha2_rsa=0, auth_fail=0,
+                           commands=0, rows=0, stalls=0, resets=0, errors=0, lost=0)
+
+    def add(self, name, n=1):
+        with self.lock:
+            self.values[name] += n
+
+    def line(self):
+        with self.lock:
+            return " ".join("%s=%d" % kv for kv in self.values.items())
+
+
+def lenenc_int(n):
+    if n < 0xfb:
+        return bytes([n])
+    if n < 1 << 16:
+        return b"\xfc" + struct.pack("<H", n)
+    if n < 1 << 24:
+        return b"\xfd" + struct.pack("<I", n)[:3]
+    return b"\xfe" + struct.pack("<Q", n)
+
+
+def lenenc_str(s):
+    return lenenc_int(len(s)) + s
+
+
+def native_scramble(password, nonce):
+    """What the client must send for mysql_native_password"""
+    if not password:
+        return b""
+    stage1 = hashlib.sha1(password.encode()).digest()
+    stage2 = hashlib.sha1(stage1).digest()
+    stage3 = hashlib.sha1(nonce + stage2).digest()
+    return bytes(a ^ b for a, b in zip(stage1, stage3))
+
+
+def ok_packet(affected=0):
+    return b"\x00" + lenenc_int(affected) + lenenc_int(0) + struct.pack("<HH", 0x0002, 0)
+
+
+def err_packet(code, message, state=b"HY000"):
+    return b"\xff" + struct.pack("<H", code) + b"#" + state + message.encode()
+
+
+def eof_packet():
+    return b"\xfe" + struct.pack("<HH", 0, 0x0002)
+
+
+def column_def(name, col_type=0xfd):
+    return (lenenc_str(b"def") + lenenc_str(b"") + lenenc_str(b"") + lenenc_str(b"") +
+            lenenc_str(name) + lenenc_str(name) + b"\x0c" +
+            struct.pack("<HIBHB", 33, 1024, col_type, 0, 0) + b"\x00\x00")
+
+
+def insert_rows(sql):
+    """Rows of a multi-row INSERT ... VALUES (...),(...)"""
+    upper = sql.upper()
+    at = upper.find("VALUES")
+    if not upper.lstrip().startswith("INSERT") or at < 0:
+        return 0
+    values = sql[at + 6:]
+    if "(" not in values:
+        return 0
+    return len(re.findall(r"\)\s*,\s*\(", values)) + 1
+
+
+class Session(socketserver.BaseRequestHandler):
+    def setup(self):
+        self.args = self.server.args
+        self.counters = self.server.counters
+        self.rx = b""
+        self.seq = 0
+        self.tls = False
+        self.stmts = {}
+        self.next_stmt = 1
+        self.request.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+    # ---- framing ----
+
+    def recv_exact(self, n):
+        # The ClientHello follows an SSLRequest unasked: don't read ahead into it
+        size = n - len(self.rx) if self.server.tls and not self.tls else 65536
+        while len(self.rx) < n:
+            data = self.request.recv(size)
+            if not data:
+                raise ConnectionError("peer closed")
+            self.rx += data
+        out, self.rx = self.rx[:n], self.rx[n:]
+        return out
+
+    def read_packet(self):
+        payload = b""
+        while True:
+            header = self.recv_exact(4)
+            length = header[0] | header[1] << 8 | header[2] << 16
+            self.seq = (header[3] + 1) & 0xff
+            payload += self.recv_exact(length)
+            if length < 0xffffff:
+                return payload
+
+    def write(self, data):
+        args = self.args
+        if args.latency:
+            time.sleep(args.latency)
+        step = args.fragment or len(data)
+        for at in range(0, len(data), step):
+            rto = args.rto
+            while args.loss and random.random() < args.loss:
+                self.counters.add("lost")
+                time.sleep(rto)
+                rto *= 2
+            self.request.sendall(data[at:at + step])
+
+    def send_packets(self, *payloads):
+        out = b""
+        for payload in payloads:
+            out += struct.pack("<I", len(payload))[:3] + bytes([self.seq]) + payload
+            self.seq = (self.seq + 1) & 0xff
+        self.write(out)
+
+    # ---- protocol ----
+
+    def handshake(self):
+        nonce = bytes(random.randrange(1, 128) for _ in range(20))
+        caps = SERVER_CAPS | (CLIENT_SSL if self.server.tls else 0)
+        plugin = b"caching_sha2_password" if self.args.sha2 else b"mysql_native_password"
+        greeting = (b"\x0a" + b"5.5.5-10.11.0-standin\x00" +
+                    struct.pack("<I", threading.get_ident() & 0xffffffff) +
+                    nonce[:8] + b"\x00" +
+                    struct.pack("<HBHH", caps & 0xffff, 45, 0x0002, caps >> 16) +
+                    bytes([21]) + b"\x00" * 10 + nonce[8:] + b"\x00" +
+                    plugin + b"\x00")
+        self.seq = 0
+        self.send_packets(greeting)
+
+        resp = self.read_packet()
+        if len(resp) == 32 and self.server.tls and struct.unpack_from("<I", resp, 0)[0] & CLIENT_SSL:
+            # SSLRequest: the full response follows over TLS
+            self.request = self.server.tls.wrap_socket(self.request, server_side=True)
+            self.tls = True
+            self.counters.add("tls")
+            resp = self.read_packet()
+        if len(resp) < 32:
+            self.send_packets(err_packet(1043, "Bad handshake", b"08S01"))
+            return False
+        caps = struct.unpack_from("<I", resp, 0)[0]
+        at = 32
+        end = resp.index(b"\x00", at)
+        user = resp[at:end].decode(errors="replace")
+        at = end + 1
+        auth = resp[at + 1:at + 1 + resp[at]]
+        at += 1 + resp[at]
+        if caps & CLIENT_CONNECT_WITH_DB and at < len(resp):
+            end = resp.index(b"\x00", at)
+            at = end + 1
+
+        if self.args.sha2:
+            ok = user == self.args.user and self.sha2_full_auth(nonce)
+        else:
+            ok = user == self.args.user and auth == native_scramble(self.args.password, nonce)
+        if not ok:
+            self.counters.add("auth_fail")
+            self.send_packets(err_packet(1045, "Access denied for user '%s'" % user, b"28000"))
+            return False
+        self.send_packets(ok_packet())
+        return True
+
+    def sha2_full_auth(self, nonce):
+        """caching_sha2_password with nothing cached: ask for the password"""
+        self.send_packets(b"\x01\x04")
+        packet = self.read_packet()
+        if self.tls:
+            self.counters.add("sha2_cleartext")
+            return packet == self.args.password.encode() + b"\x00"
+        if packet != b"\x02" or not self.server.public_key:
+            return False
+        self.send_packets(b"\x01" + self.server.public_key)
+        packet = self.read_packet()
+        plain = subprocess.run(["openssl", "pkeyutl", "-decrypt", "-inkey", self.args.tls_key,
+                                "-pkeyopt", "rsa_padding_mode:oaep"],
+                               input=packet, capture_output=True).stdout
+        self.counters.add("sha2_rsa")
+        password = bytes(b ^ nonce[i % 20] for i, b in enumerate(plain))
+        return password == self.args.password.encode() + b"\x00"
+
+    def inject(self):
+        """Fault for this command, None to answer it normally"""
+        args = self.args
+        roll = random.random()
+        for name, share in (("stall", args.stall), ("reset", args.reset), ("error", args.error)):
+            if roll < share:
+                return name
+            roll -= share
+        return None
+
+    def query(self, sql):
+        text = sql.strip()
+        if text.upper().startswith("SELECT"):
+            value = str(MAX_ALLOWED_PACKET) if "max_allowed_packet" in text else "1"
+            self.send_packets(lenenc_int(1), column_def(b"value"), eof_packet(),
+                              lenenc_str(value.encode()), eof_packet())
+            return
+        rows = insert_rows(text)
+        self.counters.add("rows", rows)
+        self.send_packets(ok_packet(rows))
+
+    def prepare(self, sql):
+        stmt_id = self.next_stmt
+        self.next_stmt += 1
+        params = sql.count("?")
+        self.stmts[stmt_id] = insert_rows(sql)
+        packets = [b"\x00" + struct.pack("<IHHBH", stmt_id, 0, params, 0, 0)]
+        if params:
+            packets += [column_def(b"?", 0xfd)] * params + [eof_packet()]
+        self.send_packets(*packets)
+
+    def execute(self, payload):
+        stmt_id = struct.unpack_from("<I", payload, 0)[0]
+        if stmt_id not in self.stmts:
+            self.send_packets(err_packet(1243, "Unknown prepared statement handler"))
+            return
+        rows = self.stmts[stmt_id]
+        self.counters.add("rows", rows)
+        self.send_packets(ok_packet(rows))
+
+    def handle(self):
+        self.counters.add("connections")
+        try:
+            if not self.handshake():
+                return
+            while True:
+                packet = self.read_packet()
+                if not packet:
+                    continue
+                cmd, body = packet[0], packet[1:]
+                if cmd == COM_QUIT:
+                    return
+                if cmd == COM_STMT_CLOSE:
+                    self.stmts.pop(struct.unpack_from("<I", body, 0)[0], None)
+                    continue
+                self.counters.add("commands")
+
+                fault = self.inject()
+                if fault == "stall":
+                    self.counters.add("stalls")
+                    while self.request.recv(65536):
+                        pass
+                    return
+                if fault == "reset":
+                    self.counters.add("resets")
+                    self.request.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack("ii", 1, 0))
+                    return
+                if fault == "error":
+                    self.counters.add("errors")
+                    self.send_packets(err_packet(1213, "Deadlock found when trying to get lock", b"40001"))
+                    continue
+
+                if cmd == COM_QUERY:
+                    self.query(body.decode(errors="replace"))
+                elif cmd in (COM_PING, COM_INIT_DB, COM_STMT_RESET):
+                    self.send_packets(ok_packet())
+                elif cmd == COM_STMT_PREPARE:
+                    self.prepare(body.decode(errors="replace"))
+                elif cmd == COM_STMT_EXECUTE:
+                    self.execute(body)
+                else:
+                    self.send_packets(err_packet(1047, "Unknown command %d" % cmd, b"08S01"))
+        except (ConnectionError, OSError, ValueError):
+            pass
+
+
+class Server(socketserver.ThreadingMixIn, socketserver.TCPServer):
+    allow_reuse_address = True
+    daemon_threads = True
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", type=int, default=13306)
+    parser.add_argument("--user", default="sensor")
+    parser.add_argument("--password", default="secret")
+    parser.add_argument("--latency", type=float, default=0.0, help="seconds to hold each response")
+    parser.add_argument("--fragment", type=int, default=0, help="bytes per write, 0 for whole responses")
+    parser.add_argument("--loss", type=float, default=0.0, help="share of writes held for a retransmission")
+    parser.add_argument("--rto", type=float, default=0.2, help="first retransmission timeout, seconds")
+    parser.add_argument("--stall", type=float, default=0.0, help="share of commands never answered")
+    parser.add_argument("--reset", type=float, default=0.0, help="share of commands answered with a reset")
+    parser.add_argument("--error", type=float, default=0.0, help="share of commands answered with ERR")
+    parser.add_argument("--seed", type=int, default=None)
+    parser.add_argument("--tls-cert", help="PEM certificate, offer TLS")
+    parser.add_argument("--tls-key", help="PEM private key for TLS and RSA password exchange")
+    parser.add_argument("--sha2", action="store_true", help="caching_sha2_password, always full auth")
+    parser.add_argument("--report", type=float, default=0.0, help="print counters every N seconds")
+    args = parser.parse_args()
+    random.seed(args.seed if args.seed is not None else os.getpid())
+
+    server = Server(("0.0.0.0", args.port), Session)
+    server.args = args
+    server.counters = Counters()
+    server.tls = None
+    server.public_key = None
+    if args.tls_cert:
+        server.tls = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        server.tls.load_cert_chain(args.tls_cert, args.tls_key)
+    if args.tls_key:
+        server.public_key = subprocess.run(["openssl", "pkey", "-in", args.tls_key, "-pubout"],
+                                           capture_output=True, check=True).stdout
+    print("serving on tcp/%d as %s, latency %.3f s, fragment %d, loss %.3f, stall %.3f, reset %.3f, error %.3f" %
+          (args.port, args.user, args.latency, args.fragment, args.loss, args.stall, args.reset, args.error),
+          flush=True)
+
+    if args.report:
+        def report():
+            while True:
+                time.sleep(args.report)
+                print(server.counters.line(), flush=True)
+        threading.Thread(target=report, daemon=True).start()
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print(server.counters.line(), flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""
+Local NTP server stand-in for exercising main/util/ntp_client.c on a host.
+It answers SNTP requests with this machine's clock shifted by --offset, plus
+random --jitter, and drops a share of the requests. Run one instance per
+port to stand in for several servers, e.g. two honest ones and a falseticker:
+
+    python3 tools/ntp_standin.py --port 12301 --jitter 0.005
+    python3 tools/ntp_standin.py --port 12302 --offset 0.010 --jitter 0.005
+    python3 tools/ntp_standin.py --port 12303 --offset 3 --drop 0.2
+
+--drift shifts the offset by that many ppm per second of run time, to watch
+a drift estimate converge. --kod answers every request with a kiss-o'-death.
+"""
+
+import argparse
+import random
+import socket
+import struct
+import time
+
+NTP_UNIX_OFFSET = 2208988800
+
+
+def ntp_ts(t):
+    sec = int(t)
+    frac = int((t - sec) * (1 << 32)) & 0xffffffff
+    return struct.pack("!II", (sec + NTP_UNIX_OFFSET) & 0xffffffff, frac)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", type=int, default=12300)
+    parser.add_argument("--offset", type=float, default=0.0, help="seconds added to the served time")
+    parser.add_argument("--jitter", type=float, default=0.0, help="uniform +/- seconds per answer")
+    parser.add_argument("--delay", type=float, default=0.0, help="seconds to hold each answer")
+    parser.add_argument("--drift", type=float, default=0.0, help="ppm the offset grows by")
+    parser.add_argument("--drop", type=float, default=0.0, help="share of requests left unanswered")
+    parser.add_argument("--stratum", type=int, default=2)
+    parser.add_argument("--kod", action="store_true", help="answer with kiss-o'-death RATE")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("0.0.0.0", args.port))
+    start = time.time()
+    print("serving on udp/%d, offset %+.3f s, jitter %.3f s" % (args.port, args.offset, args.jitter))
+
+    while True:
+        data, peer = sock.recvfrom(512)
+        if len(data) < 48 or data[0] & 0x07 != 3:
+            continue
+        if random.random() < args.drop:
+            print("%s: dropped" % peer[0])
+            continue
+
+        now = time.time()
+        shift = args.offset + (now - start) * args.drift * 1e-6 + random.uniform(-args.jitter, args.jitter)
+        receive = now + shift
+        if args.delay:
+            time.sleep(args.delay)
+        transmit = time.time() + shift
+
+        stratum = 0 if args.kod else args.stratum
+        refid = b"RATE" if args.kod else b"LOCL"
+        reply = struct.pack("!BBbb", (0 << 6) | (4 << 3) | 4, stratum, 6, -20)
+        reply += struct.pack("!II", 0, 0) + refid
+        reply += ntp_ts(receive - 1)                 # reference time
+        reply += data[40:48]                         # origin: the client's transmit time
+        reply += ntp_ts(receive) + ntp_ts(transmit)
+        sock.sendto(reply, peer)
+        print("%s: answered, shift %+.6f s" % (peer[0], shift))
+
+
+if __name__ == "__main__":
+    main()